@@ -78,6 +78,7 @@ RvdLogLsnEntryTracker::UnsafeAllocateRvdLogLsnEntryBlock(__out RvdLogLsnEntryBlo
         }
     }
 
+    newBlk->_TotalSize = 0;
     Result = newBlk;
     return STATUS_SUCCESS;
 }
@@ -166,8 +167,7 @@ RvdLogLsnEntryTracker::AddHigherLsnRecord(
         }
 
         _TailBlockLastEntryIx++;
-        RvdLogLsnEntry* entry = &_Blocks.PeekTail()->_Entries[_TailBlockLastEntryIx];
-        UnsafeAddRecord(*entry, Lsn, HeaderAndMetaDataSize, IoBufferSize);
+        UnsafeAddRecord(*_Blocks.PeekTail(), _TailBlockLastEntryIx, Lsn, HeaderAndMetaDataSize, IoBufferSize);
         _HighestLsn = Lsn;
     }
 
@@ -186,9 +186,11 @@ RvdLogLsnEntryTracker::RemoveHighestLsnRecord()
         KAssert(_NumberOfEntires > 0);
 
         RvdLogLsnEntry* oldEntry = &_Blocks.PeekTail()->_Entries[_TailBlockLastEntryIx];
+        ULONG const     oldRecordSize = ComputeTotalRecordSizeOnDisk(oldEntry->HeaderAndMetaDataSize, oldEntry->IoBufferSize);
         KAssert(oldEntry->Lsn == _HighestLsn);
         _NumberOfEntires--;
-        _TotalSize -= ComputeTotalRecordSizeOnDisk(oldEntry->HeaderAndMetaDataSize, oldEntry->IoBufferSize);
+        _TotalSize -= oldRecordSize;
+        _Blocks.PeekTail()->_TotalSize -= oldRecordSize;
         if (_TailBlockLastEntryIx == 0)
         {
             // Trailing block will need to be freed (or put into _ReservedBlock)
@@ -277,8 +279,7 @@ RvdLogLsnEntryTracker::AddLowerLsnRecord(
         }
 
         _HeadBlockFirstEntryIx--;
-        RvdLogLsnEntry* entry = &_Blocks.PeekHead()->_Entries[_HeadBlockFirstEntryIx];
-        UnsafeAddRecord(*entry, Lsn, HeaderAndMetaDataSize, IoBufferSize);
+        UnsafeAddRecord(*_Blocks.PeekHead(), _HeadBlockFirstEntryIx, Lsn, HeaderAndMetaDataSize, IoBufferSize);
         _LowestLsn = Lsn;
     }
 
@@ -288,39 +289,77 @@ RvdLogLsnEntryTracker::AddLowerLsnRecord(
 VOID
 RvdLogLsnEntryTracker::Truncate(__in RvdLogLsn NewLowestLsn)
 {
+    KNodeList<RvdLogLsnEntryBlock>  blocksToFree(FIELD_OFFSET(RvdLogLsnEntryBlock, _BlockLinks));
+
     K_LOCK_BLOCK(_ThisLock)
     {
         RvdLogLsnEntryBlock* blkPtr;
         while ((blkPtr = _Blocks.PeekHead()) != nullptr)
         {
-            while ((_NumberOfEntires > 0) && 
-                   (_HeadBlockFirstEntryIx < RvdLogLsnEntryBlock::_NumberOfEntriesPerBlock))
+            ULONG const     lastEntryIx = (blkPtr == _Blocks.PeekTail())
+                                            ? _TailBlockLastEntryIx
+                                            : RvdLogLsnEntryBlock::_NumberOfEntriesPerBlock - 1;
+
+            if (blkPtr->_Entries[lastEntryIx].Lsn < NewLowestLsn)
+            {
+                // The whole block is truncated - its size is known without visiting the entries
+                _TotalSize -= blkPtr->_TotalSize;
+                _NumberOfEntires -= (lastEntryIx + 1) - _HeadBlockFirstEntryIx;
+
+                _Blocks.RemoveHead();
+                blocksToFree.AppendTail(blkPtr);
+                _HeadBlockFirstEntryIx = 0;
+                continue;
+            }
+
+            // NewLowestLsn falls within this block - find the first entry to keep; LSNs are ascending
+            ULONG       lowIx = _HeadBlockFirstEntryIx;
+            ULONG       highIx = lastEntryIx;
+            while (lowIx < highIx)
             {
-                RvdLogLsnEntry* entry = &blkPtr->_Entries[_HeadBlockFirstEntryIx];
-                if (entry->Lsn >= NewLowestLsn)
+                ULONG const midIx = lowIx + ((highIx - lowIx) / 2);
+                if (blkPtr->_Entries[midIx].Lsn < NewLowestLsn)
                 {
-                    _LowestLsn = NewLowestLsn;
-                    return;
+                    lowIx = midIx + 1;
                 }
+                else
+                {
+                    highIx = midIx;
+                }
+            }
 
-                // Removed the entry
-                _TotalSize -= ComputeTotalRecordSizeOnDisk(entry->HeaderAndMetaDataSize, entry->IoBufferSize);
-                _NumberOfEntires--;
-                _HeadBlockFirstEntryIx++;
+            for (ULONG ix = _HeadBlockFirstEntryIx; ix < lowIx; ix++)
+            {
+                RvdLogLsnEntry* entry = &blkPtr->_Entries[ix];
+                ULONG const     recordSize = ComputeTotalRecordSizeOnDisk(entry->HeaderAndMetaDataSize, entry->IoBufferSize);
+
+                _TotalSize -= recordSize;
+                blkPtr->_TotalSize -= recordSize;
             }
 
-            _Blocks.RemoveHead();
-            _delete(blkPtr);
-            blkPtr = nullptr;
+            _NumberOfEntires -= lowIx - _HeadBlockFirstEntryIx;
+            _HeadBlockFirstEntryIx = lowIx;
+            _LowestLsn = NewLowestLsn;
+            break;
+        }
 
+        if (_Blocks.IsEmpty())
+        {
+            // Went empty
+            KAssert(_NumberOfEntires == 0);
+            KAssert(_TotalSize == 0);
             _HeadBlockFirstEntryIx = 0;
+            _TailBlockLastEntryIx = RvdLogLsnEntryBlock::_NumberOfEntriesPerBlock;
+            _LowestLsn = RvdLogLsn::Null();
+            _HighestLsn = RvdLogLsn::Null();
         }
+    }
 
-        // Went empty
-        KAssert(_NumberOfEntires == 0);
-        KAssert(_TotalSize == 0);
-        _LowestLsn = RvdLogLsn::Null();
-        _HighestLsn = RvdLogLsn::Null();
+    // Truncated blocks are freed outside the lock
+    RvdLogLsnEntryBlock* blk;
+    while ((blk = blocksToFree.RemoveHead()) != nullptr)
+    {
+        _delete(blk);
     }
 }
 
@@ -669,6 +708,18 @@ RvdLogLsnEntryTracker::GetAllRecordLsnsIntoIoBuffer(
 }
 
 //** RvdAsnIndex implementation
+//
+//  Used like K_LOCK_BLOCK: lookups take _ThisLock shared, changes to the index take it exclusive
+//
+#define __RVD_ASN_INDEX_LOCK_BLOCK_VARIABLE_EXPAND(VariableName, Index, Shared) \
+    for (RvdAsnIndex::InStackLock VariableName((Index), (Shared)); VariableName.HasLock(); VariableName.ReleaseLock())
+
+#define RVD_ASN_INDEX_SHARED_LOCK_BLOCK(Index) \
+    __RVD_ASN_INDEX_LOCK_BLOCK_VARIABLE_EXPAND(K_MAKE_UNIQUE_NAME(_localHiddenLock), Index, TRUE)
+
+#define RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(Index) \
+    __RVD_ASN_INDEX_LOCK_BLOCK_VARIABLE_EXPAND(K_MAKE_UNIQUE_NAME(_localHiddenLock), Index, FALSE)
+
 RvdAsnIndexEntry::SavedState::SavedState()
     :   _Disposition(RvdLogStream::RecordDisposition::eDispositionNone),
         _MappingEntry(RvdLogAsn::Null(), 0, RvdLogLsn::Null(), 0)
@@ -695,29 +746,16 @@ RvdAsnIndexEntry::Restore(__in SavedState& From)
     _LowestLsnOfHigherASNs = From._LowestLsnOfHigherASNs;
 }
 
-LONG
-RvdAsnIndexEntry::Comparator(__in RvdAsnIndexEntry& Left, __in RvdAsnIndexEntry& Right)
-{
-    if (Left._MappingEntry.RecordAsn < Right._MappingEntry.RecordAsn)
-    {
-        return -1;
-    }
-    if (Left._MappingEntry.RecordAsn > Right._MappingEntry.RecordAsn)
-    {
-        return 1;
-    }
-    return 0;
-}
-
 ULONG
 RvdAsnIndexEntry::GetLinksOffset()
 {
-    return FIELD_OFFSET(RvdAsnIndexEntry, _AsnIndexEntryLinks);
+    return FIELD_OFFSET(RvdAsnIndexEntry, _ReleaseLinks);
 }
 
 RvdAsnIndexEntry::RvdAsnIndexEntry(__in RvdLogAsn Asn, __in ULONGLONG Version, __in ULONG IoBufferSize)
     :   _MappingEntry(Asn, Version, RvdLogLsn::Null(), IoBufferSize),
-        _Disposition(RvdLogStream::RecordDisposition::eDispositionNone)
+        _Disposition(RvdLogStream::RecordDisposition::eDispositionNone),
+        _IsIndexed(FALSE)
 {
     #if DBG
         DebugContext = 0;
@@ -731,24 +769,717 @@ RvdAsnIndexEntry::RvdAsnIndexEntry(
     __in RvdLogStream::RecordDisposition Disposition,
     __in RvdLogLsn Lsn)
     :   _MappingEntry(Asn, Version, Lsn, IoBufferSize),
-        _Disposition(Disposition)
+        _Disposition(Disposition),
+        _IsIndexed(FALSE)
 {
 }
 
 
+//** RvdAsnIndexTree implementation
+VOID
+RvdAsnIndexTree::Cursor::MoveNext()
+{
+    KAssert(_Leaf != nullptr);
+
+    _Ix++;
+    if (_Ix == _Leaf->_Count)
+    {
+        _Leaf = _Leaf->_Next;
+        _Ix = 0;
+    }
+}
+
+VOID
+RvdAsnIndexTree::Cursor::MovePrevious()
+{
+    KAssert(_Leaf != nullptr);
+
+    if (_Ix > 0)
+    {
+        _Ix--;
+        return;
+    }
+
+    _Leaf = _Leaf->_Prev;
+    _Ix = (_Leaf == nullptr) ? 0 : _Leaf->_Count - 1;
+}
+
+RvdAsnIndexTree::RvdAsnIndexTree(__in KAllocator& Allocator)
+    :   _Allocator(Allocator),
+        _Root(nullptr),
+        _FirstLeaf(nullptr),
+        _LastLeaf(nullptr),
+        _Count(0)
+{
+}
+
+RvdAsnIndexTree::~RvdAsnIndexTree()
+{
+    Clear();
+}
+
+VOID
+RvdAsnIndexTree::Clear()
+{
+    if (_Root != nullptr)
+    {
+        FreeSubtree(_Root);
+    }
+
+    _Root = nullptr;
+    _FirstLeaf = nullptr;
+    _LastLeaf = nullptr;
+    _Count = 0;
+}
+
+VOID
+RvdAsnIndexTree::TakeContents(__inout RvdAsnIndexTree& Src)
+{
+    KInvariant(_Root == nullptr);
+
+    _Root = Src._Root;
+    _FirstLeaf = Src._FirstLeaf;
+    _LastLeaf = Src._LastLeaf;
+    _Count = Src._Count;
+
+    Src._Root = nullptr;
+    Src._FirstLeaf = nullptr;
+    Src._LastLeaf = nullptr;
+    Src._Count = 0;
+}
+
+RvdAsnIndexTree::Leaf*
+RvdAsnIndexTree::AllocateLeaf()
+{
+    Leaf*       leaf = _new(KTL_TAG_LOGGER, _Allocator) Leaf();
+    if (leaf != nullptr)
+    {
+        leaf->_IsLeaf = TRUE;
+        leaf->_Count = 0;
+        leaf->_Next = nullptr;
+        leaf->_Prev = nullptr;
+    }
+
+    return leaf;
+}
+
+RvdAsnIndexTree::Interior*
+RvdAsnIndexTree::AllocateInterior()
+{
+    Interior*   interior = _new(KTL_TAG_LOGGER, _Allocator) Interior();
+    if (interior != nullptr)
+    {
+        interior->_IsLeaf = FALSE;
+        interior->_Count = 0;
+    }
+
+    return interior;
+}
+
+VOID
+RvdAsnIndexTree::FreeSubtree(__in Node* Subtree)
+{
+    if (Subtree->_IsLeaf)
+    {
+        _delete(static_cast<Leaf*>(Subtree));
+        return;
+    }
+
+    Interior*   interior = static_cast<Interior*>(Subtree);
+    for (ULONG ix = 0; ix < interior->_Count; ix++)
+    {
+        FreeSubtree(interior->_Children[ix]);
+    }
+
+    _delete(interior);
+}
+
+ULONG
+RvdAsnIndexTree::LowerBound(__in Node& Target, __in ULONG Start, __in ULONGLONG Key)
+{
+    ULONG       lowIx = Start;
+    ULONG       highIx = Target._Count;
+
+    while (lowIx < highIx)
+    {
+        ULONG const midIx = lowIx + ((highIx - lowIx) / 2);
+        if (Target._Keys[midIx] < Key)
+        {
+            lowIx = midIx + 1;
+        }
+        else
+        {
+            highIx = midIx;
+        }
+    }
+
+    return lowIx;
+}
+
+ULONG
+RvdAsnIndexTree::UpperBound(__in Node& Target, __in ULONG Start, __in ULONGLONG Key)
+{
+    ULONG       lowIx = Start;
+    ULONG       highIx = Target._Count;
+
+    while (lowIx < highIx)
+    {
+        ULONG const midIx = lowIx + ((highIx - lowIx) / 2);
+        if (Target._Keys[midIx] <= Key)
+        {
+            lowIx = midIx + 1;
+        }
+        else
+        {
+            highIx = midIx;
+        }
+    }
+
+    return lowIx;
+}
+
+VOID
+RvdAsnIndexTree::InsertIntoLeaf(__in Leaf& Target, __in ULONG Ix, __in RvdAsnIndexEntry& Entry)
+{
+    KAssert((Target._Count < _EntriesPerNode) && (Ix <= Target._Count));
+
+    RtlMoveMemory(&Target._Keys[Ix + 1], &Target._Keys[Ix], (Target._Count - Ix) * sizeof(ULONGLONG));
+    RtlMoveMemory(&Target._Entries[Ix + 1], &Target._Entries[Ix], (Target._Count - Ix) * sizeof(RvdAsnIndexEntry*));
+    Target._Keys[Ix] = Entry.GetAsn().Get();
+    Target._Entries[Ix] = &Entry;
+    Target._Count++;
+}
+
+VOID
+RvdAsnIndexTree::InsertIntoInterior(__in Interior& Target, __in ULONG Ix, __in Node& Child)
+{
+    KAssert((Target._Count < _EntriesPerNode) && (Ix <= Target._Count));
+
+    RtlMoveMemory(&Target._Keys[Ix + 1], &Target._Keys[Ix], (Target._Count - Ix) * sizeof(ULONGLONG));
+    RtlMoveMemory(&Target._Children[Ix + 1], &Target._Children[Ix], (Target._Count - Ix) * sizeof(Node*));
+    Target._Keys[Ix] = Child._Keys[0];
+    Target._Children[Ix] = &Child;
+    Target._Count++;
+}
+
+RvdAsnIndexTree::Leaf*
+RvdAsnIndexTree::FindLeaf(
+    __in ULONGLONG Key,
+    __out_ecount(_MaxDepth) Interior** Path,
+    __out_ecount(_MaxDepth) ULONG* PathIx,
+    __out ULONG& Depth)
+{
+    KAssert(_Root != nullptr);
+
+    Node*       node = _Root;
+    Depth = 0;
+
+    while (!node->_IsLeaf)
+    {
+        KInvariant(Depth < _MaxDepth);
+        Interior*   interior = static_cast<Interior*>(node);
+
+        // _Children[ix] holds the keys from _Keys[ix] up to _Keys[ix + 1]; keys below _Keys[1] are in
+        // _Children[0] so _Keys[0] is never consulted. Removals can leave a key lower than the lowest
+        // key of its child, which is still a correct bound.
+        ULONG const ix = UpperBound(*interior, 1, Key) - 1;
+
+        Path[Depth] = interior;
+        PathIx[Depth] = ix;
+        Depth++;
+        node = interior->_Children[ix];
+    }
+
+    return static_cast<Leaf*>(node);
+}
+
+NTSTATUS
+RvdAsnIndexTree::Insert(__in RvdAsnIndexEntry& Entry, __out RvdAsnIndexEntry*& Existing)
+{
+    ULONGLONG const key = Entry.GetAsn().Get();
+
+    Existing = nullptr;
+
+    if (_Root == nullptr)
+    {
+        Leaf*   leaf = AllocateLeaf();
+        if (leaf == nullptr)
+        {
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        InsertIntoLeaf(*leaf, 0, Entry);
+        _Root = leaf;
+        _FirstLeaf = leaf;
+        _LastLeaf = leaf;
+        _Count = 1;
+        return STATUS_SUCCESS;
+    }
+
+    Interior*   path[_MaxDepth];
+    ULONG       pathIx[_MaxDepth];
+    ULONG       depth;
+    Leaf*       leaf = FindLeaf(key, path, pathIx, depth);
+    ULONG const ix = LowerBound(*leaf, 0, key);
+
+    if ((ix < leaf->_Count) && (leaf->_Keys[ix] == key))
+    {
+        Existing = leaf->_Entries[ix];
+        return STATUS_OBJECT_NAME_COLLISION;
+    }
+
+    if (leaf->_Count < _EntriesPerNode)
+    {
+        InsertIntoLeaf(*leaf, ix, Entry);
+        _Count++;
+        return STATUS_SUCCESS;
+    }
+
+    // The leaf is full and splits, as does each full Interior above it; a new root is needed if the root
+    // splits. All of the nodes needed are allocated before the tree is changed so that a failure leaves the
+    // tree as it was.
+    ULONG       fullInteriors = 0;
+    while ((fullInteriors < depth) && (path[depth - 1 - fullInteriors]->_Count == _EntriesPerNode))
+    {
+        fullInteriors++;
+    }
+
+    ULONG const interiorsNeeded = fullInteriors + ((fullInteriors == depth) ? 1 : 0);
+    Interior*   newInteriors[_MaxDepth + 1];
+    ULONG       interiorsAllocated = 0;
+    Leaf*       newLeaf = AllocateLeaf();
+
+    while ((newLeaf != nullptr) && (interiorsAllocated < interiorsNeeded))
+    {
+        newInteriors[interiorsAllocated] = AllocateInterior();
+        if (newInteriors[interiorsAllocated] == nullptr)
+        {
+            break;
+        }
+        interiorsAllocated++;
+    }
+
+    if ((newLeaf == nullptr) || (interiorsAllocated < interiorsNeeded))
+    {
+        while (interiorsAllocated > 0)
+        {
+            interiorsAllocated--;
+            _delete(newInteriors[interiorsAllocated]);
+        }
+
+        if (newLeaf != nullptr)
+        {
+            _delete(newLeaf);
+        }
+
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    // Move the upper half of the leaf into newLeaf and link it in after the leaf
+    ULONG const splitIx = _EntriesPerNode / 2;
+
+    newLeaf->_Count = _EntriesPerNode - splitIx;
+    KMemCpySafe(&newLeaf->_Keys[0], sizeof(newLeaf->_Keys), &leaf->_Keys[splitIx], newLeaf->_Count * sizeof(ULONGLONG));
+    KMemCpySafe(
+        &newLeaf->_Entries[0],
+        sizeof(newLeaf->_Entries),
+        &leaf->_Entries[splitIx],
+        newLeaf->_Count * sizeof(RvdAsnIndexEntry*));
+    leaf->_Count = splitIx;
+
+    newLeaf->_Prev = leaf;
+    newLeaf->_Next = leaf->_Next;
+    if (leaf->_Next != nullptr)
+    {
+        leaf->_Next->_Prev = newLeaf;
+    }
+    else
+    {
+        _LastLeaf = newLeaf;
+    }
+    leaf->_Next = newLeaf;
+
+    if (ix <= splitIx)
+    {
+        InsertIntoLeaf(*leaf, ix, Entry);
+    }
+    else
+    {
+        InsertIntoLeaf(*newLeaf, ix - splitIx, Entry);
+    }
+    _Count++;
+
+    // Add each new right sibling to its parent, splitting the full parents on the way up
+    Node*       newChild = newLeaf;
+    ULONG       nextInterior = 0;
+
+    for (ULONG level = depth; level > 0; level--)
+    {
+        Interior*   parent = path[level - 1];
+        ULONG const childIx = pathIx[level - 1] + 1;
+
+        if (parent->_Count < _EntriesPerNode)
+        {
+            InsertIntoInterior(*parent, childIx, *newChild);
+            newChild = nullptr;
+            break;
+        }
+
+        Interior*   newInterior = newInteriors[nextInterior++];
+
+        newInterior->_Count = _EntriesPerNode - splitIx;
+        KMemCpySafe(
+            &newInterior->_Keys[0],
+            sizeof(newInterior->_Keys),
+            &parent->_Keys[splitIx],
+            newInterior->_Count * sizeof(ULONGLONG));
+        KMemCpySafe(
+            &newInterior->_Children[0],
+            sizeof(newInterior->_Children),
+            &parent->_Children[splitIx],
+            newInterior->_Count * sizeof(Node*));
+        parent->_Count = splitIx;
+
+        if (childIx <= splitIx)
+        {
+            InsertIntoInterior(*parent, childIx, *newChild);
+        }
+        else
+        {
+            InsertIntoInterior(*newInterior, childIx - splitIx, *newChild);
+        }
+
+        newChild = newInterior;
+    }
+
+    if (newChild != nullptr)
+    {
+        // The root split - grow the tree by one level
+        Interior*   newRoot = newInteriors[nextInterior++];
+
+        newRoot->_Count = 2;
+        newRoot->_Keys[0] = _Root->_Keys[0];
+        newRoot->_Children[0] = _Root;
+        newRoot->_Keys[1] = newChild->_Keys[0];
+        newRoot->_Children[1] = newChild;
+        _Root = newRoot;
+    }
+
+    KAssert(nextInterior == interiorsNeeded);
+    return STATUS_SUCCESS;
+}
+
+VOID
+RvdAsnIndexTree::UnlinkLeaf(
+    __in Leaf& Target,
+    __in_ecount(Depth) Interior** Path,
+    __in_ecount(Depth) ULONG* PathIx,
+    __in ULONG Depth)
+{
+    if (Target._Prev != nullptr)
+    {
+        Target._Prev->_Next = Target._Next;
+    }
+    else
+    {
+        _FirstLeaf = Target._Next;
+    }
+
+    if (Target._Next != nullptr)
+    {
+        Target._Next->_Prev = Target._Prev;
+    }
+    else
+    {
+        _LastLeaf = Target._Prev;
+    }
+
+    Target._Next = nullptr;
+    Target._Prev = nullptr;
+
+    // Remove the leaf from its parent; an Interior left without children is removed from its parent in turn
+    ULONG       level = Depth;
+    while (level > 0)
+    {
+        Interior*   parent = Path[level - 1];
+        ULONG const childIx = PathIx[level - 1];
+
+        RtlMoveMemory(&parent->_Keys[childIx], &parent->_Keys[childIx + 1], (parent->_Count - childIx - 1) * sizeof(ULONGLONG));
+        RtlMoveMemory(&parent->_Children[childIx], &parent->_Children[childIx + 1], (parent->_Count - childIx - 1) * sizeof(Node*));
+        parent->_Count--;
+
+        if (parent->_Count > 0)
+        {
+            break;
+        }
+
+        _delete(parent);
+        level--;
+    }
+
+    if (level == 0)
+    {
+        // The root itself went away
+        KAssert(_Count == 0);
+        _Root = nullptr;
+        return;
+    }
+
+    // Drop roots left with a single child
+    while (!_Root->_IsLeaf && (_Root->_Count == 1))
+    {
+        Interior*   oldRoot = static_cast<Interior*>(_Root);
+        _Root = oldRoot->_Children[0];
+        _delete(oldRoot);
+    }
+}
+
+RvdAsnIndexEntry*
+RvdAsnIndexTree::Remove(__in RvdLogAsn Asn)
+{
+    if (_Root == nullptr)
+    {
+        return nullptr;
+    }
+
+    ULONGLONG const key = Asn.Get();
+    Interior*   path[_MaxDepth];
+    ULONG       pathIx[_MaxDepth];
+    ULONG       depth;
+    Leaf*       leaf = FindLeaf(key, path, pathIx, depth);
+    ULONG const ix = LowerBound(*leaf, 0, key);
+
+    if ((ix == leaf->_Count) || (leaf->_Keys[ix] != key))
+    {
+        return nullptr;
+    }
+
+    RvdAsnIndexEntry*   entry = leaf->_Entries[ix];
+
+    RtlMoveMemory(&leaf->_Keys[ix], &leaf->_Keys[ix + 1], (leaf->_Count - ix - 1) * sizeof(ULONGLONG));
+    RtlMoveMemory(&leaf->_Entries[ix], &leaf->_Entries[ix + 1], (leaf->_Count - ix - 1) * sizeof(RvdAsnIndexEntry*));
+    leaf->_Count--;
+    _Count--;
+
+    if (leaf->_Count == 0)
+    {
+        UnlinkLeaf(*leaf, path, pathIx, depth);
+        _delete(leaf);
+    }
+
+    return entry;
+}
+
+VOID
+RvdAsnIndexTree::DetachUpTo(__in RvdLogAsn UpToAsn, __inout DetachedRange& Range)
+{
+    KInvariant((Range._FirstLeaf == nullptr) && (Range._Partial._Count == 0));
+
+    ULONGLONG const key = UpToAsn.Get();
+
+    while (_FirstLeaf != nullptr)
+    {
+        Leaf*       leaf = _FirstLeaf;
+
+        if (leaf->_Keys[leaf->_Count - 1] > key)
+        {
+            // Last affected leaf keeps its upper entries; the bound kept for it in its parent is still correct
+            ULONG const numberToDetach = UpperBound(*leaf, 0, key);
+
+            RtlCopyMemory(&Range._Partial._Keys[0], &leaf->_Keys[0], numberToDetach * sizeof(ULONGLONG));
+            RtlCopyMemory(&Range._Partial._Entries[0], &leaf->_Entries[0], numberToDetach * sizeof(RvdAsnIndexEntry*));
+            Range._Partial._Count = numberToDetach;
+
+            RtlMoveMemory(&leaf->_Keys[0], &leaf->_Keys[numberToDetach], (leaf->_Count - numberToDetach) * sizeof(ULONGLONG));
+            RtlMoveMemory(
+                &leaf->_Entries[0],
+                &leaf->_Entries[numberToDetach],
+                (leaf->_Count - numberToDetach) * sizeof(RvdAsnIndexEntry*));
+            leaf->_Count -= numberToDetach;
+            _Count -= numberToDetach;
+            break;
+        }
+
+        _Count -= leaf->_Count;
+
+        // The first leaf is reached through the first child of each Interior
+        Interior*   path[_MaxDepth];
+        ULONG       pathIx[_MaxDepth];
+        ULONG       depth = 0;
+        Node*       node = _Root;
+
+        while (!node->_IsLeaf)
+        {
+            KInvariant(depth < _MaxDepth);
+            path[depth] = static_cast<Interior*>(node);
+            pathIx[depth] = 0;
+            depth++;
+            node = static_cast<Interior*>(node)->_Children[0];
+        }
+
+        KAssert(node == leaf);
+        UnlinkLeaf(*leaf, path, pathIx, depth);
+
+        if (Range._LastLeaf == nullptr)
+        {
+            Range._FirstLeaf = leaf;
+        }
+        else
+        {
+            Range._LastLeaf->_Next = leaf;
+            leaf->_Prev = Range._LastLeaf;
+        }
+        Range._LastLeaf = leaf;
+    }
+
+    if (Range._Partial._Count > 0)
+    {
+        if (Range._LastLeaf == nullptr)
+        {
+            Range._FirstLeaf = &Range._Partial;
+        }
+        else
+        {
+            Range._LastLeaf->_Next = &Range._Partial;
+        }
+    }
+}
+
+RvdAsnIndexTree::DetachedRange::DetachedRange()
+    :   _FirstLeaf(nullptr),
+        _LastLeaf(nullptr)
+{
+    _Partial._IsLeaf = TRUE;
+    _Partial._Count = 0;
+    _Partial._Next = nullptr;
+    _Partial._Prev = nullptr;
+}
+
+RvdAsnIndexTree::DetachedRange::~DetachedRange()
+{
+    Leaf*       leaf = _FirstLeaf;
+
+    while ((leaf != nullptr) && (leaf != &_Partial))
+    {
+        Leaf*   next = leaf->_Next;
+
+        _delete(leaf);
+        leaf = next;
+    }
+}
+
+RvdAsnIndexTree::Cursor
+RvdAsnIndexTree::DetachedRange::First()
+{
+    Cursor      result;
+
+    result._Leaf = _FirstLeaf;
+    return result;
+}
+
+RvdAsnIndexTree::Cursor
+RvdAsnIndexTree::First()
+{
+    Cursor      result;
+
+    result._Leaf = _FirstLeaf;
+    return result;
+}
+
+RvdAsnIndexTree::Cursor
+RvdAsnIndexTree::Last()
+{
+    Cursor      result;
+
+    if (_LastLeaf != nullptr)
+    {
+        result._Leaf = _LastLeaf;
+        result._Ix = _LastLeaf->_Count - 1;
+    }
+
+    return result;
+}
+
+RvdAsnIndexTree::Cursor
+RvdAsnIndexTree::Find(__in RvdLogAsn Asn)
+{
+    Cursor      result;
+
+    if (_Root != nullptr)
+    {
+        Interior*   path[_MaxDepth];
+        ULONG       pathIx[_MaxDepth];
+        ULONG       depth;
+        Leaf*       leaf = FindLeaf(Asn.Get(), path, pathIx, depth);
+        ULONG const ix = LowerBound(*leaf, 0, Asn.Get());
+
+        if ((ix < leaf->_Count) && (leaf->_Keys[ix] == Asn.Get()))
+        {
+            result._Leaf = leaf;
+            result._Ix = ix;
+        }
+    }
+
+    return result;
+}
+
+RvdAsnIndexTree::Cursor
+RvdAsnIndexTree::FindEqualOrNext(__in RvdLogAsn Asn)
+{
+    Cursor      result;
+
+    if (_Root != nullptr)
+    {
+        Interior*   path[_MaxDepth];
+        ULONG       pathIx[_MaxDepth];
+        ULONG       depth;
+        Leaf*       leaf = FindLeaf(Asn.Get(), path, pathIx, depth);
+        ULONG const ix = LowerBound(*leaf, 0, Asn.Get());
+
+        if (ix < leaf->_Count)
+        {
+            result._Leaf = leaf;
+            result._Ix = ix;
+        }
+        else
+        {
+            // All keys of the following leaves are above Asn
+            result._Leaf = leaf->_Next;
+        }
+    }
+
+    return result;
+}
+
+RvdAsnIndexTree::Cursor
+RvdAsnIndexTree::FindEqualOrPrevious(__in RvdLogAsn Asn)
+{
+    Cursor      result;
+
+    if (_Root != nullptr)
+    {
+        Interior*   path[_MaxDepth];
+        ULONG       pathIx[_MaxDepth];
+        ULONG       depth;
+        Leaf*       leaf = FindLeaf(Asn.Get(), path, pathIx, depth);
+        ULONG const ix = UpperBound(*leaf, 0, Asn.Get());
+
+        result._Leaf = leaf;
+        result._Ix = ix;
+        result.MovePrevious();
+    }
+
+    return result;
+}
+
+
+//** RvdAsnIndex implementation
 RvdAsnIndex::RvdAsnIndex(__in KAllocator& Allocator)
-    :   _Table(
-            RvdAsnIndexEntry::GetLinksOffset(), 
-            KNodeTable<RvdAsnIndexEntry>::CompareFunction(&RvdAsnIndexEntry::Comparator))
+    :   _Tree(Allocator)
 {
     _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPending] = 0;
     _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionNone] = 0;
     _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted] = 0;
-    _LookupKey = _new(KTL_TAG_LOGGER, Allocator) RvdAsnIndexEntry(RvdLogAsn::Min(), 0, 0);
-    if (_LookupKey == nullptr)
-    {
-        SetConstructorStatus(STATUS_INSUFFICIENT_RESOURCES);
-    }
 }
 
 RvdAsnIndex::~RvdAsnIndex()
@@ -759,64 +1490,64 @@ RvdAsnIndex::~RvdAsnIndex()
 VOID
 RvdAsnIndex::Clear()
 {
-    K_LOCK_BLOCK(_ThisLock)
-    {
-        RvdAsnIndexEntry*   entry = nullptr;
+    KNodeList<RvdAsnIndexEntry>     entriesToRelease(RvdAsnIndexEntry::GetLinksOffset());
+    RvdAsnIndexEntry*               entry;
 
-        while ((entry = _Table.First()) != nullptr)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
+    {
+        for (RvdAsnIndexTree::Cursor position = _Tree.First(); (entry = position.Current()) != nullptr; position.MoveNext())
         {
-            _Table.Remove(*entry);
-            entry->Release();   // Reverse the #1 AddRef in UnsafeAddOrUpdate() below
+            entry->_IsIndexed = FALSE;
+            entriesToRelease.AppendTail(entry);
         }
+        _Tree.Clear();
 
         _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPending] = 0;
         _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionNone] = 0;
         _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted] = 0;
     }
+
+    while ((entry = entriesToRelease.RemoveHead()) != nullptr)
+    {
+        entry->Release();   // Reverse the #1 AddRef in UnsafeAddOrUpdate() below
+    }
 }
 
 NTSTATUS
 RvdAsnIndex::Load( __in RvdAsnIndex& Src)
 {
-    // BUG, richhas, xxxxx, Consider if this needed to be safe or if "unsafe" semantics work
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
     {
-        K_LOCK_BLOCK(Src._ThisLock)
+        RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(Src)
         {
-            KInvariant(_Table.Count() == 0);
+            KInvariant(_Tree.Count() == 0);
 
-            RvdAsnIndexEntry::SPtr  nextEntry;
-            while ((nextEntry = Src._Table.First()) != nullptr)
-            {
-                Src._Table.Remove(*nextEntry.RawPtr());
+            // The entries, and the #1 AddRef held on each, move over with Src's tree
+            _Tree.TakeContents(Src._Tree);
 
-                RvdAsnIndexEntry::SPtr          resultIndexEntry;
-                RvdAsnIndexEntry::SavedState    previousIndexEntryValue;
-                BOOLEAN                         previousIndexEntryWasStored;
+            for (ULONG ix = 0; ix <= RvdLogStream::RecordDisposition::eDispositionNone; ix++)
+            {
+                _CountsOfDispositions[ix] = Src._CountsOfDispositions[ix];
+                Src._CountsOfDispositions[ix] = 0;
+            }
+        }
 
-				ULONGLONG dontCare = 0;
-                NTSTATUS status = UnsafeAddOrUpdate(
-                    nextEntry,
-                    resultIndexEntry,
-                    previousIndexEntryValue,
-                    previousIndexEntryWasStored,
-					dontCare);
+        // Recompute each written entry's _LowestLsnOfHigherASNs in one pass down from the highest ASN. This gives
+        // the same result as adding the entries one at a time in ASN order: the lowest LSN of the entry and of all
+        // written entries above it.
+        RvdLogLsn           lowestLsnOfHigherASNs = RvdLogLsn::Max();
+        RvdAsnIndexEntry*   entry;
 
-                if (!NT_SUCCESS(status))
+        for (RvdAsnIndexTree::Cursor position = _Tree.Last(); (entry = position.Current()) != nullptr; position.MovePrevious())
+        {
+            if (entry->_Disposition != RvdLogStream::RecordDisposition::eDispositionNone)
+            {
+                if (entry->_MappingEntry.RecordLsn < lowestLsnOfHigherASNs)
                 {
-                    return status;
+                    lowestLsnOfHigherASNs = entry->_MappingEntry.RecordLsn;
                 }
-
-                KInvariant(!previousIndexEntryWasStored);
-
-                // Reverse the #1 AddRef in UnsafeAddOrUpdate() below - extra AddRef() due
-                // not using "public" removal API
-                KInvariant(nextEntry->Release() > 0);   
+                entry->_LowestLsnOfHigherASNs = lowestLsnOfHigherASNs;
             }
-
-            Src._CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPending] = 0;
-            Src._CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionNone] = 0;
-            Src._CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted] = 0;
         }
     }
 
@@ -833,7 +1564,7 @@ RvdAsnIndex::AddOrUpdate(
 {
     NTSTATUS        status = STATUS_SUCCESS;
 
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
     {
         status = UnsafeAddOrUpdate(IndexEntry, ResultIndexEntry, PreviousIndexEntryValue, PreviousIndexEntryWasStored, DuplicateRecordAsnVersion);
     }
@@ -857,21 +1588,30 @@ RvdAsnIndex::UnsafeAddOrUpdate(
     //
     PreviousIndexEntryValue;
     
-    // BUG, nobertk, xxxxx, consider allowing an optional dup Entry pointer to be returned.
-    if (_Table.Insert(*IndexEntry))
+    RvdAsnIndexEntry*   currentEntry = nullptr;
+    NTSTATUS            status = _Tree.Insert(*IndexEntry, currentEntry);
+
+    if (NT_SUCCESS(status))
     {
         // BUG, richhas, xxxxx, consider a different approach - 2 add refs being done here
         ResultIndexEntry = IndexEntry;
         PreviousIndexEntryWasStored = FALSE;
 
+        IndexEntry->_IsIndexed = TRUE;
         IndexEntry->AddRef();                   // Keep add ref'd as long as indexed - #1
         UnsafeAccountForNewItem(IndexEntry->_Disposition);
         UnsafeUpdateLowestLsnOfHigherASNs(*IndexEntry);
     }
+    else if (status != STATUS_OBJECT_NAME_COLLISION)
+    {
+        // No memory for the index nodes - nothing was changed
+        PreviousIndexEntryWasStored = FALSE;
+        ResultIndexEntry.Reset();
+        return status;
+    }
     else
     {
         // Do an update
-        RvdAsnIndexEntry* currentEntry = _Table.Lookup(*IndexEntry);
         KAssert(currentEntry != nullptr);
         KAssert(currentEntry->_MappingEntry.RecordAsn == IndexEntry->_MappingEntry.RecordAsn);
         KAssert(currentEntry->IsIndexedByAsn());
@@ -897,7 +1637,7 @@ RvdAsnIndex::UnsafeAddOrUpdate(
 
         if (PreviousIndexEntryValue.GetDisposition() == RvdLogStream::RecordDisposition::eDispositionNone)
         {
-            UnsafeUpdateLowestLsnOfHigherASNs(*IndexEntry);
+            UnsafeUpdateLowestLsnOfHigherASNs(*currentEntry);
         }
     }
 
@@ -910,10 +1650,9 @@ RvdAsnIndex::GetLowestLsnOfHigherASNs(__in RvdLogLsn HighestKnownLsn)
     RvdAsnIndexEntry*   entry = nullptr;
     RvdLogLsn lowestLsnOfHigherASNs = RvdLogLsn::Max();
     
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        entry = _Table.First();
-        while (entry != nullptr)
+        for (RvdAsnIndexTree::Cursor position = _Tree.First(); (entry = position.Current()) != nullptr; position.MoveNext())
         {
             if (entry->GetDisposition() != RvdLogStream::RecordDisposition::eDispositionNone)
             {
@@ -922,7 +1661,6 @@ RvdAsnIndex::GetLowestLsnOfHigherASNs(__in RvdLogLsn HighestKnownLsn)
                     lowestLsnOfHigherASNs = entry->_LowestLsnOfHigherASNs;
                 }
             }
-            entry = _Table.Next(*entry);
         }
     }
 
@@ -945,10 +1683,11 @@ RvdAsnIndex::TryRemoveForDelete(
     RvdAsnIndexEntry* currentEntry = nullptr;
     RvdAsnIndexEntry* prevEntry = nullptr;
 
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        currentEntry = _Table.Lookup(*_LookupKey);
+        RvdAsnIndexTree::Cursor     position = _Tree.Find(Asn);
+
+        currentEntry = position.Current();
         if (currentEntry != nullptr)
         {
             if (ForVersion == currentEntry->_MappingEntry.RecordAsnVersion)
@@ -957,11 +1696,13 @@ RvdAsnIndex::TryRemoveForDelete(
 
                 // Exclude the _LowestLsnOfHigherASNs
                 TruncatableLsn = currentEntry->_LowestLsnOfHigherASNs.Get() - 1;
-                prevEntry = _Table.Previous(*currentEntry);
+                position.MovePrevious();
+                prevEntry = position.Current();
 
                 KInvariant(currentEntry->_Disposition == RvdLogStream::eDispositionPersisted);
                 status = STATUS_SUCCESS;
-                _Table.Remove(*currentEntry);
+                KInvariant(_Tree.Remove(Asn) == currentEntry);
+                currentEntry->_IsIndexed = FALSE;
                 UnsafeAccountForRemovedItem(currentEntry->_Disposition);
 
                 //
@@ -1003,13 +1744,14 @@ RvdAsnIndex::TryRemove(
 {
     BOOLEAN     wasRemoved = FALSE;
 
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
     {
         if (ForVersion == IndexEntry->_MappingEntry.RecordAsnVersion)
         {
             KAssert(IndexEntry->IsIndexedByAsn());
             wasRemoved = TRUE;
-            _Table.Remove(*(IndexEntry.RawPtr()));
+            KInvariant(_Tree.Remove(IndexEntry->GetAsn()) == IndexEntry.RawPtr());
+            IndexEntry->_IsIndexed = FALSE;
             UnsafeAccountForRemovedItem(IndexEntry->_Disposition);
         }
     }
@@ -1038,7 +1780,7 @@ RvdAsnIndex::Restore(
     BOOLEAN                         wasRestored = FALSE;
     RvdAsnIndexEntry::SavedState    entryBeforeRestore;
 
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
     {
         if (ForVersion == IndexEntry->_MappingEntry.RecordAsnVersion)
         {
@@ -1081,7 +1823,7 @@ RvdAsnIndex::UpdateDisposition(
     __in ULONGLONG ForVersion, 
     __in RvdLogStream::RecordDisposition NewDisposition)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
     {
         if (ForVersion == IndexEntry->_MappingEntry.RecordAsnVersion)
         {
@@ -1109,7 +1851,7 @@ RvdAsnIndex::UpdateLsnAndDisposition(
     __in RvdLogStream::RecordDisposition NewDisposition,
     __in RvdLogLsn NewLsn)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
     {
         if (ForVersion == IndexEntry->_MappingEntry.RecordAsnVersion)
         {
@@ -1146,12 +1888,19 @@ RvdAsnIndex::UnsafeUpdateLowestLsnOfHigherASNs(__in RvdAsnIndexEntry& IndexEntry
         return;
     }
 
+    RvdAsnIndexTree::Cursor     indexEntryPosition = _Tree.Find(IndexEntry.GetAsn());
+    KAssert(indexEntryPosition.Current() == &IndexEntry);
+
     // Search up in ASN space to find the next written (or being written) record
-    RvdAsnIndexEntry* VOLATILE  nextEntryInAsnOrder = _Table.Next(IndexEntry);
+    RvdAsnIndexTree::Cursor     nextPosition = indexEntryPosition;
+    nextPosition.MoveNext();
+
+    RvdAsnIndexEntry* VOLATILE  nextEntryInAsnOrder = nextPosition.Current();
     while ((nextEntryInAsnOrder != nullptr) && 
            (nextEntryInAsnOrder->GetDisposition() == RvdLogStream::RecordDisposition::eDispositionNone))
     {
-        nextEntryInAsnOrder = _Table.Next(*nextEntryInAsnOrder);
+        nextPosition.MoveNext();
+        nextEntryInAsnOrder = nextPosition.Current();
     }
 
     KAssert((nextEntryInAsnOrder == nullptr) || (nextEntryInAsnOrder->GetAsn() > IndexEntry.GetAsn()));
@@ -1170,7 +1919,10 @@ RvdAsnIndex::UnsafeUpdateLowestLsnOfHigherASNs(__in RvdAsnIndexEntry& IndexEntry
     // ASN descriptors kept in ascending ASN order. This protects records that are in lower LSN space (but higher ASN space) 
     // during truncation - see Truncate() below.
     //
-    RvdAsnIndexEntry* VOLATILE  prevEntryInAsnOrder = _Table.Previous(IndexEntry);
+    RvdAsnIndexTree::Cursor     prevPosition = indexEntryPosition;
+    prevPosition.MovePrevious();
+
+    RvdAsnIndexEntry* VOLATILE  prevEntryInAsnOrder = prevPosition.Current();
     RvdLogLsn                   indexEntry_LowestLsnOfHigherASNs = IndexEntry._LowestLsnOfHigherASNs;              
     while (prevEntryInAsnOrder != nullptr)
     {
@@ -1190,7 +1942,8 @@ RvdAsnIndex::UnsafeUpdateLowestLsnOfHigherASNs(__in RvdAsnIndexEntry& IndexEntry
             prevEntryInAsnOrder->SetLowestLsnOfHigherASNs(indexEntry_LowestLsnOfHigherASNs);
         }
 
-        prevEntryInAsnOrder = _Table.Previous(*prevEntryInAsnOrder);
+        prevPosition.MovePrevious();
+        prevEntryInAsnOrder = prevPosition.Current();
     }
 
     #undef VOLATILE
@@ -1206,11 +1959,12 @@ RvdAsnIndex::Validate()
 {
     RvdLogLsn       currentLsnOfHigherASNs(RvdLogLsn::Max());
 
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        RvdAsnIndexEntry* currentEntryInAsnOrder = _Table.Last();
+        RvdAsnIndexTree::Cursor     position = _Tree.Last();
+        RvdAsnIndexEntry*           currentEntryInAsnOrder;
 
-        while (currentEntryInAsnOrder != nullptr)
+        while ((currentEntryInAsnOrder = position.Current()) != nullptr)
         {
             if (currentEntryInAsnOrder->GetDisposition() != RvdLogStream::RecordDisposition::eDispositionNone)
             {
@@ -1229,7 +1983,7 @@ RvdAsnIndex::Validate()
                 currentLsnOfHigherASNs = currentEntryInAsnOrder->_LowestLsnOfHigherASNs;
             }
 
-            currentEntryInAsnOrder = _Table.Previous(*currentEntryInAsnOrder);
+            position.MovePrevious();
         }
     }
 
@@ -1239,46 +1993,48 @@ RvdAsnIndex::Validate()
 RvdLogLsn
 RvdAsnIndex::Truncate(RvdLogAsn UpToAsn, RvdLogLsn HighestKnownLsn)
 {
-    RvdLogLsn   truncatableLsn = RvdLogLsn::Null();
+    RvdLogLsn                       truncatableLsn = RvdLogLsn::Null();
+    RvdAsnIndexTree::DetachedRange  truncatedEntries;
+    BOOLEAN                         indexWentEmpty = FALSE;
+    RvdAsnIndexEntry*               entry;
 
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK(*this)
     {
-        RvdAsnIndexEntry* entry;
+        // The truncated entries are the lowest in the tree - detach them as a range. They are no longer
+        // reachable through the index, so they are walked and released once the lock is dropped.
+        ULONG const                 countBefore = _Tree.Count();
 
-        // Walk the ASN ordered index (list) from lower to higher ASNs truncating all entries below UpToAsn (or 
-        // full trucation)
-        while ((entry = _Table.First()) != nullptr)
-        {
-            KAssert(entry->IsIndexedByAsn());
+        _Tree.DetachUpTo(UpToAsn, truncatedEntries);
+        UnsafeAccountForRemovedItems(RvdLogStream::eDispositionPersisted, countBefore - _Tree.Count());
+        indexWentEmpty = (_Tree.Count() == 0);
+    }
 
-            if (entry->GetAsn() > UpToAsn)
-            {
-                return truncatableLsn;
-            }
+    // Walk the truncated entries from lower to higher ASNs
+    for (RvdAsnIndexTree::Cursor position = truncatedEntries.First(); (entry = position.Current()) != nullptr; position.MoveNext())
+    {
+        KAssert(entry->IsIndexedByAsn());
 
-            // BUG, richhas, xxxxx, Consider if we should allow an over truncation request.
-            // Asn is being truncated - don't allow over truncation from layers above
-            KInvariant(entry->_Disposition == RvdLogStream::eDispositionPersisted);
+        // BUG, richhas, xxxxx, Consider if we should allow an over truncation request.
+        // Asn is being truncated - don't allow over truncation from layers above
+        KInvariant(entry->_Disposition == RvdLogStream::eDispositionPersisted);
 
-            // _LowestLsnOfHigherASNs must not decrease in ASN space
-            KAssert(!entry->_LowestLsnOfHigherASNs.IsNull());
-            KAssert(entry->_LowestLsnOfHigherASNs.Get() >= truncatableLsn.Get());
+        // _LowestLsnOfHigherASNs must not decrease in ASN space
+        KAssert(!entry->_LowestLsnOfHigherASNs.IsNull());
+        KAssert(entry->_LowestLsnOfHigherASNs.Get() >= truncatableLsn.Get());
 
-            // Exclude the _LowestLsnOfHigherASNs
-            truncatableLsn = entry->_LowestLsnOfHigherASNs.Get() - 1;
+        // Exclude the _LowestLsnOfHigherASNs
+        truncatableLsn = entry->_LowestLsnOfHigherASNs.Get() - 1;
 
-            _Table.Remove(*entry);
-            UnsafeAccountForRemovedItem(entry->_Disposition);
-            entry->Release();                   // Reverse the #1 AddRef in AddOrUpdate() above
-        }
+        entry->_IsIndexed = FALSE;
+        entry->Release();                       // Reverse the #1 AddRef in AddOrUpdate() above
+    }
 
-        // We have an empty index - return the caller's HighestKnownLsn if that
-        // is beyond the last records LSN's _LowestLsnOfHigherASNs. Covers an out
-        // of order (in LSN space) at the end of a stream.
-        if (HighestKnownLsn > truncatableLsn)
-        {
-            return HighestKnownLsn;
-        }
+    // If the index went empty return the caller's HighestKnownLsn if that is beyond
+    // the last records LSN's _LowestLsnOfHigherASNs. Covers an out of order (in LSN
+    // space) at the end of a stream.
+    if (indexWentEmpty && (HighestKnownLsn > truncatableLsn))
+    {
+        truncatableLsn = HighestKnownLsn;
     }
 
     return truncatableLsn;
@@ -1326,13 +2082,13 @@ RvdAsnIndex::GetAllEntriesIntoIoBuffer(
 
     ULONG           countOfTableItems = 0;
 
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
         // Compute the total size needed in IoBuffer to hold all of this instance's 
         // Lsn records plus any data represented by the passed *IoBufferOffset value.
         KAssert((_CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPending] + 
                  _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionNone] + 
-                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Table.Count());
+                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Tree.Count());
 
         // NOTE: Both Pending and Persisted records are included here because of the way in which physical writes are
         //       ordered by the StreamWrite pipeline. Records that are pending are in the process of being written and only
@@ -1402,7 +2158,8 @@ RvdAsnIndex::GetAllEntriesIntoIoBuffer(
         // Move items into IoBuffer
         if (countOfTableItems > 0)
         {
-            RvdAsnIndexEntry*       currentBlkPtr = _Table.First();
+            RvdAsnIndexTree::Cursor position = _Tree.First();
+            RvdAsnIndexEntry*       currentBlkPtr = position.Current();
             KIoBufferStream         ioBufferStream(IoBuffer, startingOffset);
             ULONG                   currentSegmentRemainingSpace = spaceNeededIn1stSegment;
 
@@ -1411,7 +2168,8 @@ RvdAsnIndex::GetAllEntriesIntoIoBuffer(
             {
                 while ((currentBlkPtr != nullptr) && !UnsafeIsAllocatedLsnDisposition(currentBlkPtr->_Disposition))
                 {
-                    currentBlkPtr = _Table.Next(*currentBlkPtr);
+                    position.MoveNext();
+                    currentBlkPtr = position.Current();
                 }
                 KInvariant(currentBlkPtr != nullptr);
 
@@ -1440,7 +2198,8 @@ RvdAsnIndex::GetAllEntriesIntoIoBuffer(
                             (countOfTableItems * sizeof(AsnLsnMappingEntry)));
                     }
 
-                    currentBlkPtr = _Table.Next(*currentBlkPtr);
+                    position.MoveNext();
+                    currentBlkPtr = position.Current();
                     KInvariant(currentBlkPtr != nullptr);
                 }
                 else break;
@@ -1458,12 +2217,12 @@ RvdAsnIndex::GetEntries(
     __in RvdLogAsn HighestAsn,
     __in KArray<RvdLogStream::RecordMetadata>& ResultsArray)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(LowestAsn);
-        RvdAsnIndexEntry* currentEntry = _Table.LookupEqualOrNext(*_LookupKey);
+        RvdAsnIndexTree::Cursor position = _Tree.FindEqualOrNext(LowestAsn);
+        RvdAsnIndexEntry*       currentEntry;
 
-        while ((currentEntry != nullptr) && (currentEntry->GetAsn() <= HighestAsn))
+        while (((currentEntry = position.Current()) != nullptr) && (currentEntry->GetAsn() <= HighestAsn))
         {
             RvdLogStream::RecordMetadata    item;
             item.Asn = currentEntry->GetAsn();
@@ -1478,7 +2237,7 @@ RvdAsnIndex::GetEntries(
                 return status;
             }
 
-            currentEntry = _Table.Next(*currentEntry);
+            position.MoveNext();
         }
     }
 
@@ -1488,9 +2247,9 @@ RvdAsnIndex::GetEntries(
 VOID
 RvdAsnIndex::GetAsnRange(__out RvdLogAsn& LowestAsn, __out RvdLogAsn& HighestAsn, __in RvdLogAsn& HighestAsnObserved)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        ULONG count = _Table.Count();
+        ULONG count = _Tree.Count();
         if (count == 0)
         {
             LowestAsn = HighestAsnObserved;
@@ -1498,8 +2257,8 @@ RvdAsnIndex::GetAsnRange(__out RvdLogAsn& LowestAsn, __out RvdLogAsn& HighestAsn
             return;
         }
 
-        LowestAsn = _Table.First()->GetAsn();
-        HighestAsn = _Table.Last()->GetAsn();
+        LowestAsn = _Tree.First().Current()->GetAsn();
+        HighestAsn = _Tree.Last().Current()->GetAsn();
     }
 }
 
@@ -1511,10 +2270,9 @@ RvdAsnIndex::GetAsnInformation(
     __out RvdLogLsn&                        CurrentLsn,
     __out ULONG&                            IoBufferSizeHint)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry* currentEntry = _Table.Lookup(*_LookupKey);
+        RvdAsnIndexEntry* currentEntry = _Tree.Find(Asn).Current();
         if (currentEntry != nullptr)
         {
             Version = currentEntry->GetVersion();
@@ -1539,13 +2297,13 @@ RvdAsnIndex::GetNextAsnInformation(
     __out RvdLogLsn&                        CurrentLsn,
     __out ULONG&                            IoBufferSizeHint)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry::SPtr currentEntry = _Table.Lookup(*_LookupKey);
-        if (currentEntry != nullptr)
+        RvdAsnIndexTree::Cursor position = _Tree.Find(Asn);
+        if (position.Current() != nullptr)
         {
-            currentEntry = UnsafeNext(currentEntry);
+            position.MoveNext();
+            RvdAsnIndexEntry* currentEntry = position.Current();
             if (currentEntry != nullptr)
             {
                 Asn = currentEntry->GetAsn();
@@ -1572,13 +2330,13 @@ RvdAsnIndex::GetNextAsnInformationFromNearest(
     __out RvdLogLsn&                        CurrentLsn,
     __out ULONG&                            IoBufferSizeHint)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry::SPtr currentEntry = _Table.LookupEqualOrPrevious(*_LookupKey);
-        if (currentEntry != nullptr)
+        RvdAsnIndexTree::Cursor position = _Tree.FindEqualOrPrevious(Asn);
+        if (position.Current() != nullptr)
         {
-            currentEntry = UnsafeNext(currentEntry);
+            position.MoveNext();
+            RvdAsnIndexEntry* currentEntry = position.Current();
             if (currentEntry != nullptr)
             {
                 Asn = currentEntry->GetAsn();
@@ -1605,15 +2363,16 @@ RvdAsnIndex::GetNextFromSpecificAsnInformation(
     __out RvdLogLsn&                        CurrentLsn,
     __out ULONG&                            IoBufferSizeHint)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry::SPtr currentEntry = _Table.LookupEqualOrNext(*_LookupKey);
+        RvdAsnIndexTree::Cursor position = _Tree.FindEqualOrNext(Asn);
+        RvdAsnIndexEntry*       currentEntry = position.Current();
         if (currentEntry != nullptr)
         {
             if (currentEntry->GetAsn() == Asn)
             {
-                currentEntry = UnsafeNext(currentEntry);
+                position.MoveNext();
+                currentEntry = position.Current();
             }
 
             if (currentEntry != nullptr)
@@ -1643,13 +2402,13 @@ RvdAsnIndex::GetPreviousAsnInformation(
     __out RvdLogLsn&                        CurrentLsn,
     __out ULONG&                            IoBufferSizeHint)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry::SPtr currentEntry = _Table.Lookup(*_LookupKey);
-        if (currentEntry != nullptr)
+        RvdAsnIndexTree::Cursor position = _Tree.Find(Asn);
+        if (position.Current() != nullptr)
         {
-            currentEntry = UnsafePrev(currentEntry);
+            position.MovePrevious();
+            RvdAsnIndexEntry* currentEntry = position.Current();
             if (currentEntry != nullptr)
             {           
                 Asn = currentEntry->GetAsn();
@@ -1676,13 +2435,13 @@ RvdAsnIndex::GetPreviousAsnInformationFromNearest(
     __out RvdLogLsn&                        CurrentLsn,
     __out ULONG&                            IoBufferSizeHint)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry::SPtr currentEntry = _Table.LookupEqualOrNext(*_LookupKey);
-        if (currentEntry != nullptr)
+        RvdAsnIndexTree::Cursor position = _Tree.FindEqualOrNext(Asn);
+        if (position.Current() != nullptr)
         {
-            currentEntry = UnsafePrev(currentEntry);
+            position.MovePrevious();
+            RvdAsnIndexEntry* currentEntry = position.Current();
             if (currentEntry != nullptr)
             {           
                 Asn = currentEntry->GetAsn();
@@ -1709,15 +2468,16 @@ RvdAsnIndex::GetPreviousFromSpecificAsnInformation(
     __out RvdLogLsn&                        CurrentLsn,
     __out ULONG&                            IoBufferSizeHint)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry::SPtr currentEntry = _Table.LookupEqualOrPrevious(*_LookupKey);
+        RvdAsnIndexTree::Cursor position = _Tree.FindEqualOrPrevious(Asn);
+        RvdAsnIndexEntry*       currentEntry = position.Current();
         if (currentEntry != nullptr)
         {
             if (currentEntry->GetAsn() == Asn)
             {
-                currentEntry = UnsafePrev(currentEntry);
+                position.MovePrevious();
+                currentEntry = position.Current();
             }
 
             if (currentEntry != nullptr)
@@ -1747,10 +2507,9 @@ RvdAsnIndex::GetContainingAsnInformation(
     __out RvdLogLsn&                        CurrentLsn,
     __out ULONG&                            IoBufferSizeHint)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry* currentEntry = _Table.LookupEqualOrPrevious(*_LookupKey);
+        RvdAsnIndexEntry* currentEntry = _Tree.FindEqualOrPrevious(Asn).Current();
         if (currentEntry != nullptr)
         {
             Asn = currentEntry->GetAsn();
@@ -1773,17 +2532,17 @@ RvdAsnIndex::CheckForRecordsWithHigherVersion(
     __in RvdLogAsn Asn,
     __in ULONGLONG Version)
 {
-    K_LOCK_BLOCK(_ThisLock)
+    RVD_ASN_INDEX_SHARED_LOCK_BLOCK(*this)
     {
-        _LookupKey->SetAsn(Asn);
-        RvdAsnIndexEntry::SPtr currentEntry = _Table.LookupEqualOrPrevious(*_LookupKey);
-        while (currentEntry != nullptr)
+        RvdAsnIndexTree::Cursor position = _Tree.FindEqualOrPrevious(Asn);
+        RvdAsnIndexEntry*       currentEntry;
+        while ((currentEntry = position.Current()) != nullptr)
         {
             if (currentEntry->GetVersion() > Version)
             {
                 return(TRUE);
             }
-            currentEntry = UnsafePrev(currentEntry);
+            position.MovePrevious();
         }
     }
 
@@ -1793,28 +2552,40 @@ RvdAsnIndex::CheckForRecordsWithHigherVersion(
 RvdAsnIndexEntry::SPtr
 RvdAsnIndex::UnsafeFirst()
 {
-    RvdAsnIndexEntry::SPtr result = _Table.First();
+    RvdAsnIndexEntry::SPtr result = _Tree.First().Current();
     return result;
 }
 
 RvdAsnIndexEntry::SPtr
 RvdAsnIndex::UnsafeLast()
 {
-    RvdAsnIndexEntry::SPtr result = _Table.Last();
+    RvdAsnIndexEntry::SPtr result = _Tree.Last().Current();
     return result;
 }
 
 RvdAsnIndexEntry::SPtr
 RvdAsnIndex::UnsafeNext(__in RvdAsnIndexEntry::SPtr& Current)
 {
-    RvdAsnIndexEntry::SPtr result = _Table.Next(*Current);
+    RvdAsnIndexTree::Cursor position = _Tree.FindEqualOrNext(Current->GetAsn());
+    if (position.Current() == Current.RawPtr())
+    {
+        position.MoveNext();
+    }
+
+    RvdAsnIndexEntry::SPtr result = position.Current();
     return result;
 }
 
 RvdAsnIndexEntry::SPtr
 RvdAsnIndex::UnsafePrev(__in RvdAsnIndexEntry::SPtr& Current)
 {
-    RvdAsnIndexEntry::SPtr result = _Table.Previous(*Current);
+    RvdAsnIndexTree::Cursor position = _Tree.FindEqualOrPrevious(Current->GetAsn());
+    if (position.Current() == Current.RawPtr())
+    {
+        position.MovePrevious();
+    }
+
+    RvdAsnIndexEntry::SPtr result = position.Current();
     return result;
 }
 
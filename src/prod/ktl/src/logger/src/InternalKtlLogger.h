@@ -1499,6 +1499,7 @@ private:
     {
         static const ULONG          _NumberOfEntriesPerBlock = 1024;
         KListEntry                  _BlockLinks;
+        ULONGLONG                   _TotalSize;             // Of the entries in use; lets Truncate() drop whole blocks
         RvdLogLsnEntry              _Entries[_NumberOfEntriesPerBlock];
     };
     // BUG, richhas, xxxxxx, Consider constraining _NumberOfEntriesPerBlock so that sizeof(RvdLogLsnEntryBlock) is
@@ -1521,16 +1522,21 @@ private:
 
     __inline VOID
     UnsafeAddRecord(
-        __in RvdLogLsnEntry& Entry,
+        __in RvdLogLsnEntryBlock& Block,
+        __in ULONG EntryIx,
         __in RvdLogLsn Lsn,
         __in ULONG HeaderAndMetaDataSize,
         __in ULONG IoBufferSize)
     {
-        Entry.Lsn = Lsn;
-        Entry.IoBufferSize = IoBufferSize;
-        Entry.HeaderAndMetaDataSize = HeaderAndMetaDataSize;
+        RvdLogLsnEntry& entry = Block._Entries[EntryIx];
+        ULONG const     recordSize = ComputeTotalRecordSizeOnDisk(HeaderAndMetaDataSize, IoBufferSize);
+
+        entry.Lsn = Lsn;
+        entry.IoBufferSize = IoBufferSize;
+        entry.HeaderAndMetaDataSize = HeaderAndMetaDataSize;
         _NumberOfEntires++;
-        _TotalSize += ComputeTotalRecordSizeOnDisk(HeaderAndMetaDataSize, IoBufferSize);
+        _TotalSize += recordSize;
+        Block._TotalSize += recordSize;
     }
 
     NTSTATUS
@@ -1556,9 +1562,6 @@ class RvdAsnIndexEntry : public KShared<RvdAsnIndexEntry>
     K_FORCE_SHARED(RvdAsnIndexEntry);
 
 public:
-    static LONG
-    Comparator(__in RvdAsnIndexEntry& Left, __in RvdAsnIndexEntry& Right);
-
     static ULONG
     GetLinksOffset();
 
@@ -1577,7 +1580,7 @@ public:
                                 GetDisposition()    { return _Disposition; }
     __inline ULONG              GetIoBufferSizeHint()
                                                     { return _MappingEntry.IoBufferSizeHint; }
-    __inline BOOLEAN            IsIndexedByAsn()    { return _AsnIndexEntryLinks.IsInserted(); }
+    __inline BOOLEAN            IsIndexedByAsn()    { return _IsIndexed; }
     __inline VOID               SetLowestLsnOfHigherASNs(__in RvdLogLsn Value)   { _LowestLsnOfHigherASNs = Value; }
     __inline RvdLogLsn          GetLowestLsnOfHigherASNs()                  { return _LowestLsnOfHigherASNs; }
 
@@ -1622,8 +1625,6 @@ public:
 private:
     friend class RvdAsnIndex;
 
-    __inline VOID SetAsn(__in RvdLogAsn Asn)            { _MappingEntry.RecordAsn = Asn; }
-
     VOID
     Save(__out SavedState& To);
 
@@ -1631,12 +1632,187 @@ private:
     Restore(__in SavedState& From);
 
 private:
-    KTableEntry                     _AsnIndexEntryLinks;
+    KListEntry                      _ReleaseLinks;          // Collects entries removed from an RvdAsnIndex
+    BOOLEAN                         _IsIndexed;
     RvdLogStream::RecordDisposition _Disposition;
     AsnLsnMappingEntry              _MappingEntry;
     RvdLogLsn                       _LowestLsnOfHigherASNs;
 };
 
+//** RvdAsnIndexTree
+//
+//  B+tree of RvdAsnIndexEntry pointers keyed by ASN. Keys are kept inline in each node so that a lookup
+//  touches a few contiguous key arrays instead of one RvdAsnIndexEntry per comparison, and leaves are
+//  doubly linked so that ordered scans walk arrays of entries. Nodes that empty are freed; underfull
+//  nodes are not merged.
+//
+//  The tree is not synchronized and holds no references on its entries - RvdAsnIndex provides both.
+//
+class RvdAsnIndexTree
+{
+    K_DENY_COPY(RvdAsnIndexTree);
+
+public:
+    static const ULONG          _EntriesPerNode = 64;
+
+private:
+    static const ULONG          _MaxDepth = 16;
+
+    struct Node
+    {
+        BOOLEAN                 _IsLeaf;
+        ULONG                   _Count;
+        ULONGLONG               _Keys[_EntriesPerNode];     // Lowest ASN of each entry or child
+    };
+
+    struct Leaf : public Node
+    {
+        RvdAsnIndexEntry*       _Entries[_EntriesPerNode];
+        Leaf*                   _Next;
+        Leaf*                   _Prev;
+    };
+
+    struct Interior : public Node
+    {
+        Node*                   _Children[_EntriesPerNode];
+    };
+
+public:
+    //* Position of an entry within the tree. A Cursor is invalidated by any change to the tree.
+    class Cursor
+    {
+    public:
+        Cursor() : _Leaf(nullptr), _Ix(0) {}
+
+        __inline RvdAsnIndexEntry*
+        Current()
+        {
+            return (_Leaf == nullptr) ? nullptr : _Leaf->_Entries[_Ix];
+        }
+
+        VOID
+        MoveNext();
+
+        VOID
+        MovePrevious();
+
+    private:
+        friend class RvdAsnIndexTree;
+
+        Leaf*                   _Leaf;
+        ULONG                   _Ix;
+    };
+
+    //* Entries detached from the tree by DetachUpTo, walked in ASN order from First(). The leaves that held
+    //  them are freed with the DetachedRange; neither touches the tree.
+    class DetachedRange
+    {
+        K_DENY_COPY(DetachedRange);
+
+    public:
+        DetachedRange();
+        ~DetachedRange();
+
+        Cursor
+        First();
+
+    private:
+        friend class RvdAsnIndexTree;
+
+        Leaf*                   _FirstLeaf;     // Whole leaves unlinked from the tree; the last one links to _Partial
+        Leaf*                   _LastLeaf;
+        Leaf                    _Partial;       // Entries taken from the front of the first leaf left in the tree
+    };
+
+    RvdAsnIndexTree(__in KAllocator& Allocator);
+    ~RvdAsnIndexTree();
+
+    __inline ULONG
+    Count()
+    {
+        return _Count;
+    }
+
+    //* Add Entry under its ASN. Any nodes needed for the insertion are allocated before the tree is changed.
+    //
+    //  Returns:
+    //      STATUS_SUCCESS                  - Entry was added
+    //      STATUS_OBJECT_NAME_COLLISION    - An entry with the same ASN exists; it is returned in Existing
+    //      STATUS_INSUFFICIENT_RESOURCES   - The tree is unchanged
+    //
+    NTSTATUS
+    Insert(__in RvdAsnIndexEntry& Entry, __out RvdAsnIndexEntry*& Existing);
+
+    //* Remove and return the entry for Asn; nullptr if there is none
+    RvdAsnIndexEntry*
+    Remove(__in RvdLogAsn Asn);
+
+    //* Move all entries with an ASN of UpToAsn or lower into an empty Range. Whole leaves are unlinked
+    //  without visiting their entries and nothing is allocated.
+    VOID
+    DetachUpTo(__in RvdLogAsn UpToAsn, __inout DetachedRange& Range);
+
+    //* Take all entries of an empty tree from Src; Src is left empty
+    VOID
+    TakeContents(__inout RvdAsnIndexTree& Src);
+
+    //* Free all nodes; the entries are not touched
+    VOID
+    Clear();
+
+    Cursor
+    First();
+
+    Cursor
+    Last();
+
+    Cursor
+    Find(__in RvdLogAsn Asn);
+
+    Cursor
+    FindEqualOrNext(__in RvdLogAsn Asn);
+
+    Cursor
+    FindEqualOrPrevious(__in RvdLogAsn Asn);
+
+private:
+    Leaf*
+    AllocateLeaf();
+
+    Interior*
+    AllocateInterior();
+
+    VOID
+    FreeSubtree(__in Node* Subtree);
+
+    Leaf*
+    FindLeaf(__in ULONGLONG Key, __out_ecount(_MaxDepth) Interior** Path, __out_ecount(_MaxDepth) ULONG* PathIx, __out ULONG& Depth);
+
+    // Unlinks Target from the leaf list and from its parents; Target itself is not freed
+    VOID
+    UnlinkLeaf(__in Leaf& Target, __in_ecount(Depth) Interior** Path, __in_ecount(Depth) ULONG* PathIx, __in ULONG Depth);
+
+    static VOID
+    InsertIntoLeaf(__in Leaf& Target, __in ULONG Ix, __in RvdAsnIndexEntry& Entry);
+
+    static VOID
+    InsertIntoInterior(__in Interior& Target, __in ULONG Ix, __in Node& Child);
+
+    // First index at or above Start whose key is >= (LowerBound) or > (UpperBound) Key; Target._Count if none
+    static ULONG
+    LowerBound(__in Node& Target, __in ULONG Start, __in ULONGLONG Key);
+
+    static ULONG
+    UpperBound(__in Node& Target, __in ULONG Start, __in ULONGLONG Key);
+
+private:
+    KAllocator&                 _Allocator;
+    Node*                       _Root;
+    Leaf*                       _FirstLeaf;
+    Leaf*                       _LastLeaf;
+    ULONG                       _Count;
+};
+
 class RvdAsnIndex : public KObject<RvdAsnIndex>
 {
 public:
@@ -1698,7 +1874,7 @@ public:
         GetLowestLsnOfHigherASNs(__in RvdLogLsn HighestKnownLsn);
 
     //*
-    // Remove IndexEntry from _Table iif ForVersion matches IndexEntry current version
+    // Remove IndexEntry from the index iif ForVersion matches IndexEntry current version
     //
     void
         TryRemove(
@@ -1706,7 +1882,7 @@ public:
         __in ULONGLONG ForVersion);
 
     //*
-    // Remove IndexEntry from _Table iif ForVersion matches IndexEntry current version
+    // Remove IndexEntry from the index iif ForVersion matches IndexEntry current version
     //
     NTSTATUS
         TryRemoveForDelete(
@@ -1877,7 +2053,7 @@ public:
     ULONG _inline
     GetNumberOfEntries()
     {
-        return _Table.Count();
+        return _Tree.Count();
     }
 
     NTSTATUS
@@ -1912,7 +2088,7 @@ private:
         _CountsOfDispositions[Disposition]++;
         KAssert((_CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPending] +
                  _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionNone] +
-                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Table.Count());
+                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Tree.Count());
     }
 
     _inline VOID
@@ -1921,7 +2097,16 @@ private:
         _CountsOfDispositions[Disposition]--;
         KAssert((_CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPending] +
                  _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionNone] +
-                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Table.Count());
+                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Tree.Count());
+    }
+
+    _inline VOID
+    UnsafeAccountForRemovedItems(__in RvdLogStream::RecordDisposition Disposition, __in ULONG NumberOfItems)
+    {
+        _CountsOfDispositions[Disposition] -= NumberOfItems;
+        KAssert((_CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPending] +
+                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionNone] +
+                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Tree.Count());
     }
 
     _inline VOID
@@ -1933,7 +2118,7 @@ private:
         _CountsOfDispositions[NewDisposition]++;
         KAssert((_CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPending] +
                  _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionNone] +
-                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Table.Count());
+                 _CountsOfDispositions[RvdLogStream::RecordDisposition::eDispositionPersisted]) == _Tree.Count());
     }
 
     static _inline BOOLEAN
@@ -1944,9 +2129,79 @@ private:
     }
 
 private:
+    //* Holds _ThisLock for the scope of a RVD_ASN_INDEX_SHARED_LOCK_BLOCK or RVD_ASN_INDEX_EXCLUSIVE_LOCK_BLOCK.
+    //  In user mode _ThisLock is a reader/writer lock so that lookups do not serialize behind each other;
+    //  kernel builds keep a spin lock and take it exclusively for both.
+    class InStackLock
+    {
+        K_DENY_COPY(InStackLock);
+
+    public:
+        InStackLock(__in RvdAsnIndex& Index, __in BOOLEAN Shared)
+            :   _Index(Index),
+                _Shared(Shared),
+                _HasLock(TRUE)
+        {
+        #if KTL_USER_MODE
+            if (_Shared)
+            {
+                _Index._ThisLock.AcquireShared();
+            }
+            else
+            {
+                _Index._ThisLock.AcquireExclusive();
+            }
+        #else
+            _Index._ThisLock.Acquire();
+        #endif
+        }
+
+        ~InStackLock()
+        {
+            if (_HasLock)
+            {
+                ReleaseLock();
+            }
+        }
+
+        __inline BOOLEAN
+        HasLock()
+        {
+            return _HasLock;
+        }
+
+        VOID
+        ReleaseLock()
+        {
+            KAssert(_HasLock);
+            _HasLock = FALSE;
+
+        #if KTL_USER_MODE
+            if (_Shared)
+            {
+                _Index._ThisLock.ReleaseShared();
+            }
+            else
+            {
+                _Index._ThisLock.ReleaseExclusive();
+            }
+        #else
+            _Index._ThisLock.Release();
+        #endif
+        }
+
+    private:
+        RvdAsnIndex&                _Index;
+        BOOLEAN const               _Shared;
+        BOOLEAN                     _HasLock;
+    };
+
+#if KTL_USER_MODE
+    KReaderWriterSpinLock           _ThisLock;
+#else
     KSpinLock                       _ThisLock;
-    KNodeTable<RvdAsnIndexEntry>    _Table;
-    RvdAsnIndexEntry::SPtr          _LookupKey;
+#endif
+    RvdAsnIndexTree                 _Tree;
 
 
 
@@ -2801,6 +3056,44 @@ private:
     VOID
     ResumeIncomingStreamWriteDequeuing();
 
+    // Stream write gathering support: user record writes that are adjacent in the log file are
+    // held back while more stream write ops are queued and then issued as a single scatter/gather
+    // write. Only called while dispatched thru IncomingStreamWriteDequeueCallback().
+    //
+    //* Scatter/gather write of a set of gathered user record writes
+    class GatheredStreamWrite : public KShared<GatheredStreamWrite>, public KObject<GatheredStreamWrite>
+    {
+        K_FORCE_SHARED(GatheredStreamWrite);
+
+    public:
+        static NTSTATUS
+        Create(__in RvdOnDiskLog& Log, __out GatheredStreamWrite::SPtr& Result);
+
+    private:
+        friend class RvdOnDiskLog;
+
+        VOID
+        WriteCompletion(__in_opt KAsyncContextBase* const Parent, __in KAsyncContextBase& CompletingSubOp);
+
+    private:
+        RvdOnDiskLog::SPtr                              _Log;
+        KIoBuffer::SPtr                                 _IoBuffer;
+        KAsyncContextBase::SPtr                         _WriteOp;
+        KNodeList<RvdLogStreamImp::AsyncWriteStream>    _WriteOps;
+    };
+
+    BOOLEAN
+    GatherStreamWrite(__in RvdLogStreamImp::AsyncWriteStream& WriteOp, __in ULONGLONG FileOffset);
+
+    VOID
+    FlushGatheredStreamWrites();
+
+    VOID
+    IssueStreamWrite(__in RvdLogStreamImp::AsyncWriteStream& WriteOp, __in ULONGLONG FileOffset);
+
+    VOID
+    GatheredStreamWriteCompletion(__in GatheredStreamWrite& GatheredWrite, __in NTSTATUS Status);
+
     NTSTATUS
     EnqueueCompletedStreamWriteOp(__in RvdLogStreamImp::AsyncWriteStream& WriteOpToEnqueue);
 
@@ -2889,7 +3182,18 @@ private:
         __declspec(align(8)) ULONGLONG      _LogFileReservedSpace;      // Current reserve (against free space) in the LOG
         __declspec(align(8)) RvdLogLsn      _LowestLsn;                 // All physical space mapped below this may be reclaimed
         __declspec(align(8)) RvdLogLsn      _NextLsnToWrite;            // aka HighestLsn; active space = [_LowestLsn, _NextLsnToWrite)
+        __declspec(align(8)) RvdLogLsn      _TrimmedToLsn;              // Sparse file space mapped below this has been trimmed;
+                                                                        // Null if unknown since the log was opened
                              LONG volatile  _IncomingStreamWriteOpQueueRefCount;    // FALSE or > FALSE
+        KNodeList<RvdLogStreamImp::AsyncWriteStream>
+                                            _GatheredStreamWrites;      // Adjacent user record writes not yet issued
+        ULONGLONG                           _GatheredStreamWriteFileOffset;
+        ULONG                               _GatheredStreamWriteSize;
+        ULONGLONG                           _GatheredStreamWriteStartTicks;
+
+    static ULONG const                      _MaxGatheredStreamWriteSize = 1024 * 1024;
+    static ULONG const                      _MaxGatheredStreamWrites = 64;
+    static ULONGLONG const                  _MaxGatheredStreamWriteDelayInMs = 2;
 
     KSharedPtr<AsyncWriteStreamQueue::DequeueOperation> _IncomingStreamWriteDequeueOp;
 
@@ -2908,6 +3212,11 @@ public:
     BOOLEAN                                 _DebugDisableTruncateCheckpointing;
     BOOLEAN                                 _DebugDisableAssertOnLogFull;
     BOOLEAN                                 _DebugDisableHighestCompletedLsnUpdates;
+    ULONGLONG                               _StreamWritesGathered;          // User record writes issued as part of a
+    ULONGLONG                               _GatheredStreamWriteIoCount;    // gathered write - and those writes
+    ULONGLONG                               _TruncationTrims;               // Truncations that trimmed sparse file space
+    ULONGLONG                               _FullTruncationTrims;           // - of those, the ones that trimmed all free space
+    ULONGLONG                               _TruncationTrimmedBytes;        // - and the file bytes they trimmed
 };
 
 
@@ -3173,6 +3482,9 @@ private:
     VOID
     LogFileWriteCompletion(__in_opt KAsyncContextBase* const Parent, __in KAsyncContextBase& CompletingSubOp);
 
+    VOID
+    GatheredWriteCompletion(__in NTSTATUS Status);
+
     NTSTATUS
     ContinueRecordWriteCompletion();
 
@@ -3286,6 +3598,7 @@ private:
 
 private:
     KListEntry                              _WriteQueueLinks;
+    KListEntry                              _GatherLinks;           // Used by the log while this write is gathered
 
     KInstrumentedOperation                  _InstrumentedOperation;
     
@@ -492,6 +492,7 @@ RvdLogManagerImp::RvdOnDiskLog::AsyncCreateLog::TrailerWriteComplete(
     _Owner->_LowestLsn = RvdLogLsn::Min();
     _Owner->_NextLsnToWrite = RvdLogLsn::Min();
     _Owner->_HighestCompletedLsn = RvdLogLsn::Null();
+    _Owner->_TrimmedToLsn = RvdLogLsn::Null();
 
     // Create the dedicated checkpoint stream
     RvdLogStreamImp::SPtr       resultStream;
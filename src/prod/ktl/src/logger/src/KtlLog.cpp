@@ -45,12 +45,21 @@ RvdLogManagerImp::RvdOnDiskLog::RvdOnDiskLog(
         _LastUsedLogStreamInfoIx(0),
         _CountOfOutstandingWrites(0),
         _IncomingStreamWriteOpQueueRefCount(FALSE),
+        _GatheredStreamWrites(FIELD_OFFSET(RvdLogStreamImp::AsyncWriteStream, _GatherLinks)),
+        _GatheredStreamWriteFileOffset(0),
+        _GatheredStreamWriteSize(0),
+        _GatheredStreamWriteStartTicks(0),
         _CompletingStreamWriteLsnOrderedGateDispatched(FALSE),
         _DebugDisableAutoCheckpointing(FALSE),
         _DebugDisableTruncateCheckpointing(FALSE),
         _DebugDisableAssertOnLogFull(TRUE),
         _FullyQualifiedLogName(FullyQualifiedLogName),
         _DebugDisableHighestCompletedLsnUpdates(FALSE),
+        _StreamWritesGathered(0),
+        _GatheredStreamWriteIoCount(0),
+        _TruncationTrims(0),
+        _FullTruncationTrims(0),
+        _TruncationTrimmedBytes(0),
         _LogStreamInfoArray(GetThisAllocator(), 0),
         _ShutdownEvent(nullptr)
 {
@@ -652,6 +661,10 @@ RvdLogManagerImp::RvdOnDiskLog::PopulateLogState(__in LogState::SPtr& State)
         _LowestLsn = State->_LowestLsn;
         _NextLsnToWrite = State->_NextLsnToWrite;
         _HighestCompletedLsn = State->_HighestCompletedLsn;
+
+        // What was trimmed before the log was closed is not known and so
+        // the first trim covers all of the free space
+        _TrimmedToLsn = RvdLogLsn::Null();
         _CompletingStreamWriteLsnOrderedGate->SetNextOrderedItemValue(_NextLsnToWrite);
         KMemCpySafe(&_LogType, sizeof(_LogType), &State->_LogType, RvdLogManager::AsyncCreateLog::MaxLogTypeLength*sizeof(CHAR));
 
@@ -739,7 +752,63 @@ RvdLogManagerImp::RvdOnDiskLog::ComputeUnusedFileRanges(
         lowestLsn = nextLsnToWrite - minimumKeepSize;
         KDbgCheckpointWDataInformational(_LogId.Get().Data1, "Trim minkeep", STATUS_SUCCESS, _LowestLsn.Get(), _NextLsnToWrite.Get(), minimumKeepSize, lowestLsn);
     }
-    
+
+    if (! _TrimmedToLsn.IsNull())
+    {
+        //
+        // The free space maps the LSN-space [_NextLsnToWrite - _LogFileLsnSpace, lowestLsn)
+        // written in the previous lap of the file. The part of it below
+        // _TrimmedToLsn was trimmed by an earlier truncation and has not been
+        // written since, so only the space freed after that needs trimming.
+        // This keeps each trim in proportion to what was truncated instead
+        // of to all of the free space in the log.
+        //
+        ULONGLONG trimFromLsn = _TrimmedToLsn.Get();
+
+        if ((nextLsnToWrite > _LogFileLsnSpace) && ((nextLsnToWrite - _LogFileLsnSpace) > trimFromLsn))
+        {
+            trimFromLsn = nextLsnToWrite - _LogFileLsnSpace;
+        }
+
+        FromRange1 = 0;
+        ToRange1 = 0;
+        FromRange2 = 0;
+        ToRange2 = 0;
+
+        if (lowestLsn > trimFromLsn)
+        {
+            startOffset = ToFileAddress(trimFromLsn);
+            endOffset = ToFileAddress(lowestLsn - 1) + 1;
+
+            if (startOffset < endOffset)
+            {
+                FromRange1 = startOffset;
+                ToRange1 = endOffset;
+            }
+            else
+            {
+                //
+                // Freed space wraps around the end of the log
+                //
+                FromRange1 = startOffset;
+                ToRange1 = ToFileAddress(_LogFileLsnSpace - 1) + 1;
+
+                FromRange2 = ToFileAddress(0);
+                ToRange2 = endOffset;
+            }
+
+            _TrimmedToLsn = lowestLsn;
+        }
+
+        _TruncationTrims++;
+        _TruncationTrimmedBytes += (ToRange1 - FromRange1) + (ToRange2 - FromRange2);
+
+        KDbgCheckpointWDataInformational(_LogId.Get().Data1, "Trim increm ", STATUS_SUCCESS, trimFromLsn, _NextLsnToWrite.Get(), lowestLsn, 0);
+        KDbgCheckpointWDataInformational(_LogId.Get().Data1, "Trim offsets", STATUS_SUCCESS, FromRange1, ToRange1, FromRange2, ToRange2);
+        return;
+    }
+
+    _TrimmedToLsn = lowestLsn;
 
     //
     // Convert to file addresses
@@ -803,6 +872,10 @@ RvdLogManagerImp::RvdOnDiskLog::ComputeUnusedFileRanges(
         i = 3;
     }
 
+    _TruncationTrims++;
+    _FullTruncationTrims++;
+    _TruncationTrimmedBytes += (ToRange1 - FromRange1) + (ToRange2 - FromRange2);
+
     KDbgCheckpointWDataInformational(_LogId.Get().Data1, "Trim locatio", STATUS_SUCCESS, _LowestLsn.Get(), _NextLsnToWrite.Get(), lowestLsn, _LogFileLsnSpace);
     KDbgCheckpointWDataInformational(_LogId.Get().Data1, "Trim data   ", STATUS_SUCCESS, startOffset, endOffset, i, 0);
     KDbgCheckpointWDataInformational(_LogId.Get().Data1, "Trim offsets", STATUS_SUCCESS, FromRange1, ToRange1, FromRange2, ToRange2);
@@ -1013,6 +1086,20 @@ RvdLogManagerImp::RvdOnDiskLog::IncomingStreamWriteDequeueCallback(
             KDbgCheckpoint(0, "Log File Failed");
         }
 
+        // Keep gathering stream writes only while the next write op is sure to be dispatched
+        // right away: more are queued and dequeuing is not being suspended. Otherwise the
+        // gathered writes would hold back the completion of all later writes thru the LSN
+        // ordered gate.
+        if (!_GatheredStreamWrites.IsEmpty())
+        {
+            if ((_IncomingStreamWriteOpQueueRefCount != TRUE) ||
+                (_IncomingStreamWriteOpQueue->GetNumberOfQueuedItems() == 0) ||
+                ((KNt::GetTickCount64() - _GatheredStreamWriteStartTicks) >= _MaxGatheredStreamWriteDelayInMs))
+            {
+                FlushGatheredStreamWrites();
+            }
+        }
+
         LONG        refCount = InterlockedDecrement(&_IncomingStreamWriteOpQueueRefCount);
         KInvariant(refCount >= FALSE);
         if (refCount == FALSE)
@@ -1025,6 +1112,208 @@ RvdLogManagerImp::RvdOnDiskLog::IncomingStreamWriteDequeueCallback(
     else
     {
         KDbgCheckpoint(1, "Pump being stopped");
+        FlushGatheredStreamWrites();
+    }
+}
+
+//** Stream write gathering
+NTSTATUS
+RvdLogManagerImp::RvdOnDiskLog::GatheredStreamWrite::Create(
+    __in RvdOnDiskLog& Log,
+    __out GatheredStreamWrite::SPtr& Result)
+{
+    Result = _new(KTL_TAG_LOGGER, Log.GetThisAllocator()) GatheredStreamWrite();
+    if (!Result)
+    {
+        return STATUS_INSUFFICIENT_RESOURCES;
+    }
+
+    NTSTATUS status = Result->Status();
+    if (NT_SUCCESS(status))
+    {
+        status = KIoBuffer::CreateEmpty(Result->_IoBuffer, Log.GetThisAllocator(), KTL_TAG_LOGGER);
+    }
+
+    if (NT_SUCCESS(status))
+    {
+        status = Log._BlockDevice->AllocateWriteContext(Result->_WriteOp, KTL_TAG_LOGGER);
+    }
+
+    if (!NT_SUCCESS(status))
+    {
+        Result.Reset();
+        return status;
+    }
+
+    Result->_Log = &Log;
+    return STATUS_SUCCESS;
+}
+
+RvdLogManagerImp::RvdOnDiskLog::GatheredStreamWrite::GatheredStreamWrite()
+    :   _WriteOps(FIELD_OFFSET(RvdLogStreamImp::AsyncWriteStream, _GatherLinks))
+{
+}
+
+RvdLogManagerImp::RvdOnDiskLog::GatheredStreamWrite::~GatheredStreamWrite()
+{
+    KInvariant(_WriteOps.IsEmpty());
+}
+
+VOID
+RvdLogManagerImp::RvdOnDiskLog::GatheredStreamWrite::WriteCompletion(
+    __in_opt KAsyncContextBase* const Parent,
+    __in KAsyncContextBase& CompletingSubOp)
+//
+// Continued from FlushGatheredStreamWrites()
+{
+    UNREFERENCED_PARAMETER(Parent);
+
+    _Log->GatheredStreamWriteCompletion(*this, CompletingSubOp.Status());
+    Release();          // Reverse AddRef() in FlushGatheredStreamWrites()
+}
+
+BOOLEAN
+RvdLogManagerImp::RvdOnDiskLog::GatherStreamWrite(
+    __in RvdLogStreamImp::AsyncWriteStream& WriteOp,
+    __in ULONGLONG FileOffset)
+//
+// Called from AsyncWriteStream::OnContinueUserRecordWrite() once the write of a user record is ready
+// to be issued.
+//
+// Returns: TRUE  - the write of WriteOp's _WorkingIoBuffer0 at FileOffset is now owned by the log and
+//                  will be issued by FlushGatheredStreamWrites()
+//          FALSE - the caller must issue the write
+{
+    KAssert(_IncomingStreamWriteOpQueueRefCount > FALSE);
+
+    ULONG       sizeToWrite = WriteOp._WorkingIoBuffer0->QuerySize();
+
+    if (!_GatheredStreamWrites.IsEmpty() &&
+        ((FileOffset != (_GatheredStreamWriteFileOffset + _GatheredStreamWriteSize)) ||
+         ((_GatheredStreamWriteSize + sizeToWrite) > _MaxGatheredStreamWriteSize) ||
+         (_GatheredStreamWrites.Count() >= _MaxGatheredStreamWrites)))
+    {
+        FlushGatheredStreamWrites();
+    }
+
+    if (sizeToWrite >= _MaxGatheredStreamWriteSize)
+    {
+        // Nothing to gain by holding back large writes
+        return FALSE;
+    }
+
+    if (_GatheredStreamWrites.IsEmpty())
+    {
+        _GatheredStreamWriteFileOffset = FileOffset;
+        _GatheredStreamWriteSize = 0;
+        _GatheredStreamWriteStartTicks = KNt::GetTickCount64();
+    }
+
+    _GatheredStreamWrites.AppendTail(&WriteOp);
+    _GatheredStreamWriteSize += sizeToWrite;
+
+    return TRUE;
+    // Continued @ FlushGatheredStreamWrites()
+}
+
+VOID
+RvdLogManagerImp::RvdOnDiskLog::FlushGatheredStreamWrites()
+//
+// Issue all gathered stream writes as a single write - see GatherStreamWrite()
+{
+    RvdLogStreamImp::AsyncWriteStream*  writeOp;
+    NTSTATUS                            status = STATUS_SUCCESS;
+    GatheredStreamWrite::SPtr           gatheredWrite;
+
+    if (_GatheredStreamWrites.Count() > 1)
+    {
+        status = GatheredStreamWrite::Create(*this, gatheredWrite);
+    }
+
+    if ((_GatheredStreamWrites.Count() <= 1) || !NT_SUCCESS(status))
+    {
+        // Issue each write as it would have been without gathering
+        ULONGLONG   fileOffset = _GatheredStreamWriteFileOffset;
+
+        while ((writeOp = _GatheredStreamWrites.RemoveHead()) != nullptr)
+        {
+            ULONG   sizeToWrite = writeOp->_WorkingIoBuffer0->QuerySize();
+
+            IssueStreamWrite(*writeOp, fileOffset);
+            fileOffset += sizeToWrite;
+        }
+
+        _GatheredStreamWriteSize = 0;
+        return;
+    }
+
+    // Move the (reference) elements of each record's write buffer into the gathered write's buffer
+    ULONG       numberOfWrites = _GatheredStreamWrites.Count();
+
+    while ((writeOp = _GatheredStreamWrites.RemoveHead()) != nullptr)
+    {
+        gatheredWrite->_IoBuffer->AddIoBuffer(*writeOp->_WorkingIoBuffer0);
+        gatheredWrite->_WriteOps.AppendTail(writeOp);
+    }
+
+    KInvariant(gatheredWrite->_IoBuffer->QuerySize() == _GatheredStreamWriteSize);
+    _GatheredStreamWriteSize = 0;
+    _StreamWritesGathered += numberOfWrites;
+    _GatheredStreamWriteIoCount++;
+
+    gatheredWrite->AddRef();        // Released in GatheredStreamWrite::WriteCompletion()
+    status = _BlockDevice->Write(
+        KBlockFile::IoPriority::eForeground,
+        _GatheredStreamWriteFileOffset,
+        *gatheredWrite->_IoBuffer,
+        KAsyncContextBase::CompletionCallback(gatheredWrite.RawPtr(), &GatheredStreamWrite::WriteCompletion),
+        nullptr,
+        gatheredWrite->_WriteOp);
+    // Continued @ GatheredStreamWrite::WriteCompletion()
+
+    if (!NT_SUCCESS(status))
+    {
+        // The LSN space of these records is already assigned and used by later writes: treat as
+        // a failed write of each
+        KTraceFailedAsyncRequest(status, gatheredWrite->_WriteOp.RawPtr(), _GatheredStreamWriteFileOffset, numberOfWrites);
+        GatheredStreamWriteCompletion(*gatheredWrite, status);
+        gatheredWrite->Release();
+    }
+}
+
+VOID
+RvdLogManagerImp::RvdOnDiskLog::IssueStreamWrite(
+    __in RvdLogStreamImp::AsyncWriteStream& WriteOp,
+    __in ULONGLONG FileOffset)
+{
+    NTSTATUS    status = _BlockDevice->Write(
+        KBlockFile::IoPriority::eForeground,
+        FileOffset,
+        *WriteOp._WorkingIoBuffer0,
+        WriteOp._WriteCompletion,
+        &WriteOp,
+        WriteOp._WriteOp0);
+    // Continued @ AsyncWriteStream::LogFileWriteCompletion()
+
+    if (!NT_SUCCESS(status))
+    {
+        WriteOp.GatheredWriteCompletion(status);
+    }
+}
+
+VOID
+RvdLogManagerImp::RvdOnDiskLog::GatheredStreamWriteCompletion(
+    __in GatheredStreamWrite& GatheredWrite,
+    __in NTSTATUS Status)
+//
+// Continued from GatheredStreamWrite::WriteCompletion() or FlushGatheredStreamWrites()
+{
+    RvdLogStreamImp::AsyncWriteStream*  writeOp;
+
+    GatheredWrite._IoBuffer->Clear();
+    while ((writeOp = GatheredWrite._WriteOps.RemoveHead()) != nullptr)
+    {
+        writeOp->GatheredWriteCompletion(Status);
     }
 }
 
@@ -575,12 +575,78 @@ RvdLogRecovery::FirstChunckReadComplete(__in_opt KAsyncContextBase* const Parent
     else
     {
         //
-        // Since this is not all zeros then we can move on with recovery
+        // Data is at the front of the log and not at the end. Find out
+        // if the space after it has been trimmed so the search for the
+        // highest LSN can skip it.
         //
-        DetermineChuncksComplete(0, _LogFileLsnSpace / _Config.GetMaxQueuedWriteDepth());
+        ULONGLONG firstChunckOffset = ToFileOffsetFromChunk(0);
+
+        _AllocatedRanges.Clear();
+        status = _BlockDevice->QueryAllocations(firstChunckOffset,
+                                        _LogFileLsnSpace,
+                                        _AllocatedRanges,
+                                        KAsyncContextBase::CompletionCallback(this, &RvdLogRecovery::FrontAllocatedRangesComplete),
+                                        nullptr,
+                                        nullptr);
+        if (!K_ASYNC_SUCCESS(status))
+        {
+            KTraceFailedAsyncRequest(status, this, firstChunckOffset, _LogFileLsnSpace);
+            DetermineChuncksComplete(0, _LogFileLsnSpace / _Config.GetMaxQueuedWriteDepth());
+            return;
+        }
+
+        // continued at FrontAllocatedRangesComplete
     }
 }
 
+VOID
+RvdLogRecovery::FrontAllocatedRangesComplete(__in_opt KAsyncContextBase* const Parent, __in KAsyncContextBase& CompletedContext)
+{
+    UNREFERENCED_PARAMETER(Parent);
+
+    ULONGLONG logFileNumberOfChuncks = _LogFileLsnSpace / _Config.GetMaxQueuedWriteDepth();
+
+    NTSTATUS status = CompletedContext.Status();
+    if (!NT_SUCCESS(status))
+    {
+        //
+        // The allocations only narrow the search so search the whole log
+        // without them
+        //
+        KTraceFailedAsyncRequest(status, this, _LogFileLsnSpace, 0);
+        DetermineChuncksComplete(0, logFileNumberOfChuncks);
+        return;
+    }
+
+    //
+    // When the data at the front of the log is the only allocation then
+    // the rest of the log space has been trimmed and reads back as zero,
+    // so it holds no records and the search can stop at the end of the
+    // allocation. Any other allocation may hold records from an earlier
+    // lap of the log and in that case the whole log is searched.
+    //
+    if (_AllocatedRanges.Count() == 1)
+    {
+        ULONGLONG firstChunckOffset = ToFileOffsetFromChunk(0);
+        ULONGLONG allocationEnd = _AllocatedRanges[0].Offset + _AllocatedRanges[0].Length;
+
+        if ((_AllocatedRanges[0].Offset <= firstChunckOffset) && (allocationEnd > firstChunckOffset))
+        {
+            ULONGLONG chunckSize = _Config.GetMaxQueuedWriteDepth();
+            ULONGLONG numberOfChuncks = ((allocationEnd - firstChunckOffset) + chunckSize - 1) / chunckSize;
+
+            if (numberOfChuncks < logFileNumberOfChuncks)
+            {
+                KDbgCheckpointWData(0, "Recovery FrontAlloc", STATUS_SUCCESS, (ULONGLONG)this, numberOfChuncks, logFileNumberOfChuncks, 0);
+                DetermineChuncksComplete(0, numberOfChuncks);
+                return;
+            }
+        }
+    }
+
+    DetermineChuncksComplete(0, logFileNumberOfChuncks);
+}
+
 NTSTATUS
 RvdLogRecovery::StartNextChunckRead(
 )
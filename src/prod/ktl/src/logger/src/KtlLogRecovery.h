@@ -552,6 +552,9 @@ private:
     VOID
     GetAllocatedRangesComplete(__in_opt KAsyncContextBase* const Parent, __in KAsyncContextBase& CompletedContext);
 
+    VOID
+    FrontAllocatedRangesComplete(__in_opt KAsyncContextBase* const Parent, __in KAsyncContextBase& CompletedContext);
+
     VOID
     ChunckReadComplete(__in_opt KAsyncContextBase* const Parent, __in KAsyncContextBase& CompletedContext);
 
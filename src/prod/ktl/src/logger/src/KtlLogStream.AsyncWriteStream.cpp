@@ -714,6 +714,20 @@ RvdLogStreamImp::AsyncWriteStream::LogFileWriteCompletion(
     RelieveAsyncActivity();             // Allow continuation @ ContinueRecordWriteCompletion()
 }
 
+VOID
+RvdLogStreamImp::AsyncWriteStream::GatheredWriteCompletion(__in NTSTATUS Status)
+//
+// Continued as a gathered write of this record to the log file completes - see RvdOnDiskLog::GatherStreamWrite()
+{
+    if (!NT_SUCCESS(Status))
+    {
+        KTraceFailedAsyncRequest(Status, this, _DebugFileWriteOffset0, _DebugFileWriteLength0);
+        InterlockedIncrement(&_WriteOpFailureCount);
+    }
+
+    RelieveAsyncActivity();             // Allow continuation @ ContinueRecordWriteCompletion()
+}
+
 NTSTATUS
 RvdLogStreamImp::AsyncWriteStream::ContinueRecordWriteCompletion()
 //
@@ -1835,7 +1849,10 @@ RvdLogStreamImp::AsyncWriteStream::OnContinueUserRecordWrite()
     _DebugFileWriteOffset0 = firstSegmentFileOffset;
     _DebugFileWriteLength0 = _WorkingIoBuffer0->QuerySize();
 
-    if (NT_SUCCESS(status))
+    // A foreground write that is not wrapped may be gathered with the writes of other records
+    // adjacent to it in the log file - once gathered the write is issued by the log
+    if (NT_SUCCESS(status) &&
+        ((secondSegmentFileOffset != 0) || _LowPriorityIO || !log->GatherStreamWrite(*this, firstSegmentFileOffset)))
     {
         status = log->_BlockDevice->Write(
             _LowPriorityIO ? KBlockFile::IoPriority::eBackground : KBlockFile::IoPriority::eForeground,
@@ -1847,6 +1864,8 @@ RvdLogStreamImp::AsyncWriteStream::OnContinueUserRecordWrite()
         // Continued @ LogFileWriteCompletion() and
         // OnContinueUserRecordWrite()
     }
+    // else Continued @ LogFileWriteCompletion() or GatheredWriteCompletion(), and
+    // OnContinueUserRecordWrite()
 
     if (!NT_SUCCESS(status))
     {
@@ -2374,6 +2393,7 @@ RvdLogStreamImp::AsyncWriteStream::OnContinueTruncation()
                     if (!NT_SUCCESS(status))
                     {
                         KTraceFailedAsyncRequest(status, this, _TrimFrom1, _TrimTo1);
+                        _Log->_TrimmedToLsn = RvdLogLsn::Null();
                         ReleaseTruncateActivity();
                     }
                 }
@@ -2386,6 +2406,7 @@ RvdLogStreamImp::AsyncWriteStream::OnContinueTruncation()
                     if (!NT_SUCCESS(status))
                     {
                         KTraceFailedAsyncRequest(status, this, _TrimFrom2, _TrimTo2);
+                        _Log->_TrimmedToLsn = RvdLogLsn::Null();
                         ReleaseTruncateActivity();
                     }
                 }
@@ -2471,6 +2492,9 @@ RvdLogStreamImp::AsyncWriteStream::TruncateTrimComplete(
     {
         KTraceFailedAsyncRequest(CompletingSubOp.Status(), &CompletingSubOp, _TrimFrom1, _TrimTo1);
         KTraceFailedAsyncRequest(CompletingSubOp.Status(), &CompletingSubOp, _TrimFrom2, _TrimTo2);
+
+        // Have the next truncation trim all of the free space again
+        _Log->_TrimmedToLsn = RvdLogLsn::Null();
     }
     CompletingSubOp.Reuse();
 
@@ -2476,6 +2476,959 @@ namespace SimpleParallelStreamTest
 }
 
 
+//** GatheredStreamWriteTest
+//
+//   Many streams concurrently writing small records - the writes the log gathers into single
+//   scatter/gather writes when they are adjacent. Reports the record write rate along with how
+//   many of the writes were gathered.
+namespace GatheredStreamWriteTest
+{
+    using SimpleParallelStreamTest::TestContext;
+    using SimpleParallelStreamTest::TestDataMarker;
+
+    ULONG const         numberOfStreams = 16;
+    ULONG const         recordCount = 500;
+    ULONG const         metaDataSize = 100;
+    ULONG const         numberOfMetaDataMarkers = metaDataSize / sizeof(TestDataMarker);
+
+    VOID
+    ThreadEntry(PVOID Context)
+    {
+        TestContext&        testContext = *((TestContext*)Context);
+        KAllocator&         allocator = KAllocatorSupport::GetAllocator(testContext.Log.RawPtr());
+        Synchronizer        synchronizer;
+
+        {
+            RvdLog::AsyncCreateLogStreamContext::SPtr createStreamOp;
+            testContext.CompletionStatus = testContext.Log->CreateAsyncCreateLogStreamContext(createStreamOp);
+            if (!NT_SUCCESS(testContext.CompletionStatus))
+            {
+                KDbgPrintf("GatheredStreamWriteTest: CreateAsyncCreateLogStreamContext Failed: %i\n", __LINE__);
+                testContext.CompletionEvent.SetEvent();
+                return;
+            }
+
+            createStreamOp->StartCreateLogStream(
+                testContext.StreamGuid,
+                testContext.StreamType,
+                testContext.LogStream,
+                nullptr,
+                synchronizer.AsyncCompletionCallback());
+
+            testContext.CompletionStatus = synchronizer.WaitForCompletion();
+            if (!NT_SUCCESS(testContext.CompletionStatus))
+            {
+                KDbgPrintf("GatheredStreamWriteTest: StartCreateLogStream Failed: %i\n", __LINE__);
+                testContext.CompletionEvent.SetEvent();
+                return;
+            }
+        }
+
+        KBuffer::SPtr       metadata;
+        KIoBuffer::SPtr     emptyIoBuffer;
+
+        testContext.CompletionStatus = KBuffer::Create(metaDataSize, metadata, allocator, KTL_TAG_TEST);
+        if (NT_SUCCESS(testContext.CompletionStatus))
+        {
+            testContext.CompletionStatus = KIoBuffer::CreateEmpty(emptyIoBuffer, allocator, KTL_TAG_TEST);
+        }
+
+        if (!NT_SUCCESS(testContext.CompletionStatus))
+        {
+            testContext.CompletionEvent.SetEvent();
+            return;
+        }
+
+        TestDataMarker*                         metaDataMarkers = (TestDataMarker*)metadata->GetBuffer();
+        RvdLogStream::AsyncWriteContext::SPtr   writeOp;
+
+        testContext.CompletionStatus = testContext.LogStream->CreateAsyncWriteContext(writeOp);
+        if (!NT_SUCCESS(testContext.CompletionStatus))
+        {
+            testContext.CompletionEvent.SetEvent();
+            return;
+        }
+
+        for (ULONGLONG currentAsn = 1; currentAsn <= recordCount; currentAsn++)
+        {
+            RvdLogAsn       asn(currentAsn);
+            for (ULONG ix = 0; ix < numberOfMetaDataMarkers; ix++)
+            {
+                metaDataMarkers[ix].Asn = asn;
+                metaDataMarkers[ix].MarkerOffset = ix;
+            }
+
+            writeOp->StartWrite(asn, currentAsn, metadata, emptyIoBuffer, nullptr, synchronizer.AsyncCompletionCallback());
+            testContext.CompletionStatus = synchronizer.WaitForCompletion();
+            if (!NT_SUCCESS(testContext.CompletionStatus))
+            {
+                KDbgPrintf("GatheredStreamWriteTest: Stream Write Failed with: 0x%08X; at line: %i\n",
+                    testContext.CompletionStatus,
+                    __LINE__);
+
+                testContext.CompletionEvent.SetEvent();
+                return;
+            }
+
+            writeOp->Reuse();
+        }
+
+        testContext.CompletionStatus = STATUS_SUCCESS;
+        testContext.CompletionEvent.SetEvent();
+    }
+
+    NTSTATUS
+    VerifyStreamRecords(RvdLogStream::SPtr LogStream)
+    {
+        NTSTATUS                                status;
+        RvdLogStream::AsyncReadContext::SPtr    readOp;
+        Synchronizer                            synchronizer;
+
+        status = LogStream->CreateAsyncReadContext(readOp);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+
+        for (ULONGLONG currentAsn = 1; currentAsn <= recordCount; currentAsn++)
+        {
+            RvdLogAsn       asn(currentAsn);
+            ULONGLONG       version;
+            KBuffer::SPtr   metadata;
+            KIoBuffer::SPtr ioBuffer;
+
+            readOp->StartRead(asn, &version, metadata, ioBuffer, nullptr, synchronizer.AsyncCompletionCallback());
+            status = synchronizer.WaitForCompletion();
+            if (!NT_SUCCESS(status))
+            {
+                KDbgPrintf("GatheredStreamWriteTest: StartRead Failed with: 0x%08X; at line: %i\n",
+                    status,
+                    __LINE__);
+
+                return status;
+            }
+
+            TestDataMarker*     testMarkers = (TestDataMarker*)(metadata->GetBuffer());
+
+            if ((version != currentAsn) || (ioBuffer->QuerySize() != 0))
+            {
+                KDbgPrintf("GatheredStreamWriteTest: Record validation failed: at line: %i\n", __LINE__);
+                return STATUS_UNSUCCESSFUL;
+            }
+
+            for (ULONG ix = 0; ix < numberOfMetaDataMarkers; ix++)
+            {
+                if ((testMarkers[ix].Asn != asn) || (testMarkers[ix].MarkerOffset != ix))
+                {
+                    KDbgPrintf("GatheredStreamWriteTest: Metadata validation failed: at line: %i\n", __LINE__);
+                    return STATUS_UNSUCCESSFUL;
+                }
+            }
+
+            readOp->Reuse();
+        }
+
+        return STATUS_SUCCESS;
+    }
+
+    NTSTATUS
+    CreateLog(
+        __in CHAR TestDrive,
+        __in KtlSystem& KtlSys,
+        __in Synchronizer& ActiveLogSynchronizer,
+        __out RvdLogManager::SPtr& LogManager,
+        __out RvdLog::SPtr& Log)
+    {
+        NTSTATUS                        status;
+        Synchronizer                    synchronizer;
+
+        // Clean the unit test drive environment
+        status = CleanAndPrepLog(TestDrive);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: CleanAndPrepLog Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        status = RvdLogManager::Create(KTL_TAG_TEST, KtlSys.NonPagedAllocator(), LogManager);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: RvdLogManager::Create Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        status = LogManager->Activate(nullptr, ActiveLogSynchronizer.AsyncCompletionCallback());
+        if (!K_ASYNC_SUCCESS(status))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: Activate() Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        RvdLogManager::AsyncCreateLog::SPtr createOp;
+        status = LogManager->CreateAsyncCreateLogContext(createOp);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: CreateAsyncCreateLogContext Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        GUID                                        diskIdGuid = {};
+#if !defined(PLATFORM_UNIX)     
+        KVolumeNamespace::VolumeInformationArray    volInfo(KtlSystem::GlobalNonPagedAllocator());
+
+        status = KVolumeNamespace::QueryVolumeListEx(volInfo, KtlSys.NonPagedAllocator(), synchronizer.AsyncCompletionCallback());
+        if (!K_ASYNC_SUCCESS(status))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: KVolumeNamespace::QueryVolumeListEx Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        status = synchronizer.WaitForCompletion();
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: KVolumeNamespace::QueryVolumeListEx Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        // Find Test Drive's volume GUID
+        ULONG i;
+        for (i = 0; i < volInfo.Count(); i++)
+        {
+            if (volInfo[i].DriveLetter == (UCHAR)TestDrive)
+            {
+                break;
+            }
+        }
+
+        if (i == volInfo.Count())
+        {
+            KDbgPrintf("GatheredStreamWriteTest: KVolumeNamespace::QueryVolumeListEx did not return volume guid for drive %C: %i\n",
+                TestDrive,
+                __LINE__);
+
+            return STATUS_UNSUCCESSFUL;
+        }
+        diskIdGuid = volInfo[i].VolumeId;
+#else
+        diskIdGuid = RvdDiskLogConstants::HardCodedVolumeGuid();        
+#endif
+
+        KWString logType(KtlSystem::GlobalNonPagedAllocator(), "RvdLog");
+        KInvariant(NT_SUCCESS(logType.Status()));
+
+        // Create a log file
+        createOp->StartCreateLog(
+            KGuid(diskIdGuid),
+            RvdLogId(KGuid(TestLogIdGuid)),
+            logType,
+            DefaultTestLogFileSize,
+            Log,
+            nullptr,
+            synchronizer.AsyncCompletionCallback());
+
+        status = synchronizer.WaitForCompletion();
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: StartCreateLog Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        createOp.Reset();
+        return STATUS_SUCCESS;
+    }
+
+    NTSTATUS
+    Execute(CHAR TestDrive, KtlSystem& KtlSys)
+    {
+        NTSTATUS                        status;
+        Synchronizer                    activeLogSynchronizer;
+        RvdLogManager::SPtr             logManager;
+        RvdLog::SPtr                    log;
+
+        status = CreateLog(TestDrive, KtlSys, activeLogSynchronizer, logManager, log);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+
+        RvdLogManagerImp::RvdOnDiskLog* logImp = (RvdLogManagerImp::RvdOnDiskLog*)log.RawPtr();
+        KGuid                           streamType;
+        TestContext*                    threadContexts[numberOfStreams] = {};
+        KThread::SPtr                   threads[numberOfStreams];
+        ULONGLONG                       startTime;
+        ULONGLONG                       elapsedTime;
+
+        streamType.CreateNew();
+
+        KFinally([&]()
+        {
+            for (ULONG ix = 0; ix < numberOfStreams; ix++)
+            {
+                if (threadContexts[ix] != nullptr)
+                {
+                    _delete(threadContexts[ix]);
+                }
+            }
+        });
+
+        for (ULONG ix = 0; ix < numberOfStreams; ix++)
+        {
+            KGuid       streamGuid;
+
+            streamGuid.CreateNew();
+            threadContexts[ix] = _new(KTL_TAG_TEST, KtlSys.NonPagedAllocator()) TestContext(log, streamGuid, streamType);
+            if (threadContexts[ix] == nullptr)
+            {
+                return STATUS_INSUFFICIENT_RESOURCES;
+            }
+        }
+
+        startTime = KNt::GetTickCount64();
+        for (ULONG ix = 0; ix < numberOfStreams; ix++)
+        {
+            status = KThread::Create(ThreadEntry, threadContexts[ix], threads[ix], KtlSys.NonPagedAllocator(), KTL_TAG_TEST);
+            if (!NT_SUCCESS(status))
+            {
+                KDbgPrintf("GatheredStreamWriteTest: KThread::Create failed: %i\n", __LINE__);
+
+                // Threads already started still refer to their contexts
+                for (ULONG jx = 0; jx < ix; jx++)
+                {
+                    threadContexts[jx]->CompletionEvent.WaitUntilSet();
+                }
+                return status;
+            }
+        }
+
+        for (ULONG ix = 0; ix < numberOfStreams; ix++)
+        {
+            threadContexts[ix]->CompletionEvent.WaitUntilSet();
+        }
+        elapsedTime = KNt::GetTickCount64() - startTime;
+
+        for (ULONG ix = 0; ix < numberOfStreams; ix++)
+        {
+            if (!NT_SUCCESS(threadContexts[ix]->CompletionStatus))
+            {
+                KDbgPrintf("GatheredStreamWriteTest: Thread %u failed: %i\n", ix, __LINE__);
+                return threadContexts[ix]->CompletionStatus;
+            }
+        }
+
+        while (!log->IsLogFlushed())
+        {
+            KNt::Sleep(0);
+        }
+
+        KDbgPrintf(
+            "GatheredStreamWriteTest: %u streams wrote %u records each in %I64u ms (%I64u records/sec); "
+            "%I64u writes gathered into %I64u I/Os\n",
+            numberOfStreams,
+            recordCount,
+            elapsedTime,
+            ((ULONGLONG)numberOfStreams * recordCount * 1000) / ((elapsedTime == 0) ? 1 : elapsedTime),
+            logImp->_StreamWritesGathered,
+            logImp->_GatheredStreamWriteIoCount);
+
+        // The concurrent streams must have had writes gathered, each gathered I/O carrying at least two of them
+        if ((logImp->_StreamWritesGathered == 0) ||
+            (logImp->_StreamWritesGathered < (2 * logImp->_GatheredStreamWriteIoCount)))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: No stream writes were gathered: at line: %i\n", __LINE__);
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        // Every record written through a gathered write reads back intact
+        for (ULONG ix = 0; ix < numberOfStreams; ix++)
+        {
+            status = VerifyStreamRecords(threadContexts[ix]->LogStream);
+            if (!NT_SUCCESS(status))
+            {
+                KDbgPrintf("GatheredStreamWriteTest: VerifyStreamRecords(%u) Failed with: 0x%08X; at line: %i\n",
+                    ix,
+                    status,
+                    __LINE__);
+
+                return status;
+            }
+
+            threadContexts[ix]->LogStream.Reset();
+            threadContexts[ix]->Log.Reset();
+        }
+
+        log.Reset();
+        logManager->Deactivate();
+        status = activeLogSynchronizer.WaitForCompletion();
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("GatheredStreamWriteTest: LogManager Deactivation Failed with: 0x%08X; at line: %i\n",
+                status,
+                __LINE__);
+
+            return status;
+        }
+
+        return STATUS_SUCCESS;
+    }
+}
+
+//** SparseLogTrimTest
+//
+//   Fills a sparse log until it has wrapped and then truncates it in steps, proving that each
+//   truncation trims only the space it freed and not all of the free space in the log again.
+//   The log is then reopened to prove that recovery returns every record above the truncation
+//   point and none below it.
+namespace SparseLogTrimTest
+{
+    using SimpleParallelStreamTest::TestDataMarker;
+
+    LONGLONG const      logSize = 32 * 1024 * 1024;
+    ULONG const         maxRecordSize = 1024 * 1024;
+    ULONG const         metaDataSize = 100;
+    ULONG const         ioBufferSize = 64 * 1024;
+    ULONG const         numberOfMetaDataMarkers = metaDataSize / sizeof(TestDataMarker);
+    ULONG const         numberOfIoBufferMarkers = ioBufferSize / sizeof(TestDataMarker);
+    ULONGLONG const     fillRecordCount = 1200;
+    ULONGLONG const     recordsKept = 150;
+    ULONGLONG const     truncationStep = 25;
+    ULONG const         numberOfTruncationSteps = 4;
+
+    ULONGLONG
+    RoundUpToBlock(RvdLogLsn Lsn)
+    {
+        ULONGLONG blockSize = RvdDiskLogConstants::BlockSize;
+        return (Lsn.Get() + (blockSize - 1)) & ~(blockSize - 1);
+    }
+
+    NTSTATUS
+    WriteRecord(
+        __in RvdLogStream::AsyncWriteContext& WriteOp,
+        __in RvdLogAsn Asn,
+        __in KBuffer::SPtr& MetaData,
+        __in KIoBuffer::SPtr& IoBuffer,
+        __in TestDataMarker* IoBufferMarkers)
+    {
+        Synchronizer        synchronizer;
+        TestDataMarker*     metaDataMarkers = (TestDataMarker*)MetaData->GetBuffer();
+
+        for (ULONG ix = 0; ix < numberOfMetaDataMarkers; ix++)
+        {
+            metaDataMarkers[ix].Asn = Asn;
+            metaDataMarkers[ix].MarkerOffset = ix;
+        }
+
+        for (ULONG ix = 0; ix < numberOfIoBufferMarkers; ix++)
+        {
+            IoBufferMarkers[ix].Asn = Asn;
+            IoBufferMarkers[ix].MarkerOffset = ix;
+        }
+
+        WriteOp.Reuse();
+        WriteOp.StartWrite(Asn, Asn.Get(), MetaData, IoBuffer, nullptr, synchronizer.AsyncCompletionCallback());
+        return synchronizer.WaitForCompletion();
+    }
+
+    // Truncations run in the background; wait for the ones in flight to have computed their trims
+    VOID
+    WaitForTruncationTrims(
+        __in RvdLog& Log,
+        __in RvdLogManagerImp::RvdOnDiskLog& LogImp,
+        __in ULONGLONG AtLeast)
+    {
+        ULONGLONG       lastCount;
+        ULONG           quietTicks = 0;
+        ULONG           waitedTicks = 0;
+
+        do
+        {
+            lastCount = LogImp._TruncationTrims;
+            KNt::Sleep(50);
+            waitedTicks++;
+
+            if ((LogImp._TruncationTrims == lastCount) && (lastCount >= AtLeast) && Log.IsLogFlushed())
+            {
+                quietTicks++;
+            }
+            else
+            {
+                quietTicks = 0;
+            }
+        } while ((quietTicks < 10) && (waitedTicks < 1200));
+    }
+
+    NTSTATUS
+    SnapLogState(__in RvdLogManagerImp::RvdOnDiskLog& LogImp, __out LogState::SPtr& State)
+    {
+        NTSTATUS status = LogImp.UnsafeSnapLogState(State, KTL_TAG_TEST, KtlSystem::GlobalNonPagedAllocator());
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: UnsafeSnapLogState Failed with: 0x%08X; at line: %i\n", status, __LINE__);
+        }
+
+        return status;
+    }
+
+    NTSTATUS
+    VerifyRecoveredStream(
+        __in RvdLogStream& LogStream,
+        __in RvdLogAsn TruncationAsn,
+        __in RvdLogAsn HighestWrittenAsn)
+    {
+        NTSTATUS                                status;
+        RvdLogAsn                               lowestAsn;
+        RvdLogAsn                               highestAsn;
+        RvdLogStream::AsyncReadContext::SPtr    readOp;
+        Synchronizer                            synchronizer;
+
+        status = LogStream.QueryRecordRange(&lowestAsn, &highestAsn, nullptr);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: QueryRecordRange Failed with: 0x%08X; at line: %i\n", status, __LINE__);
+            return status;
+        }
+
+        if ((lowestAsn.Get() != (TruncationAsn.Get() + 1)) || (highestAsn != HighestWrittenAsn))
+        {
+            KDbgPrintf("SparseLogTrimTest: Recovered records [%I64u, %I64u] instead of [%I64u, %I64u]: at line: %i\n",
+                lowestAsn.Get(),
+                highestAsn.Get(),
+                TruncationAsn.Get() + 1,
+                HighestWrittenAsn.Get(),
+                __LINE__);
+
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        status = LogStream.CreateAsyncReadContext(readOp);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+
+        // Every record above the truncation point is intact
+        for (ULONGLONG currentAsn = lowestAsn.Get(); currentAsn <= highestAsn.Get(); currentAsn++)
+        {
+            RvdLogAsn       asn(currentAsn);
+            ULONGLONG       version;
+            KBuffer::SPtr   metadata;
+            KIoBuffer::SPtr ioBuffer;
+
+            readOp->Reuse();
+            readOp->StartRead(asn, &version, metadata, ioBuffer, nullptr, synchronizer.AsyncCompletionCallback());
+            status = synchronizer.WaitForCompletion();
+            if (!NT_SUCCESS(status))
+            {
+                KDbgPrintf("SparseLogTrimTest: StartRead(%I64u) Failed with: 0x%08X; at line: %i\n", currentAsn, status, __LINE__);
+                return status;
+            }
+
+            TestDataMarker*     testMarkers = (TestDataMarker*)(metadata->GetBuffer());
+
+            if ((version != currentAsn) || (ioBuffer->QuerySize() != ioBufferSize))
+            {
+                KDbgPrintf("SparseLogTrimTest: Record validation failed: at line: %i\n", __LINE__);
+                return STATUS_UNSUCCESSFUL;
+            }
+
+            for (ULONG ix = 0; ix < numberOfMetaDataMarkers; ix++)
+            {
+                if ((testMarkers[ix].Asn != asn) || (testMarkers[ix].MarkerOffset != ix))
+                {
+                    KDbgPrintf("SparseLogTrimTest: Metadata validation failed: at line: %i\n", __LINE__);
+                    return STATUS_UNSUCCESSFUL;
+                }
+            }
+
+            KInvariant(ioBuffer->QueryNumberOfIoBufferElements() == 1);
+            testMarkers = (TestDataMarker*)(ioBuffer->First()->GetBuffer());
+
+            for (ULONG ix = 0; ix < numberOfIoBufferMarkers; ix++)
+            {
+                if ((testMarkers[ix].Asn != asn) || (testMarkers[ix].MarkerOffset != ix))
+                {
+                    KDbgPrintf("SparseLogTrimTest: IoBuffer validation failed: at line: %i\n", __LINE__);
+                    return STATUS_UNSUCCESSFUL;
+                }
+            }
+        }
+
+        // And none at or below it
+        {
+            ULONGLONG       version;
+            KBuffer::SPtr   metadata;
+            KIoBuffer::SPtr ioBuffer;
+
+            readOp->Reuse();
+            readOp->StartRead(TruncationAsn, &version, metadata, ioBuffer, nullptr, synchronizer.AsyncCompletionCallback());
+            status = synchronizer.WaitForCompletion();
+            if (NT_SUCCESS(status))
+            {
+                KDbgPrintf("SparseLogTrimTest: Truncated record %I64u was recovered: at line: %i\n", TruncationAsn.Get(), __LINE__);
+                return STATUS_UNSUCCESSFUL;
+            }
+        }
+
+        return STATUS_SUCCESS;
+    }
+
+    NTSTATUS
+    CreateSparseLog(
+        __in CHAR TestDrive,
+        __in KtlSystem& KtlSys,
+        __in Synchronizer& ActiveLogSynchronizer,
+        __out RvdLogManager::SPtr& LogManager,
+        __out RvdLog::SPtr& Log,
+        __out KGuid& DiskId)
+    {
+        NTSTATUS                        status;
+        Synchronizer                    synchronizer;
+
+        // Clean the unit test drive environment
+        status = CleanAndPrepLog(TestDrive);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: CleanAndPrepLog Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        status = RvdLogManager::Create(KTL_TAG_TEST, KtlSys.NonPagedAllocator(), LogManager);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: RvdLogManager::Create Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        status = LogManager->Activate(nullptr, ActiveLogSynchronizer.AsyncCompletionCallback());
+        if (!K_ASYNC_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: Activate() Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        RvdLogManager::AsyncCreateLog::SPtr createOp;
+        status = LogManager->CreateAsyncCreateLogContext(createOp);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: CreateAsyncCreateLogContext Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        GUID                                        diskIdGuid = {};
+#if !defined(PLATFORM_UNIX)     
+        KVolumeNamespace::VolumeInformationArray    volInfo(KtlSystem::GlobalNonPagedAllocator());
+
+        status = KVolumeNamespace::QueryVolumeListEx(volInfo, KtlSys.NonPagedAllocator(), synchronizer.AsyncCompletionCallback());
+        if (!K_ASYNC_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: KVolumeNamespace::QueryVolumeListEx Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        status = synchronizer.WaitForCompletion();
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: KVolumeNamespace::QueryVolumeListEx Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        // Find Test Drive's volume GUID
+        ULONG i;
+        for (i = 0; i < volInfo.Count(); i++)
+        {
+            if (volInfo[i].DriveLetter == (UCHAR)TestDrive)
+            {
+                break;
+            }
+        }
+
+        if (i == volInfo.Count())
+        {
+            KDbgPrintf("SparseLogTrimTest: KVolumeNamespace::QueryVolumeListEx did not return volume guid for drive %C: %i\n",
+                TestDrive,
+                __LINE__);
+
+            return STATUS_UNSUCCESSFUL;
+        }
+        diskIdGuid = volInfo[i].VolumeId;
+#else
+        diskIdGuid = RvdDiskLogConstants::HardCodedVolumeGuid();        
+#endif
+
+        KWString logType(KtlSystem::GlobalNonPagedAllocator(), "RvdLog");
+        KInvariant(NT_SUCCESS(logType.Status()));
+
+        // Create a sparse log file
+        createOp->StartCreateLog(
+            KGuid(diskIdGuid),
+            RvdLogId(KGuid(TestLogIdGuid)),
+            logType,
+            logSize,
+            0,
+            maxRecordSize,
+            RvdLogManager::AsyncCreateLog::FlagSparseFile,
+            Log,
+            nullptr,
+            synchronizer.AsyncCompletionCallback());
+
+        status = synchronizer.WaitForCompletion();
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: StartCreateLog Failed: %i\n", __LINE__);
+            return status;
+        }
+
+        DiskId = KGuid(diskIdGuid);
+
+        createOp.Reset();
+        return STATUS_SUCCESS;
+    }
+
+    NTSTATUS
+    Execute(CHAR TestDrive, KtlSystem& KtlSys)
+    {
+        NTSTATUS                        status;
+        Synchronizer                    activeLogSynchronizer;
+        Synchronizer                    synchronizer;
+        RvdLogManager::SPtr             logManager;
+        RvdLog::SPtr                    log;
+        RvdLogStream::SPtr              stream;
+        KGuid                           diskId;
+        KGuid                           streamGuid;
+        KGuid                           streamType;
+        LogState::SPtr                  logState;
+
+        status = CreateSparseLog(TestDrive, KtlSys, activeLogSynchronizer, logManager, log, diskId);
+
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+
+        RvdLogManagerImp::RvdOnDiskLog* logImp = (RvdLogManagerImp::RvdOnDiskLog*)log.RawPtr();
+        KAllocator&                     allocator = KtlSys.NonPagedAllocator();
+
+        streamGuid.CreateNew();
+        streamType.CreateNew();
+
+        {
+            RvdLog::AsyncCreateLogStreamContext::SPtr createStreamOp;
+            status = log->CreateAsyncCreateLogStreamContext(createStreamOp);
+            if (!NT_SUCCESS(status))
+            {
+                return status;
+            }
+
+            createStreamOp->StartCreateLogStream(RvdLogStreamId(streamGuid), RvdLogStreamType(streamType), stream, nullptr, synchronizer.AsyncCompletionCallback());
+            status = synchronizer.WaitForCompletion();
+            if (!NT_SUCCESS(status))
+            {
+                KDbgPrintf("SparseLogTrimTest: StartCreateLogStream Failed with: 0x%08X; at line: %i\n", status, __LINE__);
+                return status;
+            }
+        }
+
+        KBuffer::SPtr       metadata;
+        KIoBuffer::SPtr     ioBuffer;
+        TestDataMarker*     ioBufferMarkers;
+        RvdLogStream::AsyncWriteContext::SPtr   writeOp;
+
+        status = KBuffer::Create(metaDataSize, metadata, allocator, KTL_TAG_TEST);
+        if (NT_SUCCESS(status))
+        {
+            status = KIoBuffer::CreateSimple(ioBufferSize, ioBuffer, (VOID*&)ioBufferMarkers, allocator, KTL_TAG_TEST);
+        }
+        if (NT_SUCCESS(status))
+        {
+            status = stream->CreateAsyncWriteContext(writeOp);
+        }
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+
+        //** Fill the log until it has wrapped, truncating as it goes
+        ULONGLONG       truncatedAsn = 0;
+
+        for (ULONGLONG currentAsn = 1; currentAsn <= fillRecordCount; currentAsn++)
+        {
+            status = WriteRecord(*writeOp, RvdLogAsn(currentAsn), metadata, ioBuffer, ioBufferMarkers);
+            if (!NT_SUCCESS(status))
+            {
+                KDbgPrintf("SparseLogTrimTest: Write(%I64u) Failed with: 0x%08X; at line: %i\n", currentAsn, status, __LINE__);
+                return status;
+            }
+
+            if ((currentAsn - truncatedAsn) >= (recordsKept + truncationStep))
+            {
+                truncatedAsn += truncationStep;
+                stream->Truncate(RvdLogAsn(truncatedAsn), RvdLogAsn(truncatedAsn));
+            }
+        }
+
+        WaitForTruncationTrims(*log, *logImp, 1);
+
+        status = SnapLogState(*logImp, logState);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+
+        if (logState->_NextLsnToWrite.Get() < (2 * logState->_LogFileLsnSpace))
+        {
+            KDbgPrintf("SparseLogTrimTest: Log did not wrap: at line: %i\n", __LINE__);
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        //
+        // Only the first truncation after the log was created trims all of the free space.
+        // Every later one trims the space freed since, so all of the trims together cover
+        // at most the log once plus the LSN space truncated after that.
+        //
+        if ((logImp->_FullTruncationTrims != 1) ||
+            (logImp->_TruncationTrims < 2) ||
+            (logImp->_TruncationTrimmedBytes > (logState->_LogFileLsnSpace + RoundUpToBlock(logState->_LowestLsn))))
+        {
+            KDbgPrintf("SparseLogTrimTest: %I64u trims (%I64u full) trimmed %I64u bytes; lsn space %I64u; lowest lsn %I64u: at line: %i\n",
+                logImp->_TruncationTrims,
+                logImp->_FullTruncationTrims,
+                logImp->_TruncationTrimmedBytes,
+                logState->_LogFileLsnSpace,
+                logState->_LowestLsn.Get(),
+                __LINE__);
+
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        //** Truncate in steps; each trims exactly the LSN space that it freed
+        for (ULONG step = 0; step < numberOfTruncationSteps; step++)
+        {
+            ULONGLONG       trimsBefore = logImp->_TruncationTrims;
+            ULONGLONG       trimmedBytesBefore = logImp->_TruncationTrimmedBytes;
+            ULONGLONG       lowestBefore = RoundUpToBlock(logState->_LowestLsn);
+
+            truncatedAsn += truncationStep;
+            stream->Truncate(RvdLogAsn(truncatedAsn), RvdLogAsn(truncatedAsn));
+
+            WaitForTruncationTrims(*log, *logImp, trimsBefore + 1);
+
+            status = SnapLogState(*logImp, logState);
+            if (!NT_SUCCESS(status))
+            {
+                return status;
+            }
+
+            ULONGLONG       lowestAfter = RoundUpToBlock(logState->_LowestLsn);
+            ULONGLONG       trimmedBytes = logImp->_TruncationTrimmedBytes - trimmedBytesBefore;
+
+            if ((logImp->_TruncationTrims == trimsBefore) ||
+                (logImp->_FullTruncationTrims != 1) ||
+                (lowestAfter <= lowestBefore) ||
+                (trimmedBytes != (lowestAfter - lowestBefore)))
+            {
+                KDbgPrintf("SparseLogTrimTest: Step %u trimmed %I64u bytes for lowest lsn %I64u -> %I64u: at line: %i\n",
+                    step,
+                    trimmedBytes,
+                    lowestBefore,
+                    lowestAfter,
+                    __LINE__);
+
+                return STATUS_UNSUCCESSFUL;
+            }
+        }
+
+        //** Close the log and open it again through recovery
+        writeOp.Reset();
+        stream.Reset();
+        log.Reset();
+        logManager->Deactivate();
+        status = activeLogSynchronizer.WaitForCompletion();
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: LogManager Deactivation Failed with: 0x%08X; at line: %i\n", status, __LINE__);
+            return status;
+        }
+        logManager.Reset();
+
+        status = RvdLogManager::Create(KTL_TAG_TEST, allocator, logManager);
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+
+        status = logManager->Activate(nullptr, activeLogSynchronizer.AsyncCompletionCallback());
+        if (!K_ASYNC_SUCCESS(status))
+        {
+            return status;
+        }
+
+        {
+            RvdLogManager::AsyncOpenLog::SPtr   openOp;
+            status = logManager->CreateAsyncOpenLogContext(openOp);
+            if (!NT_SUCCESS(status))
+            {
+                return status;
+            }
+
+            openOp->StartOpenLog(diskId, RvdLogId(KGuid(TestLogIdGuid)), log, nullptr, synchronizer.AsyncCompletionCallback());
+            status = synchronizer.WaitForCompletion();
+            if (!NT_SUCCESS(status))
+            {
+                KDbgPrintf("SparseLogTrimTest: StartOpenLog Failed with: 0x%08X; at line: %i\n", status, __LINE__);
+                return status;
+            }
+        }
+
+        {
+            RvdLog::AsyncOpenLogStreamContext::SPtr openStreamOp;
+            status = log->CreateAsyncOpenLogStreamContext(openStreamOp);
+            if (!NT_SUCCESS(status))
+            {
+                return status;
+            }
+
+            openStreamOp->StartOpenLogStream(RvdLogStreamId(streamGuid), stream, nullptr, synchronizer.AsyncCompletionCallback());
+            status = synchronizer.WaitForCompletion();
+            if (!NT_SUCCESS(status))
+            {
+                KDbgPrintf("SparseLogTrimTest: StartOpenLogStream Failed with: 0x%08X; at line: %i\n", status, __LINE__);
+                return status;
+            }
+        }
+
+        status = VerifyRecoveredStream(*stream, RvdLogAsn(truncatedAsn), RvdLogAsn(fillRecordCount));
+        if (!NT_SUCCESS(status))
+        {
+            return status;
+        }
+
+        //** What was trimmed before the log was closed is not known, so the next truncation trims all free space
+        logImp = (RvdLogManagerImp::RvdOnDiskLog*)log.RawPtr();
+
+        truncatedAsn += truncationStep;
+        stream->Truncate(RvdLogAsn(truncatedAsn), RvdLogAsn(truncatedAsn));
+
+        WaitForTruncationTrims(*log, *logImp, 1);
+
+        if (logImp->_FullTruncationTrims != 1)
+        {
+            KDbgPrintf("SparseLogTrimTest: %I64u full trims after the log was opened: at line: %i\n", logImp->_FullTruncationTrims, __LINE__);
+            return STATUS_UNSUCCESSFUL;
+        }
+
+        stream.Reset();
+        log.Reset();
+        logManager->Deactivate();
+        status = activeLogSynchronizer.WaitForCompletion();
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("SparseLogTrimTest: LogManager Deactivation Failed with: 0x%08X; at line: %i\n", status, __LINE__);
+            return status;
+        }
+
+        return STATUS_SUCCESS;
+    }
+}
+
 //** RvdLogLsnEntryTracker related tests
 NTSTATUS
 ValidateRvdLogLsnEntryTracker(
@@ -3077,6 +4030,156 @@ RvdAsnIndexTests()
     return STATUS_SUCCESS;
 }
 
+//** Times the ASN index and the LSN tracker at the sizes a long lived stream reaches: inserting in
+//   out of order ASNs, point lookups, a recovery style Load() and truncation in steps
+NTSTATUS
+RvdAsnIndexScaleTests()
+{
+    ULONG const         numberOfEntries = 1000000;
+    ULONG const         truncationStep = 10000;
+    NTSTATUS            status;
+    ULONGLONG           startTime;
+    ULONGLONG           elapsedTime;
+
+    //* Write the ASNs in a random order with ascending LSNs (from 1)
+    KArray<ULONG>       asnWriteOrder(KtlSystem::GlobalNonPagedAllocator(), numberOfEntries);
+    for (ULONG ix = 0; ix < numberOfEntries; ix++)
+    {
+        status = asnWriteOrder.Append(ix + 1);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("RvdAsnIndexScaleTests: Append failed: %i\n", __LINE__);
+            return status;
+        }
+    }
+
+    for (ULONG ix = numberOfEntries - 1; ix > 0; ix--)
+    {
+        ULONG const     swapIx = RandomGenerator::Get(ix, 0);
+        ULONG const     asn = asnWriteOrder[swapIx];
+
+        asnWriteOrder[swapIx] = asnWriteOrder[ix];
+        asnWriteOrder[ix] = asn;
+    }
+
+    RvdAsnIndex         testIndex(KtlSystem::GlobalNonPagedAllocator());
+
+    startTime = KNt::GetTickCount64();
+    for (ULONG lsn = 0; lsn < numberOfEntries; lsn++)
+    {
+        RvdAsnIndexEntry::SPtr          indexEntry = _new(KTL_TAG_TEST, KtlSystem::GlobalNonPagedAllocator())
+            RvdAsnIndexEntry(RvdLogAsn(asnWriteOrder[lsn]), asnWriteOrder[lsn], 0, RvdLogStream::RecordDisposition::eDispositionPersisted, RvdLogLsn(lsn + 1));
+
+        if (indexEntry == nullptr)
+        {
+            KDbgPrintf("RvdAsnIndexScaleTests: _new failed: %i\n", __LINE__);
+            return STATUS_INSUFFICIENT_RESOURCES;
+        }
+
+        RvdAsnIndexEntry::SPtr          resultIndexEntry;
+        RvdAsnIndexEntry::SavedState    savedState;
+        BOOLEAN                         savedStatePresent;
+        ULONGLONG                       dontCare;
+
+        status = testIndex.AddOrUpdate(indexEntry, resultIndexEntry, savedState, savedStatePresent, dontCare);
+        if (!NT_SUCCESS(status) || savedStatePresent)
+        {
+            KDbgPrintf("RvdAsnIndexScaleTests: AddOrUpdate failed: %i\n", __LINE__);
+            return NT_SUCCESS(status) ? STATUS_UNSUCCESSFUL : status;
+        }
+    }
+    elapsedTime = KNt::GetTickCount64() - startTime;
+    KDbgPrintf("RvdAsnIndexScaleTests: inserted %u entries in %I64u ms\n", numberOfEntries, elapsedTime);
+
+    KInvariant(testIndex.GetNumberOfEntries() == numberOfEntries);
+    KInvariant(testIndex.Validate());
+
+    //* Look each ASN up in write order
+    startTime = KNt::GetTickCount64();
+    for (ULONG ix = 0; ix < numberOfEntries; ix++)
+    {
+        ULONGLONG                       version;
+        RvdLogStream::RecordDisposition disposition;
+        RvdLogLsn                       lsn;
+        ULONG                           ioBufferSizeHint;
+
+        testIndex.GetAsnInformation(RvdLogAsn(asnWriteOrder[ix]), version, disposition, lsn, ioBufferSizeHint);
+        if ((version != asnWriteOrder[ix]) || (lsn.Get() != (ix + 1)))
+        {
+            KDbgPrintf("RvdAsnIndexScaleTests: GetAsnInformation returned the wrong entry: %i\n", __LINE__);
+            return STATUS_UNSUCCESSFUL;
+        }
+    }
+    elapsedTime = KNt::GetTickCount64() - startTime;
+    KDbgPrintf("RvdAsnIndexScaleTests: looked up %u entries in %I64u ms\n", numberOfEntries, elapsedTime);
+
+    //* Move the index as recovery does
+    RvdAsnIndex         loadedIndex(KtlSystem::GlobalNonPagedAllocator());
+
+    startTime = KNt::GetTickCount64();
+    status = loadedIndex.Load(testIndex);
+    elapsedTime = KNt::GetTickCount64() - startTime;
+    if (!NT_SUCCESS(status))
+    {
+        KDbgPrintf("RvdAsnIndexScaleTests: Load failed: %i\n", __LINE__);
+        return status;
+    }
+    KDbgPrintf("RvdAsnIndexScaleTests: loaded %u entries in %I64u ms\n", numberOfEntries, elapsedTime);
+
+    KInvariant(testIndex.GetNumberOfEntries() == 0);
+    KInvariant(loadedIndex.GetNumberOfEntries() == numberOfEntries);
+    KInvariant(loadedIndex.Validate());
+
+    //* Truncate in steps; an entry's LSN space is only released once all lower ASNs are truncated
+    startTime = KNt::GetTickCount64();
+    for (ULONG upToAsn = truncationStep; upToAsn <= numberOfEntries; upToAsn += truncationStep)
+    {
+        RvdLogLsn       truncatableLsn = loadedIndex.Truncate(RvdLogAsn(upToAsn), RvdLogLsn::Null());
+
+        if ((loadedIndex.GetNumberOfEntries() != (numberOfEntries - upToAsn)) ||
+            ((upToAsn < numberOfEntries) && (truncatableLsn.Get() >= numberOfEntries)))
+        {
+            KDbgPrintf("RvdAsnIndexScaleTests: Truncate caused unexpected result: %i\n", __LINE__);
+            return STATUS_UNSUCCESSFUL;
+        }
+    }
+    elapsedTime = KNt::GetTickCount64() - startTime;
+    KDbgPrintf("RvdAsnIndexScaleTests: truncated %u entries in %I64u ms\n", numberOfEntries, elapsedTime);
+
+    //* Same for the LSN tracker
+    RvdLogLsnEntryTracker   testTracker(KtlSystem::GlobalNonPagedAllocator());
+
+    startTime = KNt::GetTickCount64();
+    for (ULONG lsn = 1; lsn <= numberOfEntries; lsn++)
+    {
+        status = testTracker.AddHigherLsnRecord(RvdLogLsn(lsn), RvdDiskLogConstants::BlockSize, 0);
+        if (!NT_SUCCESS(status))
+        {
+            KDbgPrintf("RvdAsnIndexScaleTests: AddHigherLsnRecord failed: %i\n", __LINE__);
+            return status;
+        }
+    }
+    elapsedTime = KNt::GetTickCount64() - startTime;
+    KDbgPrintf("RvdAsnIndexScaleTests: tracked %u LSNs in %I64u ms\n", numberOfEntries, elapsedTime);
+
+    startTime = KNt::GetTickCount64();
+    for (ULONG lsn = truncationStep + 1; lsn <= numberOfEntries; lsn += truncationStep)
+    {
+        testTracker.Truncate(RvdLogLsn(lsn));
+
+        if ((testTracker.QueryNumberOfRecords() != (numberOfEntries - (lsn - 1))) ||
+            (testTracker.QueryTotalSize() != ((LONGLONG)(numberOfEntries - (lsn - 1)) * RvdDiskLogConstants::BlockSize)))
+        {
+            KDbgPrintf("RvdAsnIndexScaleTests: Truncate caused unexpected result: %i\n", __LINE__);
+            return STATUS_UNSUCCESSFUL;
+        }
+    }
+    elapsedTime = KNt::GetTickCount64() - startTime;
+    KDbgPrintf("RvdAsnIndexScaleTests: truncated %u LSNs in %I64u ms\n", numberOfEntries, elapsedTime);
+
+    return STATUS_SUCCESS;
+}
+
 void
 RvdLogOnDiskConfigTests()
 {
@@ -3117,6 +4220,13 @@ InternalStructuresTest()
         return status;
     }
 
+    status = RvdAsnIndexScaleTests();
+    if (!NT_SUCCESS(status))
+    {
+        KDbgPrintf("InternalStructuresTest: RvdAsnIndexScaleTests failed: %i\n", __LINE__);
+        return status;
+    }
+
     return STATUS_SUCCESS;
 }
 
@@ -3158,6 +4268,18 @@ InternalBasicDiskLoggerTest(__in int argc, __in_ecount(argc) CHAR* args[])
         return status;
     }
 
+    if (!NT_SUCCESS(status = GatheredStreamWriteTest::Execute(*(args[0]), KtlSystem::GetDefaultKtlSystem())))
+    {
+        KDbgPrintf("RvdLogger Unit Test: GatheredStreamWriteTest Failed: 0x%08X\n", status);
+        return status;
+    }
+
+    if (!NT_SUCCESS(status = SparseLogTrimTest::Execute(*(args[0]), KtlSystem::GetDefaultKtlSystem())))
+    {
+        KDbgPrintf("RvdLogger Unit Test: SparseLogTrimTest Failed: 0x%08X\n", status);
+        return status;
+    }
+
     if (!NT_SUCCESS(ParallelLogTest()))
     {
         KDbgPrintf("RvdLogger Unit Test: ParallelLogTest Failed\n");
@@ -63,6 +63,8 @@ using namespace ktl;
 
 LONGLONG g_BlockFileNumBytesReceived = 0;
 LONGLONG g_BlockFileNumBytesSent = 0;
+LONGLONG g_BlockFileNumFlushRequests = 0;
+LONGLONG g_BlockFileNumPhysicalFlushes = 0;
 BOOLEAN KBlockFile::NoScatterGather = FALSE;
 LONG KBlockFile::DisableDiskIo = FALSE;
 
@@ -424,6 +426,7 @@ class KBlockFileStandard : public KBlockFile {
 
                 KBlockFileStandard::SPtr _File;
 #if KTL_USER_MODE
+                KListEntry _ListEntry;
 #else
                 PIRP _Irp;
 #endif
@@ -1271,6 +1274,14 @@ class KBlockFileStandard : public KBlockFile {
         SystemIoPriorityHint _IoPriorityHint;
 #if KTL_USER_MODE
         VOID* _RegistrationContext;
+
+        //
+        // Flush requests waiting for the next physical flush and
+        // whether one is running. Protected by _FlushSpinLock.
+        //
+        KSpinLock _FlushSpinLock;
+        KNodeList<FlushStandard> _FlushWaiters;
+        BOOLEAN _IsFlushRunning;
 #else
         ExtentTable::KeyComparisonFunc _ExtentTableComparisonFunction;
         DEVICE_OBJECT* _VolumeObject;
@@ -2271,6 +2282,7 @@ KBlockFileStandard::KBlockFileStandard(
         _FileName(GetThisAllocator())
       , _QueueDepth(QueueDepth)
 #if KTL_USER_MODE
+    , _FlushWaiters(FIELD_OFFSET(FlushStandard, _ListEntry))
 #else
     , _ExtentTableComparisonFunction(&KBlockFileStandard::FileExtentComparison)
     , _ExtentTable(_ExtentTableComparisonFunction, GetThisAllocator(), KTL_TAG_FILE)
@@ -4312,6 +4324,7 @@ KBlockFileStandard::Zero(
     _MaxBackground = 2;
 #if KTL_USER_MODE
     _RegistrationContext = NULL;
+    _IsFlushRunning = FALSE;
 #else
     _VolumeObject = NULL;
     _FileObject = NULL;
@@ -7943,18 +7956,39 @@ Return Value:
 --*/
 
 {
+    InterlockedIncrement64(&g_BlockFileNumFlushRequests);
+
 #if KTL_USER_MODE
 
+    BOOLEAN startFlush;
+
     //
-    // The flush is officially started.  Since this is a blocking operation, we need to queue this to a system worker thread.
+    // Concurrent flushes share a physical flush.  A request that arrives while one is running cannot be completed
+    // by it since writes that finished before the request may not be covered, so it waits for the next one.  That
+    // one is started by whoever completes the running flush.
     //
 
-    GetThisKtlSystem().DefaultSystemThreadPool().QueueWorkItem(*this);
+    _File->_FlushSpinLock.Acquire();
+    _File->_FlushWaiters.AppendTail(this);
+    startFlush = !_File->_IsFlushRunning;
+    _File->_IsFlushRunning = TRUE;
+    _File->_FlushSpinLock.Release();
+
+    if (startFlush) {
+
+        //
+        // Since this is a blocking operation, we need to queue this to a system worker thread.
+        //
+
+        GetThisKtlSystem().DefaultSystemThreadPool().QueueWorkItem(*this);
+    }
 
 #else
 
     IO_STACK_LOCATION* nextSp;
 
+    InterlockedIncrement64(&g_BlockFileNumPhysicalFlushes);
+
     //
     // We have the irp in the flush packet.  Just initialize it and send it.
     //
@@ -7989,7 +8023,8 @@ KBlockFileStandard::FlushStandard::Execute(
 
 Routine Description:
 
-    This routine executes a synchronous flush command on a system worker thread.
+    This routine executes a synchronous flush command on a system worker thread.  The flush completes every
+    request that was waiting when it started.
 
 Arguments:
 
@@ -8006,18 +8041,50 @@ Return Value:
 
     NTSTATUS status;
     IO_STATUS_BLOCK ioStatus;
+    KBlockFileStandard::SPtr file = _File;
+    KNodeList<FlushStandard> flushes(FIELD_OFFSET(FlushStandard, _ListEntry));
+    FlushStandard* flush;
+    FlushStandard* nextFlush;
+
+    //
+    // The writes preceding every request waiting now completed before the flush is issued.  The physical flush is
+    // counted before the waiters are taken, so a request completed by it saw a lower count when it was enqueued.
+    //
+
+    file->_FlushSpinLock.Acquire();
+    InterlockedIncrement64(&g_BlockFileNumPhysicalFlushes);
+    flushes.AppendTail(file->_FlushWaiters);
+    file->_FlushSpinLock.Release();
 
     //
     // We're on a thread that can block.  Call FlushFileBuffers.
     //
 
-    status = KNt::FlushBuffersFile(_File->_Handle, &ioStatus);
+    status = KNt::FlushBuffersFile(file->_Handle, &ioStatus);
 
     if (!NT_SUCCESS(status)) {
-        KTraceFailedAsyncRequest(status, this, (ULONGLONG)_File, 0);
+        KTraceFailedAsyncRequest(status, this, (ULONGLONG)file.RawPtr(), flushes.Count());
     }
 
-    Complete(status);
+    //
+    // Requests that arrived during the flush need another one.  It is handed to one of them before completing,
+    // since this context may be reused as soon as it completes.
+    //
+
+    file->_FlushSpinLock.Acquire();
+    nextFlush = file->_FlushWaiters.PeekHead();
+    if (!nextFlush) {
+        file->_IsFlushRunning = FALSE;
+    }
+    file->_FlushSpinLock.Release();
+
+    if (nextFlush) {
+        GetThisKtlSystem().DefaultSystemThreadPool().QueueWorkItem(*nextFlush);
+    }
+
+    while ((flush = flushes.RemoveHead()) != NULL) {
+        flush->Complete(status);
+    }
 
 #endif
 }
@@ -41,6 +41,9 @@ using namespace ktl::test::file;
 
 const ULONGLONG g_TestSize = 1024*1024*1024;
 
+extern LONGLONG g_BlockFileNumFlushRequests;
+extern LONGLONG g_BlockFileNumPhysicalFlushes;
+
 class RandomAllocator : public KObject<RandomAllocator> {
 
     public:
@@ -2128,6 +2131,175 @@ NTSTATUS WriteAfterCloseTest(
 }
 #endif
 
+#if KTL_USER_MODE
+static LONGLONG
+QueryFlushCount(
+    __in LONGLONG& Counter
+    )
+{
+    return(InterlockedAdd64(&Counter, 0));
+}
+
+NTSTATUS FlushCoalescingTest(
+    __in KWString dirName
+    )
+{
+    NTSTATUS status;
+    static const ULONG IoCount = 64;
+    static const ULONG RoundCount = 8;
+    static const ULONG bufferSize = 0x1000;
+    ULONG fileSize = IoCount * bufferSize;
+    KBlockFile::SPtr blockFile;
+    KIoBuffer::SPtr ioBuffers[IoCount];
+    PVOID buffers[IoCount];
+    KWString fileName(dirName);
+    KSynchronizer sync;
+    KSynchronizer writeSyncs[IoCount];
+    KSynchronizer flushSyncs[IoCount];
+    LONGLONG physicalFlushesBefore[IoCount];
+    LONGLONG flushRequests;
+    LONGLONG physicalFlushes;
+    ULONG i;
+
+    for (i = 0; i < IoCount; i++)
+    {
+        status = KIoBuffer::CreateSimple(bufferSize, ioBuffers[i], buffers[i], KtlSystem::GlobalNonPagedAllocator());
+        VERIFY_IS_TRUE(NT_SUCCESS(status), "Alloc");
+    }
+
+    status = KVolumeNamespace::CreateDirectory(dirName, KtlSystem::GlobalNonPagedAllocator(), sync);
+    VERIFY_IS_TRUE(NT_SUCCESS(status), "CreateDirectory");
+    status = sync.WaitForCompletion();
+
+    fileName = dirName;
+#if !defined(PLATFORM_UNIX)
+    fileName += "\\flushcoalescing.test";
+#else
+    fileName += "/flushcoalescing.test";
+#endif
+
+    status = KBlockFile::Create(fileName,
+                                            FALSE,        // IsWriteThrough
+                                            KBlockFile::eCreateAlways,
+                                            blockFile,
+                                            sync,
+                                            nullptr,
+                                            KtlSystem::GlobalNonPagedAllocator(),
+                                            KTL_TAG_TEST);
+    VERIFY_IS_TRUE(NT_SUCCESS(status), "CreateFile");
+    status = sync.WaitForCompletion();
+    VERIFY_IS_TRUE(NT_SUCCESS(status), "CreateFile");
+
+    status = blockFile->SetFileSize(fileSize, sync, NULL);
+    VERIFY_IS_TRUE(NT_SUCCESS(status), "SetFileSize");
+    status = sync.WaitForCompletion();
+    VERIFY_IS_TRUE(NT_SUCCESS(status), "SetFileSize");
+
+    flushRequests = QueryFlushCount(g_BlockFileNumFlushRequests);
+    physicalFlushes = QueryFlushCount(g_BlockFileNumPhysicalFlushes);
+
+    //
+    // A flush with nothing else going on is a physical flush of its own
+    //
+    status = blockFile->Flush(sync);
+    VERIFY_IS_TRUE(NT_SUCCESS(status), "Flush");
+    status = sync.WaitForCompletion();
+    VERIFY_IS_TRUE(NT_SUCCESS(status), "Flush");
+
+    VERIFY_IS_TRUE(QueryFlushCount(g_BlockFileNumFlushRequests) == (flushRequests + 1), "Single flush request");
+    VERIFY_IS_TRUE(QueryFlushCount(g_BlockFileNumPhysicalFlushes) == (physicalFlushes + 1), "Single physical flush");
+
+    //
+    // Each writer flushes after its own write completes, and the
+    // flushes of a round are issued in a burst so that they overlap
+    // and can share physical flushes. A flush must only complete once
+    // a physical flush issued after it was requested has finished,
+    // otherwise the write it follows may not be durable.
+    //
+    for (ULONG round = 0; round < RoundCount; round++)
+    {
+        for (i = 0; i < IoCount; i++)
+        {
+            memset(buffers[i], (UCHAR)(round + i), bufferSize);
+            status = blockFile->Transfer(KBlockFile::eForeground,
+                                         KBlockFile::eWrite,
+                                         i * bufferSize,
+                                         *ioBuffers[i],
+                                         writeSyncs[i],
+                                         nullptr);
+            VERIFY_IS_TRUE(NT_SUCCESS(status), "Transfer");
+        }
+
+        for (i = 0; i < IoCount; i++)
+        {
+            status = writeSyncs[i].WaitForCompletion();
+            VERIFY_IS_TRUE(NT_SUCCESS(status), "Transfer");
+        }
+
+        for (i = 0; i < IoCount; i++)
+        {
+            physicalFlushesBefore[i] = QueryFlushCount(g_BlockFileNumPhysicalFlushes);
+            status = blockFile->Flush(flushSyncs[i]);
+            VERIFY_IS_TRUE(NT_SUCCESS(status), "Flush");
+        }
+
+        //
+        // The physical flush completing a request is counted when it takes the waiting requests, which is after
+        // the request was enqueued
+        //
+        for (i = 0; i < IoCount; i++)
+        {
+            status = flushSyncs[i].WaitForCompletion();
+            VERIFY_IS_TRUE(NT_SUCCESS(status), "Flush");
+            VERIFY_IS_TRUE(QueryFlushCount(g_BlockFileNumPhysicalFlushes) > physicalFlushesBefore[i], "Flush ordering");
+        }
+    }
+
+    flushRequests = QueryFlushCount(g_BlockFileNumFlushRequests) - flushRequests;
+    physicalFlushes = QueryFlushCount(g_BlockFileNumPhysicalFlushes) - physicalFlushes;
+
+    KTestPrintf("FlushCoalescingTest: %I64d flush requests, %I64d physical flushes\n", flushRequests, physicalFlushes);
+
+    VERIFY_IS_TRUE(flushRequests == (1 + (RoundCount * IoCount)), "Flush requests");
+    VERIFY_IS_TRUE(physicalFlushes > 0, "Physical flushes");
+
+    //
+    // The overlapping flushes of the bursts were coalesced
+    //
+    VERIFY_IS_TRUE(physicalFlushes < flushRequests, "Flush coalescing");
+
+    //
+    // Everything written in the last round is there
+    //
+    for (i = 0; i < IoCount; i++)
+    {
+        status = blockFile->Transfer(KBlockFile::eForeground,
+                                     KBlockFile::eRead,
+                                     i * bufferSize,
+                                     *ioBuffers[i],
+                                     writeSyncs[i],
+                                     nullptr);
+        VERIFY_IS_TRUE(NT_SUCCESS(status), "Transfer");
+        status = writeSyncs[i].WaitForCompletion();
+        VERIFY_IS_TRUE(NT_SUCCESS(status), "Transfer");
+
+        for (ULONG j = 0; j < bufferSize; j++)
+        {
+            VERIFY_IS_TRUE(((PUCHAR)buffers[i])[j] == (UCHAR)((RoundCount - 1) + i), "Data");
+        }
+    }
+
+    blockFile->Close();
+    blockFile = nullptr;
+
+    status = KVolumeNamespace::DeleteFileOrDirectory(fileName, KtlSystem::GlobalNonPagedAllocator(), sync);
+    VERIFY_IS_TRUE(NT_SUCCESS(status), "Delete file");
+    status = sync.WaitForCompletion();
+
+    return(STATUS_SUCCESS);
+}
+#endif
+
 NTSTATUS MiscTest(
     __in ULONGLONG TestSize,
     __in KWString dirName
@@ -2989,6 +3161,11 @@ KBlockFileTestX(
         if (! NT_SUCCESS(status)) {
             goto Finish;
         }
+
+        status = FlushCoalescingTest(dirName);
+        if (! NT_SUCCESS(status)) {
+            goto Finish;
+        }
     }
 #endif
 
@@ -42,6 +42,7 @@ namespace Common
 #include <aio.h>
 #include <pwd.h>
 #include <grp.h>
+#include <sched.h>
 #include <sys/epoll.h>
 #include <sys/time.h>
 #include "PAL.h" // from prod/src/inc/clr
@@ -114,6 +115,9 @@ typedef int pid_t;
 #include <locale>
 
 #include <perflib.h>
+#if defined(PLATFORM_UNIX)
+#include <perflib_shm.h>
+#endif
 
 #include "FabricTypes.h"
 
@@ -236,6 +240,7 @@ typedef int pid_t;
 #include "Common/StackTrace.h"
 
 #include "Common/Stopwatch.h"
+#include "Common/LatencyHistogram.h"
 #include "Common/Bique.h"
 
 #include "Common/ProcessTerminationService.h"
@@ -290,6 +295,7 @@ typedef int pid_t;
 #include "Common/EventLoop.h"
 #endif
 #include "Common/Timer.h"
+#include "Common/TraceBinaryFileSink.h"
 #include "Common/Handle.h"
 #include "Common/ProcessWait.h"
 #include "Common/ThreadpoolWait.h"
@@ -432,6 +438,7 @@ typedef int pid_t;
 #include "Common/PerformanceCounterSetInstanceType.h"
 #include "Common/PerformanceCounterType.h"
 #include "Common/PerformanceCounterData.h"
+#include "Common/PerformanceCounterShardedData.h"
 #include "Common/PerformanceCounterAverageTimerData.h"
 #include "Common/PerformanceProvider.h"
 #include "Common/PerformanceProviderCollection.h"
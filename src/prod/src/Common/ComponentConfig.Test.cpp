@@ -0,0 +1,141 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <boost/test/unit_test.hpp>
+#include "Common/boost-taef.h"
+
+using namespace std;
+using namespace Common;
+
+class SnapshotTestConfig : public ComponentConfig
+{
+    DECLARE_COMPONENT_CONFIG(SnapshotTestConfig, "SnapshotTestConfig")
+
+    TEST_CONFIG_ENTRY(string, "SnapshotTest", DynamicString, "default", Common::ConfigEntryUpgradePolicy::Dynamic);
+    TEST_CONFIG_ENTRY(TimeSpan, "SnapshotTest", DynamicTimeout, TimeSpan::FromSeconds(30), Common::ConfigEntryUpgradePolicy::Dynamic);
+    TEST_CONFIG_ENTRY(string, "SnapshotTest", StaticString, "static", Common::ConfigEntryUpgradePolicy::Static);
+
+public:
+    // what the getter of a Dynamic string entry did before snapshots
+    string Test_LockedRead() const
+    {
+        AcquireWriteLock grab(configLock_);
+        return DynamicString_.GetValue();
+    }
+};
+
+class ComponentConfigTest
+{
+protected:
+    // readCount reads from each of threadCount threads, returns elapsed time
+    static TimeSpan RunReaders(int threadCount, int readCount, function<bool(void)> const & read);
+};
+
+TimeSpan ComponentConfigTest::RunReaders(int threadCount, int readCount, function<bool(void)> const & read)
+{
+    atomic_long pending(threadCount);
+    atomic_long failed(0);
+    ManualResetEvent completed(false);
+
+    Stopwatch stopwatch;
+    stopwatch.Start();
+
+    for (int i = 0; i < threadCount; ++i)
+    {
+        Threadpool::Post([&]()
+        {
+            for (int j = 0; j < readCount; ++j)
+            {
+                if (!read())
+                {
+                    ++failed;
+                }
+            }
+
+            if (--pending == 0)
+            {
+                completed.Set();
+            }
+        });
+    }
+
+    BOOST_REQUIRE(completed.WaitOne(TimeSpan::FromMinutes(5)));
+    BOOST_REQUIRE(failed.load() == 0);
+
+    stopwatch.Stop();
+    return stopwatch.Elapsed;
+}
+
+BOOST_FIXTURE_TEST_SUITE2(ComponentConfigTestSuite, ComponentConfigTest)
+
+BOOST_AUTO_TEST_CASE(SnapshotUpdate)
+{
+    ENTER;
+
+    SnapshotTestConfig config;
+    BOOST_REQUIRE(config.DynamicString == "default");
+    BOOST_REQUIRE(config.DynamicTimeout == TimeSpan::FromSeconds(30));
+
+    auto snapshot = config.GetSnapshot();
+    BOOST_REQUIRE(snapshot->TryGetValue(config.DynamicStringEntry) != nullptr);
+    BOOST_REQUIRE(snapshot->TryGetValue(config.DynamicTimeoutEntry) != nullptr);
+
+    // Static entries are read without the lock and are not kept in snapshots
+    BOOST_REQUIRE(config.StaticString == "static");
+    BOOST_REQUIRE(config.GetSnapshot()->TryGetValue(config.StaticStringEntry) == nullptr);
+    BOOST_REQUIRE(config.get_StaticStringFrom(*snapshot) == "static");
+
+    config.DynamicString = "updated";
+    BOOST_REQUIRE(config.DynamicString == "updated");
+
+    auto updated = config.GetSnapshot();
+    BOOST_REQUIRE(updated->Version > snapshot->Version);
+
+    // values read from a snapshot do not change with later updates
+    BOOST_REQUIRE(config.get_DynamicStringFrom(*snapshot) == "default");
+    BOOST_REQUIRE(config.get_DynamicStringFrom(*updated) == "updated");
+    BOOST_REQUIRE(config.get_DynamicTimeoutFrom(*updated) == TimeSpan::FromSeconds(30));
+
+    config.DynamicStringEntry.Test_SetValue("test");
+    BOOST_REQUIRE(config.DynamicString == "test");
+    BOOST_REQUIRE(config.GetSnapshot()->Version > updated->Version);
+
+    LEAVE;
+}
+
+BOOST_AUTO_TEST_CASE(ContentionBenchmark)
+{
+    ENTER;
+
+    int const threadCount = max(static_cast<int>(Environment::GetNumberOfProcessors()), 4);
+    int const readCount = 100000;
+
+    SnapshotTestConfig config;
+    config.DynamicString = "a value long enough to not fit in the small string buffer";
+
+    auto locked = RunReaders(threadCount, readCount, [&config] { return !config.Test_LockedRead().empty(); });
+    auto lockFree = RunReaders(threadCount, readCount, [&config] { return !config.DynamicString.empty(); });
+
+    auto batch = RunReaders(threadCount, readCount / 2, [&config]
+    {
+        auto snapshot = config.GetSnapshot();
+        return !config.get_DynamicStringFrom(*snapshot).empty() && (config.get_DynamicTimeoutFrom(*snapshot) > TimeSpan::Zero);
+    });
+
+    Trace.WriteInfo(
+        TraceType,
+        "{0} threads, {1} reads each: locked {2}, snapshot {3}, two reads per snapshot {4}",
+        threadCount,
+        readCount,
+        locked,
+        lockFree,
+        batch);
+
+    LEAVE;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
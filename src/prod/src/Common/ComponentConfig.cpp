@@ -13,7 +13,9 @@ ComponentConfig::ComponentConfig(StringLiteral name)
     config_(),
     traceId_(),
     name_(name),
-    sections_()
+    sections_(),
+    snapshot_(),
+    snapshotVersion_(0)
 {
 }
 
@@ -22,7 +24,9 @@ ComponentConfig::ComponentConfig(ConfigStoreSPtr const & store, StringLiteral na
     config_(store),
     traceId_(),
     name_(name),
-    sections_()
+    sections_(),
+    snapshot_(),
+    snapshotVersion_(0)
 {
 }
 
@@ -52,6 +56,11 @@ void ComponentConfig::AddEntry(string const & section, ConfigEntryBase & entry)
 bool ComponentConfig::OnUpdate(string const & section, string const & key)
 {
     AcquireReadLock grab(configLock_);
+
+    // Invalidate first, so that readers do not see the old values once
+    // notifications for the new ones are raised
+    InvalidateSnapshot();
+
     for (auto it = sections_.begin(); it != sections_.end(); ++it)
     {
         (*it)->ClearCachedValue();
@@ -68,6 +77,73 @@ bool ComponentConfig::OnUpdate(string const & section, string const & key)
     return true;
 }
 
+ComponentConfig::SnapshotSPtr ComponentConfig::GetSnapshot() const
+{
+    auto snapshot = atomic_load(&snapshot_);
+    if (snapshot)
+    {
+        return snapshot;
+    }
+
+    AcquireWriteLock grab(configLock_);
+
+    snapshot = atomic_load(&snapshot_);
+    if (!snapshot)
+    {
+        snapshot = RebuildSnapshotCallerHoldingLock();
+    }
+
+    return snapshot;
+}
+
+void ComponentConfig::InvalidateSnapshot()
+{
+    ++snapshotVersion_;
+    atomic_store(&snapshot_, SnapshotSPtr());
+}
+
+void ComponentConfig::PublishSnapshotCallerHoldingLock(ConfigEntryBase const & entry) const
+{
+    // snapshot_ is only replaced under the write lock, except for being invalidated
+    auto current = atomic_load(&snapshot_);
+    if (!current)
+    {
+        RebuildSnapshotCallerHoldingLock();
+        return;
+    }
+
+    if (current->TryGetValue(&entry) != nullptr)
+    {
+        return;
+    }
+
+    auto value = entry.CreateSnapshotValue();
+    if (value)
+    {
+        atomic_store(&snapshot_, SnapshotSPtr(make_shared<Snapshot>(*current, Snapshot::EntryValue(&entry, move(value)))));
+    }
+}
+
+ComponentConfig::SnapshotSPtr ComponentConfig::RebuildSnapshotCallerHoldingLock() const
+{
+    vector<Snapshot::EntryValue> values;
+    for (auto it = sections_.begin(); it != sections_.end(); ++it)
+    {
+        (*it)->GetSnapshotValues(values);
+    }
+
+    auto snapshot = make_shared<Snapshot>(snapshotVersion_.load(), move(values));
+
+    WriteNoise(
+        Name,
+        "Rebuilt snapshot {0} with {1} entries",
+        snapshot->Version,
+        snapshot->Count);
+
+    atomic_store(&snapshot_, SnapshotSPtr(snapshot));
+    return snapshot;
+}
+
 bool ComponentConfig::CheckUpdate(string const & section, string const & key, string const & value, bool isEncrypted)
 {
     AcquireReadLock grab(configLock_);
@@ -104,6 +180,28 @@ void ComponentConfig::ComponentConfigSection::ClearCachedValue()
     }
 }
 
+void ComponentConfig::ComponentConfigSection::GetSnapshotValues(vector<Snapshot::EntryValue> & values)
+{
+    for (auto it = entries_.begin(); it != entries_.end(); ++it)
+    {
+        if ((*it)->UpgradePolicy != ConfigEntryUpgradePolicy::Dynamic)
+        {
+            continue;
+        }
+
+        if (!(*it)->HasValue)
+        {
+            (*it)->LoadValue();
+        }
+
+        auto value = (*it)->CreateSnapshotValue();
+        if (value)
+        {
+            values.push_back(Snapshot::EntryValue(*it, move(value)));
+        }
+    }
+}
+
 bool ComponentConfig::ComponentConfigSection::OnUpdate(string const & key)
 {
     for (auto it = entries_.begin(); it != entries_.end(); ++it)
@@ -129,3 +227,37 @@ bool ComponentConfig::ComponentConfigSection::CheckUpdate(string const & key, st
     
     return true;
 }
+
+namespace
+{
+    bool EntryValueLess(ComponentConfig::Snapshot::EntryValue const & left, ComponentConfig::Snapshot::EntryValue const & right)
+    {
+        return less<ConfigEntryBase const *>()(left.first, right.first);
+    }
+}
+
+ComponentConfig::Snapshot::Snapshot(uint64 version, vector<EntryValue> && values)
+    : version_(version),
+    values_(move(values))
+{
+    sort(values_.begin(), values_.end(), EntryValueLess);
+}
+
+ComponentConfig::Snapshot::Snapshot(Snapshot const & other, EntryValue && added)
+    : version_(other.version_),
+    values_()
+{
+    values_.reserve(other.values_.size() + 1);
+    values_.insert(values_.end(), other.values_.begin(), other.values_.end());
+
+    auto it = lower_bound(values_.begin(), values_.end(), added, EntryValueLess);
+    values_.insert(it, move(added));
+}
+
+void const * ComponentConfig::Snapshot::TryGetValue(ConfigEntryBase const * entry) const
+{
+    EntryValue key(entry, nullptr);
+    auto it = lower_bound(values_.begin(), values_.end(), key, EntryValueLess);
+
+    return (it != values_.end() && it->first == entry) ? it->second.get() : nullptr;
+}
@@ -14,6 +14,45 @@ namespace Common
         DENY_COPY(ComponentConfig);
 
     public:
+        // Immutable copy of the values of Dynamic entries, published through an atomic shared pointer,
+        // so that getters of Dynamic entries read it without acquiring configLock_. It is invalidated
+        // when the config store reports an update or a value is set, and rebuilt on the next read.
+        // Values read from one snapshot are consistent with each other, use get_XxxFrom(snapshot)
+        // for a batch of reads. Rebuilding loads the value of every Dynamic entry registered with the
+        // component, read or not; an entry registered after the rebuild is added on its first read.
+        class Snapshot
+        {
+            DENY_COPY(Snapshot);
+
+        public:
+            typedef std::pair<ConfigEntryBase const *, std::shared_ptr<void const>> EntryValue;
+
+            Snapshot(uint64 version, std::vector<EntryValue> && values);
+            Snapshot(Snapshot const & other, EntryValue && added);
+
+            __declspec(property(get=get_Version)) uint64 Version;
+            uint64 get_Version() const { return version_; }
+
+            __declspec(property(get=get_Count)) size_t Count;
+            size_t get_Count() const { return values_.size(); }
+
+            template <typename T>
+            T const * TryGetValue(ConfigEntry<T> const & entry) const
+            {
+                return static_cast<T const *>(TryGetValue(static_cast<ConfigEntryBase const *>(&entry)));
+            }
+
+            void const * TryGetValue(ConfigEntryBase const * entry) const;
+
+        private:
+            uint64 version_;
+
+            // sorted by entry
+            std::vector<EntryValue> values_;
+        };
+
+        typedef std::shared_ptr<Snapshot const> SnapshotSPtr;
+
         virtual ~ComponentConfig();
 
         __declspec(property(get=get_Name)) StringLiteral Name;
@@ -46,10 +85,18 @@ namespace Common
             return traceId_;
         }
 
+        // Returns the current snapshot, it is only rebuilt under configLock_ if it has been invalidated
+        SnapshotSPtr GetSnapshot() const;
+
+        void InvalidateSnapshot();
+
     protected:
         ComponentConfig(StringLiteral name);
         ComponentConfig(ConfigStoreSPtr const & store, StringLiteral name);
 
+        // Adds the value of an entry just loaded to the current snapshot
+        void PublishSnapshotCallerHoldingLock(ConfigEntryBase const & entry) const;
+
     private:
         class ComponentConfigSection
         {
@@ -66,6 +113,9 @@ namespace Common
 
             void ClearCachedValue();
 
+            // loads Dynamic entries without a cached value and collects their values
+            void GetSnapshotValues(std::vector<Snapshot::EntryValue> & values);
+
             bool OnUpdate(std::string const & key);
             bool CheckUpdate(std::string const & key, std::string const & value, bool isEncrypted);
 
@@ -76,6 +126,8 @@ namespace Common
 
         typedef std::unique_ptr<ComponentConfigSection> ComponentConfigSectionUPtr;
 
+        SnapshotSPtr RebuildSnapshotCallerHoldingLock() const;
+
     protected:
         mutable RwLock configLock_;
         Config config_;
@@ -84,6 +136,10 @@ namespace Common
     private:
         StringLiteral name_;
         mutable std::vector<ComponentConfigSectionUPtr> sections_;
+
+        // read and replaced with atomic_load/atomic_store, null after being invalidated
+        mutable SnapshotSPtr snapshot_;
+        Common::atomic_uint64 snapshotVersion_;
     };
 
 // Clang doesn't concatenate as MSVC does, 
@@ -112,11 +168,18 @@ __pragma(warning(disable: 4127)) \
         if (upgrade_policy == Common::ConfigEntryUpgradePolicy::Dynamic && (Common::is_blittable<type>::value == false || sizeof(type) > sizeof(void*))) \
 __pragma(warning(pop))  \
         {   \
+            auto snapshot = GetSnapshot();  \
+            auto value = snapshot->TryGetValue(property_name##_);   \
+            if (value != nullptr)   \
+            {   \
+                return *value;  \
+            }   \
             Common::AcquireWriteLock grab(configLock_);   \
             if (property_name##_.HasValue == false) \
             {   \
                 property_name##_.Load(this, section_name, #property_name, default_value, upgrade_policy, ##__VA_ARGS__);    \
             }                                                                                               \
+            PublishSnapshotCallerHoldingLock(property_name##_); \
             return property_name##_.GetValue(); \
         }   \
         else    \
@@ -124,10 +187,16 @@ __pragma(warning(pop))  \
             return get_##property_name##Entry().GetValue(); \
         }   \
     }   \
+    inline type get_##property_name##From(Common::ComponentConfig::Snapshot const & snapshot) const  \
+    {   \
+        auto value = snapshot.TryGetValue(property_name##_);   \
+        return (value != nullptr) ? *value : get_##property_name();  \
+    }   \
     inline void set_##property_name(type const & value) \
     {   \
     Common::AcquireWriteLock grab(configLock_);   \
     property_name##_.SetValue(this, section_name, #property_name, value, default_value, upgrade_policy, ##__VA_ARGS__); \
+    InvalidateSnapshot();   \
     }   \
 private:    \
     mutable Common::ConfigEntry<type> property_name##_;
@@ -33,6 +33,17 @@ namespace Common
 
         bool IsEncrypted() { return isEncrypted_; }
 
+        std::shared_ptr<void const> CreateSnapshotValue() const override
+        {
+            // decrypted values are not kept around
+            if (isEncrypted_)
+            {
+                return nullptr;
+            }
+
+            return std::make_shared<T>(value_);
+        }
+
         std::string GetEncryptedValue() { return encryptedValue_; }
 
         __declspec(property(get=get_DefaultValue)) T const & DefaultValue;
@@ -176,6 +187,7 @@ namespace Common
             if (value != value_)
             {
                 SetValueInternal(value);
+                InvalidateSnapshot();
                 event_.Fire(EventArgs(), true);
             }
 		}
@@ -73,6 +73,14 @@ bool ConfigEntryBase::CheckUpdate(string const & value, bool isEncrypted)
     return ((upgradePolicy_ == ConfigEntryUpgradePolicy::Dynamic) || !LoadValue(stringValue, isEncrypted, true));
 }
 
+void ConfigEntryBase::InvalidateSnapshot()
+{
+    if (componentConfig_ != nullptr)
+    {
+        componentConfig_->InvalidateSnapshot();
+    }
+}
+
 bool ConfigEntryBase::Matches(std::string const & key)
 {
     return (key_ == key || key_.size() == 0);
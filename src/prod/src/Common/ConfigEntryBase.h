@@ -26,11 +26,17 @@ namespace Common
         bool get_HasValue() const { return hasValue_; }
         void set_HasValue(bool value) { hasValue_ = value; }
 
+        __declspec(property(get=get_UpgradePolicy)) ConfigEntryUpgradePolicy::Enum UpgradePolicy;
+        ConfigEntryUpgradePolicy::Enum get_UpgradePolicy() const { return upgradePolicy_; }
+
         void Initialize(ComponentConfig const * componentConfig, std::string const & section, std::string const & key, ConfigEntryUpgradePolicy::Enum upgradePolicy);
 
         virtual bool LoadValue() = 0;
         virtual bool LoadValue(std::string & stringValue, bool isEncrypted, bool isCheckOnly) = 0;
 
+        // Copy of the current value kept in ComponentConfig::Snapshot, null if the value is not kept there
+        virtual std::shared_ptr<void const> CreateSnapshotValue() const { return nullptr; }
+
         bool Matches(std::string const & key);
 
         HHandler AddHandler(EventHandler const & handler);
@@ -40,6 +46,9 @@ namespace Common
         bool OnUpdate();
         bool CheckUpdate(std::string const & value, bool isEncrypted);
 
+    protected:
+        void InvalidateSnapshot();
+
     protected:
         ComponentConfig* componentConfig_;
         std::string section_;
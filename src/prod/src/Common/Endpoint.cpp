@@ -114,6 +114,13 @@ namespace Common
 
     ErrorCode Endpoint::TryParse(std::string const & str, Endpoint & ep)
     {
+#ifdef PLATFORM_UNIX
+        if (IsUnixDomainAddress(str))
+        {
+            return TryParseUnixDomain(str, ep);
+        }
+#endif
+
         ::ZeroMemory(&ep.address, sizeof(ep.address));
 
         int size = sizeof( ep.address );
@@ -150,6 +157,47 @@ namespace Common
     }
 
 
+#ifdef PLATFORM_UNIX
+    static char const UnixDomainAddressPrefix[] = "unix:";
+
+    bool Endpoint::IsUnixDomainAddress(std::string const & str)
+    {
+        return str.compare(0, sizeof(UnixDomainAddressPrefix) - 1, UnixDomainAddressPrefix) == 0;
+    }
+
+    ErrorCode Endpoint::TryParseUnixDomain(std::string const & str, Endpoint & ep)
+    {
+        if (!IsUnixDomainAddress(str))
+        {
+            return ErrorCodeValue::InvalidAddress;
+        }
+
+        auto path = str.substr(sizeof(UnixDomainAddressPrefix) - 1);
+
+        ::ZeroMemory(&ep.address, sizeof(ep.address));
+        auto sockAddrUn = reinterpret_cast<struct ::sockaddr_un*>(&ep.address);
+
+        // path must be null terminated in sun_path
+        if (path.empty() || (path.size() >= sizeof(sockAddrUn->sun_path)))
+        {
+            return ErrorCodeValue::InvalidAddress;
+        }
+
+        sockAddrUn->sun_family = AF_UNIX;
+        KMemCpySafe(sockAddrUn->sun_path, sizeof(sockAddrUn->sun_path), path.c_str(), path.size());
+        return ErrorCodeValue::Success;
+    }
+
+    std::string Endpoint::GetUnixDomainPath() const
+    {
+        Invariant(IsUnixDomain());
+
+        // unnamed for the connecting side of an accepted connection
+        auto sockAddrUn = reinterpret_cast<struct ::sockaddr_un const*>(&address);
+        return std::string(sockAddrUn->sun_path, ::strnlen(sockAddrUn->sun_path, sizeof(sockAddrUn->sun_path)));
+    }
+#endif
+
     //////////////////////////////////////////////////////////////////////
     //
     // Endpoint
@@ -189,6 +237,15 @@ namespace Common
         //
         // It is acceptable for sockaddr to be completely 0
         //
+#ifdef PLATFORM_UNIX
+        if ( addr.sa_family == AF_UNIX )
+        {
+            ::ZeroMemory( &address, sizeof( address ) );
+            KMemCpySafe(&address, sizeof(address), &addr, sizeof( sockaddr_un ));
+            return;
+        }
+#endif
+
         ASSERT_IFNOT(
             addr.sa_family == AF_INET || addr.sa_family == AF_INET6 || addr.sa_family == 0,
             "Invalid address family");
@@ -245,6 +302,11 @@ namespace Common
 
     bool Endpoint::IsLoopback()const
     {
+        if (IsUnixDomain())
+        {
+            return true;
+        }
+
         if (IsIPv4())
         {
             static const int loopbackMask = INADDR_LOOPBACK & 0xff000000;
@@ -334,6 +396,14 @@ namespace Common
 
     void Endpoint::ToString(std::string& result) const
     {
+#ifdef PLATFORM_UNIX
+        if (IsUnixDomain())
+        {
+            result = UnixDomainAddressPrefix + GetUnixDomainPath();
+            return;
+        }
+#endif
+
         result = formatString.L("{0}:{1}", GetIpString2(), Port);
     }
 
@@ -452,6 +522,13 @@ namespace Common
         }
         else
         {
+#ifdef PLATFORM_UNIX
+            if (address.ss_family == AF_UNIX)
+            {
+                return GetUnixDomainPath() < rhs.GetUnixDomainPath();
+            }
+#endif
+
             if (address.ss_family == AF_INET) 
             {
                 return 
@@ -7,6 +7,9 @@
 
 #include <ws2ipdef.h>
 #include <mstcpip.h>
+#ifdef PLATFORM_UNIX
+#include <sys/un.h>
+#endif
 
 //#ifndef _PREFAST_
 //#  pragma warning(disable:4068)
@@ -27,7 +30,10 @@ namespace Common
             Unknown             = -1,   // Unknown
             Unspecified = AF_UNSPEC,    // unspecified
             InterNetwork        = AF_INET,
-            InterNetworkV6        = AF_INET6
+            InterNetworkV6        = AF_INET6,
+#ifdef PLATFORM_UNIX
+            Unix                = AF_UNIX
+#endif
         };
     };
 
@@ -71,6 +77,13 @@ namespace Common
 
         static ErrorCode TryParse(std::string const & input, Endpoint & output);
 
+#ifdef PLATFORM_UNIX
+        // Unix domain socket addresses are in the form of "unix:<socket file path>"
+        static bool IsUnixDomainAddress(std::string const & input);
+        static ErrorCode TryParseUnixDomain(std::string const & input, Endpoint & output);
+        std::string GetUnixDomainPath() const;
+#endif
+
         explicit Endpoint() 
         {
             ZeroMemory( &address, sizeof(address) );
@@ -101,6 +114,11 @@ namespace Common
 
         int get_AddressLength() const
         {
+#ifdef PLATFORM_UNIX
+            if ( address.ss_family == AF_UNIX ) {
+                return sizeof( sockaddr_un );
+            }
+#endif
             debug_assert( address.ss_family == AF_INET6 || address.ss_family == AF_INET );
 
 #pragma prefast(suppress: 24002, "IPv4 and IPv6 code paths provided")
@@ -125,12 +143,23 @@ namespace Common
 
         ::USHORT get_Port() const
         {
+            if ( IsUnixDomain() ) {
+                return 0;
+            }
+
             // note that this works also for sockaddr_in6
             return ntohs(reinterpret_cast<const struct ::sockaddr_in*>(&address)->sin_port);
         }
 
+        //
+        // Unix domain socket addresses have no port, the path would be overwritten
+        //
         void put_Port( ::USHORT value )
         {
+            if ( IsUnixDomain() ) {
+                return;
+            }
+
             // note that this works also for sockaddr_in6
             reinterpret_cast<struct ::sockaddr_in*>(&address)->sin_port = htons(value);
         }
@@ -168,6 +197,15 @@ namespace Common
             return IsIPV6();
         }
 
+        bool IsUnixDomain () const
+        {
+#ifdef PLATFORM_UNIX
+            return (address.ss_family == AF_UNIX);
+#else
+            return false;
+#endif
+        }
+
         // ipString must be large enough to hold INET_ADDRSTRLEN/INET6_ADDRSTRLEN characters, depending on address type
         void GetIpString(_Out_writes_(size) CHAR * ipString, socklen_t size = INET6_ADDRSTRLEN) const;
         void GetIpString(_Out_ std::string & ipString) const;
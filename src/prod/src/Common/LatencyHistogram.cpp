@@ -0,0 +1,122 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+using namespace Common;
+using namespace std;
+
+namespace
+{
+    const int64 TicksPerMicrosecond = 10;
+}
+
+LatencyHistogram::LatencyHistogram() : maxTicks_(0)
+{
+}
+
+size_t LatencyHistogram::BucketIndex(int64 microseconds)
+{
+    size_t index = 0;
+    while ((microseconds > 0) && (index < (BucketCount - 1)))
+    {
+        microseconds >>= 1;
+        ++index;
+    }
+
+    return index;
+}
+
+TimeSpan LatencyHistogram::BucketUpperBound(size_t index)
+{
+    if (index >= (BucketCount - 1))
+    {
+        return TimeSpan::MaxValue;
+    }
+
+    return TimeSpan::FromTicks((static_cast<int64>(1) << index) * TicksPerMicrosecond);
+}
+
+void LatencyHistogram::Add(TimeSpan latency)
+{
+    int64 ticks = max<int64>(latency.Ticks, 0);
+
+    ++buckets_[BucketIndex(ticks / TicksPerMicrosecond)];
+    ++count_;
+
+    LONGLONG currentMax = maxTicks_;
+    while (ticks > currentMax)
+    {
+        auto previous = InterlockedCompareExchange64(&maxTicks_, ticks, currentMax);
+        if (previous == currentMax)
+        {
+            break;
+        }
+
+        currentMax = previous;
+    }
+}
+
+uint64 LatencyHistogram::Count() const
+{
+    return count_.load();
+}
+
+TimeSpan LatencyHistogram::Max() const
+{
+    return TimeSpan::FromTicks(maxTicks_);
+}
+
+TimeSpan LatencyHistogram::Percentile(double percentile) const
+{
+    // buckets are updated independently of count_, sum them up for a consistent view
+    uint64 counts[BucketCount];
+    uint64 total = 0;
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        counts[i] = buckets_[i].load();
+        total += counts[i];
+    }
+
+    if (total == 0)
+    {
+        return TimeSpan::Zero;
+    }
+
+    auto rank = static_cast<uint64>(ceil(total * percentile / 100));
+    uint64 seen = 0;
+    for (size_t i = 0; i < BucketCount; ++i)
+    {
+        seen += counts[i];
+        if (seen >= rank)
+        {
+            return min(BucketUpperBound(i), Max());
+        }
+    }
+
+    return Max();
+}
+
+void LatencyHistogram::Reset()
+{
+    for (auto & bucket : buckets_)
+    {
+        bucket.store(0);
+    }
+
+    count_.store(0);
+    InterlockedExchange64(&maxTicks_, 0);
+}
+
+void LatencyHistogram::WriteTo(TextWriter & w, FormatOptions const &) const
+{
+    w.Write(
+        "count = {0}, p50 <= {1}, p99 <= {2}, p99.9 <= {3}, max = {4}",
+        Count(),
+        Percentile(50),
+        Percentile(99),
+        Percentile(99.9),
+        Max());
+}
@@ -0,0 +1,43 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Common
+{
+    // Histogram of latencies with power of two microsecond buckets. Recording is lock free
+    // and cheap enough for hot paths, percentiles are approximated by bucket upper bounds.
+    class LatencyHistogram
+    {
+        DENY_COPY(LatencyHistogram);
+
+    public:
+        // bucket 0 holds latencies below 1us, bucket i holds [2^(i-1), 2^i)us,
+        // the last bucket holds everything from 2^(BucketCount-2)us upwards
+        static const size_t BucketCount = 32;
+
+        LatencyHistogram();
+
+        void Add(TimeSpan latency);
+
+        uint64 Count() const;
+        TimeSpan Max() const;
+
+        // upper bound of the bucket containing the given percentile, percentile is in (0, 100]
+        TimeSpan Percentile(double percentile) const;
+
+        void Reset();
+
+        void WriteTo(TextWriter & w, FormatOptions const &) const;
+
+    private:
+        static size_t BucketIndex(int64 microseconds);
+        static TimeSpan BucketUpperBound(size_t index);
+
+        atomic_uint64 buckets_[BucketCount];
+        atomic_uint64 count_;
+        volatile LONGLONG maxTicks_;
+    };
+}
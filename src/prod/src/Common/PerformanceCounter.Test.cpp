@@ -20,6 +20,13 @@
 #include "Common/PerformanceCounterSetDefinition.h"
 #include "Common/PerformanceProviderDefinition.h"
 
+#if defined(PLATFORM_UNIX)
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
 namespace Common
 {
     Guid testCounterSet1Id("B11EA2D6-F1E0-4C4B-9C26-F304AC4B1462");
@@ -54,8 +61,13 @@ namespace Common
 
     INITIALIZE_COUNTER_SET(TestCounterSet1)
 
+    StringLiteral const TraceComponent("PerformanceCounterTest");
+
     class PerformanceCounterTest
     {
+    protected:
+        template <typename TCounter>
+        static TimeSpan RunContention(TCounter & counter, int threadCount, int incrementsPerThread);
     };
 
     BOOST_FIXTURE_TEST_SUITE(PerformanceCounterTestSuite,PerformanceCounterTest)
@@ -490,5 +502,229 @@ namespace Common
         }
     }
 
+    BOOST_AUTO_TEST_CASE(TestShardedPerformanceCounter)
+    {
+        Guid providerId = Guid::NewGuid();
+        Guid counterSetId = Guid::NewGuid();
+
+        auto counterSet = std::make_shared<PerformanceCounterSet>(providerId, counterSetId, PerformanceCounterSetInstanceType::Multiple);
+
+        counterSet->AddCounter(1, PerformanceCounterType::RawData64);
+        counterSet->AddCounter(2, PerformanceCounterType::AverageBase, true);
+
+        VERIFY_IS_FALSE(counterSet->IsShardedCounter(1));
+        VERIFY_IS_TRUE(counterSet->IsShardedCounter(2));
+
+        auto instance = counterSet->CreateCounterSetInstance("shardedInstance");
+
+        PerformanceCounterShardedData & sharded = instance->GetShardedCounter(2);
+
+        VERIFY_IS_TRUE(sharded.ShardCount >= 1);
+        VERIFY_ARE_EQUAL(0u, sharded.ShardCount & (sharded.ShardCount - 1));
+
+        sharded.Increment();
+        sharded.IncrementBy(10);
+        sharded.Decrement();
+
+        VERIFY_ARE_EQUAL(10, sharded.Value);
+
+        // updates from many threads are all accounted for once the cells are summed
+        RunContention(sharded, 8, 10000);
+
+        VERIFY_ARE_EQUAL(10 + 8 * 10000, sharded.Value);
+
+        // setting the value folds the cells back into the base counter
+        auto previous = sharded.set_Value(5);
+
+        VERIFY_ARE_EQUAL(10 + 8 * 10000, previous);
+        VERIFY_ARE_EQUAL(5, sharded.Value);
+        VERIFY_ARE_EQUAL(5, instance->GetCounter(2).Value);
+
+        // privately allocated cells behave the same
+        PerformanceCounterData base = { 0 };
+        PerformanceCounterShardedData privateSharded(base);
+
+        RunContention(privateSharded, 4, 1000);
+
+        VERIFY_ARE_EQUAL(4 * 1000, privateSharded.Value);
+
+        // the cells are folded into the base counter, which is what perflib exports on
+        // Windows, so the base counter trails by less than a fold interval per cell
+        VERIFY_IS_TRUE(base.Value <= 4 * 1000);
+        VERIFY_IS_TRUE(4 * 1000 - base.Value < static_cast<LONGLONG>(privateSharded.ShardCount) * PerformanceCounterShardedData::FoldInterval);
+
+        // with a single cell every FoldInterval-th update folds the cell into the base counter
+        alignas(PerformanceCounterShardedData::CellSize) BYTE cell[PerformanceCounterShardedData::CellSize] = { 0 };
+        PerformanceCounterData singleBase = { 0 };
+        PerformanceCounterShardedData singleSharded(singleBase, cell, 1);
+        for (LONGLONG ix = 0; ix < PerformanceCounterShardedData::FoldInterval * 4 + 1; ++ix)
+        {
+            singleSharded.IncrementBy(2);
+        }
+
+        VERIFY_ARE_EQUAL(PerformanceCounterShardedData::FoldInterval * 8 + 2, singleSharded.Value);
+        VERIFY_ARE_EQUAL(PerformanceCounterShardedData::FoldInterval * 8, singleBase.Value);
+    }
+
+    BOOST_AUTO_TEST_CASE(ShardedPerformanceCounterContentionBenchmark)
+    {
+        int threadCount = static_cast<int>(Environment::GetNumberOfProcessors());
+        int incrementsPerThread = 1000000;
+
+        PerformanceCounterData shared = { 0 };
+        auto sharedElapsed = RunContention(shared, threadCount, incrementsPerThread);
+
+        VERIFY_ARE_EQUAL(static_cast<LONGLONG>(threadCount) * incrementsPerThread, shared.Value);
+
+        PerformanceCounterData base = { 0 };
+        PerformanceCounterShardedData sharded(base);
+        auto shardedElapsed = RunContention(sharded, threadCount, incrementsPerThread);
+
+        VERIFY_ARE_EQUAL(static_cast<LONGLONG>(threadCount) * incrementsPerThread, sharded.Value);
+
+        Trace.WriteInfo(
+            TraceComponent,
+            "Contention: threads={0} increments/thread={1} shared={2} ({3} ops/s) sharded={4} ({5} ops/s) shards={6}",
+            threadCount,
+            incrementsPerThread,
+            sharedElapsed,
+            (double)threadCount * incrementsPerThread / sharedElapsed.TotalMillisecondsAsDouble() * 1000,
+            shardedElapsed,
+            (double)threadCount * incrementsPerThread / shardedElapsed.TotalMillisecondsAsDouble() * 1000,
+            sharded.ShardCount);
+    }
+
+#if defined(PLATFORM_UNIX)
+    BOOST_AUTO_TEST_CASE(TestPerformanceCounterSetInstanceSharedMemoryExport)
+    {
+        Guid providerId = Guid::NewGuid();
+        Guid counterSetId = Guid::NewGuid();
+
+        auto counterSet = std::make_shared<PerformanceCounterSet>(providerId, counterSetId, PerformanceCounterSetInstanceType::Multiple);
+
+        counterSet->AddCounter(1, PerformanceCounterType::RawData64);
+        counterSet->AddCounter(2, PerformanceCounterType::AverageBase);
+
+        auto instance = counterSet->CreateCounterSetInstance("sharedMemoryInstance");
+
+        VERIFY_IS_NOT_NULL(instance);
+
+        instance->GetCounter(1).IncrementBy(42);
+        instance->GetCounter(2).Increment();
+
+        // locate the exported region of this counter set the way an out of process reader would
+        std::string prefix = formatString(PERF_SHM_NAME_PREFIX "{0}.", ::getpid());
+        PPERF_SHM_COUNTERSET_HEADER header = nullptr;
+        size_t regionSize = 0;
+
+        DIR * dir = ::opendir(PERF_SHM_DIRECTORY);
+        VERIFY_IS_NOT_NULL(dir);
+
+        struct dirent * entry;
+        while (nullptr == header && nullptr != (entry = ::readdir(dir)))
+        {
+            if (0 != ::strncmp(entry->d_name, prefix.c_str(), prefix.size()))
+            {
+                continue;
+            }
+
+            int fd = ::open(formatString("{0}/{1}", PERF_SHM_DIRECTORY, entry->d_name).c_str(), O_RDONLY);
+            VERIFY_IS_TRUE(fd >= 0);
+
+            struct stat st;
+            VERIFY_IS_TRUE(0 == ::fstat(fd, &st));
+
+            void * addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+            ::close(fd);
+            VERIFY_IS_TRUE(MAP_FAILED != addr);
+
+            auto candidate = static_cast<PPERF_SHM_COUNTERSET_HEADER>(addr);
+            if (Guid(candidate->Instance.CounterSetGuid) == counterSetId)
+            {
+                header = candidate;
+                regionSize = st.st_size;
+            }
+            else
+            {
+                ::munmap(addr, st.st_size);
+            }
+        }
+
+        ::closedir(dir);
+
+        VERIFY_IS_NOT_NULL(header);
+        VERIFY_ARE_EQUAL(PERF_SHM_MAGIC, header->Magic);
+        VERIFY_ARE_EQUAL(PERF_SHM_VERSION, header->Version);
+        VERIFY_ARE_EQUAL(PERF_SHM_STATE_ACTIVE, header->State);
+        VERIFY_ARE_EQUAL(2u, header->NumCounters);
+        VERIFY_ARE_EQUAL(std::string("sharedMemoryInstance"), std::string(header->InstanceName));
+
+        auto values = reinterpret_cast<LONGLONG const *>(reinterpret_cast<BYTE const *>(header) + header->ValuesOffset);
+
+        VERIFY_ARE_EQUAL(42, values[0]);
+        VERIFY_ARE_EQUAL(1, values[1]);
+
+        // updates through the counter are visible through the mapping without copying
+        instance->GetCounter(1).Increment();
+        VERIFY_ARE_EQUAL(43, values[0]);
+
+        // deleting the instance unlinks the region
+        instance.reset();
+
+        dir = ::opendir(PERF_SHM_DIRECTORY);
+        while (nullptr != (entry = ::readdir(dir)))
+        {
+            if (0 == ::strncmp(entry->d_name, prefix.c_str(), prefix.size()))
+            {
+                int fd = ::open(formatString("{0}/{1}", PERF_SHM_DIRECTORY, entry->d_name).c_str(), O_RDONLY);
+                if (fd < 0)
+                {
+                    continue;
+                }
+
+                GUID counterSetGuid;
+                auto read = ::pread(fd, &counterSetGuid, sizeof(counterSetGuid), offsetof(PERF_COUNTERSET_INSTANCE, CounterSetGuid));
+                ::close(fd);
+
+                VERIFY_IS_FALSE(read == sizeof(counterSetGuid) && Guid(counterSetGuid) == counterSetId);
+            }
+        }
+
+        ::closedir(dir);
+        ::munmap(header, regionSize);
+    }
+#endif
+
     BOOST_AUTO_TEST_SUITE_END()
+
+    template <typename TCounter>
+    TimeSpan PerformanceCounterTest::RunContention(TCounter & counter, int threadCount, int incrementsPerThread)
+    {
+        atomic_long pending(threadCount);
+        ManualResetEvent doneEvent(false);
+
+        Stopwatch stopwatch;
+        stopwatch.Start();
+
+        for (int ix = 0; ix < threadCount; ++ix)
+        {
+            Threadpool::Post([&]
+            {
+                for (int jx = 0; jx < incrementsPerThread; ++jx)
+                {
+                    counter.Increment();
+                }
+
+                if (--pending == 0)
+                {
+                    doneEvent.Set();
+                }
+            });
+        }
+
+        VERIFY_IS_TRUE(doneEvent.WaitOne(TimeSpan::FromMinutes(5)));
+
+        stopwatch.Stop();
+        return stopwatch.Elapsed;
+    }
 }
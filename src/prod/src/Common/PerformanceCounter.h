@@ -28,6 +28,20 @@ public: \
 		counterSet.AddCounterDefinition(std::move(counter)); \
 	} \
 
+#define SHARDED_COUNTER_DEFINITION(counterId, counterType, name, description, ...) \
+	{ \
+		Common::PerformanceCounterDefinition counter(counterId, counterType, name, description); \
+		counter.IsSharded = true; \
+		counterSet.AddCounterDefinition(std::move(counter)); \
+	} \
+
+#define SHARDED_COUNTER_DEFINITION_WITH_BASE(counterId, baseCounterId, counterType, name, description, ...) \
+	{ \
+		Common::PerformanceCounterDefinition counter(counterId, baseCounterId, counterType, name, description); \
+		counter.IsSharded = true; \
+		counterSet.AddCounterDefinition(std::move(counter)); \
+	} \
+
 #define END_COUNTER_SET_DEFINITION() \
 		Common::PerformanceProviderDefinition::Singleton()->AddCounterSetDefinition(std::move(counterSet)); \
 		return Common::PerformanceProviderDefinition::Singleton()->GetCounterSetDefinition(counterSetId); \
@@ -35,6 +49,8 @@ public: \
 
 #define DECLARE_COUNTER_INSTANCE(member) Common::PerformanceCounterData & member;
 
+#define DECLARE_SHARDED_COUNTER_INSTANCE(member) Common::PerformanceCounterShardedData & member;
+
 #define DECLARE_AVERAGE_TIME_COUNTER_INSTANCE(member) Common::PerformanceCounterAverageTimerData member; 
 
 #define BEGIN_COUNTER_SET_INSTANCE(className) \
@@ -49,6 +65,7 @@ public: \
 	className(Common::PerformanceCounterSetInstanceSPtr && instance) : \
 		
 #define DEFINE_COUNTER_INSTANCE(member, counterId) member(instance->GetCounter(counterId)),
+#define DEFINE_SHARDED_COUNTER_INSTANCE(member, counterId) member(instance->GetShardedCounter(counterId)),
 #define END_COUNTER_SET_INSTANCE() \
 	instance_(std::move(instance)) \
 	{ \
@@ -69,7 +86,7 @@ public: \
 			auto counters = definition.CounterDefinitions; \
 			for (auto it = begin(counters); end(counters) != it; ++it) \
 			{ \
-				className##__CounterSet->AddCounter(it->second.Identifier, it->second.Type); \
+				className##__CounterSet->AddCounter(it->second.Identifier, it->second.Type, it->second.IsSharded); \
 			} \
 			return TRUE; \
 		} \
@@ -12,7 +12,8 @@ PerformanceCounterDefinition::PerformanceCounterDefinition(PerformanceCounterId
     baseIdentifier_((PerformanceCounterId)(-1)),
     counterType_(type),
     name_(name),
-    description_(description)
+    description_(description),
+    isSharded_(false)
 {
 }
 
@@ -21,7 +22,8 @@ PerformanceCounterDefinition::PerformanceCounterDefinition(PerformanceCounterId
     baseIdentifier_(baseIdentifier),
     counterType_(type),
     name_(name),
-    description_(description)
+    description_(description),
+    isSharded_(false)
 {
 }
 
@@ -30,7 +32,8 @@ PerformanceCounterDefinition::PerformanceCounterDefinition(PerformanceCounterDef
     baseIdentifier_(other.baseIdentifier_),
     counterType_(other.counterType_),
     name_(other.name_),
-    description_(other.description_)
+    description_(other.description_),
+    isSharded_(other.isSharded_)
 {
 }
 
@@ -39,7 +42,8 @@ PerformanceCounterDefinition::PerformanceCounterDefinition(PerformanceCounterDef
     baseIdentifier_(std::move(other.baseIdentifier_)),
     counterType_(std::move(other.counterType_)),
     name_(std::move(other.name_)),
-    description_(std::move(other.description_))
+    description_(std::move(other.description_)),
+    isSharded_(other.isSharded_)
 {
 }
 
@@ -50,6 +54,7 @@ PerformanceCounterDefinition const & PerformanceCounterDefinition::operator = (P
     description_ = other.description_;
     baseIdentifier_ = other.baseIdentifier_;
     counterType_ = other.counterType_;
+    isSharded_ = other.isSharded_;
     
     return *this;
 }
@@ -61,6 +66,7 @@ PerformanceCounterDefinition const & PerformanceCounterDefinition::operator = (P
     description_ = std::move(other.description_);
     baseIdentifier_ = std::move(other.baseIdentifier_);
     counterType_ = std::move(other.counterType_);
+    isSharded_ = other.isSharded_;
 
     return *this;
 }
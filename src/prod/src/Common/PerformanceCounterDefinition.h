@@ -34,6 +34,11 @@ namespace Common
         __declspec(property(get=get_Description)) std::string const & Description;
         inline std::string const & get_Description() const { return description_; }
 
+        // sharded counters spread updates over per-CPU cells (see PerformanceCounterShardedData)
+        __declspec(property(get=get_IsSharded, put=set_IsSharded)) bool IsSharded;
+        inline bool get_IsSharded() const { return isSharded_; }
+        inline void set_IsSharded(bool value) { isSharded_ = value; }
+
     private:
 
         PerformanceCounterId identifier_;
@@ -42,6 +47,8 @@ namespace Common
 
         std::string name_;
         std::string description_;
+
+        bool isSharded_;
     };
 }
 
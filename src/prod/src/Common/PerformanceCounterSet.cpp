@@ -22,11 +22,16 @@ PerformanceCounterSet::~PerformanceCounterSet(void)
 {
 }
 
-void PerformanceCounterSet::AddCounter(PerformanceCounterId counterId, PerformanceCounterType::Enum counterType)
+void PerformanceCounterSet::AddCounter(PerformanceCounterId counterId, PerformanceCounterType::Enum counterType, bool isSharded)
 {
     ASSERT_IF(end(counterTypes_) != counterTypes_.find(counterId), "Counter already exisits.");
 
     counterTypes_[counterId] = counterType;
+
+    if (isSharded)
+    {
+        shardedCounters_.insert(counterId);
+    }
 }
 
 HRESULT PerformanceCounterSet::CreateCounterSetInstance(std::string const & instanceName, bool allocateCounterMemory, bool avoidAssert, PerformanceCounterSetInstance* &counterSetInstance)
@@ -80,6 +85,12 @@ HRESULT PerformanceCounterSet::EnsureInitialized(bool avoidAssert)
                 counterInfo->CounterId = it->first;
                 counterInfo->Type = it->second;
                 counterInfo->Attrib = PERF_ATTRIB_BY_REFERENCE;
+#if defined(PLATFORM_UNIX)
+                if (IsShardedCounter(it->first))
+                {
+                    counterInfo->Attrib |= PERF_ATTRIB_SHARDED;
+                }
+#endif
                 counterInfo->Size = sizeof(PerformanceCounterValue);
                 counterInfo->DetailLevel = PERF_DETAIL_NOVICE;
                 counterInfo->Scale = 0; // scale is exponential, thus 0 is a multiplier of 1, todo: make this customizable
@@ -20,7 +20,7 @@ namespace Common
         PerformanceCounterSet(Guid const & providerId, Guid const & counterSetId, PerformanceCounterSetInstanceType::Enum instanceType);
         ~PerformanceCounterSet(void);
 
-        void AddCounter(PerformanceCounterId counterId, PerformanceCounterType::Enum PerformanceCounterType);
+        void AddCounter(PerformanceCounterId counterId, PerformanceCounterType::Enum PerformanceCounterType, bool isSharded = false);
 
         PerformanceCounterSetInstanceSPtr CreateCounterSetInstance(std::string const & instanceName);
         HRESULT CreateCounterSetInstance(std::string const & instanceName, bool allocateCounterMemory, bool avoidAssert, PerformanceCounterSetInstance* &counterSetInstance);
@@ -34,6 +34,8 @@ namespace Common
         __declspec(property(get=get_CounterTypes)) CounterIdToType const & CounterTypes;
         inline CounterIdToType const & get_CounterTypes() const { return counterTypes_; }
 
+        inline bool IsShardedCounter(PerformanceCounterId counterId) const { return shardedCounters_.find(counterId) != shardedCounters_.end(); }
+
     private:
 
         long nextCounterInstanceId_;
@@ -53,6 +55,9 @@ namespace Common
         // specifies the counter type for every counter (CounterId -> PerformanceCounterType)
         CounterIdToType counterTypes_;
 
+        // counters whose updates are spread over per-CPU cells
+        std::set<PerformanceCounterId> shardedCounters_;
+
         // indicates whether the counter set has been initialized
         // the counter set must be initialized before creating an instance
         bool isInitialized_;
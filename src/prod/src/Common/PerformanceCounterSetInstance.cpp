@@ -26,25 +26,61 @@ PerformanceCounterSetInstance::PerformanceCounterSetInstance(PerformanceCounterS
         return;
     }
 
+#if !defined(PLATFORM_UNIX)
     // set up the backing store for all counter values in the counter set instance
     PerformanceCounterData init = {0};
     counterData_.insert(begin(counterData_), counterSet_->CounterTypes.size(), init);
 
     size_t count = 0;
+#endif
+
     for (auto it = begin(counterSet_->CounterTypes); end(counterSet_->CounterTypes) != it; ++it)
     {
-        PerformanceCounterData & data = counterData_.at(count);
+#if defined(PLATFORM_UNIX)
+        // the counter lives directly in the exported shared memory region so that
+        // out of process readers observe updates without any copying; the PAL falls
+        // back to private memory for the region when shared memory is not available
+        auto data = static_cast<PerformanceCounterData*>(::PerfGetCounterStorage(counterSetInstance_, it->first));
+        if (nullptr == data)
+        {
+            Common::Assert::CodingError("counter {0} of instance '{1}' has no storage", it->first, instanceName);
+        }
+#else
+        PerformanceCounterData * data = &counterData_.at(count);
         count++;
+#endif
 
-        counterIdToCounterData_.insert(std::make_pair(it->first, &data));
+        counterIdToCounterData_.insert(std::make_pair(it->first, data));
 
         if (NULL != counterSetInstance_)
         {
             // connect PerformanceCounterSet instance to backing store
-            auto error = ::PerfSetCounterRefValue(counterSet_->ProviderHandle, counterSetInstance_, it->first, &data.RawValue);
+            auto error = ::PerfSetCounterRefValue(counterSet_->ProviderHandle, counterSetInstance_, it->first, &data->RawValue);
 
             TESTASSERT_IF(ERROR_SUCCESS != error, "PerfSetCounterRefValue failed");
         }
+
+        if (counterSet_->IsShardedCounter(it->first))
+        {
+            std::unique_ptr<PerformanceCounterShardedData> shardedData;
+
+#if defined(PLATFORM_UNIX)
+            // use the exported shard cells so that readers can aggregate them
+            ULONG shardCount = 0;
+            auto cells = ::PerfGetCounterShardStorage(counterSetInstance_, it->first, &shardCount);
+            if (nullptr != cells)
+            {
+                shardedData = std::make_unique<PerformanceCounterShardedData>(*data, cells, shardCount);
+            }
+#endif
+
+            if (!shardedData)
+            {
+                shardedData = std::make_unique<PerformanceCounterShardedData>(*data);
+            }
+
+            counterIdToShardedData_.insert(std::make_pair(it->first, std::move(shardedData)));
+        }
     }
 
 }
@@ -70,6 +106,15 @@ PerformanceCounterData & PerformanceCounterSetInstance::GetCounter(PerformanceCo
     return *(it->second);
 }
 
+PerformanceCounterShardedData & PerformanceCounterSetInstance::GetShardedCounter(PerformanceCounterId id)
+{
+    auto it = counterIdToShardedData_.find(id);
+
+    ASSERT_IF(end(counterIdToShardedData_) == it, "Unknown or unsharded counter id");
+
+    return *(it->second);
+}
+
 HRESULT PerformanceCounterSetInstance::SetCounterRefValue(PerformanceCounterId id, void *addr)
 {
     return HRESULT_FROM_WIN32(::PerfSetCounterRefValue(counterSet_->ProviderHandle, counterSetInstance_, id, addr));
@@ -19,6 +19,8 @@ namespace Common
 
         PerformanceCounterData & GetCounter(PerformanceCounterId id);
 
+        PerformanceCounterShardedData & GetShardedCounter(PerformanceCounterId id);
+
         HRESULT PerformanceCounterSetInstance::SetCounterRefValue(PerformanceCounterId id, void *addr);
 
     private:
@@ -29,7 +31,11 @@ namespace Common
         
         std::map<PerformanceCounterId, PerformanceCounterData *> counterIdToCounterData_;
 
+#if !defined(PLATFORM_UNIX)
         std::vector<PerformanceCounterData> counterData_;
+#endif
+
+        std::map<PerformanceCounterId, std::unique_ptr<PerformanceCounterShardedData>> counterIdToShardedData_;
 
         bool allocateCounterMemory_;
     };
@@ -0,0 +1,76 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+using namespace Common;
+
+PerformanceCounterShardedData::PerformanceCounterShardedData(PerformanceCounterData & base, void * cells, ULONG shardCount) :
+    base_(base),
+    cells_(static_cast<BYTE*>(cells)),
+    shardMask_(shardCount - 1),
+    privateCells_()
+{
+    ASSERT_IF(shardCount == 0 || (shardCount & (shardCount - 1)) != 0, "shard count {0} must be a power of two", shardCount);
+    ASSERT_IF((reinterpret_cast<ULONG_PTR>(cells) % CellSize) != 0, "shard cells must be cache line aligned");
+}
+
+PerformanceCounterShardedData::PerformanceCounterShardedData(PerformanceCounterData & base) :
+    base_(base),
+    cells_(nullptr),
+    shardMask_(GetDefaultShardCount() - 1),
+    privateCells_()
+{
+    // over-allocate by one cell so that the first cell can be aligned to a cache line
+    privateCells_.resize((ShardCount + 1) * CellSize, 0);
+
+    auto address = reinterpret_cast<ULONG_PTR>(privateCells_.data());
+    cells_ = reinterpret_cast<BYTE*>((address + CellSize - 1) & ~static_cast<ULONG_PTR>(CellSize - 1));
+}
+
+PerformanceCounterValue PerformanceCounterShardedData::get_Value(void) const
+{
+    PerformanceCounterValue value = base_.Value;
+
+    for (ULONG ix = 0; ix <= shardMask_; ++ix)
+    {
+        // aligned 64-bit loads are atomic; cells are only ever updated with interlocked operations
+        value += *static_cast<PerformanceCounterValue volatile *>(GetCell(ix));
+    }
+
+    return value;
+}
+
+PerformanceCounterValue PerformanceCounterShardedData::set_Value(PerformanceCounterValue value)
+{
+    PerformanceCounterValue previous = base_.set_Value(value);
+
+    for (ULONG ix = 0; ix <= shardMask_; ++ix)
+    {
+        previous += ::InterlockedExchange64(GetCell(ix), 0);
+    }
+
+    return previous;
+}
+
+void PerformanceCounterShardedData::FoldCell(PerformanceCounterValue * cell)
+{
+    // Value may briefly miss the folded amount between the exchange and the add,
+    // the same as a sample racing with an update.
+    base_.IncrementBy(::InterlockedExchange64(cell, 0));
+}
+
+ULONG PerformanceCounterShardedData::GetDefaultShardCount()
+{
+    ULONG processors = static_cast<ULONG>(Environment::GetNumberOfProcessors());
+
+    ULONG count = 1;
+    while (count < processors && count < MaxShardCount)
+    {
+        count <<= 1;
+    }
+
+    return count;
+}
@@ -0,0 +1,99 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Common
+{
+    //
+    // A counter whose updates are spread over cache line sized cells, one per CPU, so that
+    // counters bumped from many threads do not bounce a single cache line between cores.
+    // Value sums the base counter and the cells. Every FoldInterval updates a cell is also
+    // folded into the base counter, so that readers of the base counter alone (perflib on
+    // Windows, readers that ignore the shard cells of the shared memory export on Linux)
+    // see the value, trailing by less than FoldInterval updates per cell.
+    //
+    class PerformanceCounterShardedData
+    {
+        DENY_COPY(PerformanceCounterShardedData)
+
+    public:
+        static const ULONG CellSize = 64;
+        static const ULONG MaxShardCount = 64;
+        static const LONGLONG FoldInterval = 64;
+
+        // cells are provided by the counter set instance (exported shared memory on Linux)
+        PerformanceCounterShardedData(PerformanceCounterData & base, void * cells, ULONG shardCount);
+
+        // cells are allocated privately
+        explicit PerformanceCounterShardedData(PerformanceCounterData & base);
+
+        inline void Increment()
+        {
+            auto cell = CurrentCell();
+            ::InterlockedIncrement64(cell);
+            OnCellUpdated(cell);
+        }
+
+        inline void Decrement()
+        {
+            auto cell = CurrentCell();
+            ::InterlockedDecrement64(cell);
+            OnCellUpdated(cell);
+        }
+
+        inline void IncrementBy(PerformanceCounterValue value)
+        {
+            auto cell = CurrentCell();
+            ::InterlockedExchangeAdd64(cell, value);
+            OnCellUpdated(cell);
+        }
+
+        __declspec(property(get=get_Value, put=set_Value)) PerformanceCounterValue Value;
+
+        PerformanceCounterValue get_Value(void) const;
+
+        // Not linearizable with concurrent updates: increments racing with the reset
+        // of the cells may be lost, as with a read-modify-write of a plain counter.
+        PerformanceCounterValue set_Value(PerformanceCounterValue value);
+
+        __declspec(property(get=get_ShardCount)) ULONG ShardCount;
+        inline ULONG get_ShardCount() const { return shardMask_ + 1; }
+
+        static ULONG GetDefaultShardCount();
+
+    private:
+        inline PerformanceCounterValue * GetCell(ULONG index) const
+        {
+            return reinterpret_cast<PerformanceCounterValue*>(cells_ + (index * CellSize));
+        }
+
+        inline PerformanceCounterValue * CurrentCell() const
+        {
+#if defined(PLATFORM_UNIX)
+            return GetCell(static_cast<ULONG>(::sched_getcpu()) & shardMask_);
+#else
+            return GetCell(::GetCurrentProcessorNumber() & shardMask_);
+#endif
+        }
+
+        // The first word of a cell holds its share of the value, the second counts
+        // the updates since the cell was last folded into the base counter.
+        inline void OnCellUpdated(PerformanceCounterValue * cell)
+        {
+            if ((::InterlockedIncrement64(cell + 1) % FoldInterval) == 0)
+            {
+                FoldCell(cell);
+            }
+        }
+
+        void FoldCell(PerformanceCounterValue * cell);
+
+        PerformanceCounterData & base_;
+        BYTE * cells_;
+        ULONG shardMask_;
+        std::vector<BYTE> privateCells_;
+    };
+}
@@ -232,6 +232,11 @@ ErrorCode Socket::Open(
 {
     int type    = (SocketType::Tcp == socketType) ? SOCK_STREAM : SOCK_DGRAM;
     int proto    = (SocketType::Tcp == socketType) ? IPPROTO_TCP : IPPROTO_UDP;
+    if (AddressFamily::Unix == addressFamily)
+    {
+        // unix domain sockets take no protocol, SocketType::Tcp gives the stream semantics
+        proto = 0;
+    }
 
     handle_ = socket(static_cast<int>(addressFamily), type | SOCK_CLOEXEC, proto);
     if (handle_ == -1)
@@ -35,6 +35,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0);
@@ -53,6 +59,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1);
@@ -73,6 +85,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2);
@@ -94,6 +112,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3);
@@ -116,6 +140,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4);
@@ -139,6 +169,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5);
@@ -163,6 +199,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5, &a6 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5, a6);
@@ -188,6 +230,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5, &a6, &a7 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5, a6, a7);
@@ -214,6 +262,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5, &a6, &a7, &a8 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5, a6, a7, a8);
@@ -241,6 +295,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5, &a6, &a7, &a8, &a9 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5, a6, a7, a8, a9);
@@ -269,6 +329,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5, &a6, &a7, &a8, &a9, &a10 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10);
@@ -298,6 +364,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5, &a6, &a7, &a8, &a9, &a10, &a11 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11);
@@ -328,6 +400,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5, &a6, &a7, &a8, &a9, &a10, &a11, &a12 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12);
@@ -359,6 +437,12 @@ namespace Common
 		bool useFile = event_.IsFileSinkEnabled();
 		bool useConsole = event_.IsConsoleSinkEnabled();
 
+		if (useFile && TraceTextFileSink::IsBinary())
+		{
+			WriteBinary(type, id, format, { &a0, &a1, &a2, &a3, &a4, &a5, &a6, &a7, &a8, &a9, &a10, &a11, &a12, &a13 });
+			useFile = false;
+		}
+
 		if (useETW || useFile || useConsole)
 		{
 			std::string text = formatString.L(format, a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13);
@@ -367,6 +451,15 @@ namespace Common
 		}
 	}
 
+	void TextTraceWriter::WriteBinary(
+		StringLiteral type,
+		std::string const & id,
+		StringLiteral format,
+		std::initializer_list<VariableArgument const *> args) const
+	{
+		TraceBinaryFileSink::Write(event_.GetTaskName(), type, event_.GetLevel(), id, format, args.begin(), args.size());
+	}
+
 	void TraceError(
 		TraceTaskCodes::Enum taskId,
 		StringLiteral type,
@@ -90,6 +90,12 @@ namespace Common
 			bool useFile = event_.IsFileSinkEnabled();
 			bool useConsole = event_.IsConsoleSinkEnabled();
 
+			if (useFile && TraceTextFileSink::IsBinary())
+			{
+				WriteBinary(type, std::string(), format, { &a0 });
+				useFile = false;
+			}
+
 			if (useETW || useFile || useConsole)
 			{
 				std::string text = formatString.L(format, a0);
@@ -474,6 +480,13 @@ namespace Common
 			VariableArgument const & a13) const;
 
 	private:
+		// In binary mode the file sink records the format string and arguments, see TraceBinaryFileSink
+		void WriteBinary(
+			StringLiteral type,
+			std::string const & id,
+			StringLiteral format,
+			std::initializer_list<VariableArgument const *> args) const;
+
 		TraceEvent & event_;
 	};
 
@@ -306,6 +306,8 @@ void TimerQueue::FireDueTimers()
             auto idx = heap_.front()->ClearHeapIndex();
             Invariant(idx == 0);
 
+            lateness_.Add(now - heap_.front()->DueTime());
+
             WriteNoise(
                 TraceType,
                 "{0}: {1} '{2}': calling callback,  asyncDispatch_ = {3}",
@@ -377,8 +379,7 @@ void TimerQueue::InitSignalPipe()
 {
     ZeroRetValAssert(pipe2(pipeFd_, O_CLOEXEC));
 
-    pthread_t tid;
-    ZeroRetValAssert(pthread_create(&tid, nullptr, &SignalPipeLoopStatic, this));
+    ZeroRetValAssert(pthread_create(&pipeThread_, nullptr, &SignalPipeLoopStatic, this));
 
     struct sigaction sa = {};
     sa.sa_flags = SA_SIGINFO | SA_RESTART;
@@ -392,6 +393,24 @@ void TimerQueue::InitSignalPipe()
     ZeroRetValAssert(sigprocmask(SIG_UNBLOCK, &mask, nullptr));
 }
 
+void TimerQueue::SetSchedParam(int policy, int priority)
+{
+    WriteInfo(TraceType, "{0}: setting sched param on dispatch thread: policy = {1}, priority = {2}", TextTraceThis, policy, priority);
+
+    sched_param param = { priority };
+    auto retval = pthread_setschedparam(pipeThread_, policy, &param);
+    if (retval)
+    {
+        WriteWarning(
+            TraceType,
+            "{0}: failed to set sched param on dispatch thread: policy = {1}, priority = {2}, error = {3}",
+            TextTraceThis,
+            policy,
+            priority,
+            retval);
+    }
+}
+
 void* TimerQueue::SignalPipeLoopStatic(void* arg)
 {
     auto thisPtr = (TimerQueue*)arg;
@@ -28,6 +28,13 @@ namespace Common
 
         bool IsTimerArmed(TimerSPtr const & timer);
 
+        // how late timers fired relative to their due time
+        LatencyHistogram const & Lateness() const { return lateness_; }
+
+        // sets the scheduling policy and priority of the thread that fires the timers,
+        // only meaningful with synchronous dispatch
+        void SetSchedParam(int policy, int priority);
+
     private:
         static void SigHandler(int sig, siginfo_t *si, void*);
         static void* SignalPipeLoopStatic(void*);
@@ -50,10 +57,12 @@ namespace Common
 
         timer_t timer_;
         int pipeFd_[2];
+        pthread_t pipeThread_;
 
         std::vector<TimerSPtr> heap_;
 
         const bool asyncDispatch_;
         const TimeSpan dispatchTimeThreshold_;
+        LatencyHistogram lateness_;
     };
 }
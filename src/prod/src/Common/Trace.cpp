@@ -650,6 +650,11 @@ namespace Common
             {
                 TraceTextFileSink::SetOption(option);
             }
+
+            // "Binary" defers formatting to TraceDecoder, see TraceBinaryFileSink
+            std::string format;
+            config.ReadUnencryptedConfig<string>(section, "Format", format, "Text");
+            TraceTextFileSink::SetBinary(StringUtility::AreEqualCaseInsensitive(format, "Binary"));
         }
         else if (section == ConsoleTraceSection)
         {
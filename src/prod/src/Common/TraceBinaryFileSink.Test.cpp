@@ -0,0 +1,232 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <boost/test/unit_test.hpp>
+#include "Common/boost-taef.h"
+
+using namespace std;
+using namespace Common;
+
+StringLiteral const BinaryTestTaskName("TraceBinaryFileSinkTest");
+StringLiteral const BinaryTestEventName("Decode");
+
+class TraceBinaryFileSinkTest
+{
+protected:
+    TraceBinaryFileSinkTest();
+    ~TraceBinaryFileSinkTest();
+
+    // traces an event in binary mode, the text it is expected to decode to is kept in expected_
+    void Write(
+        LogLevel::Enum level,
+        StringLiteral format,
+        VariableArgument const & a0,
+        VariableArgument const & a1 = VariableArgument(),
+        VariableArgument const & a2 = VariableArgument(),
+        VariableArgument const & a3 = VariableArgument());
+
+    void ReadEvents(vector<TraceBinaryFileReader::TraceRecord> & records);
+
+    string fileName_;
+    vector<string> expected_;
+
+private:
+    string savedPath_;
+    string savedOption_;
+    bool savedBinary_;
+};
+
+TraceBinaryFileSinkTest::TraceBinaryFileSinkTest()
+    : fileName_("TraceBinaryFileSinkTest.btrace"),
+    expected_(),
+    savedPath_(TraceTextFileSink::GetPath()),
+    savedOption_(TraceTextFileSink::GetOption()),
+    savedBinary_(TraceTextFileSink::IsBinary())
+{
+    File::Delete(fileName_, NOTHROW());
+
+    TraceTextFileSink::SetOption("");
+    TraceTextFileSink::SetPath(fileName_);
+    TraceTextFileSink::SetBinary(true);
+}
+
+TraceBinaryFileSinkTest::~TraceBinaryFileSinkTest()
+{
+    TraceTextFileSink::SetBinary(savedBinary_);
+    TraceTextFileSink::SetPath(savedPath_);
+    TraceTextFileSink::SetOption(savedOption_);
+
+    // text events traced after leaving binary mode went to the .trace file of the same name
+    File::Delete(fileName_, NOTHROW());
+    File::Delete("TraceBinaryFileSinkTest.trace", NOTHROW());
+}
+
+void TraceBinaryFileSinkTest::Write(
+    LogLevel::Enum level,
+    StringLiteral format,
+    VariableArgument const & a0,
+    VariableArgument const & a1,
+    VariableArgument const & a2,
+    VariableArgument const & a3)
+{
+    VariableArgument const * args[] = { &a0, &a1, &a2, &a3 };
+
+    string id = formatString.L("{0}", expected_.size());
+    TraceBinaryFileSink::Write(BinaryTestTaskName, BinaryTestEventName, level, id, format, args, 4);
+
+    expected_.push_back(formatString.L(format, a0, a1, a2, a3));
+}
+
+void TraceBinaryFileSinkTest::ReadEvents(vector<TraceBinaryFileReader::TraceRecord> & records)
+{
+    // closes the file after appending what is buffered
+    TraceTextFileSink::SetBinary(false);
+
+    TraceBinaryFileReader reader;
+    auto error = reader.Open(fileName_);
+    BOOST_REQUIRE_MESSAGE(error.IsSuccess(), formatString.L("Open failed: {0}", error));
+    BOOST_REQUIRE(reader.UnknownFormatCount == 0);
+    BOOST_REQUIRE(reader.TruncatedBytes == 0);
+
+    // events traced by other components while the test runs are skipped
+    TraceBinaryFileReader::TraceRecord record;
+    while (reader.TryReadNext(record))
+    {
+        if ((record.TaskName == BinaryTestTaskName.begin()) && (record.EventName == BinaryTestEventName.begin()))
+        {
+            records.push_back(record);
+        }
+    }
+}
+
+BOOST_FIXTURE_TEST_SUITE2(TraceBinaryFileSinkTestSuite, TraceBinaryFileSinkTest)
+
+BOOST_AUTO_TEST_CASE(DecodeMatchesText)
+{
+    ENTER;
+
+    Guid guid = Guid::NewGuid();
+    ErrorCode error(ErrorCodeValue::NotFound);
+    vector<int> values = { 1, 2, 3 };
+
+    // arguments with a binary encoding
+    Write(LogLevel::Info, "{0} {1:x} {2,6}|{3}", 42, static_cast<uint64>(255), "text", TimeSpan::FromMilliseconds(1500));
+    Write(LogLevel::Noise, "{0} {1} {2:3} {3}", true, 'c', -7, 2.5);
+    Write(LogLevel::Info, "no inserts, escaped {{0}", string());
+
+    // arguments formatted when traced, one of them referred to twice
+    Write(LogLevel::Info, "{0} {1} {0}", guid, error);
+    Write(LogLevel::Info, "{0}: {1} at {2}", values, string("mixed"), DateTime::Now());
+
+    // a warning is flushed right away
+    Write(LogLevel::Warning, "insert index {3} too big", 1);
+
+    TraceBinaryFileSink::WriteText(BinaryTestTaskName, BinaryTestEventName, LogLevel::Info, "text", "already formatted {0}");
+    expected_.push_back("already formatted {0}");
+
+    vector<TraceBinaryFileReader::TraceRecord> records;
+    ReadEvents(records);
+
+    BOOST_REQUIRE_EQUAL(records.size(), expected_.size());
+    for (size_t i = 0; i < records.size(); ++i)
+    {
+        Trace.WriteInfo(TraceType, "{0}: '{1}'", i, records[i].Text);
+        BOOST_REQUIRE_EQUAL(records[i].Text, expected_[i]);
+        BOOST_REQUIRE(records[i].ThreadId == GetCurrentThreadId());
+        BOOST_REQUIRE(records[i].ToLine().find(records[i].Text) != string::npos);
+    }
+
+    BOOST_REQUIRE(records[0].Level == LogLevel::Info);
+    BOOST_REQUIRE(records[1].Level == LogLevel::Noise);
+    BOOST_REQUIRE(records[0].Id == "0");
+    BOOST_REQUIRE(records.back().Id == "text");
+
+    LEAVE;
+}
+
+BOOST_AUTO_TEST_CASE(PublicWriters)
+{
+    ENTER;
+
+    // text and structured events are recorded as format string and arguments when traced through their writers
+    string marker = formatString.L("PublicWriters-{0}", Guid::NewGuid());
+    StringLiteral const textType("TraceBinaryFileSinkPublicWriters");
+    Trace.WriteWarning(textType, "text writer {0} {1:x}", marker, 255);
+    CommonEventSource::Events->TraceDynamicString(7, marker);
+
+    vector<TraceBinaryFileReader::TraceRecord> records;
+    {
+        TraceTextFileSink::SetBinary(false);
+
+        TraceBinaryFileReader reader;
+        BOOST_REQUIRE(reader.Open(fileName_).IsSuccess());
+
+        TraceBinaryFileReader::TraceRecord record;
+        while (reader.TryReadNext(record))
+        {
+            if (record.Text.find(marker) != string::npos)
+            {
+                records.push_back(record);
+            }
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(records.size(), 2u);
+
+    BOOST_REQUIRE_EQUAL(records[0].EventName, string(textType.begin(), textType.end()));
+    BOOST_REQUIRE_EQUAL(records[0].Text, formatString.L("text writer {0} ff", marker));
+    BOOST_REQUIRE(records[0].Level == LogLevel::Warning);
+    BOOST_REQUIRE(!records[0].IsText);
+
+    BOOST_REQUIRE_EQUAL(records[1].Text, formatString.L(" {0} ", marker));
+    BOOST_REQUIRE(!records[1].IsText);
+
+    LEAVE;
+}
+
+BOOST_AUTO_TEST_CASE(TruncatedFile)
+{
+    ENTER;
+
+    for (int i = 0; i < 10; ++i)
+    {
+        Write(LogLevel::Info, "event {0} of {1}", i, "TruncatedFile");
+    }
+
+    TraceTextFileSink::SetBinary(false);
+
+    // a process stopped while appending leaves a partial record at the end
+    {
+        File file;
+        BOOST_REQUIRE(file.TryOpen(fileName_, FileMode::Open, FileAccess::Write, FileShare::ReadWrite).IsSuccess());
+        file.Seek(0, SeekOrigin::End);
+        BYTE partial[] = { TraceBinaryFileSink::EventRecord, 0xff, 0xff };
+        file.Write(partial, sizeof(partial));
+        file.Close2();
+    }
+
+    TraceBinaryFileReader reader;
+    BOOST_REQUIRE(reader.Open(fileName_).IsSuccess());
+    BOOST_REQUIRE(reader.TruncatedBytes == 3);
+
+    size_t count = 0;
+    TraceBinaryFileReader::TraceRecord record;
+    while (reader.TryReadNext(record))
+    {
+        if (record.TaskName == BinaryTestTaskName.begin())
+        {
+            BOOST_REQUIRE_EQUAL(record.Text, expected_[count]);
+            ++count;
+        }
+    }
+
+    BOOST_REQUIRE_EQUAL(count, expected_.size());
+
+    LEAVE;
+}
+
+BOOST_AUTO_TEST_SUITE_END()
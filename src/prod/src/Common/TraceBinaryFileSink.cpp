@@ -0,0 +1,704 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+using namespace std;
+
+namespace Common
+{
+    namespace
+    {
+        template <typename T>
+        void AppendValue(vector<BYTE> & data, T value)
+        {
+            size_t offset = data.size();
+            data.resize(offset + sizeof(T));
+            memcpy(data.data() + offset, &value, sizeof(T));
+        }
+
+        template <typename TLength>
+        void AppendString(vector<BYTE> & data, char const * value, size_t size)
+        {
+            size = min(size, static_cast<size_t>(numeric_limits<TLength>::max()));
+            AppendValue<TLength>(data, static_cast<TLength>(size));
+            data.insert(data.end(), reinterpret_cast<BYTE const *>(value), reinterpret_cast<BYTE const *>(value) + size);
+        }
+
+        template <typename T>
+        bool TryReadValue(BYTE const * & current, BYTE const * end, T & value)
+        {
+            if (static_cast<size_t>(end - current) < sizeof(T))
+            {
+                return false;
+            }
+
+            memcpy(&value, current, sizeof(T));
+            current += sizeof(T);
+            return true;
+        }
+
+        template <typename TLength>
+        bool TryReadString(BYTE const * & current, BYTE const * end, string & value)
+        {
+            TLength size;
+            if (!TryReadValue(current, end, size) || (static_cast<size_t>(end - current) < size))
+            {
+                return false;
+            }
+
+            value.assign(reinterpret_cast<char const *>(current), size);
+            current += size;
+            return true;
+        }
+
+        // Starts a record, EndRecord fills in its size
+        size_t BeginRecord(vector<BYTE> & data, BYTE kind)
+        {
+            data.push_back(kind);
+            size_t sizeOffset = data.size();
+            AppendValue<uint32>(data, 0);
+            return sizeOffset;
+        }
+
+        void EndRecord(vector<BYTE> & data, size_t sizeOffset)
+        {
+            uint32 size = static_cast<uint32>(data.size() - sizeOffset - sizeof(uint32));
+            memcpy(data.data() + sizeOffset, &size, sizeof(size));
+        }
+
+        void AppendFormatRecord(vector<BYTE> & data, uint32 formatId, string const & format)
+        {
+            size_t sizeOffset = BeginRecord(data, TraceBinaryFileSink::FormatRecord);
+            AppendValue<uint32>(data, formatId);
+            AppendString<uint32>(data, format.c_str(), format.size());
+            EndRecord(data, sizeOffset);
+        }
+
+        class NullTextWriter : public TextWriter
+        {
+            DENY_COPY(NullTextWriter);
+
+        public:
+            NullTextWriter() {}
+            virtual void WriteAsciiBuffer(__in_ecount(ccLen) char const *, size_t) {}
+            virtual void WriteUnicodeBuffer(__in_ecount(ccLen) char const *, size_t) {}
+            virtual void Flush() {}
+        };
+
+        // Formats an argument with the options of each insert referring to it
+        class CapturedArgument : public ITextWritable
+        {
+        public:
+            CapturedArgument(VariableArgument const & arg, vector<string> & texts)
+                : arg_(arg), texts_(texts)
+            {
+            }
+
+            virtual void WriteTo(TextWriter & w, FormatOptions const & format) const
+            {
+                UNREFERENCED_PARAMETER(w);
+
+                string text;
+                StringWriterA writer(text);
+                arg_.WriteTo(writer, format);
+                texts_.push_back(move(text));
+            }
+
+        private:
+            VariableArgument const & arg_;
+            vector<string> & texts_;
+        };
+
+        // Writes the texts of captured arguments back, in the order they were captured
+        class DecodedArgument : public ITextWritable
+        {
+        public:
+            DecodedArgument(vector<string> const & texts, size_t & next)
+                : texts_(texts), next_(next)
+            {
+            }
+
+            virtual void WriteTo(TextWriter & w, FormatOptions const &) const
+            {
+                if (next_ < texts_.size())
+                {
+                    string const & text = texts_[next_++];
+                    w.WriteUnicodeBuffer(text.c_str(), text.size());
+                }
+            }
+
+        private:
+            vector<string> const & texts_;
+            size_t & next_;
+        };
+    }
+
+    struct TraceBinaryFileSink::ThreadBuffer
+    {
+        ThreadBuffer()
+            : FirstEventTime(DateTime::Zero)
+        {
+        }
+
+        // Lock protects Data and FirstEventTime, FlushLock keeps flushes of the buffer in order
+        ExclusiveLock Lock;
+        ExclusiveLock FlushLock;
+        vector<BYTE> Data;
+        DateTime FirstEventTime;
+
+        // Only accessed by the owning thread, format strings are verified on a hit since the
+        // memory of a format string may be reused for another one
+        unordered_map<char const *, pair<uint32, string const *>> FormatCache;
+    };
+
+    class TraceBinaryFileSink::ThreadBufferHolder
+    {
+        DENY_COPY(ThreadBufferHolder);
+
+    public:
+        ThreadBufferHolder()
+            : buffer_(make_shared<ThreadBuffer>())
+        {
+            AcquireExclusiveLock grab(Singleton->lock_);
+            Singleton->threadBuffers_.push_back(buffer_);
+        }
+
+        ~ThreadBufferHolder()
+        {
+            Singleton->FlushBuffer(*buffer_);
+            Singleton->UnregisterThreadBuffer(buffer_.get());
+        }
+
+        ThreadBuffer & GetBuffer()
+        {
+            return *buffer_;
+        }
+
+    private:
+        ThreadBufferSPtr buffer_;
+    };
+
+    uint32 const TraceBinaryFileSink::Magic;
+    uint32 const TraceBinaryFileSink::Version;
+    BYTE const TraceBinaryFileSink::FormattedArgument;
+    uint32 const TraceBinaryFileSink::TextFormatId;
+    size_t const TraceBinaryFileSink::MaxArgumentCount;
+
+    TraceBinaryFileSink* TraceBinaryFileSink::Singleton = new TraceBinaryFileSink();
+
+    size_t const TraceBinaryFileSink::FlushSize = 64 * 1024;
+    TimeSpan const TraceBinaryFileSink::FlushInterval = TimeSpan::FromSeconds(1);
+
+    TraceBinaryFileSink::TraceBinaryFileSink()
+        : lock_(),
+        formatIds_(),
+        formats_(),
+        threadBuffers_(),
+        flushTimer_(),
+        flushTimerStarted_(false)
+    {
+    }
+
+    TraceBinaryFileSink::ThreadBuffer & TraceBinaryFileSink::GetThreadBuffer()
+    {
+        static thread_local ThreadBufferHolder holder;
+        return holder.GetBuffer();
+    }
+
+    void TraceBinaryFileSink::StartFlushTimer()
+    {
+        bool expected = false;
+        if (flushTimerStarted_.load() || !flushTimerStarted_.compare_exchange_strong(expected, true))
+        {
+            return;
+        }
+
+        // Creating a timer traces, events traced here are buffered like any other
+        auto timer = Timer::Create(
+            "TraceBinaryFileSink.Flush",
+            [this](TimerSPtr const &) { this->PrivateFlush(); },
+            false);
+        timer->Change(FlushInterval, FlushInterval);
+
+        AcquireExclusiveLock grab(lock_);
+        flushTimer_ = timer;
+    }
+
+    uint32 TraceBinaryFileSink::GetFormatId(ThreadBuffer & buffer, StringLiteral format)
+    {
+        size_t size = format.size();
+
+        auto cached = buffer.FormatCache.find(format.begin());
+        if (cached != buffer.FormatCache.end())
+        {
+            string const & value = *cached->second.second;
+            if ((value.size() == size) && (memcmp(value.c_str(), format.begin(), size) == 0))
+            {
+                return cached->second.first;
+            }
+        }
+
+        string formatText(format.begin(), format.end());
+        uint32 formatId;
+        string const * value;
+        bool added = false;
+        {
+            AcquireExclusiveLock grab(lock_);
+
+            auto iter = formatIds_.find(formatText);
+            if (iter == formatIds_.end())
+            {
+                formats_.push_back(make_unique<string>(formatText));
+                formatId = static_cast<uint32>(formats_.size());
+                formatIds_.insert(make_pair(formatText, formatId));
+                added = true;
+            }
+            else
+            {
+                formatId = iter->second;
+            }
+
+            value = formats_[formatId - 1].get();
+        }
+
+        if (added)
+        {
+            // Written before any event referring to it is flushed. Files opened after this
+            // include the format in their header.
+            vector<BYTE> record;
+            AppendFormatRecord(record, formatId, formatText);
+            TraceTextFileSink::WriteBinary(record.data(), record.size());
+        }
+
+        buffer.FormatCache[format.begin()] = make_pair(formatId, value);
+        return formatId;
+    }
+
+    void TraceBinaryFileSink::PrivateWrite(
+        StringLiteral taskName,
+        StringLiteral eventName,
+        LogLevel::Enum level,
+        string const & id,
+        StringLiteral format,
+        VariableArgument const * const * args,
+        size_t argCount)
+    {
+        ThreadBuffer & buffer = GetThreadBuffer();
+        uint32 formatId = GetFormatId(buffer, format);
+
+        WriteEvent(formatId, taskName, eventName, level, id, format, args, min(argCount, MaxArgumentCount));
+    }
+
+    void TraceBinaryFileSink::PrivateWriteText(StringLiteral taskName, StringLiteral eventName, LogLevel::Enum level, string const & id, string const & data)
+    {
+        VariableArgument arg(data);
+        VariableArgument const * args[] = { &arg };
+
+        WriteEvent(TextFormatId, taskName, eventName, level, id, StringLiteral(), args, 1);
+    }
+
+    void TraceBinaryFileSink::WriteEvent(
+        uint32 formatId,
+        StringLiteral taskName,
+        StringLiteral eventName,
+        LogLevel::Enum level,
+        string const & id,
+        StringLiteral format,
+        VariableArgument const * const * args,
+        size_t argCount)
+    {
+        // Arguments formatted here may trace themselves, such events are encoded into their own record
+        static thread_local int depth = 0;
+        static thread_local vector<BYTE> scratch;
+
+        vector<BYTE> nested;
+        vector<BYTE> & record = (depth == 0) ? scratch : nested;
+
+        DateTime now = DateTime::Now();
+
+        ++depth;
+        record.clear();
+        AppendEvent(record, now, formatId, taskName, eventName, level, id, format, args, argCount);
+        --depth;
+
+        ThreadBuffer & buffer = GetThreadBuffer();
+        bool flush;
+        {
+            AcquireExclusiveLock grab(buffer.Lock);
+
+            if (buffer.Data.empty())
+            {
+                buffer.FirstEventTime = now;
+            }
+
+            buffer.Data.insert(buffer.Data.end(), record.begin(), record.end());
+
+            flush = (level <= LogLevel::Warning) ||
+                (buffer.Data.size() >= FlushSize) ||
+                ((now - buffer.FirstEventTime) >= FlushInterval);
+        }
+
+        if (flush)
+        {
+            FlushBuffer(buffer);
+        }
+
+        StartFlushTimer();
+    }
+
+    void TraceBinaryFileSink::AppendEvent(
+        vector<BYTE> & data,
+        DateTime now,
+        uint32 formatId,
+        StringLiteral taskName,
+        StringLiteral eventName,
+        LogLevel::Enum level,
+        string const & id,
+        StringLiteral format,
+        VariableArgument const * const * args,
+        size_t argCount)
+    {
+        size_t sizeOffset = BeginRecord(data, EventRecord);
+
+        AppendValue<int64>(data, now.Ticks);
+        AppendValue<uint32>(data, static_cast<uint32>(GetCurrentThreadId()));
+        AppendValue<BYTE>(data, static_cast<BYTE>(level));
+        AppendValue<uint32>(data, formatId);
+        AppendString<uint16>(data, taskName.begin(), taskName.size());
+        AppendString<uint16>(data, eventName.begin(), eventName.size());
+        AppendString<uint16>(data, id.c_str(), id.size());
+
+        AppendValue<BYTE>(data, static_cast<BYTE>(argCount));
+
+        bool formatted[MaxArgumentCount] = {};
+        bool anyFormatted = false;
+        for (size_t i = 0; i < argCount; ++i)
+        {
+            if (!args[i]->TryWriteBinary(data))
+            {
+                data.push_back(FormattedArgument);
+                formatted[i] = true;
+                anyFormatted = true;
+            }
+        }
+
+        vector<string> texts;
+        if (anyFormatted)
+        {
+            // Runs the format string over the arguments, so that each insert referring to an
+            // argument without binary encoding is formatted with the options of the insert
+            vector<CapturedArgument> captured;
+            captured.reserve(argCount);
+
+            VariableArgument inserts[MaxArgumentCount];
+            for (size_t i = 0; i < argCount; ++i)
+            {
+                if (formatted[i])
+                {
+                    captured.push_back(CapturedArgument(*args[i], texts));
+                    inserts[i] = VariableArgument(&captured.back());
+                }
+            }
+
+            NullTextWriter w;
+            w.Write(
+                format,
+                inserts[0], inserts[1], inserts[2], inserts[3], inserts[4], inserts[5], inserts[6],
+                inserts[7], inserts[8], inserts[9], inserts[10], inserts[11], inserts[12], inserts[13]);
+        }
+
+        AppendValue<BYTE>(data, static_cast<BYTE>(min(texts.size(), static_cast<size_t>(numeric_limits<BYTE>::max()))));
+        for (size_t i = 0; (i < texts.size()) && (i < numeric_limits<BYTE>::max()); ++i)
+        {
+            AppendString<uint32>(data, texts[i].c_str(), texts[i].size());
+        }
+
+        EndRecord(data, sizeOffset);
+    }
+
+    void TraceBinaryFileSink::PrivateFlush()
+    {
+        vector<ThreadBufferSPtr> buffers;
+        {
+            AcquireExclusiveLock grab(lock_);
+            buffers = threadBuffers_;
+        }
+
+        for (auto const & buffer : buffers)
+        {
+            FlushBuffer(*buffer);
+        }
+    }
+
+    void TraceBinaryFileSink::FlushBuffer(ThreadBuffer & buffer)
+    {
+        AcquireExclusiveLock flushGrab(buffer.FlushLock);
+
+        vector<BYTE> data;
+        {
+            AcquireExclusiveLock grab(buffer.Lock);
+            if (buffer.Data.empty())
+            {
+                return;
+            }
+
+            data.reserve(FlushSize);
+            buffer.Data.swap(data);
+        }
+
+        TraceTextFileSink::WriteBinary(data.data(), data.size());
+    }
+
+    void TraceBinaryFileSink::PrivateGetFileHeader(vector<BYTE> & header)
+    {
+        AppendValue<uint32>(header, Magic);
+        AppendValue<uint32>(header, Version);
+
+        AcquireExclusiveLock grab(lock_);
+        for (size_t i = 0; i < formats_.size(); ++i)
+        {
+            AppendFormatRecord(header, static_cast<uint32>(i + 1), *formats_[i]);
+        }
+    }
+
+    void TraceBinaryFileSink::UnregisterThreadBuffer(ThreadBuffer const * buffer)
+    {
+        AcquireExclusiveLock grab(lock_);
+        for (auto iter = threadBuffers_.begin(); iter != threadBuffers_.end(); ++iter)
+        {
+            if (iter->get() == buffer)
+            {
+                threadBuffers_.erase(iter);
+                break;
+            }
+        }
+    }
+
+    TraceBinaryFileReader::TraceBinaryFileReader()
+        : data_(),
+        offset_(0),
+        end_(0),
+        formats_(),
+        unknownFormatCount_(0),
+        truncatedBytes_(0)
+    {
+    }
+
+    string TraceBinaryFileReader::TraceRecord::ToLine() const
+    {
+        string line;
+        TraceTextFileSink::FormatLine(
+            Time,
+            Level,
+            ThreadId,
+            StringLiteral(TaskName.c_str(), TaskName.c_str() + TaskName.size()),
+            StringLiteral(EventName.c_str(), EventName.c_str() + EventName.size()),
+            Id,
+            Text,
+            line);
+
+        return line;
+    }
+
+    ErrorCode TraceBinaryFileReader::Open(string const & fileName)
+    {
+        File file;
+        auto error = file.TryOpen(fileName, FileMode::Open, FileAccess::Read, FileShare::ReadWrite);
+        if (!error.IsSuccess())
+        {
+            return error;
+        }
+
+        int64 size;
+        error = file.GetSize(size);
+        if (!error.IsSuccess())
+        {
+            return error;
+        }
+
+        // the file may still be written to, only what is read now is decoded
+        data_.resize(static_cast<size_t>(size));
+        size_t read = 0;
+        while (read < data_.size())
+        {
+            DWORD bytesRead = 0;
+            int count = static_cast<int>(min(data_.size() - read, static_cast<size_t>(numeric_limits<int>::max())));
+            error = file.TryRead2(data_.data() + read, count, bytesRead);
+            if (!error.IsSuccess())
+            {
+                return error;
+            }
+
+            if (bytesRead == 0)
+            {
+                break;
+            }
+
+            read += bytesRead;
+        }
+
+        data_.resize(read);
+        file.Close2();
+
+        BYTE const * current = data_.data();
+        BYTE const * end = current + data_.size();
+
+        uint32 magic;
+        uint32 version;
+        if (!TryReadValue(current, end, magic) || !TryReadValue(current, end, version) ||
+            (magic != TraceBinaryFileSink::Magic) || (version != TraceBinaryFileSink::Version))
+        {
+            return ErrorCode(ErrorCodeValue::InvalidArgument, formatString.L("'{0}' is not a binary trace file", fileName));
+        }
+
+        offset_ = current - data_.data();
+
+        // Formats are defined before the events referring to them are flushed, but events of other
+        // threads may be appended in between, so all formats are collected before decoding events
+        while (current < end)
+        {
+            BYTE const * record = current;
+            BYTE kind;
+            uint32 recordSize;
+            if (!TryReadValue(current, end, kind) || !TryReadValue(current, end, recordSize) || (static_cast<size_t>(end - current) < recordSize))
+            {
+                current = record;
+                break;
+            }
+
+            if (kind == TraceBinaryFileSink::FormatRecord)
+            {
+                BYTE const * payload = current;
+                uint32 formatId;
+                string format;
+                if (TryReadValue(payload, current + recordSize, formatId) && TryReadString<uint32>(payload, current + recordSize, format))
+                {
+                    formats_[formatId] = move(format);
+                }
+            }
+
+            current += recordSize;
+        }
+
+        end_ = current - data_.data();
+        truncatedBytes_ = data_.size() - end_;
+
+        return ErrorCode::Success();
+    }
+
+    bool TraceBinaryFileReader::TryReadNext(TraceRecord & record)
+    {
+        while (offset_ < end_)
+        {
+            BYTE const * current = data_.data() + offset_;
+            BYTE kind = *current++;
+            uint32 recordSize;
+            memcpy(&recordSize, current, sizeof(recordSize));
+            current += sizeof(recordSize);
+
+            offset_ = (current + recordSize) - data_.data();
+
+            // records of other kinds are skipped
+            if ((kind == TraceBinaryFileSink::EventRecord) && TryDecodeEvent(current, current + recordSize, record))
+            {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    bool TraceBinaryFileReader::TryDecodeEvent(BYTE const * current, BYTE const * end, TraceRecord & record)
+    {
+        int64 ticks;
+        uint32 threadId;
+        BYTE level;
+        uint32 formatId;
+        BYTE argCount;
+        if (!TryReadValue(current, end, ticks) ||
+            !TryReadValue(current, end, threadId) ||
+            !TryReadValue(current, end, level) ||
+            !TryReadValue(current, end, formatId) ||
+            !TryReadString<uint16>(current, end, record.TaskName) ||
+            !TryReadString<uint16>(current, end, record.EventName) ||
+            !TryReadString<uint16>(current, end, record.Id) ||
+            !TryReadValue(current, end, argCount) ||
+            (argCount > TraceBinaryFileSink::MaxArgumentCount))
+        {
+            return false;
+        }
+
+        VariableArgument args[TraceBinaryFileSink::MaxArgumentCount];
+        string strings[TraceBinaryFileSink::MaxArgumentCount];
+        bool formatted[TraceBinaryFileSink::MaxArgumentCount] = {};
+        for (size_t i = 0; i < argCount; ++i)
+        {
+            if ((current < end) && (*current == TraceBinaryFileSink::FormattedArgument))
+            {
+                formatted[i] = true;
+                ++current;
+            }
+            else if (!VariableArgument::TryReadBinary(current, end, strings[i], args[i]))
+            {
+                return false;
+            }
+        }
+
+        BYTE textCount;
+        if (!TryReadValue(current, end, textCount))
+        {
+            return false;
+        }
+
+        vector<string> texts(textCount);
+        for (auto & text : texts)
+        {
+            if (!TryReadString<uint32>(current, end, text))
+            {
+                return false;
+            }
+        }
+
+        record.Time = DateTime(ticks);
+        record.Level = static_cast<LogLevel::Enum>(level);
+        record.ThreadId = static_cast<DWORD>(threadId);
+        record.IsText = (formatId == TraceBinaryFileSink::TextFormatId);
+
+        if (record.IsText)
+        {
+            record.Text = (argCount > 0) ? strings[0] : string();
+            return true;
+        }
+
+        auto iter = formats_.find(formatId);
+        if (iter == formats_.end())
+        {
+            ++unknownFormatCount_;
+            record.Text = formatString.L("** Unknown format {0} **", formatId);
+            return true;
+        }
+
+        size_t next = 0;
+        vector<DecodedArgument> decoded;
+        decoded.reserve(argCount);
+        for (size_t i = 0; i < argCount; ++i)
+        {
+            if (formatted[i])
+            {
+                decoded.push_back(DecodedArgument(texts, next));
+                args[i] = VariableArgument(&decoded.back());
+            }
+        }
+
+        string const & format = iter->second;
+        record.Text = formatString.L(
+            StringLiteral(format.c_str(), format.c_str() + format.size()),
+            args[0], args[1], args[2], args[3], args[4], args[5], args[6],
+            args[7], args[8], args[9], args[10], args[11], args[12], args[13]);
+
+        return true;
+    }
+}
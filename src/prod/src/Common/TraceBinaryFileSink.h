@@ -0,0 +1,176 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Common
+{
+    // Binary mode of the text file sink, see TraceTextFileSink::SetBinary. Instead of formatting an
+    // event, the id of its format string and the raw bytes of its scalar and string arguments are
+    // recorded into a buffer of the calling thread. Arguments of other types are formatted one by
+    // one, with the options of the inserts referring to them. Buffers are appended to the trace file
+    // when they fill up, on warnings and errors, and every second. TraceBinaryFileReader renders
+    // the events into the lines the text file sink would have written.
+    class TraceBinaryFileSink
+    {
+        DENY_COPY(TraceBinaryFileSink);
+
+    public:
+        static uint32 const Magic = 0x54424653; // "SFBT"
+        static uint32 const Version = 1;
+
+        // Records are a kind byte and a 32-bit payload size followed by the payload
+        enum RecordKind : BYTE
+        {
+            FormatRecord = 1,
+            EventRecord = 2
+        };
+
+        // Written in place of the type of an argument formatted when traced
+        static BYTE const FormattedArgument = 0xff;
+
+        // Format id of events traced as text, their only argument is the text
+        static uint32 const TextFormatId = 0;
+
+        static size_t const MaxArgumentCount = 14;
+
+        static void Write(
+            StringLiteral taskName,
+            StringLiteral eventName,
+            LogLevel::Enum level,
+            std::string const & id,
+            StringLiteral format,
+            VariableArgument const * const * args,
+            size_t argCount)
+        {
+            Singleton->PrivateWrite(taskName, eventName, level, id, format, args, argCount);
+        }
+
+        static void WriteText(StringLiteral taskName, StringLiteral eventName, LogLevel::Enum level, std::string const & id, std::string const & data)
+        {
+            Singleton->PrivateWriteText(taskName, eventName, level, id, data);
+        }
+
+        // Appends events buffered by all threads to the trace file
+        static void Flush()
+        {
+            Singleton->PrivateFlush();
+        }
+
+        // Written at the start of every trace file, so that files can be decoded on their own
+        static void GetFileHeader(std::vector<BYTE> & header)
+        {
+            Singleton->PrivateGetFileHeader(header);
+        }
+
+    private:
+        struct ThreadBuffer;
+        class ThreadBufferHolder;
+        typedef std::shared_ptr<ThreadBuffer> ThreadBufferSPtr;
+
+        static TraceBinaryFileSink* Singleton;
+
+        static size_t const FlushSize;
+        static TimeSpan const FlushInterval;
+
+        TraceBinaryFileSink();
+
+        ThreadBuffer & GetThreadBuffer();
+        uint32 GetFormatId(ThreadBuffer & buffer, StringLiteral format);
+        void StartFlushTimer();
+
+        void PrivateWrite(
+            StringLiteral taskName,
+            StringLiteral eventName,
+            LogLevel::Enum level,
+            std::string const & id,
+            StringLiteral format,
+            VariableArgument const * const * args,
+            size_t argCount);
+        void PrivateWriteText(StringLiteral taskName, StringLiteral eventName, LogLevel::Enum level, std::string const & id, std::string const & data);
+        void WriteEvent(
+            uint32 formatId,
+            StringLiteral taskName,
+            StringLiteral eventName,
+            LogLevel::Enum level,
+            std::string const & id,
+            StringLiteral format,
+            VariableArgument const * const * args,
+            size_t argCount);
+        void PrivateFlush();
+        void FlushBuffer(ThreadBuffer & buffer);
+        void PrivateGetFileHeader(std::vector<BYTE> & header);
+        void UnregisterThreadBuffer(ThreadBuffer const * buffer);
+
+        static void AppendEvent(
+            std::vector<BYTE> & data,
+            DateTime now,
+            uint32 formatId,
+            StringLiteral taskName,
+            StringLiteral eventName,
+            LogLevel::Enum level,
+            std::string const & id,
+            StringLiteral format,
+            VariableArgument const * const * args,
+            size_t argCount);
+
+        // lock_ protects formatIds_, formats_, threadBuffers_ and flushTimer_, it is never held
+        // while writing to the trace file
+        ExclusiveLock lock_;
+        std::map<std::string, uint32> formatIds_;
+        std::vector<std::unique_ptr<std::string>> formats_;
+        std::vector<ThreadBufferSPtr> threadBuffers_;
+        TimerSPtr flushTimer_;
+        Common::atomic_bool flushTimerStarted_;
+    };
+
+    // Reads a trace file written in binary mode by the text file sink, see TraceBinaryFileSink
+    class TraceBinaryFileReader
+    {
+        DENY_COPY(TraceBinaryFileReader);
+
+    public:
+        struct TraceRecord
+        {
+            DateTime Time;
+            LogLevel::Enum Level;
+            DWORD ThreadId;
+            std::string TaskName;
+            std::string EventName;
+            std::string Id;
+            std::string Text;
+            bool IsText; // traced as text rather than as format string and arguments
+
+            // the line the text file sink would have written, including the line break
+            std::string ToLine() const;
+        };
+
+        TraceBinaryFileReader();
+
+        ErrorCode Open(std::string const & fileName);
+
+        // Records are returned in the order they were appended, which is ordered by time for each
+        // thread. Returns false at the end of the file or of its last complete record.
+        bool TryReadNext(TraceRecord & record);
+
+        // Events whose format string was not found in the file
+        __declspec(property(get=get_UnknownFormatCount)) size_t UnknownFormatCount;
+        size_t get_UnknownFormatCount() const { return unknownFormatCount_; }
+
+        // Bytes at the end of the file not forming a complete record
+        __declspec(property(get=get_TruncatedBytes)) size_t TruncatedBytes;
+        size_t get_TruncatedBytes() const { return truncatedBytes_; }
+
+    private:
+        bool TryDecodeEvent(BYTE const * current, BYTE const * end, TraceRecord & record);
+
+        std::vector<BYTE> data_;
+        size_t offset_;
+        size_t end_;
+        std::map<uint32, std::string> formats_;
+        size_t unknownFormatCount_;
+        size_t truncatedBytes_;
+    };
+}
@@ -357,6 +357,18 @@ namespace Common
         }
     }
 
+    void TraceEvent::WriteToBinaryFileSinkInternal(std::string const & id, std::vector<VariableArgument> const & arguments)
+    {
+        VariableArgument const * args[TraceBinaryFileSink::MaxArgumentCount];
+        size_t argCount = min(arguments.size(), TraceBinaryFileSink::MaxArgumentCount);
+        for (size_t i = 0; i < argCount; ++i)
+        {
+            args[i] = &arguments[i];
+        }
+
+        TraceBinaryFileSink::Write(taskName_, eventName_, level_, id, format_, args, argCount);
+    }
+
     void TraceEvent::WriteManifest(TraceManifestGenerator & manifest)
     {
         StringWriterA & eventsWriter = manifest.GetEventsWriter();
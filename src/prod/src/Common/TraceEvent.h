@@ -75,6 +75,11 @@ namespace Common
             return taskName_;
         }
 
+        LogLevel::Enum GetLevel() const
+        {
+            return level_;
+        }
+
         size_t GetFieldCount() const
         {
             return fields_.size();
@@ -139,6 +144,21 @@ namespace Common
             WriteToTextSinkInternal(HasIdField() ? a0.ToString() : std::string(), data, useConsole, useFile, useETW);
         }
 
+        // In binary mode the file sink records the format string and the arguments of the event instead
+        // of its text, see TraceBinaryFileSink. TraceEventWriter still writes events with extended metadata
+        // as text, because the metadata fields are not part of the format string of the event.
+        template <class T, class ...Args>
+        void WriteToBinaryFileSink(T const & a0, Args const & ...args)
+        {
+            std::vector<VariableArgument> arguments{ a0, args... };
+            WriteToBinaryFileSinkInternal(HasIdField() ? FormatId(a0) : std::string(), arguments);
+        }
+
+        void WriteToBinaryFileSink()
+        {
+            WriteToBinaryFileSinkInternal(std::string(), std::vector<VariableArgument>());
+        }
+
         void WriteTextEvent(StringLiteral type, std::string const & id, std::string const & text, bool useETW, bool useFile, bool useConsole);
 
         template<class T>
@@ -469,6 +489,13 @@ namespace Common
 
         void WriteToTextSinkInternal(std::string const & id, std::string const & data, bool useConsole, bool useFile, bool useETW);
 
+        void WriteToBinaryFileSinkInternal(std::string const & id, std::vector<VariableArgument> const & arguments);
+
+        template <class T>
+        static std::string FormatId(T const & a0) { return formatString(a0); }
+        static std::string FormatId(std::string const & a0) { return a0; }
+        static std::string FormatId(Guid const & a0) { return a0.ToString(); }
+
         static size_t CountArguments(std::string const & format);
 
         static void UpdateArgument(std::string & format, size_t oldIndex, size_t newIndex);
@@ -538,6 +538,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink();
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -591,6 +597,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -645,6 +657,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -700,6 +718,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -756,6 +780,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -813,6 +843,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -871,6 +907,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -930,6 +972,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5, a6);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -990,6 +1038,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5, a6, a7);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -1051,6 +1105,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5, a6, a7, a8);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -1113,6 +1173,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -1176,6 +1242,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -1240,6 +1312,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -1305,6 +1383,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -1369,6 +1453,12 @@ namespace Common
 #if defined(PLATFORM_UNIX)
             useETW = event_.IsETWSinkEnabled() && !event_.IsLinuxStructuredTracesEnabled();
 #endif
+            if (useFile && !extendedMetadata_ && TraceTextFileSink::IsBinary())
+            {
+                event_.WriteToBinaryFileSink(a0, a1, a2, a3, a4, a5, a6, a7, a8, a9, a10, a11, a12, a13);
+                useFile = false;
+            }
+
             if (useConsole || useFile || useETW)
             {
                 std::string formattedString;
@@ -10,6 +10,7 @@ using namespace std;
 namespace Common
 {
     StringLiteral const Extension(".trace");
+    StringLiteral const BinaryExtension(".btrace");
 
     int const TraceTextFileSink::DefaultMaxFilesToKeep = 3;
     int64 const TraceTextFileSink::DefaultSizeCheckIntervalInMinutes = 5;
@@ -22,11 +23,17 @@ namespace Common
 
     TraceTextFileSink::CleanupHelper::~CleanupHelper()
     {
+        if (TraceTextFileSink::Singleton->binary_.load())
+        {
+            TraceBinaryFileSink::Flush();
+        }
+
         TraceTextFileSink::Singleton->Disable();
     }
 
     TraceTextFileSink::TraceTextFileSink()
         : enabled_(false),
+        binary_(false),
         processNameOption_("e"),
         processIdOption_("p"),
         instanceIdOption_("i"),
@@ -85,6 +92,22 @@ namespace Common
         }
     }
 
+    void TraceTextFileSink::PrivateSetBinary(bool binary)
+    {
+        if (binary_.load() && !binary)
+        {
+            // Events buffered after this are dropped by PrivateWriteBinary
+            TraceBinaryFileSink::Flush();
+        }
+
+        AcquireWriteLock lock(lock_);
+        if (binary_.load() != binary)
+        {
+            binary_.store(binary);
+            CloseFile();
+        }
+    }
+
     void TraceTextFileSink::CloseFile()
     {
         if (file_.IsValid())
@@ -105,6 +128,10 @@ namespace Common
         {
             fileName = path_.substr(0, path_.size() - Extension.size());
         }
+        else if (StringUtility::EndsWithCaseInsensitive(path_, string(BinaryExtension.begin(), BinaryExtension.end())))
+        {
+            fileName = path_.substr(0, path_.size() - BinaryExtension.size());
+        }
         else
         {
             fileName = path_;
@@ -213,7 +240,7 @@ namespace Common
             }
         } // foreach options
 
-        fileName += formatString.L("{0}", Extension);
+        fileName += formatString.L("{0}", binary_.load() ? BinaryExtension : Extension);
 
         auto error = file_.TryOpen(fileName, FileMode::Create, FileAccess::Write, FileShare::Read);
         if (!error.IsSuccess())
@@ -222,6 +249,14 @@ namespace Common
             throw runtime_error(formatString.L("Unable to open text trace file '{0}': {1}", fileName, error));
         }
 
+        if (binary_.load())
+        {
+            // every file can be decoded on its own
+            vector<BYTE> header;
+            TraceBinaryFileSink::GetFileHeader(header);
+            file_.TryWrite(header.data(), static_cast<int>(header.size()));
+        }
+
         files_.push_back(fileName);
         if (files_.size() > static_cast<size_t>(maxFilesToKeep))
         {
@@ -236,11 +271,16 @@ namespace Common
         return result.substr(0, 11) + "-" + result.substr(12, 2) + "-" + result.substr(15, 2);  
     }
 
-    void TraceTextFileSink::PrivateWrite(StringLiteral taskName, StringLiteral eventName, LogLevel::Enum level, std::string const & id, std::string const & data)
+    void TraceTextFileSink::FormatLine(
+        DateTime now,
+        LogLevel::Enum level,
+        DWORD threadId,
+        StringLiteral taskName,
+        StringLiteral eventName,
+        std::string const & id,
+        std::string const & data,
+        std::string & text)
     {
-        DateTime now = DateTime::Now();
-
-        std::string text;
         text.reserve(data.size() + 128);
         StringWriterA w(text);
 
@@ -248,7 +288,7 @@ namespace Common
         w.Write(',');
         w.Write(level);
         w.Write(',');
-        w.Write(GetCurrentThreadId());
+        w.Write(threadId);
         w.Write(',');
         w.Write(taskName);
 
@@ -274,36 +314,67 @@ namespace Common
         }
 
         text.append("\r\n");
+    }
+
+    void TraceTextFileSink::PrivateWrite(StringLiteral taskName, StringLiteral eventName, LogLevel::Enum level, std::string const & id, std::string const & data)
+    {
+        if (binary_.load())
+        {
+            TraceBinaryFileSink::WriteText(taskName, eventName, level, id, data);
+            return;
+        }
+
+        DateTime now = DateTime::Now();
+
+        std::string text;
+        FormatLine(now, level, GetCurrentThreadId(), taskName, eventName, id, data, text);
 
         AcquireWriteLock lock(lock_);
+        if (!binary_.load())
         {
-            if (now > segmentTime_)
+            WriteToFileCallerHoldingLock(now, text.c_str(), text.size());
+        }
+    }
+
+    void TraceTextFileSink::PrivateWriteBinary(BYTE const * data, size_t size)
+    {
+        DateTime now = DateTime::Now();
+
+        AcquireWriteLock lock(lock_);
+        if (binary_.load())
+        {
+            WriteToFileCallerHoldingLock(now, reinterpret_cast<char const *>(data), size);
+        }
+    }
+
+    void TraceTextFileSink::WriteToFileCallerHoldingLock(DateTime now, char const * data, size_t count)
+    {
+        if (now > segmentTime_)
+        {
+            CloseFile();
+        }
+
+        if (now > sizeCheckTime_)
+        {
+            int64 size;
+            if (file_.TryGetSize(size) && (size >= maxSize_))
             {
                 CloseFile();
             }
-
-            if (now > sizeCheckTime_)
+            else
             {
-                int64 size;
-                if (file_.TryGetSize(size) && (size >= maxSize_))
-                {
-                    CloseFile();
-                }
-                else
-                {
-                    sizeCheckTime_ = CalculateCheckTime(now, sizeCheckIntervalInMinutes_);
-                }
+                sizeCheckTime_ = CalculateCheckTime(now, sizeCheckIntervalInMinutes_);
             }
+        }
 
-            if (!file_.IsValid())
-            {
-                OpenFile();
-            }
+        if (!file_.IsValid())
+        {
+            OpenFile();
+        }
 
-            if (file_.IsValid())
-            {
-                file_.TryWrite(text.c_str(), static_cast<int>(text.size()));
-            }
+        if (file_.IsValid())
+        {
+            file_.TryWrite(data, static_cast<int>(count));
         }
     }
 }
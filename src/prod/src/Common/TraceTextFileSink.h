@@ -22,21 +22,54 @@ namespace Common
             Singleton->PrivateSetPath(path);
         }
 
+        static std::string GetOption()
+        {
+            return Singleton->option_;
+        }
+
         static void SetOption(std::string const & option)
         {
             Singleton->PrivateSetOption(option);
         }
 
+        // In binary mode, events are written by TraceBinaryFileSink into files with the .btrace extension
+        static void SetBinary(bool binary)
+        {
+            Singleton->PrivateSetBinary(binary);
+        }
+
+        static bool IsBinary()
+        {
+            return Singleton->binary_.load();
+        }
+
         static void Write(StringLiteral taskName, StringLiteral eventName, LogLevel::Enum level, std::string const & id, std::string const & data)
         {
             Singleton->PrivateWrite(taskName, eventName, level, id, data);
         }
 
+        // Appends whole records of TraceBinaryFileSink, dropped if not in binary mode
+        static void WriteBinary(BYTE const * data, size_t size)
+        {
+            Singleton->PrivateWriteBinary(data, size);
+        }
+
         static bool IsEnabled()
         {
             return Singleton->enabled_;
         }
 
+        // Formats a line of the trace file, also used to decode binary trace files
+        static void FormatLine(
+            DateTime time,
+            LogLevel::Enum level,
+            DWORD threadId,
+            StringLiteral taskName,
+            StringLiteral eventName,
+            std::string const & id,
+            std::string const & data,
+            std::string & text);
+
     private:
         // Helper class to release file handle without destructing TraceTextFileSink::Singleton
         class CleanupHelper
@@ -58,7 +91,10 @@ namespace Common
         void OpenFile();
         void PrivateSetPath(std::string const & path);
         void PrivateSetOption(std::string const & option);
+        void PrivateSetBinary(bool binary);
         void PrivateWrite(StringLiteral taskName, StringLiteral eventName, LogLevel::Enum level, std::string const & id, std::string const & data);
+        void PrivateWriteBinary(BYTE const * data, size_t size);
+        void WriteToFileCallerHoldingLock(DateTime now, char const * data, size_t count);
         void Disable();
         static std::string TimeToFileNameSuffix(DateTime const & now);
 
@@ -72,6 +108,7 @@ namespace Common
         int64 maxSize_;
         int64 sizeCheckIntervalInMinutes_;
         bool enabled_;
+        Common::atomic_bool binary_; // read without lock_ on every event
 
         std::string const processNameOption_;
         std::string const processIdOption_;
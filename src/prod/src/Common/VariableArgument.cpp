@@ -541,6 +541,169 @@ bool VariableArgument::IsValid() const
     return (type_ != TypeInvalid);
 }
 
+bool VariableArgument::TryWriteBinary(vector<BYTE> & buffer) const
+{
+    size_t payloadSize;
+    switch (type_)
+    {
+    case TypeInvalid:
+        payloadSize = 0;
+        break;
+    case TypeBool:
+    case TypeChar:
+        payloadSize = 1;
+        break;
+    case TypeSignedNumber:
+    case TypeUnsignedNumber:
+    case TypeDouble:
+    case TypeTimeSpan:
+    case TypePointer:
+        payloadSize = 8;
+        break;
+    case TypeString:
+        if (value_.valueString_.size_ > numeric_limits<uint32>::max())
+        {
+            return false;
+        }
+
+        payloadSize = sizeof(uint32) + value_.valueString_.size_;
+        break;
+    default:
+        // DateTime and StopwatchTime are rendered in local or process time by some formats
+        return false;
+    }
+
+    size_t offset = buffer.size();
+    buffer.resize(offset + 1 + payloadSize);
+    BYTE * current = buffer.data() + offset;
+    *current++ = static_cast<BYTE>(type_);
+
+    switch (type_)
+    {
+    case TypeBool:
+        *current = value_.valueBool_ ? 1 : 0;
+        break;
+    case TypeChar:
+        *current = static_cast<BYTE>(value_.valueChar_);
+        break;
+    case TypeSignedNumber:
+    case TypeUnsignedNumber:
+    case TypeTimeSpan:
+        memcpy(current, &value_.valueUInt64_, 8);
+        break;
+    case TypeDouble:
+        memcpy(current, &value_.valueDouble_, 8);
+        break;
+    case TypePointer:
+        {
+        uint64 pointer = reinterpret_cast<uint64>(value_.valuePointer_);
+        memcpy(current, &pointer, 8);
+        }
+        break;
+    case TypeString:
+        {
+        uint32 size = static_cast<uint32>(value_.valueString_.size_);
+        memcpy(current, &size, sizeof(size));
+        memcpy(current + sizeof(size), value_.valueString_.buffer_, size);
+        }
+        break;
+    default:
+        break;
+    }
+
+    return true;
+}
+
+bool VariableArgument::TryReadBinary(BYTE const * & current, BYTE const * end, string & stringValue, VariableArgument & arg)
+{
+    if (current >= end)
+    {
+        return false;
+    }
+
+    auto type = static_cast<Enum>(*current);
+    BYTE const * payload = current + 1;
+    size_t available = end - payload;
+
+    arg = VariableArgument();
+    arg.type_ = type;
+
+    switch (type)
+    {
+    case TypeInvalid:
+        current = payload;
+        return true;
+    case TypeBool:
+    case TypeChar:
+        if (available < 1)
+        {
+            return false;
+        }
+
+        if (type == TypeBool)
+        {
+            arg.value_.valueBool_ = (*payload != 0);
+        }
+        else
+        {
+            arg.value_.valueChar_ = static_cast<char>(*payload);
+        }
+
+        current = payload + 1;
+        return true;
+    case TypeSignedNumber:
+    case TypeUnsignedNumber:
+    case TypeTimeSpan:
+    case TypeDouble:
+    case TypePointer:
+        if (available < 8)
+        {
+            return false;
+        }
+
+        if (type == TypeDouble)
+        {
+            memcpy(&arg.value_.valueDouble_, payload, 8);
+        }
+        else if (type == TypePointer)
+        {
+            uint64 pointer;
+            memcpy(&pointer, payload, 8);
+            arg.value_.valuePointer_ = reinterpret_cast<void const*>(pointer);
+        }
+        else
+        {
+            memcpy(&arg.value_.valueUInt64_, payload, 8);
+        }
+
+        current = payload + 8;
+        return true;
+    case TypeString:
+        {
+        uint32 size;
+        if (available < sizeof(size))
+        {
+            return false;
+        }
+
+        memcpy(&size, payload, sizeof(size));
+        if ((available - sizeof(size)) < size)
+        {
+            return false;
+        }
+
+        stringValue.assign(reinterpret_cast<char const*>(payload + sizeof(size)), size);
+        arg.value_.valueString_.size_ = stringValue.size();
+        arg.value_.valueString_.buffer_ = stringValue.c_str();
+
+        current = payload + sizeof(size) + size;
+        return true;
+        }
+    default:
+        return false;
+    }
+}
+
 void VariableArgument::WriteTo(TextWriter& w, FormatOptions const & format) const
 {
     switch (type_)
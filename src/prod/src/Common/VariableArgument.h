@@ -289,6 +289,13 @@ namespace Common
 
         void WriteTo(TextWriter& w, FormatOptions const & format) const;
 
+        // Binary encoding used by TraceBinaryFileSink. Only types whose text depends on nothing but
+        // their value and format options are encoded, TryWriteBinary returns false for other types.
+        bool TryWriteBinary(std::vector<BYTE> & buffer) const;
+
+        // stringValue holds the characters of a decoded string, it must outlive the argument
+        static bool TryReadBinary(BYTE const * & current, BYTE const * end, std::string & stringValue, VariableArgument & arg);
+
     private:
         Enum type_;
         Value value_;
@@ -65,3 +65,11 @@ namespace Federation
         std::string fromRing_;
     };
 }
+
+namespace Transport
+{
+    template <>
+    struct CacheDecodedHeader<Federation::BroadcastHeader> : std::true_type
+    {
+    };
+}
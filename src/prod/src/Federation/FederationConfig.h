@@ -61,6 +61,11 @@ namespace Federation
         INTERNAL_CONFIG_ENTRY(Common::TimeSpan, "Federation", RoutingTableCompactInterval, Common::TimeSpan::FromSeconds(300), Common::ConfigEntryUpgradePolicy::Static);
         // The interval to check routing table health.
         INTERNAL_CONFIG_ENTRY(Common::TimeSpan, "Federation", RoutingTableHealthCheckInterval, Common::TimeSpan::FromSeconds(1), Common::ConfigEntryUpgradePolicy::Static);
+        // The number of exponentially spaced levels kept in the finger table on each side of the node.
+        INTERNAL_CONFIG_ENTRY(int, "Federation", FingerTableLevels, 64, Common::ConfigEntryUpgradePolicy::Static);
+        // The max number of routing table entries walked from the closest position when looking
+        // for a routing hop before falling back to the finger table.
+        INTERNAL_CONFIG_ENTRY(int, "Federation", FingerTableWalkLimit, 32, Common::ConfigEntryUpgradePolicy::Dynamic);
         // The limit on number of nodes kept in routing table that will trigger a compact.
         INTERNAL_CONFIG_ENTRY(int, "Federation", RoutingTableCapacity, 4096, Common::ConfigEntryUpgradePolicy::Dynamic);
         // The max number of nodes to keep in the neighborhood, including shutdown ones.
@@ -126,6 +131,15 @@ namespace Federation
 
         // The interval to send ping messages.
         INTERNAL_CONFIG_ENTRY(Common::TimeSpan, "Federation", PingInterval, Common::TimeSpan::FromSeconds(15), Common::ConfigEntryUpgradePolicy::Static);
+        // The ping interval is divided into this many slots and every ping target is assigned a
+        // jittered slot, so that pings to a large neighborhood are spread across the interval
+        // instead of being sent in one burst.  1 sends all pings together.
+        INTERNAL_CONFIG_ENTRY(int, "Federation", PingPacingSlotCount, 8, Common::ConfigEntryUpgradePolicy::Static);
+        // Whether vote tickets and global store state are piggybacked on ordinary traffic to a
+        // ping target that is due for a ping, in place of a dedicated ping message.  Nodes of
+        // earlier versions ignore the piggybacked ping, so enable it only after every node in
+        // the ring has been upgraded.
+        INTERNAL_CONFIG_ENTRY(bool, "Federation", PingPiggybackEnabled, false, Common::ConfigEntryUpgradePolicy::Dynamic);
         // The interval to send update messages.
         INTERNAL_CONFIG_ENTRY(Common::TimeSpan, "Federation", UpdateInterval, Common::TimeSpan::FromSeconds(15), Common::ConfigEntryUpgradePolicy::Static);
         // Maximum number of update messages to send each round.
@@ -272,6 +286,15 @@ namespace Federation
 
         // The config to set the threshold to do faster pulling of the app ttl
         INTERNAL_CONFIG_ENTRY(Common::TimeSpan, "Federation", LeaseMonitorRenewLevelThreshold, Common::TimeSpan::FromSeconds(10), Common::ConfigEntryUpgradePolicy::Dynamic);
+        // SCHED_FIFO priority of the lease event loop and lease timer threads on Linux, 0 keeps the default scheduling policy.
+        // Lease renewals are then processed ahead of regular work when the machine is CPU saturated.
+        INTERNAL_CONFIG_ENTRY(int, "Federation", LeaseThreadRealtimePriority, 0, Common::ConfigEntryUpgradePolicy::Static, Common::InRange<int>(0, 99));
+        // The number of lease event loop threads on Linux, 0 uses Common/EventLoopConcurrency, or the processor count when that is 0 too, and no fewer than 2 threads are used
+        INTERNAL_CONFIG_ENTRY(int, "Federation", LeaseEventLoopThreadCount, 2, Common::ConfigEntryUpgradePolicy::Static, Common::NoLessThan(0));
+        // Size of the buffer preallocated on every lease event loop thread for incoming lease messages
+        INTERNAL_CONFIG_ENTRY(int, "Federation", LeaseReceiveBufferSize, 4096, Common::ConfigEntryUpgradePolicy::Static, Common::NoLessThan(0));
+        // Renew round trip and lease timer lateness histograms are traced every time this many renew round trips are recorded
+        INTERNAL_CONFIG_ENTRY(int, "Federation", LeaseLatencyTraceSampleCount, 1000, Common::ConfigEntryUpgradePolicy::Static, Common::NoLessThan(1));
 
         /* Point to point communcation*/
         // Specify max thread count for loopback job queue, default to 0, which means using processor count
@@ -0,0 +1,45 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Federation
+{
+    class FederationPerfCounters
+    {
+        DENY_COPY(FederationPerfCounters)
+
+    public:
+
+        BEGIN_COUNTER_SET_DEFINITION(
+            "517b6741-6d44-4d7b-976f-bae20f4a3772",
+            "Federation",
+            "Counters for Federation",
+            Common::PerformanceCounterSetInstanceType::Multiple)
+            COUNTER_DEFINITION(
+                1,
+                Common::PerformanceCounterType::RateOfCountPerSecond64,
+                "# Ping messages sent/Second",
+                "Number of dedicated ping messages sent per second")
+            COUNTER_DEFINITION(
+                2,
+                Common::PerformanceCounterType::RateOfCountPerSecond64,
+                "# Pings piggybacked/Second",
+                "Number of pings per second that were piggybacked on other traffic to the ping target instead of being sent as a dedicated message")
+        END_COUNTER_SET_DEFINITION()
+
+        DECLARE_COUNTER_INSTANCE(RateOfPingsSent)
+        DECLARE_COUNTER_INSTANCE(RateOfPingsPiggybacked)
+
+        BEGIN_COUNTER_SET_INSTANCE(FederationPerfCounters)
+            DEFINE_COUNTER_INSTANCE(
+                RateOfPingsSent,
+                1)
+            DEFINE_COUNTER_INSTANCE(
+                RateOfPingsPiggybacked,
+                2)
+        END_COUNTER_SET_INSTANCE()
+    };
+}
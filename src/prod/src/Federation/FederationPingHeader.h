@@ -0,0 +1,62 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Federation
+{
+    /// <summary>
+    /// Carries the content of a ping message (vote tickets and global store state)
+    /// on ordinary point to point traffic to a ping target, in place of a
+    /// dedicated ping message.
+    /// </summary>
+    class FederationPingHeader : public Transport::MessageHeader<Transport::MessageHeaderId::FederationPing>, public Serialization::FabricSerializable
+    {
+        DENY_COPY(FederationPingHeader);
+
+    public:
+        FederationPingHeader()
+        {
+        }
+
+        FederationPingHeader(GlobalLease && globalLease, SerializableWithActivationList && globalStates)
+            : globalLease_(std::move(globalLease)), globalStates_(std::move(globalStates))
+        {
+        }
+
+        FederationPingHeader(FederationPingHeader && other)
+            : globalLease_(std::move(other.globalLease_)), globalStates_(std::move(other.globalStates_))
+        {
+        }
+
+        FederationPingHeader & operator = (FederationPingHeader && other)
+        {
+            if (this != &other)
+            {
+                globalLease_ = std::move(other.globalLease_);
+                globalStates_ = std::move(other.globalStates_);
+            }
+
+            return *this;
+        }
+
+        __declspec(property(get = getGlobalLease)) GlobalLease & Lease;
+        GlobalLease & getGlobalLease() { return globalLease_; }
+
+        __declspec(property(get = getGlobalStates)) SerializableWithActivationList & GlobalStates;
+        SerializableWithActivationList & getGlobalStates() { return globalStates_; }
+
+        void WriteTo(Common::TextWriter & w, Common::FormatOptions const &) const
+        {
+            w.Write("{0}", globalLease_);
+        }
+
+        FABRIC_FIELDS_02(globalLease_, globalStates_);
+
+    private:
+        GlobalLease globalLease_;
+        SerializableWithActivationList globalStates_;
+    };
+}
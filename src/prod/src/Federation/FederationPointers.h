@@ -20,4 +20,10 @@ namespace Federation
     typedef std::unique_ptr<FederationSubsystem> FederationSubsystemUPtr;
     typedef std::unique_ptr<RequestReceiverContext> RequestReceiverContextUPtr;
     typedef std::unique_ptr<OneWayReceiverContext> OneWayReceiverContextUPtr;
+
+    class RoutingTableSnapshot;
+    typedef std::shared_ptr<RoutingTableSnapshot const> RoutingTableSnapshotSPtr;
+
+    class FederationPerfCounters;
+    typedef std::shared_ptr<FederationPerfCounters> FederationPerfCountersSPtr;
 }
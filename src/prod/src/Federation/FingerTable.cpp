@@ -0,0 +1,168 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+using namespace std;
+using namespace Common;
+using namespace Federation;
+
+PartnerNodeSPtr const FingerTable::NullFinger;
+
+FingerTable::FingerTable(NodeId thisNode, int levels)
+    : thisNode_(thisNode),
+    version_(0)
+{
+    // same spacing as the exponential targets of the update protocol so that
+    // update replies can refresh the fingers directly
+    LargeInteger stepSize = LargeInteger::MaxValue >> 1;
+    stepSize += LargeInteger::One; // half the number space size
+    targets_.push_back(thisNode_ + stepSize);
+
+    for (int i = 1; i < levels && stepSize > LargeInteger::One; i++)
+    {
+        stepSize >>= 1;
+        targets_.push_back(thisNode_ + stepSize);
+        targets_.push_back(thisNode_ - stepSize);
+    }
+
+    fingers_.resize(targets_.size());
+}
+
+bool FingerTable::IsInRing(NodeRing const & ring, PartnerNodeSPtr const & node)
+{
+    return (ring.Size > 0 && ring.GetNode(ring.FindSuccOrSamePosition(node->Id)) == node);
+}
+
+void FingerTable::Refresh(NodeRing const & ring, size_t walkLimit)
+{
+    for (size_t i = 0; i < targets_.size(); i++)
+    {
+        size_t position = ring.FindSuccOrSamePosition(targets_[i]);
+        size_t count = min(walkLimit, ring.Size);
+
+        PartnerNodeSPtr const * found = nullptr;
+        for (size_t j = 0; j < count; j++)
+        {
+            PartnerNodeSPtr const & node = ring.GetNode(position);
+            if (node->Id != thisNode_ && IsUsable(node))
+            {
+                found = &node;
+                break;
+            }
+
+            position = ring.GetSucc(position);
+        }
+
+        if (found)
+        {
+            fingers_[i] = *found;
+        }
+        else if (fingers_[i] && (!IsUsable(fingers_[i]) || !IsInRing(ring, fingers_[i])))
+        {
+            fingers_[i] = nullptr;
+        }
+    }
+
+    UpdateDistinctFingers();
+}
+
+bool FingerTable::Update(NodeId target, PartnerNodeSPtr const & owner)
+{
+    if (!IsUsable(owner) || owner->Id == thisNode_)
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < targets_.size(); i++)
+    {
+        if (targets_[i] == target)
+        {
+            if (fingers_[i] != owner)
+            {
+                fingers_[i] = owner;
+                UpdateDistinctFingers();
+            }
+
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void FingerTable::Clear()
+{
+    for (PartnerNodeSPtr & finger : fingers_)
+    {
+        finger = nullptr;
+    }
+
+    if (distinctFingers_.size() > 0)
+    {
+        distinctFingers_.clear();
+        version_++;
+    }
+}
+
+void FingerTable::UpdateDistinctFingers()
+{
+    vector<PartnerNodeSPtr> distinctFingers;
+
+    for (PartnerNodeSPtr const & finger : fingers_)
+    {
+        if (finger && find(distinctFingers.begin(), distinctFingers.end(), finger) == distinctFingers.end())
+        {
+            distinctFingers.push_back(finger);
+        }
+    }
+
+    if (distinctFingers != distinctFingers_)
+    {
+        distinctFingers_ = move(distinctFingers);
+        version_++;
+    }
+}
+
+PartnerNodeSPtr const & FingerTable::FindClosest(NodeId const & value) const
+{
+    return FindClosest(distinctFingers_, value);
+}
+
+PartnerNodeSPtr const & FingerTable::FindClosest(vector<PartnerNodeSPtr> const & fingers, NodeId const & value)
+{
+    // Node ids are uniformly distributed so only O(log n) of the fingers are
+    // distinct; a scan over them is cheaper than keeping them sorted.
+    PartnerNodeSPtr const * result = &NullFinger;
+    LargeInteger minDist = LargeInteger::MaxValue;
+
+    for (PartnerNodeSPtr const & finger : fingers)
+    {
+        if (!IsUsable(finger))
+        {
+            continue;
+        }
+
+        LargeInteger predDist = value.PredDist(finger->Id);
+        LargeInteger succDist = value.SuccDist(finger->Id);
+        LargeInteger const & dist = (predDist <= succDist ? predDist : succDist);
+        if (!*result || dist < minDist)
+        {
+            result = &finger;
+            minDist = dist;
+        }
+    }
+
+    return *result;
+}
+
+void FingerTable::WriteTo(TextWriter& w, FormatOptions const &) const
+{
+    w.Write("{0}/{1}:", distinctFingers_.size(), targets_.size());
+    for (PartnerNodeSPtr const & finger : distinctFingers_)
+    {
+        w.Write(" {0}", finger->Instance);
+    }
+}
@@ -0,0 +1,101 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Federation
+{
+    /// <summary>
+    /// Exponentially spaced routing partners of a node: for every level k the first
+    /// known routing node at or after (this node + 2^k) and (this node - 2^k).
+    /// The table lets the routing table pick a hop in O(log n) when long runs of
+    /// unknown or shutdown entries would otherwise be walked linearly.
+    /// </summary>
+    /// <remarks>
+    /// The finger table is owned by the routing table and is only accessed under
+    /// the routing table lock.
+    /// </remarks>
+    class FingerTable
+    {
+        DENY_COPY(FingerTable);
+
+    public:
+        /// <summary>
+        /// Constructor.
+        /// </summary>
+        /// <param name="thisNode">The id of the node that owns the table</param>
+        /// <param name="levels">The number of exponential levels to maintain on each side</param>
+        FingerTable(NodeId thisNode, int levels);
+
+        /// <summary>
+        /// The number of distinct nodes in the table.
+        /// </summary>
+        __declspec (property(get=getSize)) size_t Size;
+        size_t getSize() const { return distinctFingers_.size(); }
+
+        /// <summary>
+        /// The distinct nodes in the table.
+        /// </summary>
+        __declspec (property(get=getFingers)) std::vector<PartnerNodeSPtr> const & Fingers;
+        std::vector<PartnerNodeSPtr> const & getFingers() const { return distinctFingers_; }
+
+        /// <summary>
+        /// A counter that changes whenever the distinct fingers change.
+        /// </summary>
+        __declspec (property(get=getVersion)) uint64 Version;
+        uint64 getVersion() const { return version_; }
+
+        /// <summary>
+        /// Recompute every finger from the routing ring, walking at most walkLimit
+        /// entries from each target. A finger that cannot be replaced within the
+        /// limit is kept as long as it is still a usable member of the ring.
+        /// </summary>
+        void Refresh(NodeRing const & ring, size_t walkLimit);
+
+        /// <summary>
+        /// Record the owner of an exponential target reported back by the update protocol.
+        /// </summary>
+        /// <returns>Whether target is one of the finger targets.</returns>
+        bool Update(NodeId target, PartnerNodeSPtr const & owner);
+
+        /// <summary>
+        /// Drop all fingers.
+        /// </summary>
+        void Clear();
+
+        /// <summary>
+        /// Find the usable finger closest to value.
+        /// </summary>
+        /// <returns>The finger, or a null pointer if the table has no usable finger.</returns>
+        PartnerNodeSPtr const & FindClosest(NodeId const & value) const;
+
+        /// <summary>
+        /// Find the usable node in fingers closest to value.
+        /// </summary>
+        static PartnerNodeSPtr const & FindClosest(std::vector<PartnerNodeSPtr> const & fingers, NodeId const & value);
+
+        void WriteTo(Common::TextWriter& w, Common::FormatOptions const &) const;
+
+        static bool IsUsable(PartnerNodeSPtr const & node)
+        {
+            return (node && node->IsRouting && !node->IsUnknown);
+        }
+
+    private:
+        void UpdateDistinctFingers();
+
+        static bool IsInRing(NodeRing const & ring, PartnerNodeSPtr const & node);
+
+        NodeId thisNode_;
+        std::vector<NodeId> targets_;
+        std::vector<PartnerNodeSPtr> fingers_;
+
+        // fingers_ without duplicates and empty entries, used for lookups
+        std::vector<PartnerNodeSPtr> distinctFingers_;
+        uint64 version_;
+
+        static PartnerNodeSPtr const NullFinger;
+    };
+}
@@ -12,12 +12,12 @@ namespace Federation
         DENY_COPY(NodeRingBase);
 
     public:
-        NodeRingBase()
+        NodeRingBase() : version_(0)
         {
         }
 
         NodeRingBase(NodeRingBase && other)
-            : ring_(std::move(other.ring_))
+            : ring_(std::move(other.ring_)), version_(other.version_)
         {
         }
 
@@ -27,6 +27,12 @@ namespace Federation
         __declspec (property(get=getSize)) size_t Size;
         size_t getSize() const { return ring_.size(); }
 
+        /// <summary>
+        /// Return a counter that changes whenever nodes are added, removed or replaced
+        /// </summary>
+        __declspec (property(get=getVersion)) uint64 Version;
+        uint64 getVersion() const { return version_; }
+
         /// <summary>
         /// Get a node at specified position
         /// </summary>
@@ -95,6 +101,12 @@ namespace Federation
         /// <param name="newNode">The new node</param>
         void ReplaceNode(size_t position, PartnerNodeSPtr const& newNode);
 
+        /// <summary>
+        /// Replace the nodes of this ring with the nodes of another ring.
+        /// </summary>
+        /// <param name="other">The ring to copy from</param>
+        void CopyFrom(NodeRingBase const & other);
+
         /// <summary>
         /// Clear the ring.
         /// </summary>
@@ -130,6 +142,11 @@ namespace Federation
         /// The ring data structure
         /// </summary>
         std::vector<PartnerNodeSPtr> ring_;
+
+        /// <summary>
+        /// Incremented on every change to ring_
+        /// </summary>
+        uint64 version_;
     };
 
     /// <summary>
@@ -74,3 +74,11 @@ namespace Federation
         bool exactInstance_;
     };
 }
+
+namespace Transport
+{
+    template <>
+    struct CacheDecodedHeader<Federation::PToPHeader> : std::true_type
+    {
+    };
+}
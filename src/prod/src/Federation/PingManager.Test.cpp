@@ -0,0 +1,178 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <boost/test/unit_test.hpp>
+#include "Common/boost-taef.h"
+
+namespace FederationUnitTests
+{
+    using namespace std;
+    using namespace Common;
+    using namespace Federation;
+    using namespace Transport;
+
+    class PingManagerTests
+    {
+    protected:
+        static vector<NodeInstance> CreateTargets(size_t count)
+        {
+            vector<NodeInstance> targets;
+            for (size_t i = 0; i < count; i++)
+            {
+                targets.push_back(NodeInstance(NodeId(LargeInteger(0, i + 1)), 1));
+            }
+
+            return targets;
+        }
+    };
+
+    BOOST_FIXTURE_TEST_SUITE(PingManagerTestsSuite,PingManagerTests)
+
+    BOOST_AUTO_TEST_CASE(PingPacingTest)
+    {
+        const int slotCount = 8;
+        const int rounds = 4;
+        PingSchedule schedule(TimeSpan::FromSeconds(8), slotCount, 1234);
+        vector<NodeInstance> targets = CreateTargets(80);
+
+        StopwatchTime now = StopwatchTime(TimeSpan::FromSeconds(100).Ticks);
+        vector<size_t> dueTargets;
+
+        // new targets are all pinged right away
+        schedule.Update(targets, now, dueTargets);
+        VERIFY_ARE_EQUAL2(dueTargets.size(), targets.size());
+        VERIFY_ARE_EQUAL2(schedule.Count, targets.size());
+
+        vector<vector<int>> pingSteps(targets.size());
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            pingSteps[i].push_back(0);
+        }
+
+        for (int step = 1; step <= slotCount * rounds; step++)
+        {
+            now = now + schedule.Slot;
+            schedule.Update(targets, now, dueTargets);
+
+            // the pings are spread across the slots instead of being sent in one burst
+            VERIFY_IS_TRUE(dueTargets.size() <= targets.size() / 2);
+
+            for (size_t index : dueTargets)
+            {
+                pingSteps[index].push_back(step);
+            }
+        }
+
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            // every target is pinged once per interval; the first ping after joining
+            // is followed by one at a random phase within the interval
+            VERIFY_IS_TRUE(pingSteps[i].size() >= rounds);
+            VERIFY_IS_TRUE(pingSteps[i][1] <= slotCount);
+
+            for (size_t j = 2; j < pingSteps[i].size(); j++)
+            {
+                int gap = pingSteps[i][j] - pingSteps[i][j - 1];
+                VERIFY_IS_TRUE(gap == slotCount - 1 || gap == slotCount);
+            }
+        }
+
+        // targets that are gone are dropped from the schedule
+        targets.resize(10);
+        schedule.Update(targets, now, dueTargets);
+        VERIFY_ARE_EQUAL2(schedule.Count, 10u);
+    }
+
+    BOOST_AUTO_TEST_CASE(PingPiggybackTest)
+    {
+        const int slotCount = 8;
+        PingSchedule schedule(TimeSpan::FromSeconds(8), slotCount, 4321);
+        vector<NodeInstance> targets = CreateTargets(16);
+
+        StopwatchTime now = StopwatchTime(TimeSpan::FromSeconds(100).Ticks);
+        vector<size_t> dueTargets;
+        schedule.Update(targets, now, dueTargets);
+
+        NodeInstance unknown(NodeId(LargeInteger(1, 0)), 1);
+        VERIFY_IS_FALSE(schedule.IsPiggybackDue(unknown, now));
+        VERIFY_IS_FALSE(schedule.TryPiggyback(unknown, now));
+
+        size_t piggybacked = 0;
+        for (int step = 1; step <= slotCount; step++)
+        {
+            for (NodeInstance const & target : targets)
+            {
+                bool due = schedule.IsPiggybackDue(target, now);
+                VERIFY_ARE_EQUAL2(schedule.TryPiggyback(target, now), due);
+
+                if (due)
+                {
+                    // the ping is rescheduled a full interval out, so neither another
+                    // send nor the timer pings the target again within this slot
+                    VERIFY_IS_FALSE(schedule.IsPiggybackDue(target, now));
+                    VERIFY_IS_FALSE(schedule.TryPiggyback(target, now));
+                    piggybacked++;
+                }
+            }
+
+            now = now + schedule.Slot;
+            schedule.Update(targets, now, dueTargets);
+
+            // every target had traffic in every slot, so there are no dedicated pings
+            VERIFY_ARE_EQUAL2(dueTargets.size(), 0u);
+        }
+
+        // each target was pinged once in the interval, on traffic
+        VERIFY_ARE_EQUAL2(piggybacked, targets.size());
+    }
+
+    BOOST_AUTO_TEST_CASE(PiggybackedPingReceiveTest)
+    {
+        FederationConfig::Test_Reset();
+
+        // nodes that do not understand the header must keep receiving dedicated pings
+        VERIFY_IS_FALSE(FederationConfig::GetConfig().PingPiggybackEnabled);
+
+        NodeId voteId(LargeInteger(0, 7));
+        StopwatchTime expireTime = StopwatchTime(TimeSpan::FromSeconds(200).Ticks);
+        vector<VoteTicket> tickets;
+        tickets.push_back(VoteTicket(voteId, expireTime));
+
+        auto message = make_unique<Message>();
+        message->Headers.Add(ActorHeader(Actor::GenericTestActor));
+        message->Headers.Add(FederationPingHeader(GlobalLease(move(tickets), TimeSpan::FromSeconds(1)), SerializableWithActivationList()));
+
+        // copy the bytes to a new buffer and construct a received message from them
+        bique<byte> headersBique(1024);
+        BiqueWriteStream headersWriteStream(headersBique);
+        for (BiqueChunkIterator chunk = message->BeginHeaderChunks(); !(chunk == message->EndHeaderChunks()); ++chunk)
+        {
+            Common::const_buffer buffer = *chunk;
+            headersWriteStream.WriteBytes(buffer.buf, buffer.len);
+        }
+
+        bique<byte> bodyBique(1024);
+        ByteBiqueRange headersRange(headersBique.begin(), headersBique.end(), false);
+        ByteBiqueRange bodyRange(bodyBique.begin(), bodyBique.end(), false);
+        Message receivedMessage(move(headersRange), move(bodyRange), Message::NullReceiveTime());
+
+        FederationPingHeader header;
+        VERIFY_IS_TRUE(receivedMessage.Headers.TryReadFirst(header));
+        VERIFY_ARE_EQUAL2(header.Lease.Tickets.size(), 1u);
+        VERIFY_IS_TRUE(header.Lease.Tickets[0].VoteId == voteId);
+        VERIFY_ARE_EQUAL2(header.GlobalStates.Objects.size(), 0u);
+
+        // a message without the header is not a ping
+        auto plainMessage = make_unique<Message>();
+        plainMessage->Headers.Add(ActorHeader(Actor::GenericTestActor));
+        VERIFY_IS_FALSE(plainMessage->Headers.TryReadFirst(header));
+
+        FederationConfig::Test_Reset();
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+}
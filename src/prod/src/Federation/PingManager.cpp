@@ -14,14 +14,16 @@ namespace Federation
 
     PingManager::PingManager(SiteNode & siteNode)
         : siteNode_(siteNode),
-          stopped_(false)
+          stopped_(false),
+          schedule_(FederationConfig::GetConfig().PingInterval, FederationConfig::GetConfig().PingPacingSlotCount)
     {
+        perfCounters_ = FederationPerfCounters::CreateInstance(formatString.L("{0}-{1}-{2}", ::GetCurrentProcessId(), siteNode.Instance, Guid::NewGuid()));
     }
 
     PingManager::~PingManager()
     {
     }
-    
+
     void PingManager::Start()
     {
         {
@@ -36,8 +38,7 @@ namespace Federation
                 PingTimerTag,
                 [this, rootSPtr] (TimerSPtr const &) { this->TimerCallback(); });
 
-            TimeSpan interval = FederationConfig::GetConfig().PingInterval;
-            timerSPtr_->Change(interval, interval);
+            timerSPtr_->Change(schedule_.Slot, schedule_.Slot);
         }
 
         SendPingMessages();
@@ -50,6 +51,7 @@ namespace Federation
             AcquireWriteLock writeLock(thisLock_);
             needToStop = (timerSPtr_ != nullptr);
             stopped_ = true;
+            schedule_.Clear();
         }
 
         if (needToStop)
@@ -65,6 +67,8 @@ namespace Federation
         message->AddBody(siteNode_.GetGlobalStore().AddOutputState(&(target->Instance)), true);
         siteNode_.Table.AddGlobalTimeExchangeHeader(*message, target);
         siteNode_.Send(std::move(message), target);
+
+        perfCounters_->RateOfPingsSent.Increment();
     }
 
     void PingManager::SendPingMessages()
@@ -72,15 +76,94 @@ namespace Federation
         std::vector<PartnerNodeSPtr> targets;
         siteNode_.Table.GetPingTargets(targets);
 
+        vector<NodeInstance> instances;
+        instances.reserve(targets.size());
+        for (PartnerNodeSPtr const & target : targets)
+        {
+            instances.push_back(target->Instance);
+        }
+
+        vector<size_t> dueTargets;
+        {
+            AcquireWriteLock grab(thisLock_);
+            if (stopped_)
+            {
+                return;
+            }
+
+            schedule_.Update(instances, Stopwatch::Now(), dueTargets);
+        }
+
+        if (dueTargets.empty())
+        {
+            return;
+        }
+
         vector<VoteTicket> tickets;
         siteNode_.GetVoteManager().GenerateGlobalLease(tickets);
 
-        while(!targets.empty())
+        for (size_t index : dueTargets)
+        {
+            SendPingMessage(targets[index], tickets);
+        }
+    }
+
+    void PingManager::AddPiggybackedPing(__inout Transport::Message & message, PartnerNodeSPtr const & target)
+    {
+        if (!FederationConfig::GetConfig().PingPiggybackEnabled)
         {
-            PartnerNodeSPtr target = targets.back();
-            targets.pop_back();
+            return;
+        }
 
-            SendPingMessage(target, tickets);
+        StopwatchTime now = Stopwatch::Now();
+        {
+            AcquireReadLock grab(thisLock_);
+            if (!schedule_.IsPiggybackDue(target->Instance, now))
+            {
+                return;
+            }
+        }
+
+        {
+            AcquireWriteLock grab(thisLock_);
+            if (!schedule_.TryPiggyback(target->Instance, now))
+            {
+                // another send has already piggybacked the ping
+                return;
+            }
+        }
+
+        message.Headers.Add(FederationPingHeader(
+            siteNode_.GetVoteManager().GenerateGlobalLease(target->Instance),
+            siteNode_.GetGlobalStore().AddOutputState(&(target->Instance))));
+        siteNode_.Table.AddGlobalTimeExchangeHeader(message, target);
+
+        perfCounters_->RateOfPingsPiggybacked.Increment();
+    }
+
+    void PingManager::ProcessPiggybackedPing(__in Transport::Message & message, NodeInstance const & fromInstance, PartnerNodeSPtr const & from)
+    {
+        FederationPingHeader header;
+        if (!message.Headers.TryReadFirst(header) || !siteNode_.IsAvailable)
+        {
+            return;
+        }
+
+        bool newEntry = siteNode_.GetVoteManager().UpdateGlobalTickets(header.Lease, fromInstance);
+
+        if (from->Instance == fromInstance)
+        {
+            siteNode_.Table.ProcessGlobalTimeExchangeHeader(message, from);
+        }
+
+        siteNode_.GetGlobalStore().ProcessInputState(header.GlobalStates, from->Instance);
+
+        if (newEntry)
+        {
+            vector<VoteTicket> tickets;
+            siteNode_.GetVoteManager().GenerateGlobalLease(tickets);
+
+            SendPingMessage(from, tickets);
         }
     }
 
@@ -109,7 +192,7 @@ namespace Federation
 
         auto body = message.GetBodyStream();
         GlobalLease globalLease;
-        
+
         NTSTATUS status = body->ReadSerializable(&globalLease);
         if (!NT_SUCCESS(status))
         {
@@ -7,6 +7,18 @@
 
 namespace Federation
 {
+    /// <summary>
+    /// Sends the vote tickets and global store state of this node to its ping targets
+    /// once per ping interval.
+    /// </summary>
+    /// <remarks>
+    /// The interval is divided into PingPacingSlotCount slots.  Every ping target is
+    /// assigned a randomly jittered due time, and the timer fires once per slot to ping
+    /// only the targets that are due, so that pings are spread across the interval.
+    /// A target that is due within the next slot does not need a dedicated ping when
+    /// other point to point traffic is sent to it: the ping content is piggybacked on
+    /// that traffic in a FederationPingHeader instead.
+    /// </remarks>
     class PingManager : public std::enable_shared_from_this<PingManager>
     {
         DENY_COPY(PingManager);
@@ -14,11 +26,25 @@ namespace Federation
     public:
         PingManager(SiteNode & siteNode);
         ~PingManager();
-        
+
         void Start();
         void Stop();
         void MessageHandler(__in Transport::Message & message, OneWayReceiverContext & oneWayReceiverContext);
 
+        /// <summary>
+        /// Adds a FederationPingHeader to a message sent to target if the next ping to
+        /// target is due within the current slot, and reschedules the ping.
+        /// </summary>
+        void AddPiggybackedPing(__inout Transport::Message & message, PartnerNodeSPtr const & target);
+
+        /// <summary>
+        /// Processes the FederationPingHeader of a received message, if there is one.
+        /// </summary>
+        void ProcessPiggybackedPing(__in Transport::Message & message, NodeInstance const & fromInstance, PartnerNodeSPtr const & from);
+
+        __declspec(property(get = get_PerfCounters)) FederationPerfCounters & PerfCounters;
+        FederationPerfCounters & get_PerfCounters() const { return *perfCounters_; }
+
     private:
         void TimerCallback();
         void SendPingMessage(PartnerNodeSPtr const & target, std::vector<VoteTicket> const & tickets);
@@ -29,5 +55,8 @@ namespace Federation
         SiteNode & siteNode_;
         Common::TimerSPtr timerSPtr_;
         _Guarded_by_(thisLock_) bool stopped_;
+        _Guarded_by_(thisLock_) PingSchedule schedule_;
+
+        FederationPerfCountersSPtr perfCounters_;
     };
 }
@@ -0,0 +1,102 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+namespace Federation
+{
+    using namespace Common;
+    using namespace std;
+
+    PingSchedule::PingSchedule(TimeSpan interval, int slotCount)
+        : interval_(interval),
+          slot_(TimeSpan::FromTicks(interval.Ticks / max(slotCount, 1)))
+    {
+    }
+
+    PingSchedule::PingSchedule(TimeSpan interval, int slotCount, int seed)
+        : interval_(interval),
+          slot_(TimeSpan::FromTicks(interval.Ticks / max(slotCount, 1))),
+          random_(seed)
+    {
+    }
+
+    StopwatchTime PingSchedule::GetNextDueTime(StopwatchTime dueTime, StopwatchTime now)
+    {
+        // Keep the phase of the target within the interval so that the pings stay
+        // spread, but pull it forward by a random part of a slot every round so that
+        // targets sharing a slot drift apart and the timer granularity does not
+        // stretch the interval.
+        StopwatchTime next = dueTime + interval_ - TimeSpan::FromTicks(static_cast<int64>(slot_.Ticks * random_.NextDouble()));
+        if (next <= now)
+        {
+            // the timer has fallen behind; do not catch up with a burst
+            next = now + TimeSpan::FromTicks(static_cast<int64>(interval_.Ticks * random_.NextDouble()));
+        }
+
+        return next;
+    }
+
+    void PingSchedule::Update(vector<NodeInstance> const & targets, StopwatchTime now, __out vector<size_t> & dueTargets)
+    {
+        dueTargets.clear();
+
+        map<NodeInstance, StopwatchTime> schedule;
+        for (size_t i = 0; i < targets.size(); i++)
+        {
+            NodeInstance const & target = targets[i];
+            if (schedule.find(target) != schedule.end())
+            {
+                continue;
+            }
+
+            StopwatchTime dueTime;
+            auto it = schedule_.find(target);
+            if (it == schedule_.end())
+            {
+                // A new target is pinged right away and then assigned a random
+                // phase within the interval.
+                dueTargets.push_back(i);
+                dueTime = now + slot_ + TimeSpan::FromTicks(static_cast<int64>((interval_ - slot_).Ticks * random_.NextDouble()));
+            }
+            else if (it->second <= now)
+            {
+                dueTargets.push_back(i);
+                dueTime = GetNextDueTime(it->second, now);
+            }
+            else
+            {
+                dueTime = it->second;
+            }
+
+            schedule.insert(make_pair(target, dueTime));
+        }
+
+        schedule_ = move(schedule);
+    }
+
+    bool PingSchedule::IsPiggybackDue(NodeInstance const & target, StopwatchTime now) const
+    {
+        auto it = schedule_.find(target);
+        return (it != schedule_.end() && it->second <= now + slot_);
+    }
+
+    bool PingSchedule::TryPiggyback(NodeInstance const & target, StopwatchTime now)
+    {
+        auto it = schedule_.find(target);
+        if (it == schedule_.end() || it->second > now + slot_)
+        {
+            return false;
+        }
+
+        it->second = GetNextDueTime(now, now);
+        return true;
+    }
+
+    void PingSchedule::Clear()
+    {
+        schedule_.clear();
+    }
+}
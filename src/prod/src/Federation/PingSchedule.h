@@ -0,0 +1,70 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Federation
+{
+    /// <summary>
+    /// The due time of the next ping to every ping target of a node.
+    /// </summary>
+    /// <remarks>
+    /// The ping interval is divided into slots.  Every target is assigned a randomly
+    /// jittered due time, so that pings are spread across the interval.  The schedule
+    /// is not thread safe, PingManager accesses it under its lock.
+    /// </remarks>
+    class PingSchedule
+    {
+        DENY_COPY(PingSchedule);
+
+    public:
+        /// <summary>
+        /// Constructor.
+        /// </summary>
+        /// <param name="interval">The ping interval</param>
+        /// <param name="slotCount">The number of slots the interval is divided into</param>
+        PingSchedule(Common::TimeSpan interval, int slotCount);
+
+        PingSchedule(Common::TimeSpan interval, int slotCount, int seed);
+
+        __declspec(property(get = getInterval)) Common::TimeSpan Interval;
+        Common::TimeSpan getInterval() const { return interval_; }
+
+        __declspec(property(get = getSlot)) Common::TimeSpan Slot;
+        Common::TimeSpan getSlot() const { return slot_; }
+
+        __declspec(property(get = getCount)) size_t Count;
+        size_t getCount() const { return schedule_.size(); }
+
+        /// <summary>
+        /// Replace the scheduled targets with targets and find the ones due at now.
+        /// A new target is due right away and is then assigned a random phase in the interval.
+        /// </summary>
+        /// <param name="dueTargets">The indexes in targets of the targets to ping now</param>
+        void Update(std::vector<NodeInstance> const & targets, Common::StopwatchTime now, __out std::vector<size_t> & dueTargets);
+
+        /// <summary>
+        /// Whether the ping to target is due within the slot after now.
+        /// </summary>
+        bool IsPiggybackDue(NodeInstance const & target, Common::StopwatchTime now) const;
+
+        /// <summary>
+        /// Reschedule the ping to target if it is due within the slot after now, so that
+        /// the ping can be piggybacked on a message sent to target now.
+        /// </summary>
+        /// <returns>Whether the ping was rescheduled and should be piggybacked.</returns>
+        bool TryPiggyback(NodeInstance const & target, Common::StopwatchTime now);
+
+        void Clear();
+
+    private:
+        Common::StopwatchTime GetNextDueTime(Common::StopwatchTime dueTime, Common::StopwatchTime now);
+
+        Common::TimeSpan interval_;
+        Common::TimeSpan slot_;
+        std::map<NodeInstance, Common::StopwatchTime> schedule_;
+        Common::Random random_;
+    };
+}
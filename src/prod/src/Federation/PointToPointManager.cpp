@@ -96,6 +96,11 @@ void PointToPointManager::AddPToPHeaders(__inout Message & message, PartnerNodeS
     if (to->Id != siteNode_.Id || isToRemoteRing)
     {
         this->siteNode_.Table.AddNeighborHeaders(message, isToRemoteRing);
+
+        if (this->siteNode_.pingManagerUPtr_ && !FederationMessage::IsFederationMessage(message))
+        {
+            this->siteNode_.pingManagerUPtr_->AddPiggybackedPing(message, to);
+        }
     }
 
     message.Headers.Add(PToPHeader(this->siteNode_.Instance, to->Instance, actor, siteNode_.RingName, to->RingName, exactInstance));
@@ -141,6 +146,11 @@ bool PointToPointManager::ProcessPToPHeaders(
         source->OnReceive(message.ExpectsReply);
     }
 
+    if (siteNode_.pingManagerUPtr_ && !FederationMessage::IsFederationMessage(message))
+    {
+        siteNode_.pingManagerUPtr_->ProcessPiggybackedPing(message, header.From, source);
+    }
+
     source->UpdateLastAccess(Stopwatch::Now());
 
     return true;
@@ -95,3 +95,11 @@ namespace Federation
         bool expectsReply_;
     };
 }
+
+namespace Transport
+{
+    template <>
+    struct CacheDecodedHeader<Federation::RoutingHeader> : std::true_type
+    {
+    };
+}
@@ -16,6 +16,8 @@ namespace FederationUnitTests
     using namespace Transport;
     using namespace Federation;
 
+    StringLiteral const TraceRoutingTableTest("RoutingTableTest");
+
     class RoutingTableTests
     {
     };
@@ -88,6 +90,25 @@ namespace FederationUnitTests
         }
     }
 
+    // ids of 2^bits nodes spread evenly over the whole number space,
+    // unlike CreateNodeHeader which only uses the low part
+    NodeId SpreadNodeId(size_t index, int bits)
+    {
+        return NodeId(LargeInteger(static_cast<uint64>(index) << (64 - bits), 0));
+    }
+
+    FederationPartnerNodeHeader CreateSpreadNodeHeader(size_t index, int bits, NodePhase::Enum phase, uint64 instance = 1)
+    {
+        return FederationPartnerNodeHeader(NodeInstance(SpreadNodeId(index, bits), instance), phase, AddressOfNode(index), "", 0, RoutingToken(NodeIdRange(), 0), Common::Uri(), false, "", 1);
+    }
+
+    LargeInteger GetDistance(NodeId const & value, NodeId const & id)
+    {
+        LargeInteger predDist = value.PredDist(id);
+        LargeInteger succDist = value.SuccDist(id);
+        return (predDist <= succDist ? predDist : succDist);
+    }
+
     bool ContainsExactlyOne(vector<PartnerNodeSPtr> const& partnerNodes, NodeId nodeId)
     {
         size_t count = count_if(
@@ -513,6 +534,7 @@ namespace FederationUnitTests
         NodeId node150(LargeInteger(0, 150));
 
 		sitePtr->Test_SetToken(RoutingToken(NodeIdRange(LargeInteger(0, 96), LargeInteger(0, 105)), 1));
+        table.Test_PublishSnapshot();
 
         // Check a routing hop arriving at the current node
         node = table.GetRoutingHop(NodeId(LargeInteger(0, 100)), "", 0, ownsToken);
@@ -544,6 +566,350 @@ namespace FederationUnitTests
         FederationConfig::Test_Reset();
     }
 
+    BOOST_AUTO_TEST_CASE(RoutingTableFingerTableTest)
+    {
+        FederationConfig::Test_Reset();
+        FederationConfig::GetConfig().FingerTableWalkLimit = 4;
+
+        SiteNodeSPtr sitePtr = CreateSiteNode(100);
+        OpenSiteNode(sitePtr);
+
+        RoutingTable & table = sitePtr->Table;
+
+        int const bits = 8;
+        size_t const nodeCount = 1 << bits;
+        for (size_t i = 1; i < nodeCount; i++)
+        {
+            table.Consider(CreateSpreadNodeHeader(i, bits, NodePhase::Inserting), true);
+            table.Consider(CreateSpreadNodeHeader(i, bits, NodePhase::Routing));
+        }
+
+        // leave only every 16th node known away from the neighborhood, so that
+        // most lookups cannot find a known node within the walk limit
+        for (size_t i = 16; i < nodeCount - 16; i++)
+        {
+            if (i % 16 != 0)
+            {
+                table.SetUnknown(NodeInstance(SpreadNodeId(i, bits), 1), "");
+            }
+        }
+
+        table.Test_RefreshFingers();
+        VERIFY_IS_TRUE(table.GetFingerCount() > 0);
+
+        NodeId thisId = sitePtr->Id;
+        for (size_t i = 0; i < nodeCount * 4; i++)
+        {
+            NodeId value = SpreadNodeId(i, bits + 2);
+
+            PartnerNodeSPtr node = table.FindClosest(value, "");
+            VERIFY_IS_TRUE(node && node->IsRouting && !node->IsUnknown);
+            VERIFY_IS_TRUE(GetDistance(value, node->Id) <= GetDistance(value, thisId));
+        }
+
+        // a finger reported by the update protocol is only taken for a finger target
+        NodeId farTarget = thisId + LargeInteger(static_cast<uint64>(1) << 63, 0);
+        NodeId farOwner = SpreadNodeId(nodeCount / 2, bits);
+        table.UpdateFinger(farTarget, NodeInstance(farOwner, 1));
+        table.UpdateFinger(NodeId(LargeInteger(0, 12345)), NodeInstance(farOwner, 1));
+        VERIFY_IS_TRUE(table.GetFingerCount() > 0);
+
+        // without fingers the full walk is used
+        FederationConfig::GetConfig().FingerTableWalkLimit = 0;
+        table.Test_RefreshFingers();
+        VERIFY_IS_TRUE(table.GetFingerCount() == 0);
+
+        PartnerNodeSPtr node = table.FindClosest(SpreadNodeId(100, bits), "");
+        VERIFY_IS_TRUE(node->Instance.Id == SpreadNodeId(96, bits));
+
+        CloseSiteNode(sitePtr);
+
+        FederationConfig::Test_Reset();
+    }
+
+    BOOST_AUTO_TEST_CASE(RoutingTableFingerTableBenchmark)
+    {
+        FederationConfig::Test_Reset();
+
+        SiteNodeSPtr sitePtr = CreateSiteNode(100);
+        OpenSiteNode(sitePtr);
+
+        RoutingTable & table = sitePtr->Table;
+        sitePtr->Test_SetToken(RoutingToken(NodeIdRange(LargeInteger(0, 96), LargeInteger(0, 105)), 1));
+        table.Test_PublishSnapshot();
+
+        int const bits = 11;
+        size_t const nodeCount = 1 << bits;
+        for (size_t i = 1; i < nodeCount; i++)
+        {
+            table.Consider(CreateSpreadNodeHeader(i, bits, NodePhase::Inserting), true);
+            table.Consider(CreateSpreadNodeHeader(i, bits, NodePhase::Routing));
+        }
+
+        for (size_t i = 16; i < nodeCount - 16; i++)
+        {
+            if (i % 64 != 0)
+            {
+                table.SetUnknown(NodeInstance(SpreadNodeId(i, bits), 1), "");
+            }
+        }
+
+        int const lookups = 100000;
+        mt19937_64 random(0);
+        vector<NodeId> values;
+        for (int i = 0; i < lookups; i++)
+        {
+            values.push_back(NodeId(LargeInteger(random(), random())));
+        }
+
+        auto measure = [&]() -> TimeSpan
+        {
+            bool ownsToken;
+            Stopwatch stopwatch;
+            stopwatch.Start();
+
+            for (NodeId const & value : values)
+            {
+                PartnerNodeSPtr node = table.GetRoutingHop(value, "", false, ownsToken);
+                VERIFY_IS_TRUE(node && !node->IsUnknown);
+            }
+
+            stopwatch.Stop();
+            return stopwatch.Elapsed;
+        };
+
+        FederationConfig::GetConfig().FingerTableWalkLimit = 0;
+        table.Test_RefreshFingers();
+        TimeSpan walkElapsed = measure();
+
+        FederationConfig::GetConfig().FingerTableWalkLimit = 32;
+        table.Test_RefreshFingers();
+        TimeSpan fingerElapsed = measure();
+
+        Trace.WriteInfo(
+            TraceRoutingTableTest,
+            "GetRoutingHop: nodes={0} lookups={1} full walk={2} fingers={3} ({4} fingers)",
+            nodeCount,
+            lookups,
+            walkElapsed,
+            fingerElapsed,
+            table.GetFingerCount());
+
+        CloseSiteNode(sitePtr);
+
+        // Hop counts of greedy routing over the fingers and immediate neighbors of
+        // every node in a ring of simulated nodes with random ids.
+        SiteNodeSPtr simulationSite = CreateSiteNode(0);
+        OpenSiteNode(simulationSite);
+        size_t const simulatedNodes = 4096;
+
+        NodeRing ring(make_shared<PartnerNode>(FederationPartnerNodeHeader(NodeInstance(NodeId(LargeInteger(random(), random())), 1), NodePhase::Routing, AddressOfNode(0), "", 0, RoutingToken(NodeIdRange(), 0), Common::Uri(), false, "", 1), *simulationSite));
+        for (size_t i = 1; i < simulatedNodes; i++)
+        {
+            NodeId id(LargeInteger(random(), random()));
+            ring.AddNode(make_shared<PartnerNode>(FederationPartnerNodeHeader(NodeInstance(id, 1), NodePhase::Routing, AddressOfNode(0), "", 0, RoutingToken(NodeIdRange(), 0), Common::Uri(), false, "", 1), *simulationSite));
+        }
+
+        vector<unique_ptr<FingerTable>> fingers;
+        for (size_t i = 0; i < ring.Size; i++)
+        {
+            fingers.push_back(std::make_unique<FingerTable>(ring.GetNode(i)->Id, FederationConfig::GetConfig().FingerTableLevels));
+            fingers.back()->Refresh(ring, FederationConfig::GetConfig().FingerTableWalkLimit);
+        }
+
+        int const routes = 10000;
+        size_t totalHops = 0;
+        size_t maxHops = 0;
+        for (int i = 0; i < routes; i++)
+        {
+            NodeId value(LargeInteger(random(), random()));
+            size_t current = static_cast<size_t>(random() % ring.Size);
+
+            size_t hops = 0;
+            for (;;)
+            {
+                PartnerNodeSPtr const * best = &ring.GetNode(current);
+                PartnerNodeSPtr const * candidates[] =
+                {
+                    &ring.GetNode(ring.GetSucc(current)),
+                    &ring.GetNode(ring.GetPred(current)),
+                    &fingers[current]->FindClosest(value)
+                };
+
+                for (PartnerNodeSPtr const * candidate : candidates)
+                {
+                    if (*candidate && GetDistance(value, (*candidate)->Id) < GetDistance(value, (*best)->Id))
+                    {
+                        best = candidate;
+                    }
+                }
+
+                if (*best == ring.GetNode(current))
+                {
+                    break;
+                }
+
+                current = ring.FindSuccOrSamePosition((*best)->Id);
+                hops++;
+            }
+
+            size_t succ = ring.FindSuccOrSamePosition(value);
+            size_t pred = ring.GetPred(succ);
+            size_t closest = (value.PredDist(ring.GetNode(pred)->Id) <= value.SuccDist(ring.GetNode(succ)->Id) ? pred : succ);
+            VERIFY_IS_TRUE(current == closest || GetDistance(value, ring.GetNode(current)->Id) == GetDistance(value, ring.GetNode(closest)->Id));
+
+            totalHops += hops;
+            maxHops = max(maxHops, hops);
+        }
+
+        Trace.WriteInfo(
+            TraceRoutingTableTest,
+            "Finger routing: nodes={0} routes={1} average hops={2} max hops={3}",
+            simulatedNodes,
+            routes,
+            static_cast<double>(totalHops) / routes,
+            maxHops);
+
+        // log2(4096) = 12
+        VERIFY_IS_TRUE(maxHops <= 36);
+
+        CloseSiteNode(simulationSite);
+
+        FederationConfig::Test_Reset();
+    }
+
+    BOOST_AUTO_TEST_CASE(RoutingTableSnapshotTest)
+    {
+        FederationConfig::Test_Reset();
+
+        SiteNodeSPtr sitePtr = CreateSiteNode(100);
+        OpenSiteNode(sitePtr);
+
+        RoutingTable & table = sitePtr->Table;
+
+        size_t tableNodes[] = {60, 70, 80, 90, 110, 120, 130, 140};
+        FillTable(table, tableNodes, 8);
+
+        // a snapshot is immutable, changes are only visible in the next one
+        RoutingTableSnapshotSPtr snapshot = table.GetSnapshot();
+        VERIFY_IS_TRUE(snapshot->Ring.Size == 9);
+        VERIFY_IS_TRUE(snapshot->Get(NodeId(LargeInteger(0, 130))));
+
+        table.Consider(CreateNodeHeader(150, NodePhase::Inserting), true);
+        table.Consider(CreateNodeHeader(150, NodePhase::Routing));
+
+        VERIFY_IS_TRUE(snapshot->Ring.Size == 9);
+        VERIFY_IS_TRUE(!snapshot->Get(NodeId(LargeInteger(0, 150))));
+
+        RoutingTableSnapshotSPtr current = table.GetSnapshot();
+        VERIFY_IS_TRUE(current != snapshot);
+        VERIFY_IS_TRUE(current->Ring.Size == 10);
+        VERIFY_IS_TRUE(current->Get(NodeId(LargeInteger(0, 150))));
+        VERIFY_IS_TRUE(table.Get(NodeId(LargeInteger(0, 150))));
+        VERIFY_IS_TRUE(table.FindClosest(NodeId(LargeInteger(0, 152)), "")->Id == NodeId(LargeInteger(0, 150)));
+
+        // state changes of known nodes do not need a new snapshot
+        table.SetUnknown(NodeInstance(NodeId(LargeInteger(0, 150)), 1), "");
+        VERIFY_IS_TRUE(table.GetSnapshot() == current);
+        VERIFY_IS_TRUE(table.FindClosest(NodeId(LargeInteger(0, 152)), "")->Id == NodeId(LargeInteger(0, 140)));
+
+        vector<PartnerNodeSPtr> hood;
+        vector<PartnerNodeSPtr> snapshotHood;
+        VERIFY_IS_TRUE(table.GetHood(hood) == current->GetHood(snapshotHood));
+        VERIFY_IS_TRUE(hood.size() == snapshotHood.size());
+
+        CloseSiteNode(sitePtr);
+
+        FederationConfig::Test_Reset();
+    }
+
+    BOOST_AUTO_TEST_CASE(RoutingTableSnapshotChurnBenchmark)
+    {
+        FederationConfig::Test_Reset();
+
+        SiteNodeSPtr sitePtr = CreateSiteNode(100);
+        OpenSiteNode(sitePtr);
+
+        RoutingTable & table = sitePtr->Table;
+        sitePtr->Test_SetToken(RoutingToken(NodeIdRange(LargeInteger(0, 96), LargeInteger(0, 105)), 1));
+        table.Test_PublishSnapshot();
+
+        int const bits = 10;
+        size_t const nodeCount = 1 << bits;
+        for (size_t i = 1; i < nodeCount; i++)
+        {
+            table.Consider(CreateSpreadNodeHeader(i, bits, NodePhase::Inserting), true);
+            table.Consider(CreateSpreadNodeHeader(i, bits, NodePhase::Routing));
+        }
+
+        int const readerCount = 4;
+        int const lookupsPerReader = 200000;
+
+        Common::atomic_long pendingReaders(readerCount);
+        Common::atomic_bool failed(false);
+        ManualResetEvent readersDone(false);
+
+        Stopwatch stopwatch;
+        stopwatch.Start();
+
+        for (int r = 0; r < readerCount; r++)
+        {
+            Threadpool::Post([&, r]
+            {
+                mt19937_64 random(r);
+                bool ownsToken;
+                for (int i = 0; i < lookupsPerReader; i++)
+                {
+                    PartnerNodeSPtr node = table.GetRoutingHop(NodeId(LargeInteger(random(), random())), "", false, ownsToken);
+                    if (!node)
+                    {
+                        failed.store(true);
+                    }
+                }
+
+                if (--pendingReaders == 0)
+                {
+                    readersDone.Set();
+                }
+            });
+        }
+
+        // restart nodes with a new instance while the readers route, every restart
+        // replaces the node in the ring and publishes a new snapshot
+        uint64 instance = 1;
+        size_t churn = 0;
+        while (!readersDone.WaitOne(TimeSpan::Zero))
+        {
+            size_t index = 1 + (churn % (nodeCount - 1));
+            if (index == 1)
+            {
+                instance++;
+            }
+
+            table.Consider(CreateSpreadNodeHeader(index, bits, NodePhase::Routing, instance));
+            churn++;
+        }
+
+        stopwatch.Stop();
+
+        VERIFY_IS_FALSE(failed.load());
+
+        Trace.WriteInfo(
+            TraceRoutingTableTest,
+            "Snapshot churn: nodes={0} readers={1} lookups={2} ({3} lookups/s) restarts={4} ({5} restarts/s) elapsed={6}",
+            nodeCount,
+            readerCount,
+            readerCount * lookupsPerReader,
+            (double)readerCount * lookupsPerReader / stopwatch.Elapsed.TotalMillisecondsAsDouble() * 1000,
+            churn,
+            (double)churn / stopwatch.Elapsed.TotalMillisecondsAsDouble() * 1000,
+            stopwatch.Elapsed);
+
+        CloseSiteNode(sitePtr);
+
+        FederationConfig::Test_Reset();
+    }
+
     BOOST_AUTO_TEST_CASE(RoutingTableGetHoodTest)
     {
         FederationConfig::Test_Reset();
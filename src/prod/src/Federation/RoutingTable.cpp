@@ -52,11 +52,27 @@ namespace Federation
             : grab_(table.lock_), table_(table)
         {
             oldTokenVersion_ = table.site_.Token.Version;
+            oldTokenRange_ = table.site_.Token.Range;
             oldNeighborhoodVersion_ = table.neighborhoodVersion_;
+            oldHoodRange_ = table.knownTable_.GetRange();
+            oldRingVersion_ = table.ring_.Version;
+            oldKnownTableVersion_ = table.knownTable_.Version;
+            oldFingerVersion_ = table.fingerTable_.Version;
         }
 
         ~WriteLock()
         {
+            // publish before any notification so that lookups triggered by it see the change
+            if (oldRingVersion_ != table_.ring_.Version ||
+                oldKnownTableVersion_ != table_.knownTable_.Version ||
+                oldFingerVersion_ != table_.fingerTable_.Version ||
+                oldTokenVersion_ != table_.site_.Token.Version ||
+                oldTokenRange_ != table_.site_.Token.Range ||
+                oldHoodRange_ != table_.knownTable_.GetRange())
+            {
+                table_.PublishSnapshot();
+            }
+
             if (!table_.isTestMode_)
             {
                 if (table_.neighborhoodVersion_ != oldNeighborhoodVersion_)
@@ -75,7 +91,12 @@ namespace Federation
         AcquireWriteLock grab_;
         RoutingTable & table_;
         uint64 oldTokenVersion_;
+        NodeIdRange oldTokenRange_;
         uint oldNeighborhoodVersion_;
+        NodeIdRange oldHoodRange_;
+        uint64 oldRingVersion_;
+        uint64 oldKnownTableVersion_;
+        uint64 oldFingerVersion_;
     };
 
     class GapRequestAction : public StateMachineAction
@@ -179,6 +200,8 @@ namespace Federation
         safeHoodSize_(hoodSize / 2),
         ring_(PartnerNodeSPtr(site)),
         knownTable_(PartnerNodeSPtr(site), hoodSize),
+        fingerTable_(site->Id, FederationConfig::GetConfig().FingerTableLevels),
+        snapshot_(),
         lock_(),
         timer_(),
         lastSuccEdgeProbe_(StopwatchTime::Zero),
@@ -217,6 +240,8 @@ namespace Federation
                 this->OnTimer();
             },
             true);
+
+        PublishSnapshot();
     }
 
     RoutingTable::~RoutingTable()
@@ -229,22 +254,54 @@ namespace Federation
         return ring_.GetRoutingNodeCount();
     }
 
+    RoutingTableSnapshotSPtr RoutingTable::GetSnapshot() const
+    {
+        return atomic_load(&snapshot_);
+    }
+
+    void RoutingTable::PublishSnapshot()
+    {
+        atomic_store(&snapshot_, RoutingTableSnapshotSPtr(make_shared<RoutingTableSnapshot>(ring_, knownTable_, fingerTable_, site_.Token)));
+    }
+
+    void RoutingTable::Test_PublishSnapshot()
+    {
+        AcquireWriteLock grab(lock_);
+        PublishSnapshot();
+    }
+
     PartnerNodeSPtr RoutingTable::FindClosest(NodeId const& value, string const & toRing) const
     {
+        if (site_.IsRingNameMatched(toRing))
+        {
+            // the local ring is looked up in the snapshot without taking the lock,
+            // the reference keeps the snapshot alive until the result is copied
+            RoutingTableSnapshotSPtr snapshot = GetSnapshot();
+            return InternalFindClosest(value, snapshot->Ring, snapshot.get());
+        }
+
         AcquireReadLock grab(lock_);
         return InternalFindClosest(value, toRing, false);
     }
 
     PartnerNodeSPtr RoutingTable::GetRoutingHop(NodeId const& value, string const & toRing, bool safeMode, bool& ownsToken) const
     {
-        AcquireReadLock grab(lock_);
-        
-        ownsToken = (site_.IsRingNameMatched(toRing) && site_.Token.Contains(value));
-        if (ownsToken)
+        if (site_.IsRingNameMatched(toRing))
         {
-            return knownTable_.ThisNodePtr;
+            RoutingTableSnapshotSPtr snapshot = GetSnapshot();
+
+            ownsToken = snapshot->Token.Contains(value);
+            if (ownsToken)
+            {
+                return snapshot->ThisNodePtr;
+            }
+
+            return InternalFindClosest(value, snapshot->Ring, snapshot.get());
         }
 
+        ownsToken = false;
+
+        AcquireReadLock grab(lock_);
         return InternalFindClosest(value, toRing, safeMode);
     }
 
@@ -252,7 +309,8 @@ namespace Federation
     {
         if (site_.IsRingNameMatched(toRing))
         {
-            return InternalFindClosest(value, ring_);
+            // snapshot_ is only replaced under the write lock
+            return InternalFindClosest(value, snapshot_->Ring, snapshot_.get());
         }
         else
         {
@@ -268,21 +326,37 @@ namespace Federation
                     }
                 }
 
-                return InternalFindClosest(value, it->second);
+                return InternalFindClosest(value, it->second, nullptr);
             }
 
             return knownTable_.ThisNodePtr;
         }
     }
 
-    PartnerNodeSPtr const& RoutingTable::InternalFindClosest(NodeId const& value, NodeRingBase const & ring) const
+    PartnerNodeSPtr const& RoutingTable::InternalFindClosest(NodeId const& value, NodeRingBase const & ring, RoutingTableSnapshot const * local) const
     {
         if (ring.Size == 0)
         {
+            // only external rings can be empty, the local ring always contains this node
             return knownTable_.ThisNodePtr;
         }
 
-        bool isLocal = (&ring == &ring_);
+        bool isLocal = (local != nullptr);
+        if (isLocal)
+        {
+            // On large rings avoid walking long runs of unknown or shutdown nodes.
+            // The full walk below remains the fallback when no better hop is found.
+            size_t walkLimit = static_cast<size_t>(FederationConfig::GetConfig().FingerTableWalkLimit);
+            if (walkLimit > 0 && ring.Size > walkLimit * 2)
+            {
+                PartnerNodeSPtr const & result = InternalFindClosestWithFingers(value, *local, walkLimit);
+                if (result)
+                {
+                    return result;
+                }
+            }
+        }
+
         size_t succOrSame = ring.FindSuccOrSamePosition(value);
         size_t pred = ring.GetPred(succOrSame);
 
@@ -306,7 +380,7 @@ namespace Federation
                     foundSuccRouting = true;
                 }
 
-                if (!currentNode->IsUnknown || (isLocal && site_.IsAvailable && knownTable_.WithinHoodRange(currentNode->Id)))
+                if (IsRoutingHopCandidate(currentNode, local))
                 {
                     found = true;
                     break;
@@ -338,7 +412,7 @@ namespace Federation
                     foundPredRouting = true;
                 }
 
-                if (!currentNode->IsUnknown || (isLocal && site_.IsAvailable && knownTable_.WithinHoodRange(currentNode->Id)))
+                if (IsRoutingHopCandidate(currentNode, local))
                 {
                     break;
                 }
@@ -361,14 +435,14 @@ namespace Federation
             // but will check whether it is better than the saved unknown nodes
             if (value.PredDist(predNode->Id) <= value.SuccDist(succOrSameNode->Id))
             {
-                if (!isLocal || pred != ring_.ThisNode)
+                if (!isLocal || pred != local->ThisNode)
                 {
                     return predNode;
                 }
             }
             else
             {
-                if (!isLocal || succOrSame != ring_.ThisNode)
+                if (!isLocal || succOrSame != local->ThisNode)
                 {
                     return succOrSameNode;
                 }
@@ -384,16 +458,129 @@ namespace Federation
             savedPredNode : savedSuccOrSameNode;
     }
 
-    PartnerNodeSPtr RoutingTable::Get(NodeInstance const & value) const
+    bool RoutingTable::IsRoutingHopCandidate(PartnerNodeSPtr const & node, RoutingTableSnapshot const * local) const
+    {
+        return (!node->IsUnknown || (local && site_.IsAvailable && local->HoodRange.Contains(node->Id)));
+    }
+
+    PartnerNodeSPtr const& RoutingTable::InternalFindClosestWithFingers(NodeId const& value, RoutingTableSnapshot const & local, size_t walkLimit) const
+    {
+        NodeRingBase const & ring = local.Ring;
+
+        // Same selection as the full walk, but each side is only walked walkLimit
+        // entries. A side that does not find a hop within the limit is replaced by
+        // the closest finger, which is at most half the remaining distance away.
+        size_t succOrSame = ring.FindSuccOrSamePosition(value);
+        size_t pred = ring.GetPred(succOrSame);
+
+        PartnerNodeSPtr const * succNode = nullptr;
+        for (size_t i = 0; i < walkLimit; i++)
+        {
+            PartnerNodeSPtr const & currentNode = ring.GetNode(succOrSame);
+            if (currentNode->IsRouting && IsRoutingHopCandidate(currentNode, &local))
+            {
+                succNode = &currentNode;
+                break;
+            }
+
+            succOrSame = ring.GetSucc(succOrSame);
+        }
+
+        PartnerNodeSPtr const * predNode = nullptr;
+        for (size_t i = 0; i < walkLimit; i++)
+        {
+            PartnerNodeSPtr const & currentNode = ring.GetNode(pred);
+            if (currentNode->IsRouting && IsRoutingHopCandidate(currentNode, &local))
+            {
+                predNode = &currentNode;
+                break;
+            }
+
+            pred = ring.GetPred(pred);
+        }
+
+        PartnerNodeSPtr const * result;
+        if (succNode && predNode)
+        {
+            result = (value.PredDist((*predNode)->Id) <= value.SuccDist((*succNode)->Id) ? predNode : succNode);
+        }
+        else
+        {
+            result = (succNode ? succNode : predNode);
+
+            PartnerNodeSPtr const & finger = FingerTable::FindClosest(local.Fingers, value);
+            if (finger && ring.GetNode(ring.FindSuccOrSamePosition(finger->Id)) == finger)
+            {
+                LargeInteger fingerDist = min(value.PredDist(finger->Id), value.SuccDist(finger->Id));
+                if (!result || fingerDist < min(value.PredDist((*result)->Id), value.SuccDist((*result)->Id)))
+                {
+                    result = &finger;
+                }
+            }
+
+            // Only take the hop if it makes progress; otherwise let the full walk decide.
+            LargeInteger thisDist = min(value.PredDist(site_.Id), value.SuccDist(site_.Id));
+            if (result && min(value.PredDist((*result)->Id), value.SuccDist((*result)->Id)) >= thisDist)
+            {
+                result = nullptr;
+            }
+        }
+
+        // "this" node and the unknown fallback are resolved by the full walk
+        if (!result || *result == local.ThisNodePtr)
+        {
+            return NullNode;
+        }
+
+        return *result;
+    }
+
+    void RoutingTable::RefreshFingers()
+    {
+        size_t walkLimit = static_cast<size_t>(FederationConfig::GetConfig().FingerTableWalkLimit);
+        if (site_.IsRouting && walkLimit > 0 && ring_.Size > walkLimit * 2)
+        {
+            fingerTable_.Refresh(ring_, walkLimit);
+        }
+        else if (fingerTable_.Size > 0)
+        {
+            fingerTable_.Clear();
+        }
+    }
+
+    void RoutingTable::UpdateFinger(NodeId target, NodeInstance const & owner)
+    {
+        WriteLock grab(*this);
+
+        PartnerNodeSPtr const & node = GetInternal(owner);
+        if (node && node->IsRouting)
+        {
+            fingerTable_.Update(target, node);
+        }
+    }
+
+    size_t RoutingTable::GetFingerCount() const
     {
         AcquireReadLock grab(lock_);
-        return GetInternal(value);
+        return fingerTable_.Size;
+    }
+
+    void RoutingTable::Test_RefreshFingers()
+    {
+        WriteLock grab(*this);
+        RefreshFingers();
+    }
+
+    PartnerNodeSPtr RoutingTable::Get(NodeInstance const & value) const
+    {
+        RoutingTableSnapshotSPtr snapshot = GetSnapshot();
+        PartnerNodeSPtr const & result = snapshot->Get(value.Id);
+        return (result && result->Instance.InstanceId == value.InstanceId ? result : nullptr);
     }
 
     PartnerNodeSPtr RoutingTable::Get(NodeInstance const & value, string const & ringName) const
     {
-        AcquireReadLock grab(lock_);
-        PartnerNodeSPtr result = GetInternal(value.Id, ringName);
+        PartnerNodeSPtr result = Get(value.Id, ringName);
         return (result && result->Instance.InstanceId == value.InstanceId ? result : nullptr);
     }
 
@@ -405,12 +592,16 @@ namespace Federation
 
     PartnerNodeSPtr RoutingTable::Get(NodeId value) const
     {
-        AcquireReadLock grab(lock_);
-        return GetInternal(value, &knownTable_);
+        return GetSnapshot()->Get(value);
     }
 
     PartnerNodeSPtr RoutingTable::Get(NodeId value, string const & ringName) const
     {
+        if (ringName.empty() || ringName == site_.RingName)
+        {
+            return GetSnapshot()->Get(value);
+        }
+
         AcquireReadLock grab(lock_);
         return GetInternal(value, ringName);
     }
@@ -765,16 +956,12 @@ namespace Federation
 
     NodeIdRange RoutingTable::GetHood(vector<PartnerNodeSPtr>& vecNode) const
     {
-        AcquireReadLock grab(lock_);
-
-        return knownTable_.GetHood(vecNode);
+        return GetSnapshot()->GetHood(vecNode);
     }
 
     NodeIdRange RoutingTable::GetHoodRange() const
     {
-        AcquireReadLock grab(lock_);
-
-        return knownTable_.GetRange();
+        return GetSnapshot()->HoodRange;
     }
 
     NodeIdRange RoutingTable::GetCombinedNeighborHoodTokenRange() const
@@ -1757,6 +1944,7 @@ namespace Federation
     {
         WriteLock grab(*this);
         CheckHealth();
+        RefreshFingers();
 
         StopwatchTime now = Stopwatch::Now();
         FederationConfig const & config = FederationConfig::GetConfig();
@@ -57,6 +57,12 @@ namespace Federation
 
         PartnerNodeSPtr GetRoutingHop(NodeId const& value, std::string const & ringName, bool safeMode, bool& ownsToken) const;
 
+        /// <summary>
+        /// Get the current immutable snapshot of the local ring, neighborhood and token.
+        /// Lookups on the local ring use the snapshot without taking the routing table lock.
+        /// </summary>
+        RoutingTableSnapshotSPtr GetSnapshot() const;
+
         /// <summary>
         /// Get the PartnerNode with the id in the input.
         /// </summary>
@@ -150,6 +156,28 @@ namespace Federation
 
         bool IsDown(NodeInstance const & nodeInstance) const;
 
+        /// <summary>
+        /// Record the owner of an exponential target as reported by the update protocol
+        /// </summary>
+        /// <param name="target">The exponential target the update request was routed to</param>
+        /// <param name="owner">The node that replied for the target</param>
+        void UpdateFinger(NodeId target, NodeInstance const & owner);
+
+        /// <summary>
+        /// Get the number of distinct nodes in the finger table
+        /// </summary>
+        size_t GetFingerCount() const;
+
+        /// <summary>
+        /// Recompute the finger table immediately instead of on the next timer
+        /// </summary>
+        void Test_RefreshFingers();
+
+        /// <summary>
+        /// Publish a new snapshot after test code changed state outside of the routing table lock
+        /// </summary>
+        void Test_PublishSnapshot();
+
         /// <summary>
         /// This is used for test only now to remove nodes outside of neighborhood range
         /// </summary>
@@ -382,6 +410,18 @@ namespace Federation
         /// </summary>
         NodeRingWithHood knownTable_;
 
+        /// <summary>
+        /// Exponentially spaced routing partners used to find a routing hop
+        /// without walking the whole ring
+        /// </summary>
+        FingerTable fingerTable_;
+
+        /// <summary>
+        /// The last published snapshot, replaced atomically whenever the ring,
+        /// neighborhood, token or fingers change under the write lock
+        /// </summary>
+        RoutingTableSnapshotSPtr snapshot_;
+
         std::map<std::string, ExternalRing> externalRings_;
 
         /// <summary>
@@ -432,7 +472,11 @@ namespace Federation
         ImplicitLeaseContext implicitLeaseContext_;
 
         PartnerNodeSPtr const& InternalFindClosest(NodeId const& value, std::string const & toRing, bool safeMode) const;
-        PartnerNodeSPtr const& InternalFindClosest(NodeId const& value, NodeRingBase const & ring) const;
+        PartnerNodeSPtr const& InternalFindClosest(NodeId const& value, NodeRingBase const & ring, RoutingTableSnapshot const * local) const;
+        PartnerNodeSPtr const& InternalFindClosestWithFingers(NodeId const& value, RoutingTableSnapshot const & local, size_t walkLimit) const;
+        bool IsRoutingHopCandidate(PartnerNodeSPtr const & node, RoutingTableSnapshot const * local) const;
+        void RefreshFingers();
+        void PublishSnapshot();
 
         PartnerNodeSPtr const& InternalConsider(FederationPartnerNodeHeader const & nodeInfo, bool isInserting = false, int64 now = 0);
         PartnerNodeSPtr const& InternalConsiderExternalNode(FederationPartnerNodeHeader const & nodeInfo);
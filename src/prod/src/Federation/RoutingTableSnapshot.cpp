@@ -0,0 +1,46 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+using namespace std;
+using namespace Common;
+using namespace Federation;
+
+PartnerNodeSPtr const RoutingTableSnapshot::NullNode;
+
+RoutingTableSnapshot::RoutingTableSnapshot(
+    NodeRing const & ring,
+    NodeRingWithHood const & knownTable,
+    FingerTable const & fingerTable,
+    RoutingToken const & token)
+    : thisNode_(ring.ThisNode),
+    token_(token),
+    fingers_(fingerTable.Fingers)
+{
+    ring_.CopyFrom(ring);
+    knownNodes_.CopyFrom(knownTable);
+    hoodRange_ = knownTable.GetHood(hood_);
+}
+
+PartnerNodeSPtr const & RoutingTableSnapshot::Get(NodeId const & value) const
+{
+    if (knownNodes_.Size > 0)
+    {
+        PartnerNodeSPtr const & node = knownNodes_.GetNode(knownNodes_.FindSuccOrSamePosition(value));
+        if (node->Id == value)
+        {
+            return node;
+        }
+    }
+
+    return NullNode;
+}
+
+NodeIdRange RoutingTableSnapshot::GetHood(vector<PartnerNodeSPtr> & vecNode) const
+{
+    vecNode.insert(vecNode.end(), hood_.begin(), hood_.end());
+    return hoodRange_;
+}
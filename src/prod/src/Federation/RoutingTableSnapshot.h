@@ -0,0 +1,78 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Federation
+{
+    /// <summary>
+    /// An immutable copy of the local ring, neighborhood, token and fingers of the
+    /// routing table. The routing table publishes a new snapshot whenever one of
+    /// them changes, so that route lookups can use the current snapshot without
+    /// taking the routing table lock.
+    /// </summary>
+    /// <remarks>
+    /// The snapshot shares the PartnerNode objects with the routing table. Their
+    /// state (phase, unknown) is read live, as it already is by the readers that
+    /// hold the routing table read lock while SetUnknown updates it.
+    /// </remarks>
+    class RoutingTableSnapshot
+    {
+        DENY_COPY(RoutingTableSnapshot);
+
+    public:
+        RoutingTableSnapshot(
+            NodeRing const & ring,
+            NodeRingWithHood const & knownTable,
+            FingerTable const & fingerTable,
+            RoutingToken const & token);
+
+        /// <summary>
+        /// The routing nodes, including this node.
+        /// </summary>
+        __declspec (property(get=getRing)) NodeRingBase const & Ring;
+        NodeRingBase const & getRing() const { return ring_; }
+
+        /// <summary>
+        /// The position of this node in Ring.
+        /// </summary>
+        __declspec (property(get=getThisNode)) size_t ThisNode;
+        size_t getThisNode() const { return thisNode_; }
+
+        __declspec (property(get=getThisNodePtr)) PartnerNodeSPtr const & ThisNodePtr;
+        PartnerNodeSPtr const & getThisNodePtr() const { return ring_.GetNode(thisNode_); }
+
+        __declspec (property(get=getToken)) RoutingToken const & Token;
+        RoutingToken const & getToken() const { return token_; }
+
+        __declspec (property(get=getHoodRange)) NodeIdRange const & HoodRange;
+        NodeIdRange const & getHoodRange() const { return hoodRange_; }
+
+        __declspec (property(get=getFingers)) std::vector<PartnerNodeSPtr> const & Fingers;
+        std::vector<PartnerNodeSPtr> const & getFingers() const { return fingers_; }
+
+        /// <summary>
+        /// Get the known node with the specified id.
+        /// </summary>
+        /// <returns>The node if it exists, else a null pointer.</returns>
+        PartnerNodeSPtr const & Get(NodeId const & value) const;
+
+        /// <summary>
+        /// Get the neighborhood of this node and its range.
+        /// </summary>
+        NodeIdRange GetHood(std::vector<PartnerNodeSPtr> & vecNode) const;
+
+    private:
+        NodeRingBase ring_;
+        size_t thisNode_;
+        NodeRingBase knownNodes_;
+        std::vector<PartnerNodeSPtr> hood_;
+        NodeIdRange hoodRange_;
+        RoutingToken token_;
+        std::vector<PartnerNodeSPtr> fingers_;
+
+        static PartnerNodeSPtr const NullNode;
+    };
+}
@@ -266,6 +266,7 @@ SiteNode::SiteNode(
     REGISTER_MESSAGE_HEADER(GlobalTimeExchangeHeader);
     REGISTER_MESSAGE_HEADER(VoterStoreHeader);
     REGISTER_MESSAGE_HEADER(JoinThrottleHeader);
+    REGISTER_MESSAGE_HEADER(FederationPingHeader);
 
     WriteInfo(TraceState, IdString, "SiteNode constructor called for {0}", Instance);
 
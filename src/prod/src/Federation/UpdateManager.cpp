@@ -78,7 +78,7 @@ void UpdateManager::Stop()
 }
 
 _Use_decl_annotations_
-void UpdateManager::ProcessUpdateReply(Message & message)
+void UpdateManager::ProcessUpdateReply(Message & message, NodeId targetLocation)
 {
     auto body = message.GetBodyStream();
     UpdateReplyBody updateReply;
@@ -93,16 +93,21 @@ void UpdateManager::ProcessUpdateReply(Message & message)
 
     ProcessIncomingRange(updateReply.UpdateRange);
 
+    NodeInstance from;
+    bool hasFrom = PointToPointManager::GetFromInstance(message, from);
+
+    // the owner of an exponential target is the finger for that target
+    if (hasFrom && updateReply.IsFromExponentialTarget)
+    {
+        siteNode_.Table.UpdateFinger(targetLocation, from);
+    }
+
     SerializableWithActivationList globalStates;
     status = body->ReadSerializable(&globalStates);
-    if (NT_SUCCESS(status))
+    if (NT_SUCCESS(status) && hasFrom)
     {
-        NodeInstance from;
-        if (PointToPointManager::GetFromInstance(message, from))
-        {
-            siteNode_.Table.ProcessGlobalTimeExchangeHeader(message, from);
-            siteNode_.GetGlobalStore().ProcessInputState(globalStates, from);
-        }
+        siteNode_.Table.ProcessGlobalTimeExchangeHeader(message, from);
+        siteNode_.GetGlobalStore().ProcessInputState(globalStates, from);
     }
 }
 
@@ -287,7 +292,7 @@ void UpdateManager::RouteCallback(AsyncOperationSPtr const & contextSPtr, NodeId
     }
     else if (siteNode_.IsAvailable)
     {
-        ProcessUpdateReply(*reply);
+        ProcessUpdateReply(*reply, targetLocation);
     }
 }
 
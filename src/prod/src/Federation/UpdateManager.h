@@ -33,7 +33,7 @@ namespace Federation
         };
 
         void TimerCallback();
-        void ProcessUpdateReply(_In_ Transport::Message & message);
+        void ProcessUpdateReply(_In_ Transport::Message & message, NodeId targetLocation);
 
         void RouteCallback(Common::AsyncOperationSPtr const & contextSPtr, NodeId targetLocation);
         void RouteUpdateRequest(Transport::MessageUPtr && updateRequestMessage, NodeId targetLocation);
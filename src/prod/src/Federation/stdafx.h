@@ -56,11 +56,14 @@
 #include "Federation/FabricCodeVersionHeader.h"
 #include "Federation/FederationPartnerNodeHeader.h"
 #include "Federation/JoinThrottleHeader.h"
+#include "Federation/FederationPingHeader.h"
 #include "Federation/FederationMessage.h"
 
 #include "Federation/Multicast.h"
 #include "Federation/SendMessageAction.h"
 #include "Federation/NodeRing.h"
+#include "Federation/FingerTable.h"
+#include "Federation/RoutingTableSnapshot.h"
 #include "Federation/RoutingTable.h"
 #include "Federation/JoinLock.h"
 #include "Federation/JoinLockManager.h"
@@ -69,6 +72,8 @@
 #include "Federation/RoutedRequestReceiverContext.h"
 #include "Federation/VoteManager.h"
 #include "Federation/JoinManager.h"
+#include "Federation/FederationPerfCounters.h"
+#include "Federation/PingSchedule.h"
 #include "Federation/PingManager.h"
 #include "Federation/PointToPointManager.h"
 #include "Federation/RoutingManager.h"
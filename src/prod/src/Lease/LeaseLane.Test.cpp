@@ -0,0 +1,213 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <boost/test/unit_test.hpp>
+#include "Common/boost-taef.h"
+
+namespace LeaseLaneTest
+{
+    using namespace std;
+    using namespace Common;
+
+    const StringLiteral TraceType("LeaseLaneTest");
+
+    class TestLeaseLane
+    {
+    protected:
+        // keeps every thread pool thread busy until Stop is called
+        class ThreadpoolSaturation
+        {
+            DENY_COPY(ThreadpoolSaturation);
+
+        public:
+            ThreadpoolSaturation(uint workItemCount) : state_(make_shared<State>(workItemCount))
+            {
+                // work items hold the state, so that items still queued when the wait in Stop
+                // gives up do not touch a destroyed object
+                auto state = state_;
+                for (uint i = 0; i < workItemCount; ++i)
+                {
+                    Threadpool::Post([state]
+                    {
+                        auto deadline = Stopwatch::Now() + TimeSpan::FromSeconds(60);
+                        while (!state->Stopped.load() && (Stopwatch::Now() < deadline))
+                        {
+                        }
+
+                        --state->Pending;
+                    });
+                }
+            }
+
+            ~ThreadpoolSaturation()
+            {
+                Stop();
+            }
+
+            void Stop()
+            {
+                state_->Stopped.store(true);
+                for (int i = 0; (state_->Pending.load() > 0) && (i < 600); ++i)
+                {
+                    ::Sleep(100);
+                }
+            }
+
+        private:
+            struct State
+            {
+                State(uint workItemCount) : Stopped(false), Pending(workItemCount)
+                {
+                }
+
+                Common::atomic_bool Stopped;
+                Common::atomic_long Pending; // posted work items that have not finished
+            };
+
+            shared_ptr<State> state_;
+        };
+
+        // shared by the timers started by RunPeriodicTimers and the test, so that timers
+        // still scheduled when the test gives up waiting do not touch destroyed locals
+        struct PeriodicTimers
+        {
+            DENY_COPY(PeriodicTimers);
+
+        public:
+            PeriodicTimers() : Done(false), Cancelled(false)
+            {
+            }
+
+            LatencyHistogram Lateness;
+            ManualResetEvent Done;
+            Common::atomic_bool Cancelled;
+        };
+
+        typedef shared_ptr<PeriodicTimers> PeriodicTimersSPtr;
+
+        // fires count timers one after another with the given interval, and records
+        // how late every timer fires relative to when it was supposed to fire
+        PeriodicTimersSPtr RunPeriodicTimers(
+            function<void(TimeSpan, function<void()> const &)> const & schedule,
+            int count,
+            TimeSpan interval);
+    };
+
+    TestLeaseLane::PeriodicTimersSPtr TestLeaseLane::RunPeriodicTimers(
+        function<void(TimeSpan, function<void()> const &)> const & schedule,
+        int count,
+        TimeSpan interval)
+    {
+        auto timers = make_shared<PeriodicTimers>();
+        auto remaining = make_shared<int>(count);
+        auto dueTime = make_shared<StopwatchTime>(Stopwatch::Now() + interval);
+        auto callback = make_shared<function<void()>>();
+
+        // only the scheduled timer holds the callback, it captures itself weakly to reschedule,
+        // so the callback is released after the last timer fires instead of keeping itself alive
+        weak_ptr<function<void()>> weakCallback = callback;
+        *callback = [=]
+        {
+            if (timers->Cancelled.load())
+            {
+                return;
+            }
+
+            auto now = Stopwatch::Now();
+            timers->Lateness.Add(now - *dueTime);
+
+            if (--(*remaining) == 0)
+            {
+                timers->Done.Set();
+                return;
+            }
+
+            auto thisCallback = weakCallback.lock();
+            if (!thisCallback)
+            {
+                return;
+            }
+
+            *dueTime = now + interval;
+            schedule(interval, [thisCallback] { (*thisCallback)(); });
+        };
+
+        schedule(interval, [callback] { (*callback)(); });
+        return timers;
+    }
+
+    BOOST_FIXTURE_TEST_SUITE(TestLeaseLaneSuite, TestLeaseLane)
+
+    BOOST_AUTO_TEST_CASE(LeaseTimerLatenessWithSaturatedThreadpool)
+    {
+        const int timerCount = 300;
+        const TimeSpan interval = TimeSpan::FromMilliseconds(10);
+
+        ThreadpoolSaturation saturation(Environment::GetNumberOfProcessors() * 8);
+
+        // lease timers are fired on the dedicated lease timer thread
+        auto leaseTimers = RunPeriodicTimers(
+            [](TimeSpan dueTime, function<void()> const & callback) { GetLeaseTimerQueue().Enqueue("LeaseLaneTest", callback, dueTime); },
+            timerCount,
+            interval);
+
+        // the same timers dispatched through the thread pool for comparison
+        auto threadpoolTimers = RunPeriodicTimers(
+            [](TimeSpan dueTime, function<void()> const & callback) { Threadpool::Post(callback, dueTime); },
+            timerCount,
+            interval);
+
+        bool leaseTimersDone = leaseTimers->Done.WaitOne(TimeSpan::FromSeconds(60));
+
+        saturation.Stop();
+        bool threadpoolTimersDone = threadpoolTimers->Done.WaitOne(TimeSpan::FromSeconds(60));
+
+        leaseTimers->Cancelled.store(true);
+        threadpoolTimers->Cancelled.store(true);
+        VERIFY_IS_TRUE(leaseTimersDone);
+        VERIFY_IS_TRUE(threadpoolTimersDone);
+
+        Trace.WriteInfo(TraceType, "lease timer lateness: {0}", leaseTimers->Lateness);
+        Trace.WriteInfo(TraceType, "thread pool timer lateness: {0}", threadpoolTimers->Lateness);
+        Trace.WriteInfo(TraceType, "lease timer queue lateness: {0}", GetLeaseTimerQueue().Lateness());
+
+        VERIFY_IS_TRUE(leaseTimers->Lateness.Count() == static_cast<uint64>(timerCount));
+
+        // absolute lateness depends on the load of the test machine, only compare the lease lane with
+        // the thread pool, which was saturated while both ran
+        VERIFY_IS_TRUE(leaseTimers->Lateness.Percentile(99) <= threadpoolTimers->Lateness.Percentile(99));
+    }
+
+    BOOST_AUTO_TEST_CASE(LatencyHistogramPercentiles)
+    {
+        LatencyHistogram histogram;
+        VERIFY_IS_TRUE(histogram.Percentile(99) == TimeSpan::Zero);
+
+        for (int i = 0; i < 99; ++i)
+        {
+            histogram.Add(TimeSpan::FromMilliseconds(1));
+        }
+
+        histogram.Add(TimeSpan::FromSeconds(1));
+
+        Trace.WriteInfo(TraceType, "histogram: {0}", histogram);
+
+        VERIFY_IS_TRUE(histogram.Count() == 100);
+        VERIFY_IS_TRUE(histogram.Max() == TimeSpan::FromSeconds(1));
+
+        // 1ms falls into the [512us, 1024us) bucket
+        VERIFY_IS_TRUE(histogram.Percentile(50) == TimeSpan::FromTicks(1024 * 10));
+        VERIFY_IS_TRUE(histogram.Percentile(99) == TimeSpan::FromTicks(1024 * 10));
+        VERIFY_IS_TRUE(histogram.Percentile(100) == TimeSpan::FromSeconds(1));
+
+        histogram.Reset();
+        VERIFY_IS_TRUE(histogram.Count() == 0);
+        VERIFY_IS_TRUE(histogram.Max() == TimeSpan::Zero);
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+}
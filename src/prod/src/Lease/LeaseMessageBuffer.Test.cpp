@@ -0,0 +1,148 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+#include <boost/test/unit_test.hpp>
+#include "Common/boost-taef.h"
+
+namespace LeaseMessageBufferTest
+{
+    using namespace std;
+    using namespace Common;
+
+    const StringLiteral TraceType("LeaseMessageBufferTest");
+
+    class TestLeaseMessageBuffer
+    {
+    protected:
+        // typical size of renew requests and responses with empty identifier lists
+        static const ULONG RequestSize = 420;
+        static const ULONG ResponseSize = 436;
+
+        // serializes a request and a response for every relationship per round, both are
+        // in flight at the same time before the transport releases them, returns elapsed time
+        static TimeSpan RunRenewRounds(
+            vector<shared_ptr<LeaseMessageBufferPool>> const & pools,
+            int roundCount,
+            bool pooled);
+    };
+
+    TimeSpan TestLeaseMessageBuffer::RunRenewRounds(
+        vector<shared_ptr<LeaseMessageBufferPool>> const & pools,
+        int roundCount,
+        bool pooled)
+    {
+        Stopwatch stopwatch;
+        stopwatch.Start();
+
+        for (int round = 0; round < roundCount; ++round)
+        {
+            for (auto const & pool : pools)
+            {
+                PVOID request = pooled ? pool->Allocate(RequestSize) : new BYTE[RequestSize];
+                PVOID response = pooled ? pool->Allocate(ResponseSize) : new BYTE[ResponseSize];
+                VERIFY_IS_TRUE((request != NULL) && (response != NULL));
+
+                RtlZeroMemory(request, RequestSize);
+                RtlZeroMemory(response, ResponseSize);
+
+                if (pooled)
+                {
+                    LeaseMessageBufferPool::Release(request);
+                    LeaseMessageBufferPool::Release(response);
+                }
+                else
+                {
+                    delete[] (PBYTE)request;
+                    delete[] (PBYTE)response;
+                }
+            }
+        }
+
+        stopwatch.Stop();
+        return stopwatch.Elapsed;
+    }
+
+    BOOST_FIXTURE_TEST_SUITE(TestLeaseMessageBufferSuite, TestLeaseMessageBuffer)
+
+    BOOST_AUTO_TEST_CASE(BufferReuse)
+    {
+        auto pool = make_shared<LeaseMessageBufferPool>();
+        auto allocated = LeaseMessageBufferPool::AllocationCount();
+        auto reused = LeaseMessageBufferPool::ReuseCount();
+
+        auto buffer = pool->Allocate(RequestSize);
+        VERIFY_IS_TRUE(buffer != NULL);
+        VERIFY_IS_TRUE(((ULONG_PTR)buffer % alignof(std::max_align_t)) == 0);
+        LeaseMessageBufferPool::Release(buffer);
+
+        // a slightly larger message fits in the same buffer
+        auto buffer2 = pool->Allocate(ResponseSize);
+        VERIFY_IS_TRUE(buffer2 == buffer);
+        VERIFY_IS_TRUE(LeaseMessageBufferPool::AllocationCount() == allocated + 1);
+        VERIFY_IS_TRUE(LeaseMessageBufferPool::ReuseCount() == reused + 1);
+
+        // a much larger message does not
+        auto large = pool->Allocate(64 * 1024);
+        VERIFY_IS_TRUE(large != NULL);
+        VERIFY_IS_TRUE(large != buffer2);
+        VERIFY_IS_TRUE(LeaseMessageBufferPool::AllocationCount() == allocated + 2);
+
+        LeaseMessageBufferPool::Release(large);
+        LeaseMessageBufferPool::Release(buffer2);
+    }
+
+    BOOST_AUTO_TEST_CASE(BufferOutlivesPool)
+    {
+        auto pool = make_shared<LeaseMessageBufferPool>();
+        auto buffer = pool->Allocate(RequestSize);
+        VERIFY_IS_TRUE(buffer != NULL);
+
+        // the remote lease agent goes away while its message is still being sent
+        weak_ptr<LeaseMessageBufferPool> poolWPtr = pool;
+        pool.reset();
+        VERIFY_IS_FALSE(poolWPtr.expired());
+
+        LeaseMessageBufferPool::Release(buffer);
+        VERIFY_IS_TRUE(poolWPtr.expired());
+    }
+
+    BOOST_AUTO_TEST_CASE(RenewBenchmark)
+    {
+        const int relationshipCount = 500;
+        const int roundCount = 200;
+
+        vector<shared_ptr<LeaseMessageBufferPool>> pools;
+        for (int i = 0; i < relationshipCount; ++i)
+        {
+            pools.push_back(make_shared<LeaseMessageBufferPool>());
+        }
+
+        auto unpooled = RunRenewRounds(pools, roundCount, false);
+
+        auto allocated = LeaseMessageBufferPool::AllocationCount();
+        auto reused = LeaseMessageBufferPool::ReuseCount();
+        auto pooled = RunRenewRounds(pools, roundCount, true);
+        allocated = LeaseMessageBufferPool::AllocationCount() - allocated;
+        reused = LeaseMessageBufferPool::ReuseCount() - reused;
+
+        Trace.WriteInfo(
+            TraceType,
+            "{0} relationships, {1} rounds: unpooled {2}, pooled {3}, buffers allocated {4}, reused {5}",
+            relationshipCount,
+            roundCount,
+            unpooled,
+            pooled,
+            allocated,
+            reused);
+
+        // only the first round allocates
+        VERIFY_IS_TRUE(allocated == static_cast<ULONGLONG>(relationshipCount * 2));
+        VERIFY_IS_TRUE(reused == static_cast<ULONGLONG>(relationshipCount * 2 * (roundCount - 1)));
+    }
+
+    BOOST_AUTO_TEST_SUITE_END()
+}
@@ -1320,6 +1320,10 @@ typedef struct _LEASE_RELATIONSHIP_CONTEXT {
     KTIMER SubjectTimer;
     KDPC SubjectTimerDpc;
     BOOL LeaseMessageSent;
+    //
+    // When the last renew request was sent, zero once a response is received.
+    //
+    Common::StopwatchTime RenewRequestSentTime;
 
     //
     // Monitor information.
@@ -1465,6 +1469,62 @@ typedef struct _LEASE_RELATIONSHIP_IDENTIFIER {
     ULONG RemoteLeasingApplicationIdentifierByteCount;
 
 } LEASE_RELATIONSHIP_IDENTIFIER, *PLEASE_RELATIONSHIP_IDENTIFIER;
+//
+// Reusable buffers for the lease messages sent to one remote lease agent.
+// Messages to the same remote lease agent have nearly the same size every
+// time, so steady state renewals are serialized into a buffer released by
+// an earlier message instead of a new allocation. Buffers in flight keep
+// their pool alive.
+//
+class LeaseMessageBufferPool : public std::enable_shared_from_this<LeaseMessageBufferPool>
+{
+    DENY_COPY(LeaseMessageBufferPool);
+
+public:
+    LeaseMessageBufferPool() = default;
+    ~LeaseMessageBufferPool();
+
+    //
+    // Returns a buffer of at least Size bytes, NULL if it cannot be allocated.
+    //
+    PVOID Allocate(__in ULONG Size);
+
+    //
+    // Returns a buffer from Allocate to its pool, or frees it when the pool is full.
+    //
+    static VOID Release(__in PVOID Buffer);
+
+    //
+    // Process wide counts of buffers allocated and of buffers reused.
+    //
+    static ULONGLONG AllocationCount();
+    static ULONGLONG ReuseCount();
+
+private:
+    struct BufferHeader
+    {
+        std::shared_ptr<LeaseMessageBufferPool> Pool;
+        ULONG Capacity;
+    };
+
+    //
+    // A renew request and a response are usually the only messages in flight.
+    //
+    static const size_t MaxFreeBufferCount = 2;
+    //
+    // Message data follows the header at this offset, which keeps its alignment.
+    //
+    static const size_t HeaderSize = (sizeof(BufferHeader) + alignof(std::max_align_t) - 1) & ~(alignof(std::max_align_t) - 1);
+
+    static BufferHeader* HeaderOf(__in PVOID Buffer);
+    static VOID Free(__in BufferHeader* Header);
+
+    BOOLEAN TryReturn(__in BufferHeader* Header);
+
+    Common::ExclusiveLock lock_;
+    std::vector<BufferHeader*> freeBuffers_;
+};
+
 //
 // Remote lease agent data structure. The lease layer will contain one of 
 // these structures for each remote machine it maintains a lease with.
@@ -1573,6 +1633,10 @@ typedef struct _REMOTE_LEASE_AGENT_CONTEXT {
     // Lease protocol version of the remote side
     //
     USHORT RemoteVersion;
+    //
+    // Buffers for lease messages sent to the remote side.
+    //
+    std::shared_ptr<LeaseMessageBufferPool> MessageBufferPool;
 
 } REMOTE_LEASE_AGENT_CONTEXT, *PREMOTE_LEASE_AGENT_CONTEXT;
 
@@ -1928,6 +1992,11 @@ SetRenewTimer(
     __in LONG RenewDuration
     );
 
+VOID
+RecordLeaseRenewRoundTrip(
+    __in PREMOTE_LEASE_AGENT_CONTEXT RemoteLeaseAgentContext
+    );
+
 //
 // Lease event buffer routines.
 //
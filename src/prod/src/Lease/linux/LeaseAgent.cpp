@@ -482,6 +482,8 @@ Return Value:
         goto Error;
     }
 
+    RemoteLeaseAgentContext->MessageBufferPool = std::make_shared<LeaseMessageBufferPool>();
+
     //
     // Construct lease socket context identifier.
     //
@@ -3050,6 +3052,11 @@ emptySet,
         //
         if (LEASE_STATE_ACTIVE == RemoteLeaseAgentContext->LeaseRelationshipContext->SubjectState)
         {
+            if (LEASE_RESPONSE == MessageType)
+            {
+                RecordLeaseRenewRoundTrip(RemoteLeaseAgentContext);
+            }
+
             if (RemoteLeaseAgentContext->LeaseRelationshipContext->IndirectLeaseCount != 0 && LEASE_RESPONSE == MessageType)
             {
                 // Received a direct RESPONSE, reset the indirect lease count
@@ -4691,11 +4698,7 @@ Routine Description:
     //
     // Allocate message buffer.
     //
-    RelayMsgBuf = ExAllocatePoolWithTag(
-        NonPagedPool,
-        RelayMsgSize,
-        LEASE_MESSAGE_TAG
-        );
+    RelayMsgBuf = RemoteLeaseAgentContext->MessageBufferPool->Allocate(RelayMsgSize);
 
     if (NULL == RelayMsgBuf)
     {
@@ -4808,7 +4811,7 @@ Error:
     //
     // Deallocate lease message. There was an error serializing the message.
     //
-    ExFreePool(RelayMsgBuf);
+    LeaseMessageBufferPool::Release(RelayMsgBuf);
     
     return Status;
 }
@@ -29,7 +29,13 @@ namespace
         // create a dedicated EventLoopPool for isolation, also, dispatch socket events
         // synchronously to avoid potential delay in thread pool, assuming the number
         // of socket events for lease transport is small and their processing is fast
-        eventLoopPool = new EventLoopPool("lease");
+        auto const & config = Federation::FederationConfig::GetConfig();
+        eventLoopPool = new EventLoopPool("lease", config.LeaseEventLoopThreadCount);
+        if (config.LeaseThreadRealtimePriority > 0)
+        {
+            eventLoopPool->SetSchedParam(SCHED_FIFO, config.LeaseThreadRealtimePriority);
+        }
+
         return TRUE;
     }
 
@@ -97,8 +103,15 @@ NTSTATUS TransportListen(PLEASE_TRANSPORT const & transport, __in TRANSPORT_MESS
             totalBytes += buffer.size();
         }
 
-        auto bufUPtr = std::make_unique<BYTE[]>(totalBytes);
-        auto buf = bufUPtr.get(); 
+        // messages are dispatched synchronously on lease event loop threads, so every loop
+        // thread reuses its own buffer, which is preallocated for common lease messages
+        static thread_local vector<BYTE> receiveBuffer(Federation::FederationConfig::GetConfig().LeaseReceiveBufferSize);
+        if (receiveBuffer.size() < totalBytes)
+        {
+            receiveBuffer.resize(totalBytes);
+        }
+
+        auto buf = receiveBuffer.data();
 
         auto ptr = buf;
         for(auto const & buffer : buffers)
@@ -227,7 +240,7 @@ NTSTATUS TransportSendBufferNotification(__in PTRANSPORT_SENDTARGET const & Targ
 {
     if (Target == nullptr)
     {
-        ExFreePool(Buffer);
+        LeaseMessageBufferPool::Release(Buffer);
         return STATUS_INVALID_PARAMETER;
     }
 
@@ -236,7 +249,7 @@ NTSTATUS TransportSendBufferNotification(__in PTRANSPORT_SENDTARGET const & Targ
     vector<const_buffer> bufferList(1, const_buffer(Buffer, Size));
     auto msg = make_unique<Message>(
         bufferList,
-        [] (std::vector<Common::const_buffer> const &, void * buffer) { ExFreePool(buffer); },
+        [] (std::vector<Common::const_buffer> const &, void * buffer) { LeaseMessageBufferPool::Release(buffer); },
         Buffer);
 
     auto error = Target->SendOneWay(move(msg), TimeSpan::MaxValue);
@@ -244,8 +257,10 @@ NTSTATUS TransportSendBufferNotification(__in PTRANSPORT_SENDTARGET const & Targ
     if (NT_SUCCESS(status))
     {
         //LINUXTODO consider support sending callback in IDatagramTransport
+        //the callback is queued to the lease timer thread instead of the thread pool,
+        //so that it is not delayed by other work when the thread pool is busy
         if (messageSendingCallback)
-        Threadpool::Post([=] { messageSendingCallback(sendingCallbackState, TRUE); });
+        GetLeaseTimerQueue().Enqueue("LeaseSending", [=] { messageSendingCallback(sendingCallbackState, TRUE); }, TimeSpan::Zero);
     }
 
     return status;
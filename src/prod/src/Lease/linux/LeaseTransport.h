@@ -44,6 +44,7 @@ NTSTATUS ListenEndpointToWString(
     __out_bcount(sizeInBytes) PCHAR string,
     USHORT sizeInBytes);
 
+// Buffer must come from LeaseMessageBufferPool::Allocate, it is released after sending
 NTSTATUS TransportSendBuffer(__in PTRANSPORT_SENDTARGET const & pTarget, __in PVOID Buffer, ULONG Size);
 NTSTATUS TransportSendBufferNotification(
     __in PTRANSPORT_SENDTARGET const & pTarget,
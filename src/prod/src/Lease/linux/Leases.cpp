@@ -4,6 +4,7 @@
 // ------------------------------------------------------------
 
 #include "stdafx.h"
+#include "Federation/FederationConfig.h"
 
 using namespace Common;
 
@@ -11,12 +12,27 @@ namespace
 {
     INIT_ONCE initOnce;
     Global<TimerQueue> singleton;
+    LatencyHistogram renewRoundTrip;
+    atomic_uint64 messageBufferAllocations(0);
+    atomic_uint64 messageBufferReuses(0);
+
+    //
+    // Buffer capacity is rounded up to this, so that messages varying slightly in size share buffers.
+    //
+    ULONG const MessageBufferGranularity = 256;
 
     BOOL CALLBACK InitOnceFunc(PINIT_ONCE, PVOID, PVOID *)
     {
         //Timer callback dispatch is made synchronous to avoid scheduling delays. This is fine
         //because lease timer callback never blocks and the number of lease timers is low.
         singleton = make_global<TimerQueue>(false);
+
+        auto priority = Federation::FederationConfig::GetConfig().LeaseThreadRealtimePriority;
+        if (priority > 0)
+        {
+            singleton->SetSchedParam(SCHED_FIFO, priority);
+        }
+
         return TRUE;
     }
 
@@ -30,6 +46,50 @@ TimerQueue & GetLeaseTimerQueue()
     return *singleton;
 }
 
+VOID
+RecordLeaseRenewRoundTrip(
+    __in PREMOTE_LEASE_AGENT_CONTEXT RemoteLeaseAgentContext
+    )
+
+/*++
+
+Routine Description:
+
+    Records the time from sending the last renew request to receiving
+    a lease response, the histograms are traced once in a while.
+
+Parameters Description:
+
+    RemoteLeaseAgentContext - remote lease agent the response came from.
+
+Return Value:
+
+    n/a
+
+--*/
+
+{
+    StopwatchTime SentTime = RemoteLeaseAgentContext->LeaseRelationshipContext->RenewRequestSentTime;
+    if (StopwatchTime::Zero == SentTime)
+    {
+        return;
+    }
+
+    RemoteLeaseAgentContext->LeaseRelationshipContext->RenewRequestSentTime = StopwatchTime::Zero;
+
+    renewRoundTrip.Add(Stopwatch::Now() - SentTime);
+    if ((renewRoundTrip.Count() % Federation::FederationConfig::GetConfig().LeaseLatencyTraceSampleCount) == 0)
+    {
+        LeaseTrace::TraceInfo(
+            "LeaseLatency",
+            "renew round trip: {0}; lease timer lateness: {1}; message buffers allocated: {2}, reused: {3}",
+            formatString.L("{0}", renewRoundTrip),
+            formatString.L("{0}", GetLeaseTimerQueue().Lateness()),
+            LeaseMessageBufferPool::AllocationCount(),
+            LeaseMessageBufferPool::ReuseCount());
+    }
+}
+
 BOOLEAN
 IsRemoteLeaseAgentFailed(
     __in PREMOTE_LEASE_AGENT_CONTEXT RemoteLeaseAgentContext
@@ -1737,6 +1797,8 @@ emptySet,
 
             AddRef(RemoteLeaseAgentContext);
 
+            RemoteLeaseAgentContext->LeaseRelationshipContext->RenewRequestSentTime = Stopwatch::Now();
+
             status = TransportSendBufferNotification(
                 RemoteLeaseAgentContext->PartnerTarget,
                 LeaseMessage,
@@ -2885,6 +2947,124 @@ SerializeMessageExtension(
 
 }
 
+LeaseMessageBufferPool::~LeaseMessageBufferPool()
+{
+    for (auto Header : freeBuffers_)
+    {
+        Free(Header);
+    }
+}
+
+PVOID
+LeaseMessageBufferPool::Allocate(
+    __in ULONG Size
+    )
+{
+    BufferHeader* Header = NULL;
+
+    {
+        AcquireExclusiveLock grab(lock_);
+
+        for (auto iter = freeBuffers_.begin(); iter != freeBuffers_.end(); ++iter)
+        {
+            if ((*iter)->Capacity >= Size)
+            {
+                Header = *iter;
+                freeBuffers_.erase(iter);
+                break;
+            }
+        }
+    }
+
+    if (NULL != Header)
+    {
+        ++messageBufferReuses;
+    }
+    else
+    {
+        if (Size > MAXULONG - MessageBufferGranularity)
+        {
+            return NULL;
+        }
+
+        ULONG Capacity = (Size + MessageBufferGranularity - 1) / MessageBufferGranularity * MessageBufferGranularity;
+        PBYTE Memory = new (std::nothrow) BYTE[HeaderSize + Capacity];
+        if (NULL == Memory)
+        {
+            return NULL;
+        }
+
+        Header = new (Memory) BufferHeader();
+        Header->Capacity = Capacity;
+        ++messageBufferAllocations;
+    }
+
+    Header->Pool = shared_from_this();
+    return (PBYTE)Header + HeaderSize;
+}
+
+VOID
+LeaseMessageBufferPool::Release(
+    __in PVOID Buffer
+    )
+{
+    BufferHeader* Header = HeaderOf(Buffer);
+
+    //
+    // The pool may go away with this reference, after taking the buffer back.
+    //
+    auto Pool = std::move(Header->Pool);
+    if (!Pool || !Pool->TryReturn(Header))
+    {
+        Free(Header);
+    }
+}
+
+ULONGLONG
+LeaseMessageBufferPool::AllocationCount()
+{
+    return messageBufferAllocations.load();
+}
+
+ULONGLONG
+LeaseMessageBufferPool::ReuseCount()
+{
+    return messageBufferReuses.load();
+}
+
+LeaseMessageBufferPool::BufferHeader*
+LeaseMessageBufferPool::HeaderOf(
+    __in PVOID Buffer
+    )
+{
+    return (BufferHeader*)((PBYTE)Buffer - HeaderSize);
+}
+
+VOID
+LeaseMessageBufferPool::Free(
+    __in BufferHeader* Header
+    )
+{
+    Header->~BufferHeader();
+    delete[] (PBYTE)Header;
+}
+
+BOOLEAN
+LeaseMessageBufferPool::TryReturn(
+    __in BufferHeader* Header
+    )
+{
+    AcquireExclusiveLock grab(lock_);
+
+    if (freeBuffers_.size() >= MaxFreeBufferCount)
+    {
+        return FALSE;
+    }
+
+    freeBuffers_.push_back(Header);
+    return TRUE;
+}
+
 NTSTATUS
 SerializeLeaseMessage(
     __in PREMOTE_LEASE_AGENT_CONTEXT RemoteLeaseAgentContext,
@@ -3101,13 +3281,10 @@ Return Value:
     }
 
     //
-    // Allocate message buffer.
+    // Take message buffer from the pool of the remote lease agent, it is
+    // returned to the pool once the message is sent.
     //
-    LeaseMessage = ExAllocatePoolWithTag(
-        NonPagedPool,
-        LeaseMessageSize,
-        LEASE_MESSAGE_TAG
-        );
+    LeaseMessage = RemoteLeaseAgentContext->MessageBufferPool->Allocate(LeaseMessageSize);
 
     if (NULL == LeaseMessage)
     {
@@ -3383,7 +3560,7 @@ Error:
     //
     // Deallocate lease message. There was an error serializing the message.
     //
-    ExFreePool(LeaseMessage);
+    LeaseMessageBufferPool::Release(LeaseMessage);
     
     return Status;
 }
@@ -0,0 +1,252 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+//
+// Samples the performance counter sets exported by running processes through
+// /dev/shm (see pal/src/perflib_shm.h). The target process is never called
+// into; every sample is a read of its mapped counter values.
+//
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+#include <string>
+#include <vector>
+
+#include "perflib_shm.h"
+
+using namespace std;
+
+const size_t MaxArgLen = 128;
+
+struct MappedCounterSet
+{
+    string Name;
+    PPERF_SHM_COUNTERSET_HEADER Header;
+    size_t Size;
+};
+
+void PrintHelp(char* exe)
+{
+    printf("usage: %s [-p <pid>] [-i <interval ms>] [-c <sample count>]\n", exe);
+    printf("example: %s -p 1234 -i 1000 -c 10\n", exe);
+    printf("\n");
+    printf("Each sample prints one line per counter:\n");
+    printf("  <timestamp ms> <pid> <counter set guid> <instance name> <counter id> <counter type> <value>\n");
+}
+
+bool IsProcessAlive(LONG pid)
+{
+    return (kill(pid, 0) == 0) || (errno == EPERM);
+}
+
+bool TryMapCounterSet(string const & name, MappedCounterSet & counterSet)
+{
+    string path = string(PERF_SHM_DIRECTORY) + "/" + name;
+
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+    {
+        return false;
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size < (off_t)sizeof(PERF_SHM_COUNTERSET_HEADER))
+    {
+        close(fd);
+        return false;
+    }
+
+    void * addr = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (addr == MAP_FAILED)
+    {
+        return false;
+    }
+
+    auto header = static_cast<PPERF_SHM_COUNTERSET_HEADER>(addr);
+
+    if (header->Magic != PERF_SHM_MAGIC ||
+        header->Version != PERF_SHM_VERSION ||
+        __atomic_load_n(&header->State, __ATOMIC_ACQUIRE) != PERF_SHM_STATE_ACTIVE ||
+        header->TotalSize > (ULONG)st.st_size ||
+        header->ValuesOffset + header->NumCounters * sizeof(LONGLONG) > header->TotalSize ||
+        !IsProcessAlive(header->ProcessId))
+    {
+        munmap(addr, st.st_size);
+        return false;
+    }
+
+    counterSet.Name = name;
+    counterSet.Header = header;
+    counterSet.Size = st.st_size;
+    return true;
+}
+
+vector<MappedCounterSet> MapCounterSets(LONG pid)
+{
+    vector<MappedCounterSet> result;
+
+    string prefix = PERF_SHM_NAME_PREFIX;
+    if (pid > 0)
+    {
+        prefix += to_string(pid) + ".";
+    }
+
+    DIR * dir = opendir(PERF_SHM_DIRECTORY);
+    if (dir == NULL)
+    {
+        return result;
+    }
+
+    struct dirent * entry;
+    while ((entry = readdir(dir)) != NULL)
+    {
+        if (strncmp(entry->d_name, prefix.c_str(), prefix.size()) != 0)
+        {
+            continue;
+        }
+
+        MappedCounterSet counterSet;
+        if (TryMapCounterSet(entry->d_name, counterSet))
+        {
+            result.push_back(counterSet);
+        }
+    }
+
+    closedir(dir);
+    return result;
+}
+
+void UnmapCounterSets(vector<MappedCounterSet> & counterSets)
+{
+    for (auto const & counterSet : counterSets)
+    {
+        munmap(counterSet.Header, counterSet.Size);
+    }
+
+    counterSets.clear();
+}
+
+void PrintCounterSet(ULONGLONG timestamp, PPERF_SHM_COUNTERSET_HEADER header)
+{
+    // the owning process may have deleted the instance since the last sample
+    if (__atomic_load_n(&header->State, __ATOMIC_ACQUIRE) != PERF_SHM_STATE_ACTIVE)
+    {
+        return;
+    }
+
+    auto base = reinterpret_cast<BYTE const *>(header);
+    auto counters = reinterpret_cast<PERF_SHM_COUNTER const *>(base + header->CounterInfoOffset);
+    auto values = reinterpret_cast<LONGLONG const *>(base + header->ValuesOffset);
+
+    GUID const & g = header->Instance.CounterSetGuid;
+
+    char instanceName[PERF_SHM_MAX_INSTANCE_NAME];
+    memcpy(instanceName, header->InstanceName, sizeof(instanceName));
+    instanceName[sizeof(instanceName) - 1] = '\0';
+
+    for (ULONG i = 0; i < header->NumCounters; ++i)
+    {
+        if ((counters[i].Flags & PERF_SHM_COUNTER_FLAG_EXTERNAL) != 0)
+        {
+            continue;
+        }
+
+        LONGLONG value = __atomic_load_n(&values[i], __ATOMIC_RELAXED);
+
+        // sharded counters are aggregated here, at sampling time
+        if ((counters[i].Flags & PERF_SHM_COUNTER_FLAG_SHARDED) != 0 &&
+            counters[i].ShardOffset + counters[i].ShardCount * PERF_SHM_VALUE_ALIGNMENT <= header->TotalSize)
+        {
+            for (ULONG shard = 0; shard < counters[i].ShardCount; ++shard)
+            {
+                auto cell = reinterpret_cast<LONGLONG const *>(base + counters[i].ShardOffset + shard * PERF_SHM_VALUE_ALIGNMENT);
+                value += __atomic_load_n(cell, __ATOMIC_RELAXED);
+            }
+        }
+
+        printf(
+            "%llu %d %08x-%04hx-%04hx-%02hhx%02hhx-%02hhx%02hhx%02hhx%02hhx%02hhx%02hhx \"%s\" %u %u %lld\n",
+            timestamp,
+            header->ProcessId,
+            g.Data1, g.Data2, g.Data3,
+            g.Data4[0], g.Data4[1], g.Data4[2], g.Data4[3], g.Data4[4], g.Data4[5], g.Data4[6], g.Data4[7],
+            instanceName,
+            counters[i].CounterId,
+            counters[i].Type,
+            value);
+    }
+}
+
+ULONGLONG GetTimestampMilliseconds()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return static_cast<ULONGLONG>(ts.tv_sec) * 1000 + ts.tv_nsec / 1000000;
+}
+
+int main(int argc, char* argv[])
+{
+    LONG pid = 0;
+    unsigned int intervalMs = 1000;
+    unsigned int sampleCount = 1;
+
+    for (auto ix=0; ix<argc; ++ix)
+    {
+        if (ix+1 < argc)
+        {
+            if (strncmp(argv[ix], "-p", MaxArgLen) == 0)
+            {
+                pid = atoi(argv[++ix]);
+            }
+            else if (strncmp(argv[ix], "-i", MaxArgLen) == 0)
+            {
+                intervalMs = atoi(argv[++ix]);
+            }
+            else if (strncmp(argv[ix], "-c", MaxArgLen) == 0)
+            {
+                sampleCount = atoi(argv[++ix]);
+            }
+        }
+
+        if (strncmp(argv[ix], "-?", MaxArgLen) == 0)
+        {
+            PrintHelp(argv[0]);
+            exit(1);
+        }
+    }
+
+    for (unsigned int sample = 0; sampleCount == 0 || sample < sampleCount; ++sample)
+    {
+        if (sample > 0)
+        {
+            usleep(intervalMs * 1000);
+        }
+
+        // remap on every sample to pick up instances created or deleted in between
+        auto counterSets = MapCounterSets(pid);
+        auto timestamp = GetTimestampMilliseconds();
+
+        for (auto const & counterSet : counterSets)
+        {
+            PrintCounterSet(timestamp, counterSet.Header);
+        }
+
+        fflush(stdout);
+        UnmapCounterSets(counterSets);
+    }
+
+    return 0;
+}
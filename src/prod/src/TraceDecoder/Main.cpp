@@ -0,0 +1,104 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include <stdio.h>
+
+#include "Common/Common.h"
+
+using namespace std;
+using namespace Common;
+
+const size_t MaxArgLen = 128;
+
+void PrintHelp(char* exe)
+{
+    printf("usage: %s [-s] <file.btrace> [<file.btrace> ...]\n", exe);
+    printf("  decodes trace files written with Trace/File Format=Binary into text trace lines\n");
+    printf("  -s: sort the events of all files by time, they are otherwise written in file order\n");
+}
+
+int main(int argc, char* argv[])
+{
+    bool sort = false;
+    vector<string> files;
+
+    for (auto ix = 1; ix < argc; ++ix)
+    {
+        if (strncmp(argv[ix], "-s", MaxArgLen) == 0)
+        {
+            sort = true;
+        }
+        else if (strncmp(argv[ix], "-?", MaxArgLen) == 0)
+        {
+            PrintHelp(argv[0]);
+            return 0;
+        }
+        else
+        {
+            files.push_back(argv[ix]);
+        }
+    }
+
+    if (files.empty())
+    {
+        PrintHelp(argv[0]);
+        return 1;
+    }
+
+    vector<TraceBinaryFileReader::TraceRecord> records;
+    int result = 0;
+
+    for (auto const & file : files)
+    {
+        TraceBinaryFileReader reader;
+        auto error = reader.Open(file);
+        if (!error.IsSuccess())
+        {
+            fprintf(stderr, "Failed to open '%s': %s\n", file.c_str(), formatString.L("{0}", error).c_str());
+            result = 1;
+            continue;
+        }
+
+        TraceBinaryFileReader::TraceRecord record;
+        while (reader.TryReadNext(record))
+        {
+            if (sort)
+            {
+                records.push_back(move(record));
+            }
+            else
+            {
+                string line = record.ToLine();
+                fwrite(line.c_str(), 1, line.size(), stdout);
+            }
+        }
+
+        if (reader.UnknownFormatCount > 0)
+        {
+            fprintf(stderr, "'%s': %zu events with unknown format\n", file.c_str(), reader.UnknownFormatCount);
+        }
+
+        if (reader.TruncatedBytes > 0)
+        {
+            fprintf(stderr, "'%s': %zu bytes at the end do not form a complete record\n", file.c_str(), reader.TruncatedBytes);
+        }
+    }
+
+    if (sort)
+    {
+        stable_sort(
+            records.begin(),
+            records.end(),
+            [](TraceBinaryFileReader::TraceRecord const & left, TraceBinaryFileReader::TraceRecord const & right) { return left.Time < right.Time; });
+
+        for (auto const & record : records)
+        {
+            string line = record.ToLine();
+            fwrite(line.c_str(), 1, line.size(), stdout);
+        }
+    }
+
+    return result;
+}
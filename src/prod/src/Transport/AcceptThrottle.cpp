@@ -49,6 +49,11 @@ bool AcceptThrottle::OnConnectionAccepted(
     Endpoint connectionGroupId = remoteEndpoint;
     connectionGroupId.Port = localListenPort; // remote port is an ephemeral port,
     // replace it with localListenPort to distinguish different listeners in this process
+    if (remoteEndpoint.IsUnixDomain())
+    {
+        // connecting side of unix domain socket is unnamed, group by listener path
+        connectionGroupId = listenSocket.ListenEndpoint();
+    }
 
     // avoid destruction under lock
     vector<TcpConnectionSPtr> abortedConnections;
@@ -32,6 +32,24 @@ IDatagramTransportSPtr DatagramTransportFactory::CreateTcpClient(string const &
     return TcpDatagramTransport::CreateClient(id, owner);
 }
 
+#ifdef PLATFORM_UNIX
+
+IDatagramTransportSPtr DatagramTransportFactory::CreateUnixDomain(
+    string const & socketPath,
+    string const & id,
+    string const & owner)
+{
+    string address = "unix:" + socketPath;
+    if (TransportConfig::GetConfig().InMemoryTransportEnabled)
+    {
+        return CreateMem(address, id);
+    }
+
+    return TcpDatagramTransport::Create(address, id, owner);
+}
+
+#endif
+
 IDatagramTransportSPtr DatagramTransportFactory::CreateMem(string const & name, string const & id)
 {
     string address;
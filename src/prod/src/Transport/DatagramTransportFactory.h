@@ -19,6 +19,16 @@ namespace Transport
             std::string const & id = "",
             std::string const & owner = "");
 
+#ifdef PLATFORM_UNIX
+        // Listens on a unix domain stream socket at socketPath, with the same framing and connection
+        // management as TCP. Clients created with CreateTcpClient can connect to its "unix:<socketPath>"
+        // listen address. Same host only.
+        static IDatagramTransportSPtr CreateUnixDomain(
+            std::string const & socketPath,
+            std::string const & id = "",
+            std::string const & owner = "");
+#endif
+
         // Returns an empty pointer if the local address already exists
         static IDatagramTransportSPtr  CreateMem(
             std::string const & name,
@@ -23,6 +23,7 @@ namespace Transport
         virtual IConnectionWPtr GetWPtr() = 0;
 
         virtual TransportPriority::Enum GetPriority() const = 0;
+        virtual uint GetLane() const = 0; // 0 for control lane, bulk lanes start from 1
         virtual TransportFlags & GetTransportFlags() = 0;
 
         virtual void SetSecurityContext(TransportSecuritySPtr const & transportSecurity, std::string const & sspiTarget) = 0;
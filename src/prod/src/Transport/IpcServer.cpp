@@ -14,6 +14,18 @@ static const IpcEventSource ipcTrace;
 
 namespace
 {
+#ifdef PLATFORM_UNIX
+    string GetUnixDomainSocketPath()
+    {
+        static Common::atomic_long sequence(0);
+        return formatString.L(
+            "{0}/sfipc-{1}-{2}.sock",
+            TransportConfig::GetConfig().IpcUnixDomainSocketDirectory,
+            ::GetCurrentProcessId(),
+            ++sequence);
+    }
+#endif
+
     IDatagramTransportSPtr CreateTransport(
         ComponentRoot const & root,
         string const & transportListenAddress,
@@ -26,7 +38,14 @@ namespace
             return nullptr;
         }
 
+#ifdef PLATFORM_UNIX
+        // all IPC is on the same host, unix domain socket skips the TCP/IP stack
+        auto transport = TransportConfig::GetConfig().IpcUnixDomainSocketEnabled ?
+            DatagramTransportFactory::CreateUnixDomain(GetUnixDomainSocketPath(), serverId, owner + ".IpcServer") :
+            DatagramTransportFactory::CreateTcp(transportListenAddress, serverId, owner + ".IpcServer");
+#else
         auto transport = DatagramTransportFactory::CreateTcp(transportListenAddress, serverId, owner + ".IpcServer");
+#endif
 
         //Support for Unreliable transport for request reply over IPC
         if (useUnreliableTransport && TransportConfig::GetConfig().UseUnreliableForRequestReply)
@@ -0,0 +1,246 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+#include <linux/tls.h>
+
+using namespace Transport;
+using namespace Common;
+using namespace std;
+
+#ifndef SOL_TLS
+#define SOL_TLS 282
+#endif
+
+#ifndef TCP_ULP
+#define TCP_ULP 31
+#endif
+
+namespace
+{
+    StringLiteral const TraceType("KernelTls");
+
+    // TLS 1.2 AES-GCM nonce = 4 byte implicit part from the key block + 8 byte explicit part
+    size_t const GcmSaltLength = 4;
+
+    ErrorCode DeriveKeyBlock(SSL* ssl, EVP_MD const* prfMd, _Out_ vector<byte> & keyBlock)
+    {
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+        byte masterKey[SSL_MAX_MASTER_KEY_LENGTH];
+        auto masterKeyLength = SSL_SESSION_get_master_key(SSL_get_session(ssl), masterKey, sizeof(masterKey));
+        KFinally([&] { OPENSSL_cleanse(masterKey, sizeof(masterKey)); });
+
+        byte clientRandom[SSL3_RANDOM_SIZE];
+        byte serverRandom[SSL3_RANDOM_SIZE];
+        if ((masterKeyLength == 0) ||
+            (SSL_get_client_random(ssl, clientRandom, sizeof(clientRandom)) != sizeof(clientRandom)) ||
+            (SSL_get_server_random(ssl, serverRandom, sizeof(serverRandom)) != sizeof(serverRandom)))
+        {
+            return ErrorCodeValue::OperationFailed;
+        }
+
+        // key_block = PRF(master_secret, "key expansion", server_random + client_random), RFC 5246 section 6.3
+        static const char label[] = "key expansion";
+        auto ctx = EVP_PKEY_CTX_new_id(EVP_PKEY_TLS1_PRF, nullptr);
+        if (!ctx)
+        {
+            return ErrorCodeValue::OperationFailed;
+        }
+
+        KFinally([=] { EVP_PKEY_CTX_free(ctx); });
+
+        size_t keyBlockLength = keyBlock.size();
+        if ((EVP_PKEY_derive_init(ctx) <= 0) ||
+            (EVP_PKEY_CTX_set_tls1_prf_md(ctx, prfMd) <= 0) ||
+            (EVP_PKEY_CTX_set1_tls1_prf_secret(ctx, masterKey, masterKeyLength) <= 0) ||
+            (EVP_PKEY_CTX_add1_tls1_prf_seed(ctx, label, sizeof(label) - 1) <= 0) ||
+            (EVP_PKEY_CTX_add1_tls1_prf_seed(ctx, serverRandom, sizeof(serverRandom)) <= 0) ||
+            (EVP_PKEY_CTX_add1_tls1_prf_seed(ctx, clientRandom, sizeof(clientRandom)) <= 0) ||
+            (EVP_PKEY_derive(ctx, keyBlock.data(), &keyBlockLength) <= 0) ||
+            (keyBlockLength != keyBlock.size()))
+        {
+            return LinuxCryptUtil().GetOpensslErr();
+        }
+
+        return ErrorCode();
+#else
+        ssl; prfMd; keyBlock;
+        return ErrorCodeValue::NotImplemented;
+#endif
+    }
+
+    template <typename TCryptoInfo>
+    void FillCryptoInfo(
+        TCryptoInfo & info,
+        unsigned short cipherType,
+        byte const* key,
+        byte const* salt,
+        uint64 recordSequence)
+    {
+        static_assert(sizeof(info.rec_seq) == sizeof(recordSequence), "unexpected record sequence size");
+        static_assert(sizeof(info.iv) == sizeof(recordSequence), "unexpected explicit nonce size");
+        static_assert(sizeof(info.salt) == GcmSaltLength, "unexpected salt size");
+
+        info.info.version = TLS_1_2_VERSION;
+        info.info.cipher_type = cipherType;
+        memcpy(info.key, key, sizeof(info.key));
+        memcpy(info.salt, salt, sizeof(info.salt));
+
+        // record sequence numbers are big endian in the additional data of a record.
+        // The explicit nonce only has to be unique per key: on send the kernel starts
+        // from iv and increments it per record, on receive it takes the nonce carried
+        // in each record and ignores iv. OpenSSL starts its send nonces at a random
+        // value, so starting ours at the record sequence number is as unlikely to
+        // repeat one of its nonces as its own random start is.
+        for (size_t i = 0; i < sizeof(info.rec_seq); ++i)
+        {
+            info.rec_seq[i] = static_cast<byte>(recordSequence >> (8 * (sizeof(info.rec_seq) - 1 - i)));
+        }
+
+        memcpy(info.iv, info.rec_seq, sizeof(info.iv));
+    }
+}
+
+void TlsRecordCounter::Add(void const* data, size_t length)
+{
+    auto cur = static_cast<byte const*>(data);
+    auto end = cur + length;
+    while (cur < end)
+    {
+        if (bodyRemaining_ > 0)
+        {
+            size_t toSkip = min(bodyRemaining_, static_cast<size_t>(end - cur));
+            cur += toSkip;
+            bodyRemaining_ -= toSkip;
+            if (bodyRemaining_ == 0)
+            {
+                ++recordCount_;
+            }
+
+            continue;
+        }
+
+        header_[headerBytes_++] = *cur++;
+        if (headerBytes_ == RecordHeaderLength)
+        {
+            // header: content type (1), protocol version (2), length (2)
+            headerBytes_ = 0;
+            bodyRemaining_ = (static_cast<size_t>(header_[3]) << 8) | header_[4];
+            if (bodyRemaining_ == 0)
+            {
+                ++recordCount_;
+            }
+        }
+    }
+}
+
+ErrorCode KernelTls::Enable(
+    string const & traceId,
+    SOCKET socket,
+    SSL* ssl,
+    bool send,
+    uint64 recordSequence)
+{
+    auto direction = send ? "send" : "receive";
+
+    if (SSL_version(ssl) != TLS1_2_VERSION)
+    {
+        WriteInfo(TraceType, traceId, "{0}: protocol version {1:x} not supported", direction, SSL_version(ssl));
+        return ErrorCodeValue::NotImplemented;
+    }
+
+#if OPENSSL_VERSION_NUMBER >= 0x10100000L
+    auto cipher = SSL_get_current_cipher(ssl);
+    auto cipherNid = cipher ? SSL_CIPHER_get_cipher_nid(cipher) : NID_undef;
+
+    // all TLS 1.2 AES-GCM cipher suites use SHA256 with AES-128 and SHA384 with AES-256 for PRF
+    size_t keyLength = 0;
+    EVP_MD const* prfMd = nullptr;
+    if (cipherNid == NID_aes_128_gcm)
+    {
+        keyLength = TLS_CIPHER_AES_GCM_128_KEY_SIZE;
+        prfMd = EVP_sha256();
+    }
+#ifdef TLS_CIPHER_AES_GCM_256
+    else if (cipherNid == NID_aes_256_gcm)
+    {
+        keyLength = TLS_CIPHER_AES_GCM_256_KEY_SIZE;
+        prfMd = EVP_sha384();
+    }
+#endif
+    else
+    {
+        WriteInfo(TraceType, traceId, "{0}: cipher {1} not supported", direction, cipher ? SSL_CIPHER_get_name(cipher) : "");
+        return ErrorCodeValue::NotImplemented;
+    }
+
+    // GCM cipher suites have no MAC keys:
+    // client_write_key, server_write_key, client_write_IV, server_write_IV
+    vector<byte> keyBlock(2 * (keyLength + GcmSaltLength));
+    KFinally([&] { OPENSSL_cleanse(keyBlock.data(), keyBlock.size()); });
+
+    auto error = DeriveKeyBlock(ssl, prfMd, keyBlock);
+    if (!error.IsSuccess())
+    {
+        WriteWarning(TraceType, traceId, "{0}: failed to derive key block: {1}", direction, error);
+        return error;
+    }
+
+    bool isClientKey = ((SSL_is_server(ssl) == 0) == send);
+    auto key = keyBlock.data() + (isClientKey ? 0 : keyLength);
+    auto salt = keyBlock.data() + (2 * keyLength) + (isClientKey ? 0 : GcmSaltLength);
+
+    union
+    {
+        tls12_crypto_info_aes_gcm_128 aes128;
+#ifdef TLS_CIPHER_AES_GCM_256
+        tls12_crypto_info_aes_gcm_256 aes256;
+#endif
+    } cryptoInfo = {};
+    KFinally([&] { OPENSSL_cleanse(&cryptoInfo, sizeof(cryptoInfo)); });
+
+    socklen_t cryptoInfoLength = 0;
+    if (keyLength == TLS_CIPHER_AES_GCM_128_KEY_SIZE)
+    {
+        FillCryptoInfo(cryptoInfo.aes128, TLS_CIPHER_AES_GCM_128, key, salt, recordSequence);
+        cryptoInfoLength = sizeof(cryptoInfo.aes128);
+    }
+#ifdef TLS_CIPHER_AES_GCM_256
+    else
+    {
+        FillCryptoInfo(cryptoInfo.aes256, TLS_CIPHER_AES_GCM_256, key, salt, recordSequence);
+        cryptoInfoLength = sizeof(cryptoInfo.aes256);
+    }
+#endif
+
+    // the upper layer protocol is attached once per socket, EEXIST when the other direction has it attached already
+    if ((setsockopt(socket, SOL_TCP, TCP_ULP, "tls", sizeof("tls")) < 0) && (errno != EEXIST))
+    {
+        error = ErrorCode::FromErrno();
+        WriteInfo(TraceType, traceId, "{0}: setsockopt(TCP_ULP) failed, kernel TLS not available: {1}", direction, error);
+        return error;
+    }
+
+    if (setsockopt(socket, SOL_TLS, send ? TLS_TX : TLS_RX, &cryptoInfo, cryptoInfoLength) < 0)
+    {
+        error = ErrorCode::FromErrno();
+        WriteInfo(TraceType, traceId, "{0}: setsockopt(SOL_TLS) failed: {1}", direction, error);
+        return error;
+    }
+
+    WriteInfo(
+        TraceType, traceId,
+        "{0}: records are now processed by the kernel, cipher = {1}, record sequence = {2}",
+        direction,
+        SSL_CIPHER_get_name(cipher),
+        recordSequence);
+
+    return ErrorCode();
+#else
+    socket; recordSequence;
+    WriteInfo(TraceType, traceId, "{0}: OpenSSL {1:x} does not expose the session keys", direction, OPENSSL_VERSION_NUMBER);
+    return ErrorCodeValue::NotImplemented;
+#endif
+}
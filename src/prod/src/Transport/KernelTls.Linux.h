@@ -0,0 +1,43 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Transport
+{
+    // Counts the complete TLS records in a TLS byte stream, so that the record
+    // sequence number can be handed over to the kernel along with the keys
+    class TlsRecordCounter
+    {
+    public:
+        void Add(void const* data, size_t length);
+
+        bool AtRecordBoundary() const { return (headerBytes_ == 0) && (bodyRemaining_ == 0); }
+        uint64 RecordCount() const { return recordCount_; }
+
+    private:
+        static const size_t RecordHeaderLength = 5;
+
+        byte header_[RecordHeaderLength];
+        size_t headerBytes_ = 0;
+        size_t bodyRemaining_ = 0;
+        uint64 recordCount_ = 0;
+    };
+
+    // Installs the record keys negotiated by OpenSSL into a TCP socket with Linux kernel TLS (kTLS),
+    // after which the kernel encrypts the bytes written to the socket into TLS records, or decrypts
+    // the TLS records read from the socket. Only TLS 1.2 with AES-GCM is supported, the handover
+    // fails for everything else and the caller is expected to keep using OpenSSL for the records.
+    class KernelTls : public Common::TextTraceComponent<Common::TraceTaskCodes::Transport>
+    {
+    public:
+        static Common::ErrorCode Enable(
+            std::string const & traceId,
+            SOCKET socket,
+            SSL* ssl,
+            bool send,
+            uint64 recordSequence);
+    };
+}
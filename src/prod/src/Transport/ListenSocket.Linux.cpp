@@ -50,7 +50,8 @@ void ListenSocket::AcceptCallback(int sd, uint events)
         return;
     }
 
-    socklen_t addrLen = sizeof(sockaddr_in6);
+    socklen_t addrLen = sizeof(sockaddr_storage);
+    acceptedRemoteEndpoint_ = Endpoint();
     auto acceptedSd = accept(
         listenSocket_.GetHandle(),
         acceptedRemoteEndpoint_.as_sockaddr(),
@@ -101,6 +102,16 @@ ErrorCode ListenSocket::OnOpen()
             error);
     }
  
+    if (listenEndpoint_.IsUnixDomain())
+    {
+        // remove socket file left behind by a previous listener, bind fails with EADDRINUSE otherwise
+        auto path = listenEndpoint_.GetUnixDomainPath();
+        if ((unlink(path.c_str()) < 0) && (errno != ENOENT))
+        {
+            WriteWarning(TraceType, traceId_, "failed to remove existing socket file {0}: {1}", path, ErrorCode::FromErrno());
+        }
+    }
+
     error = Bind();
     if (!error.IsSuccess())
     {
@@ -182,7 +193,13 @@ ErrorCode ListenSocket::OnClose()
         eventLoop_.UnregisterFd(fdContext_, true); 
     }
 
-    return listenSocket_.Close(SocketShutdown::None);
+    auto error = listenSocket_.Close(SocketShutdown::None);
+    if (listenEndpoint_.IsUnixDomain())
+    {
+        unlink(listenEndpoint_.GetUnixDomainPath().c_str());
+    }
+
+    return error;
 }
 
 void ListenSocket::OnAbort()
@@ -57,6 +57,11 @@ namespace Transport
         uint seq_;
     };
 
+    template <>
+    struct CacheDecodedHeader<ExampleHeader2> : std::true_type
+    {
+    };
+
     struct ExampleHeader3 : public MessageHeader<MessageHeaderId::Example3>, public Serialization::FabricSerializable
     {
         ExampleHeader3() { }
@@ -1209,6 +1214,54 @@ namespace Transport
         VERIFY_IS_TRUE(userDefinedPropertyRetrieved.Value() == sharedPtrPropertyValue);
     }
 
+    BOOST_AUTO_TEST_CASE(MessagePropertyAllocation)
+    {
+        Message message;
+        auto storedInMessage = [&message](void const* property)
+        {
+            return (property >= static_cast<void const*>(&message)) && (property < static_cast<void const*>(&message + 1));
+        };
+
+        // small trivially copyable properties are stored in the message itself
+        message.AddProperty(true, "bool property");
+        message.AddProperty(static_cast<int64>(12345));
+        message.AddProperty(ErrorCodeValue::NotFound, "error property");
+        VERIFY_IS_TRUE(storedInMessage(message.TryGetProperty<bool>("bool property")));
+        VERIFY_IS_TRUE(storedInMessage(message.TryGetProperty<int64>()));
+        VERIFY_IS_TRUE(storedInMessage(message.TryGetProperty<ErrorCodeValue::Enum>("error property")));
+        VERIFY_IS_TRUE(message.GetProperty<bool>("bool property"));
+        VERIFY_IS_TRUE(message.GetProperty<int64>() == 12345);
+        VERIFY_IS_TRUE(message.GetProperty<ErrorCodeValue::Enum>("error property") == ErrorCodeValue::NotFound);
+
+        // beyond inline slots
+        message.AddProperty(static_cast<double>(0.5));
+        VERIFY_IS_FALSE(storedInMessage(message.TryGetProperty<double>()));
+        VERIFY_IS_TRUE(message.GetProperty<double>() == 0.5);
+
+        // a removed slot is reused
+        VERIFY_IS_TRUE(message.RemoveProperty<int64>());
+        VERIFY_IS_TRUE(message.TryGetProperty<int64>() == nullptr);
+        message.AddProperty(string("string property"));
+        VERIFY_IS_TRUE(message.GetProperty<string>() == "string property");
+        message.AddProperty(static_cast<int>(7));
+        VERIFY_IS_TRUE(storedInMessage(message.TryGetProperty<int>()));
+
+        // a clone copies values stored in slots into its own slots
+        auto clone = message.Clone();
+        auto storedInClone = [&clone](void const* property)
+        {
+            return (property >= static_cast<void const*>(clone.get())) && (property < static_cast<void const*>(clone.get() + 1));
+        };
+
+        VERIFY_IS_TRUE(storedInClone(clone->TryGetProperty<bool>("bool property")));
+        VERIFY_IS_TRUE(storedInClone(clone->TryGetProperty<int>()));
+        VERIFY_IS_FALSE(storedInClone(clone->TryGetProperty<double>()));
+        VERIFY_IS_TRUE(clone->GetProperty<bool>("bool property"));
+        VERIFY_ARE_EQUAL2(clone->GetProperty<int>(), 7);
+        VERIFY_IS_TRUE(clone->GetProperty<double>() == 0.5);
+        VERIFY_IS_TRUE(clone->GetProperty<string>() == "string property");
+    }
+
     BOOST_AUTO_TEST_CASE(SimpleMessage)
     {
         //
@@ -1376,6 +1429,156 @@ namespace Transport
         VERIFY_IS_TRUE(found);
     }
 
+    void CreateIncomingHeaderBytes(ByteBique & byteBique)
+    {
+        BiqueWriteStream biqueStream(byteBique);
+        AddHeader(biqueStream, ActionHeader("IndexedHeaderTestAction"));
+        AddHeader(biqueStream, ActorHeader(Actor::GenericTestActor));
+        AddHeader(biqueStream, MessageIdHeader());
+        AddHeader(biqueStream, ExampleHeader("ExampleHeader", std::vector<LONG>(16, 1), 1));
+        for (uint i = 2; i < 6; ++ i)
+        {
+            AddHeader(biqueStream, ExampleHeader2("ExampleHeader2 Key", "ExampleHeader2 Value", i));
+        }
+    }
+
+    // reads the first header of type T the way MessageHeaders::TryReadFirst does without header index
+    template <class T> bool WalkToReadFirst(MessageHeaders & headers, T & header)
+    {
+        for (auto iter = headers.Begin(); iter != headers.End(); ++ iter)
+        {
+            if (iter->Id() == T::Id)
+            {
+                header = iter->Deserialize<T>();
+                return iter->IsValid;
+            }
+        }
+
+        return false;
+    }
+
+    BOOST_AUTO_TEST_CASE(MessageHeadersIndexTest)
+    {
+        ByteBique byteBique;
+        CreateIncomingHeaderBytes(byteBique);
+        MessageHeaders incomingHeaders(std::move(ByteBiqueRange(std::move(byteBique))), MessageHeaders::NullReceiveTime());
+        VERIFY_ARE_EQUAL2(incomingHeaders.Action, string("IndexedHeaderTestAction"));
+
+        ExampleHeader2 header2;
+        VERIFY_IS_TRUE(incomingHeaders.TryReadFirst(header2));
+        VERIFY_ARE_EQUAL2(header2.Seq(), 2u);
+
+        // read again from the decoded copy kept in the index
+        header2 = ExampleHeader2();
+        VERIFY_IS_TRUE(incomingHeaders.TryReadFirst(header2));
+        VERIFY_ARE_EQUAL2(header2.Seq(), 2u);
+
+        // headers that can only be moved are read through the index as well
+        IpcHeader ipcHeader;
+        VERIFY_IS_FALSE(incomingHeaders.TryReadFirst(ipcHeader));
+
+        ExampleHeader3 header3;
+        VERIFY_IS_FALSE(incomingHeaders.TryReadFirst(header3));
+        VERIFY_IS_FALSE(incomingHeaders.Contains(MessageHeaderId::Example3));
+
+        // index must not hide headers added locally
+        incomingHeaders.Add(ExampleHeader3("ExampleHeader3 Key", "ExampleHeader3 Value", 7));
+        VERIFY_IS_TRUE(incomingHeaders.TryReadFirst(header3));
+        VERIFY_ARE_EQUAL2(header3.Seq(), 7u);
+
+        // removing the first ExampleHeader2 drops its decoded copy and exposes the next one
+        for (auto iter = incomingHeaders.Begin(); iter != incomingHeaders.End(); )
+        {
+            if (iter->Id() == MessageHeaderId::Example)
+            {
+                incomingHeaders.Remove(iter);
+            }
+            else if (iter->Id() == MessageHeaderId::Example2)
+            {
+                incomingHeaders.Remove(iter);
+                break;
+            }
+            else
+            {
+                ++ iter;
+            }
+        }
+
+        VERIFY_IS_TRUE(incomingHeaders.TryReadFirst(header2));
+        VERIFY_ARE_EQUAL2(header2.Seq(), 3u);
+        VERIFY_IS_FALSE(incomingHeaders.Contains(MessageHeaderId::Example));
+
+        // replacing the headers drops the index together with the decoded copies
+        ByteBique replacement;
+        BiqueWriteStream replacementStream(replacement);
+        AddHeader(replacementStream, ExampleHeader2("ExampleHeader2 Key", "ExampleHeader2 Value", 9));
+        incomingHeaders.Replace(ByteBiqueRange(std::move(replacement)));
+        VERIFY_IS_TRUE(incomingHeaders.TryReadFirst(header2));
+        VERIFY_ARE_EQUAL2(header2.Seq(), 9u);
+    }
+
+    BOOST_AUTO_TEST_CASE(MessageHeadersIndexBenchmark)
+    {
+        // typical federation message processing: common headers are parsed on receiving, then
+        // a few handlers each look up the headers they are interested in, some of them absent
+        int const iterations = 20000;
+
+        auto createIncomingHeaders = []
+        {
+            ByteBique byteBique;
+            CreateIncomingHeaderBytes(byteBique);
+            return make_unique<MessageHeaders>(std::move(ByteBiqueRange(std::move(byteBique))), MessageHeaders::NullReceiveTime());
+        };
+
+        size_t found = 0;
+        Stopwatch stopwatch;
+        stopwatch.Start();
+        for (int i = 0; i < iterations; ++ i)
+        {
+            auto headers = createIncomingHeaders();
+            ExampleHeader header;
+            ExampleHeader2 header2;
+            ExampleHeader3 header3;
+            found += WalkToReadFirst(*headers, header2);
+            found += WalkToReadFirst(*headers, header);
+            found += WalkToReadFirst(*headers, header3);
+            found += WalkToReadFirst(*headers, header2);
+            found += WalkToReadFirst(*headers, header);
+            found += WalkToReadFirst(*headers, header3);
+        }
+
+        stopwatch.Stop();
+        auto walkElapsed = stopwatch.ElapsedMicroseconds;
+        VERIFY_ARE_EQUAL2(found, static_cast<size_t>(4 * iterations));
+
+        found = 0;
+        stopwatch.Restart();
+        for (int i = 0; i < iterations; ++ i)
+        {
+            auto headers = createIncomingHeaders();
+            ExampleHeader header;
+            ExampleHeader2 header2;
+            ExampleHeader3 header3;
+            found += headers->TryReadFirst(header2);
+            found += headers->TryReadFirst(header);
+            found += headers->TryReadFirst(header3);
+            found += headers->TryReadFirst(header2);
+            found += headers->TryReadFirst(header);
+            found += headers->TryReadFirst(header3);
+        }
+
+        stopwatch.Stop();
+        auto indexedElapsed = stopwatch.ElapsedMicroseconds;
+        VERIFY_ARE_EQUAL2(found, static_cast<size_t>(4 * iterations));
+
+        Trace.WriteInfo(
+            TraceType,
+            "{0} messages: walking headers {1}us, indexed headers {2}us",
+            iterations,
+            walkElapsed,
+            indexedElapsed);
+    }
+
     void TestBiqueChunIterator(size_t size1, size_t size2)
     {
         ByteBique b1;
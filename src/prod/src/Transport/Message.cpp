@@ -167,7 +167,7 @@ MessageUPtr Message::Clone()
     MessageUPtr clone = CloneSharedParts();
     clone->headers_.CopyNonSharedHeadersFrom(headers_);
     clone->headers_.Idempotent = headers_.Idempotent;
-    clone->properties_.insert(properties_.begin(), properties_.end());
+    clone->properties_ = properties_;
 
     return clone;
 }
@@ -186,7 +186,7 @@ MessageUPtr Message::Clone(MessageHeaders && extraHeaders)
     clone->headers_.UpdateCommonHeaders();
     clone->headers_.Idempotent = headers_.Idempotent;
 
-    clone->properties_.insert(properties_.begin(), properties_.end());
+    clone->properties_ = properties_;
 
     return clone;
 }
@@ -638,3 +638,98 @@ bool Message::AccessCheck(AccessControl::FabricAcl const & acl, DWORD desiredAcc
     return true;
 }
 
+Message::PropertyTable::PropertyTable(PropertyTable const & other)
+{
+    *this = other;
+}
+
+Message::PropertyTable & Message::PropertyTable::operator = (PropertyTable const & other)
+{
+    if (this != &other)
+    {
+        for (size_t i = 0; i < InlineSlotCount; ++i)
+        {
+            slots_[i] = other.slots_[i];
+        }
+
+        overflow_ = other.overflow_ ? make_unique<OverflowMap>(*other.overflow_) : nullptr;
+    }
+
+    return *this;
+}
+
+void Message::PropertyTable::Add(const char* key, shared_ptr<MessageProperty> && property)
+{
+    AddSlot(key).Property = move(property);
+}
+
+bool Message::PropertyTable::Remove(const char* key)
+{
+    for (auto & slot : slots_)
+    {
+        if (slot.Key && KeyEquals(slot.Key, key))
+        {
+            slot.Key = nullptr;
+            slot.Property.reset();
+            return true;
+        }
+    }
+
+    return overflow_ && (overflow_->erase(key) > 0);
+}
+
+void* Message::PropertyTable::TryGet(const char* key) const
+{
+    auto slot = Find(key);
+    if (!slot)
+    {
+        return nullptr;
+    }
+
+    return slot->Property ? slot->Property->GetPointer() : const_cast<byte*>(slot->Value);
+}
+
+Message::PropertyTable::Slot & Message::PropertyTable::AddSlot(const char* key)
+{
+    ASSERT_IF(Find(key) != nullptr, "Message property key already existed.");
+
+    for (auto & slot : slots_)
+    {
+        if (!slot.Key)
+        {
+            slot.Key = key;
+            return slot;
+        }
+    }
+
+    if (!overflow_)
+    {
+        overflow_ = make_unique<OverflowMap>();
+    }
+
+    auto & slot = (*overflow_)[key];
+    slot.Key = key;
+    return slot;
+}
+
+Message::PropertyTable::Slot const * Message::PropertyTable::Find(const char* key) const
+{
+    for (auto & slot : slots_)
+    {
+        if (slot.Key && KeyEquals(slot.Key, key))
+        {
+            return &slot;
+        }
+    }
+
+    if (overflow_)
+    {
+        auto iter = overflow_->find(key);
+        if (iter != overflow_->end())
+        {
+            return &(iter->second);
+        }
+    }
+
+    return nullptr;
+}
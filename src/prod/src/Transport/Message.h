@@ -20,9 +20,6 @@ namespace Transport
     {
         //DENY_COPY(Message);
         class MessageProperty;
-        // The key type of message property table is "const char*", key value by default is typeid(property).raw_name().
-        // By default, std::map compares "const char*" pointer value in key comparison, so we need our own key_compare.
-        typedef std::map<const char*, std::shared_ptr<MessageProperty>, ConstCharPtrLess> PropertyMap;
         class BodyBuffers;
 
     public:
@@ -189,8 +186,62 @@ namespace Transport
         // This operation does not affect lifetime management of the buffers, which is still managed by ByteBiqueRange Message::body_.
         void UpdateBodyBufferList(BodyBuffers && other);
 
-        // todo: make this a smart pointer, so that we do not incur the cost of initial map memory allocation until properties are added.
-        PropertyMap properties_;
+        template <class T> void AddPropertyValue(T const & prop, const char* key, std::true_type);
+        template <class T> void AddPropertyValue(T const & prop, const char* key, std::false_type);
+
+        // Messages carry few properties, typically none to three, so the first InlineSlotCount properties are
+        // kept in the message itself and only the rest go to a map. Values of small trivially copyable types
+        // are stored in their slot, other values are wrapped in a MessageProperty. Slots never move, so that
+        // a pointer returned by TryGet stays valid until the property is removed.
+        class PropertyTable
+        {
+        public:
+            static const size_t InlineSlotCount = 3;
+            static const size_t InlineValueSize = 16;
+
+            template <class T> struct IsInline : std::integral_constant<
+                bool,
+                std::is_trivially_copyable<T>::value && (sizeof(T) <= InlineValueSize) && (alignof(T) <= alignof(uint64))>
+            {
+            };
+
+            PropertyTable() = default;
+            PropertyTable(PropertyTable const & other);
+            PropertyTable & operator = (PropertyTable const & other);
+
+            template <class T> void AddValue(const char* key, T const & value)
+            {
+                static_assert(IsInline<T>::value, "property value cannot be stored in slot");
+                new (AddSlot(key).Value) T(value);
+            }
+
+            void Add(const char* key, std::shared_ptr<MessageProperty> && property);
+            bool Remove(const char* key);
+            void* TryGet(const char* key) const;
+
+        private:
+            struct Slot
+            {
+                const char* Key = nullptr; // nullptr for unused slot
+                std::shared_ptr<MessageProperty> Property; // nullptr if the value is stored in Value
+                alignas(uint64) byte Value[InlineValueSize];
+            };
+
+            // The key type is "const char*", key value by default is typeid(property).raw_name(). std::map compares
+            // "const char*" pointer value by default, so we need our own key_compare.
+            typedef std::map<const char*, Slot, ConstCharPtrLess> OverflowMap;
+
+            // Keys are usually the same typeid name literal, so pointer comparison avoids strcmp in most cases
+            static bool KeyEquals(const char* key1, const char* key2) { return (key1 == key2) || (strcmp(key1, key2) == 0); }
+
+            Slot & AddSlot(const char* key);
+            Slot const * Find(const char* key) const;
+
+            Slot slots_[InlineSlotCount];
+            std::unique_ptr<OverflowMap> overflow_;
+        };
+
+        PropertyTable properties_;
         MessageHeaders headers_;
 
         // On the incoming side, body_ always contains serialized message body. On the outgoing side, when user provides serialized 
@@ -329,56 +380,45 @@ namespace Transport
     template <class T>
     void Message::AddProperty(T const & prop, const char* key) // copy-by-value
     {        
-        std::shared_ptr<MessageProperty> value = std::make_shared<MessagePropertyByValue<T>>(prop);
-        bool inserted = properties_.emplace(std::move(std::pair<const char*, std::shared_ptr<MessageProperty>>(key, std::move(value)))).second;
-        ASSERT_IF(!inserted, "Message property key already existed.");
+        AddPropertyValue(prop, key, std::integral_constant<bool, PropertyTable::IsInline<T>::value>());
+    }
+
+    template <class T>
+    void Message::AddPropertyValue(T const & prop, const char* key, std::true_type)
+    {
+        properties_.AddValue(key, prop);
+    }
+
+    template <class T>
+    void Message::AddPropertyValue(T const & prop, const char* key, std::false_type)
+    {
+        properties_.Add(key, std::make_shared<MessagePropertyByValue<T>>(prop));
     }
 
     template <class T> 
     void Message::AddProperty(std::unique_ptr<T> && prop, const char* key) // move semantics
     {
-        std::shared_ptr<MessageProperty> value = std::make_shared<MessagePropertyByUPtr<T>>(std::move(prop));
-        bool inserted = properties_.emplace(std::move(std::pair<const char*, std::shared_ptr<MessageProperty>>(key, std::move(value)))).second;
-        ASSERT_IF(!inserted, "Message property key already existed.");
+        properties_.Add(key, std::make_shared<MessagePropertyByUPtr<T>>(std::move(prop)));
     }
 
     template <class T> 
     void Message::AddProperty(std::shared_ptr<T> const & prop, const char* key) // copy/addref semantics
     {
-        std::shared_ptr<MessageProperty> value = std::make_shared<MessagePropertyBySPtr<T>>(prop);
-        bool inserted = properties_.emplace(std::move(std::pair<const char*, std::shared_ptr<MessageProperty>>(key, std::move(value)))).second;
-        ASSERT_IF(!inserted, "Message property key already existed.");
+        properties_.Add(key, std::make_shared<MessagePropertyBySPtr<T>>(prop));
     }
 
     // Returns true if the property exists.
     template <class T> 
     bool Message::RemoveProperty(const char* key)
     {
-        auto iter = properties_.find(key);
-        if (iter != properties_.end())
-        {
-            properties_.erase(iter);
-            return true;
-        }
-        else
-        {
-            return false;
-        }
+        return properties_.Remove(key);
     } 
 
     // Returns NULL if the property does not exist.
     template <class T> 
     T* Message::TryGetProperty(const char* key) const
     {
-        PropertyMap::const_iterator iter = properties_.find(key);
-        if (iter != properties_.end())
-        {
-            return static_cast<T*>(iter->second->GetPointer());
-        }
-        else
-        {
-            return nullptr;
-        }
+        return static_cast<T*>(properties_.TryGet(key));
     }
 
     template <class T>
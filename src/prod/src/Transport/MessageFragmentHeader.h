@@ -0,0 +1,45 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Transport
+{
+    // Carried by each fragment of a message whose body is split by TcpConnection, see
+    // TransportConfig::MessageFragmentSize. Fragment 0 also carries the headers of the
+    // original message, BodySize is the body size of the original message.
+    class MessageFragmentHeader : public MessageHeader<MessageHeaderId::MessageFragment>, public Serialization::FabricSerializable
+    {
+    public:
+        MessageFragmentHeader() = default;
+        MessageFragmentHeader(uint64 fragmentedMessageId, uint32 index, uint32 count, uint64 bodySize)
+            : fragmentedMessageId_(fragmentedMessageId), index_(index), count_(count), bodySize_(bodySize)
+        {
+        }
+
+        __declspec(property(get=get_FragmentedMessageId)) uint64 FragmentedMessageId;
+        __declspec(property(get=get_Index)) uint32 Index;
+        __declspec(property(get=get_Count)) uint32 Count;
+        __declspec(property(get=get_BodySize)) uint64 BodySize;
+
+        uint64 get_FragmentedMessageId() const { return fragmentedMessageId_; }
+        uint32 get_Index() const { return index_; }
+        uint32 get_Count() const { return count_; }
+        uint64 get_BodySize() const { return bodySize_; }
+
+        void WriteTo(Common::TextWriter & w, Common::FormatOptions const &) const
+        {
+            w << fragmentedMessageId_ << ':' << index_ << '/' << count_ << ',' << bodySize_;
+        }
+
+        FABRIC_FIELDS_04(fragmentedMessageId_, index_, count_, bodySize_);
+
+    private:
+        uint64 fragmentedMessageId_ = 0;
+        uint32 index_ = 0;
+        uint32 count_ = 0;
+        uint64 bodySize_ = 0;
+    };
+}
@@ -0,0 +1,218 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#include "stdafx.h"
+
+using namespace Transport;
+using namespace Common;
+using namespace std;
+
+namespace
+{
+    const StringLiteral TraceType("Fragments");
+}
+
+// shared by all fragments of a message, the last one released completes the original message
+struct OutgoingMessageFragments::SendState
+{
+    explicit SendState(MessageUPtr && message) : Message(move(message))
+    {
+    }
+
+    ~SendState()
+    {
+        Message->OnSendStatus(ErrorCode(FirstError.ReadValue()), move(Message));
+    }
+
+    MessageUPtr Message;
+    FirstErrorTracker FirstError;
+};
+
+OutgoingMessageFragments::OutgoingMessageFragments(
+    MessageUPtr && message,
+    uint64 fragmentedMessageId,
+    size_t fragmentSize,
+    TimeSpan expiration,
+    bool shouldEncrypt)
+    : fragmentedMessageId_(fragmentedMessageId)
+    , fragmentSize_(fragmentSize)
+    , expiration_(StopwatchTime::MaxValue)
+    , shouldEncrypt_(shouldEncrypt)
+    , bodySize_(message->SerializedBodySize())
+    , count_(static_cast<uint32>((bodySize_ + fragmentSize - 1) / fragmentSize))
+    , bytesRemaining_(static_cast<size_t>(bodySize_))
+{
+    if (expiration != TimeSpan::MaxValue)
+    {
+        auto now = Stopwatch::Now();
+        expiration_ = now + expiration;
+        if (expiration_ < now) // overflow?
+        {
+            expiration_ = StopwatchTime::MaxValue;
+        }
+    }
+
+    for (auto chunk = message->BeginBodyChunks(); chunk != message->EndBodyChunks(); ++chunk)
+    {
+        if (chunk->size() > 0)
+        {
+            body_.push_back(*chunk);
+        }
+    }
+
+    state_ = make_shared<SendState>(move(message));
+}
+
+OutgoingMessageFragments::~OutgoingMessageFragments()
+{
+    if (!IsEmpty())
+    {
+        Abandon(ErrorCodeValue::OperationCanceled);
+    }
+}
+
+bool OutgoingMessageFragments::ShouldFragment(Message & message, size_t fragmentSize)
+{
+    return (fragmentSize > 0) && (message.SerializedBodySize() > fragmentSize);
+}
+
+TimeSpan OutgoingMessageFragments::RemainingTime(StopwatchTime now) const
+{
+    if (expiration_ == StopwatchTime::MaxValue)
+    {
+        return TimeSpan::MaxValue;
+    }
+
+    return (expiration_ > now) ? (expiration_ - now) : TimeSpan::Zero;
+}
+
+void OutgoingMessageFragments::OnFragmentBodyDeleted(vector<const_buffer> const &, void * state)
+{
+    delete static_cast<shared_ptr<SendState>*>(state);
+}
+
+MessageUPtr OutgoingMessageFragments::TakeNext()
+{
+    Invariant(!IsEmpty());
+
+    vector<const_buffer> buffers;
+    size_t size = 0;
+    while ((size < fragmentSize_) && (nextChunk_ < body_.size()))
+    {
+        auto & chunk = body_[nextChunk_];
+        auto toTake = min(chunk.size(), fragmentSize_ - size);
+        buffers.emplace_back(chunk.cbegin(), toTake);
+        chunk += toTake;
+        size += toTake;
+
+        if (chunk.size() == 0)
+        {
+            ++nextChunk_;
+        }
+    }
+
+    bytesRemaining_ -= size;
+
+    auto fragment = make_unique<Message>(buffers, OnFragmentBodyDeleted, new shared_ptr<SendState>(state_));
+    if (nextIndex_ == 0)
+    {
+        auto clone = state_->Message->Clone();
+        fragment->Headers.AppendFrom(clone->Headers);
+    }
+
+    fragment->Headers.Add(MessageFragmentHeader(fragmentedMessageId_, nextIndex_, count_, bodySize_));
+
+    if (state_->Message->HasSendStatusCallback())
+    {
+        auto state = state_;
+        fragment->SetSendStatusCallback([state](ErrorCode const & error, MessageUPtr &&)
+        {
+            if (!error.IsSuccess())
+            {
+                state->FirstError.Update(error);
+            }
+        });
+    }
+
+    ++nextIndex_;
+    if (IsEmpty())
+    {
+        body_.clear();
+    }
+
+    return fragment;
+}
+
+void OutgoingMessageFragments::Abandon(ErrorCode const & error)
+{
+    if (IsEmpty())
+    {
+        return;
+    }
+
+    TcpConnection::WriteInfo(
+        TraceType,
+        "abandon fragments [{0}, {1}) of {2}: {3}",
+        nextIndex_, count_, fragmentedMessageId_, error);
+
+    state_->FirstError.Update(error);
+    nextIndex_ = count_;
+    bytesRemaining_ = 0;
+    body_.clear();
+}
+
+IncomingMessageFragments::IncomingMessageFragments(Message & firstFragment, MessageFragmentHeader const & header)
+    : fragmentedMessageId_(header.FragmentedMessageId)
+    , count_(header.Count)
+    , bodySize_(header.BodySize)
+    , chunkSize_(static_cast<size_t>(max<uint64>(min<uint64>(header.BodySize, MaxChunkSize), 1)))
+    , headers_(max<size_t>(firstFragment.SerializedHeaderSize(), 1))
+    , body_(chunkSize_)
+{
+    for (auto chunk = firstFragment.BeginHeaderChunks(); chunk != firstFragment.EndHeaderChunks(); ++chunk)
+    {
+        headers_.append(chunk->cbegin(), chunk->size());
+    }
+
+    // allocate the whole body up front, so that copying fragments never reallocates
+    body_.reserve_back(static_cast<size_t>(bodySize_));
+}
+
+bool IncomingMessageFragments::Add(Message & fragment, MessageFragmentHeader const & header)
+{
+    if ((header.FragmentedMessageId != fragmentedMessageId_) || (header.Index != nextIndex_) || IsComplete())
+    {
+        return false;
+    }
+
+    for (auto chunk = fragment.BeginBodyChunks(); chunk != fragment.EndBodyChunks(); ++chunk)
+    {
+        if ((bodyReceived_ + chunk->size()) > bodySize_)
+        {
+            return false;
+        }
+
+        body_.append(chunk->cbegin(), chunk->size());
+        bodyReceived_ += chunk->size();
+    }
+
+    ++nextIndex_;
+    return !IsComplete() || (bodyReceived_ == bodySize_);
+}
+
+MessageUPtr IncomingMessageFragments::TakeMessage(StopwatchTime recvTime)
+{
+    Invariant(IsComplete());
+
+    auto bodyBufferCount = static_cast<size_t>((bodySize_ + chunkSize_ - 1) / chunkSize_ + 1);
+    auto message = make_unique<Message>(
+        ByteBiqueRange(move(headers_)),
+        ByteBiqueRange(move(body_)),
+        recvTime,
+        bodyBufferCount);
+
+    message->Headers.TryRemoveHeader<MessageFragmentHeader>();
+    return message;
+}
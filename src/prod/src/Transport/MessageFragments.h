@@ -0,0 +1,96 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+namespace Transport
+{
+    // Splits the body of an outgoing message into fragments of at most fragmentSize bytes, see
+    // TransportConfig::MessageFragmentSize. Fragments are created one at a time, so that the
+    // caller decides how many of them are queued for sending at once. Fragments refer to the
+    // body buffers of the original message, which is kept alive until all fragments are
+    // released, its send status callback is then invoked with the first failure, if any.
+    class OutgoingMessageFragments
+    {
+        DENY_COPY(OutgoingMessageFragments);
+
+    public:
+        OutgoingMessageFragments(
+            MessageUPtr && message,
+            uint64 fragmentedMessageId,
+            size_t fragmentSize,
+            Common::TimeSpan expiration,
+            bool shouldEncrypt);
+
+        ~OutgoingMessageFragments();
+
+        static bool ShouldFragment(Message & message, size_t fragmentSize);
+
+        bool ShouldEncrypt() const { return shouldEncrypt_; }
+        bool IsEmpty() const { return nextIndex_ >= count_; }
+        size_t BytesRemaining() const { return bytesRemaining_; }
+        bool HasExpired(Common::StopwatchTime now) const { return expiration_ <= now; }
+        Common::TimeSpan RemainingTime(Common::StopwatchTime now) const;
+
+        MessageUPtr TakeNext();
+
+        // Drops fragments not yet taken, the original message fails with error
+        void Abandon(Common::ErrorCode const & error);
+
+    private:
+        struct SendState;
+
+        static void OnFragmentBodyDeleted(std::vector<Common::const_buffer> const &, void * state);
+
+        std::shared_ptr<SendState> state_;
+        uint64 const fragmentedMessageId_;
+        size_t const fragmentSize_;
+        Common::StopwatchTime expiration_;
+        bool const shouldEncrypt_;
+        uint64 const bodySize_;
+        uint32 const count_;
+        uint32 nextIndex_ = 0;
+        size_t bytesRemaining_;
+
+        // body chunks of the original message not yet taken, the first one may be partially taken
+        std::vector<Common::const_buffer> body_;
+        size_t nextChunk_ = 0;
+    };
+
+    // Reassembles fragments of an incoming message. It is created from fragment 0, which is then
+    // added like the rest of the fragments. The body is copied into buffers sized for the whole
+    // message up front, fragment messages are released as soon as their bodies are copied, so
+    // that receive buffers can be reused while reassembly is in progress.
+    class IncomingMessageFragments
+    {
+        DENY_COPY(IncomingMessageFragments);
+
+    public:
+        IncomingMessageFragments(Message & firstFragment, MessageFragmentHeader const & header);
+
+        uint64 FragmentedMessageId() const { return fragmentedMessageId_; }
+        uint32 ExpectedIndex() const { return nextIndex_; }
+        uint32 Count() const { return count_; }
+        bool IsComplete() const { return nextIndex_ >= count_; }
+
+        // returns false if the fragment does not follow the ones added so far or does not fit the body size
+        bool Add(Message & fragment, MessageFragmentHeader const & header);
+
+        MessageUPtr TakeMessage(Common::StopwatchTime recvTime);
+
+    private:
+        static size_t const MaxChunkSize = 1024 * 1024;
+
+        uint64 const fragmentedMessageId_;
+        uint32 const count_;
+        uint64 const bodySize_;
+        uint32 nextIndex_ = 0;
+        uint64 bodyReceived_ = 0;
+        size_t const chunkSize_;
+
+        ByteBique headers_;
+        ByteBique body_;
+    };
+}
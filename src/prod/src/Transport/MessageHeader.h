@@ -17,4 +17,12 @@ namespace Transport
     // Need to keep compiler happy on Linux
     template <MessageHeaderId::Enum id> const MessageHeaderId::Enum MessageHeader<id>::Id;
 #endif
+
+    // Specialized to std::true_type, next to the definition of a copyable header, for headers that are
+    // read repeatedly while a received message is processed, MessageHeaders::TryReadFirst() then keeps
+    // their decoded copy in the header index of the message.
+    template <class T>
+    struct CacheDecodedHeader : std::false_type
+    {
+    };
 }
@@ -119,6 +119,8 @@ namespace Transport
             case UpgradeComposeDeploymentRequest: w << "UpgradeComposeDeploymentRequest"; return;
             case CreateVolumeRequest: w << "CreateVolumeRequest"; return;
             case FileUploadCreateRequest: w << "FileUploadCreateRequest"; return;
+            case FederationPing: w << "FederationPing"; return;
+            case MessageFragment: w << "MessageFragment"; return;
 
             // Header IDs for tests follow this line.
             case Example: w << "Example"; return;
@@ -145,6 +145,8 @@ namespace Transport
             UpgradeComposeDeploymentRequest = 0x804d,
             CreateVolumeRequest = 0x804e,
             FileUploadCreateRequest = 0x804f,
+            FederationPing = 0x8050,
+            MessageFragment = 0x8051,
 
             // Add new internal message header ids must be explicitly defined
             // ----------------------------------------------------------------
@@ -24,6 +24,7 @@ Global<MessageHeaderTrace> MessageHeaderTrace::StaticInit()
     singleton->RegisterHeader<HighPriorityHeader>();
     singleton->RegisterHeader<IdempotentHeader>();
     singleton->RegisterHeader<IpcHeader>();
+    singleton->RegisterHeader<MessageFragmentHeader>();
     singleton->RegisterHeader<MessageIdHeader>();
     singleton->RegisterHeader<RelatesToHeader>();
     singleton->RegisterHeader<RequestInstanceHeader>();
@@ -26,7 +26,7 @@ MessageHeaders::MessageHeaders(ByteBiqueRange && shared, StopwatchTime recvTime)
     , recvTime_(recvTime)
 {
     CheckSize();
-    UpdateCommonHeaders();
+    UpdateCommonHeaders(true);
 }
 
 uint MessageHeaders::SerializedSize()
@@ -585,6 +585,7 @@ void MessageHeaders::HeaderReference::WriteTo(Common::TextWriter & w, Common::Fo
 
 void MessageHeaders::CheckPoint()
 {
+    InvalidateHeaderIndex();
     nonSharedHeaders_.insert(nonSharedHeaders_.begin(), sharedHeaders_.Begin, sharedHeaders_.End);
     sharedHeaders_ = std::move(ByteBiqueRange(std::move(nonSharedHeaders_)));
     checkpointDone_ = true;
@@ -627,6 +628,7 @@ void MessageHeaders::Compact()
 
     if (!this->IsValid) return;
 
+    InvalidateHeaderIndex();
     sharedHeaders_ = std::move(ByteBiqueRange(std::move(compacted)));
     nonSharedHeaders_.truncate_before(nonSharedHeaders_.end());
 
@@ -640,6 +642,8 @@ void MessageHeaders::AppendFrom(MessageHeaders & other)
     other.CheckPoint();
     other.deletedHeaderByteCount_ = 0; // all headers in "other" will be moved to "this"
 
+    other.InvalidateHeaderIndex();
+
     // Steal all shared headers from other into nonSharedHeaders_
     ByteBiqueRange localBiqueRange(std::move(other.sharedHeaders_));
     nonSharedHeaders_.insert(nonSharedHeaders_.begin(), localBiqueRange.Begin, localBiqueRange.End);
@@ -652,6 +656,7 @@ void MessageHeaders::AppendFrom(MessageHeaders & other)
 
 void MessageHeaders::SetShared(ByteBique & buffers, bool setCommonHeaders)
 {
+    InvalidateHeaderIndex();
     sharedHeaders_ = ByteBiqueRange(buffers.begin(), buffers.end(), true);
     CheckSize();
     if (setCommonHeaders)
@@ -671,6 +676,7 @@ void MessageHeaders::Replace(ByteBiqueRange && otherRange)
 
 void MessageHeaders::ReplaceUnsafe(ByteBiqueRange && headers)
 {
+    InvalidateHeaderIndex();
     sharedHeaders_ = std::move(ByteBiqueRange(std::move(headers)));
     nonSharedHeaders_.truncate_before(nonSharedHeaders_.end());
     CheckSize();
@@ -735,11 +741,17 @@ MessageHeaders::HeaderIterator& MessageHeaders::Remove(HeaderIterator& iter)
 
     this->deletedHeaderByteCount_ += iter->ByteTotalInStream();
 
+    if (headerIndexValid_ && iter.InFirstStream())
+    {
+        RemoveIndexedHeader(iter->Id(), iter->Start() - sharedHeaders_.Begin);
+    }
+
     return iter.Remove();
 }
 
 void MessageHeaders::RemoveAll()
 {
+    InvalidateHeaderIndex();
     sharedHeaders_ = ByteBiqueRange(EmptyByteBique.begin(), EmptyByteBique.end(), false);
     nonSharedHeaders_.truncate_before(nonSharedHeaders_.end());
 
@@ -762,14 +774,41 @@ void MessageHeaders::ResetCommonHeaders()
     isUncorrelatedReply_ = false;
 }
 
-NTSTATUS MessageHeaders::UpdateCommonHeaders()
+NTSTATUS MessageHeaders::UpdateCommonHeaders(bool buildHeaderIndex)
 {
+    if (buildHeaderIndex)
+    {
+        InvalidateHeaderIndex();
+        headerIndex_.reserve(16);
+        memset(headerSlots_, NoIndexedHeader, sizeof(headerSlots_));
+    }
+
     // Search for common headers
     // todo, consider moving this to HeaderReference.Deserialize<T> specilization.
     // we only need to do this when the requested common header is not already cached
     HeaderIterator iter = Begin();
     for ( ; this->IsValid && iter != End(); ++ iter)
     {
+        if (buildHeaderIndex && iter.InFirstStream() && IsIndexedHeaderId(iter->Id()))
+        {
+            if (headerIndex_.size() < NoIndexedHeader)
+            {
+                auto & slot = headerSlots_[iter->Id() - MessageHeaderId::INVALID_SYSTEM_HEADER_ID];
+                if (slot == NoIndexedHeader)
+                {
+                    slot = static_cast<byte>(headerIndex_.size());
+                }
+
+                headerIndex_.push_back(IndexedHeader{ iter->Id(), static_cast<size_t>(iter->Start() - sharedHeaders_.Begin), nullptr });
+            }
+            else
+            {
+                // too many headers to index, lookups walk the headers
+                buildHeaderIndex = false;
+                headerIndex_.clear();
+            }
+        }
+
         switch (iter->Id())
         {
         case MessageHeaderId::Action:
@@ -901,9 +940,81 @@ NTSTATUS MessageHeaders::UpdateCommonHeaders()
     if (!this->IsValid) return this->Status;
 
     this->deletedHeaderByteCount_ = iter.CurrentDeletedBytesCount();
+    headerIndexValid_ = headerIndexValid_ || buildHeaderIndex;
     return this->Status;
 }
 
+bool MessageHeaders::IsIndexedHeaderId(MessageHeaderId::Enum id)
+{
+    return (id > MessageHeaderId::INVALID_SYSTEM_HEADER_ID) && (id < MessageHeaderId::SYSTEM_HEADER_ID_END);
+}
+
+MessageHeaders::IndexedHeader * MessageHeaders::FindIndexedHeader(MessageHeaderId::Enum id)
+{
+    auto slot = headerSlots_[id - MessageHeaderId::INVALID_SYSTEM_HEADER_ID];
+    return (slot == NoIndexedHeader) ? nullptr : &headerIndex_[slot];
+}
+
+void MessageHeaders::RemoveIndexedHeader(MessageHeaderId::Enum id, size_t offset)
+{
+    if (!IsIndexedHeaderId(id))
+    {
+        return;
+    }
+
+    auto & slot = headerSlots_[id - MessageHeaderId::INVALID_SYSTEM_HEADER_ID];
+    if (slot == NoIndexedHeader)
+    {
+        return;
+    }
+
+    // entries are left in place to keep the positions in headerSlots_, a removed entry gets an invalid id
+    auto next = NoIndexedHeader;
+    for (size_t i = slot; i < headerIndex_.size(); ++ i)
+    {
+        auto & indexed = headerIndex_[i];
+        if (indexed.Id != id)
+        {
+            continue;
+        }
+
+        if (indexed.Offset == offset)
+        {
+            indexed.Id = MessageHeaderId::INVALID_SYSTEM_HEADER_ID;
+            indexed.Decoded.reset();
+        }
+        else if (next == NoIndexedHeader)
+        {
+            next = static_cast<byte>(i);
+        }
+    }
+
+    slot = next;
+}
+
+MessageHeaders::HeaderIterator MessageHeaders::GetIndexedHeaderIterator(IndexedHeader const & indexed)
+{
+    BiqueRangeStream first(sharedHeaders_.Begin + indexed.Offset, sharedHeaders_.End);
+    BiqueRangeStream second(nonSharedHeaders_.begin(), nonSharedHeaders_.end());
+    return HeaderIterator::Begin(first, second, *this);
+}
+
+bool MessageHeaders::IsIndexedHeaderAt(HeaderIterator & iter, IndexedHeader const & indexed)
+{
+    // removing a header through a clone marks the shared bytes as deleted, and iterator skips deleted headers
+    return
+        this->IsValid &&
+        iter.InFirstStream() &&
+        (iter->Id() == indexed.Id) &&
+        (iter->Start() == (sharedHeaders_.Begin + indexed.Offset));
+}
+
+void MessageHeaders::InvalidateHeaderIndex()
+{
+    headerIndexValid_ = false;
+    headerIndex_.clear();
+}
+
 void MessageHeaders::Test_SetOutgoingChunkSize(size_t value)
 {
     outgoingChunkSize_ = value;
@@ -949,6 +1060,25 @@ void MessageHeaders::CopyNonSharedHeadersFrom(const MessageHeaders & other)
 
 bool MessageHeaders::Contains(MessageHeaderId::Enum headerId)
 {
+    if (headerIndexValid_ && this->IsValid && IsIndexedHeaderId(headerId))
+    {
+        auto indexed = FindIndexedHeader(headerId);
+        if (indexed)
+        {
+            auto headerIter = GetIndexedHeaderIterator(*indexed);
+            if (IsIndexedHeaderAt(headerIter, *indexed))
+            {
+                return true;
+            }
+
+            InvalidateHeaderIndex();
+        }
+        else if (nonSharedHeaders_.empty())
+        {
+            return false;
+        }
+    }
+
 	for (auto headerIter = Begin(); this->IsValid && (headerIter != End()); ++headerIter)
 	{
 		if (headerIter->Id() == headerId)
@@ -290,7 +290,7 @@ namespace Transport
         void CheckPoint();
         void CopyFrom(const MessageHeaders & other);
         void CopyNonSharedHeadersFrom(const MessageHeaders & other);
-        NTSTATUS UpdateCommonHeaders();
+        NTSTATUS UpdateCommonHeaders(bool buildHeaderIndex = false);
         void ResetCommonHeaders();
         void RaiseSizeLimitForTracingUnsafe();
 
@@ -299,6 +299,33 @@ namespace Transport
 
         NTSTATUS FinalizeIdempotentHeader();
 
+        // Headers in sharedHeaders_ of a received message are indexed when the message is constructed,
+        // so that TryReadFirst() and Contains() find the first header of a system header id through
+        // headerSlots_ without walking and parsing the serialized headers. TryReadFirst() keeps the
+        // decoded copy of headers opted in with CacheDecodedHeader, so that they are deserialized at
+        // most once, other headers are deserialized on every read. Removing an indexed header drops
+        // its decoded copy, the whole index is dropped when sharedHeaders_ is replaced or rearranged,
+        // lookups then fall back to walking the headers.
+        struct IndexedHeader
+        {
+            MessageHeaderId::Enum Id;
+            size_t Offset; // from sharedHeaders_.Begin
+            std::shared_ptr<void const> Decoded;
+        };
+
+        static const size_t IndexedHeaderIdCount = MessageHeaderId::SYSTEM_HEADER_ID_END - MessageHeaderId::INVALID_SYSTEM_HEADER_ID;
+        static const byte NoIndexedHeader = 0xff;
+
+        static bool IsIndexedHeaderId(MessageHeaderId::Enum id);
+        IndexedHeader * FindIndexedHeader(MessageHeaderId::Enum id);
+        HeaderIterator GetIndexedHeaderIterator(IndexedHeader const & indexed);
+        bool IsIndexedHeaderAt(HeaderIterator & iter, IndexedHeader const & indexed);
+        void RemoveIndexedHeader(MessageHeaderId::Enum id, size_t offset);
+        void InvalidateHeaderIndex();
+
+        template <class T> static bool ReadIndexedHeader(HeaderIterator & iter, IndexedHeader & indexed, T & header, std::false_type);
+        template <class T> static bool ReadIndexedHeader(HeaderIterator & iter, IndexedHeader & indexed, T & header, std::true_type);
+
         static const size_t defaultOutgoingChunkSize_ = 1024;
         static size_t outgoingChunkSize_;
         static size_t MessageHeaders::compactThreshold_;
@@ -331,6 +358,10 @@ namespace Transport
 
         Common::StopwatchTime recvTime_ = NullReceiveTime();
 
+        std::vector<IndexedHeader> headerIndex_;
+        byte headerSlots_[IndexedHeaderIdCount]; // position in headerIndex_ of the first header of each id
+        bool headerIndexValid_ = false;
+
         friend class Message;
     };
 
@@ -491,6 +522,26 @@ namespace Transport
 
     template <class T> bool MessageHeaders::TryReadFirst(T& header)
     {
+        if (headerIndexValid_ && this->IsValid && IsIndexedHeaderId(T::Id))
+        {
+            auto indexed = FindIndexedHeader(T::Id);
+            if (indexed)
+            {
+                auto headerIter = GetIndexedHeaderIterator(*indexed);
+                if (IsIndexedHeaderAt(headerIter, *indexed))
+                {
+                    return ReadIndexedHeader(headerIter, *indexed, header, CacheDecodedHeader<T>());
+                }
+
+                // removed through another message sharing the buffers
+                InvalidateHeaderIndex();
+            }
+            else if (nonSharedHeaders_.empty())
+            {
+                return false;
+            }
+        }
+
         for(auto headerIter = Begin(); this->IsValid && (headerIter != End()); ++ headerIter)
         {
             if (headerIter->Id() == T::Id)
@@ -503,6 +554,29 @@ namespace Transport
         return false;
     }
 
+    template <class T> bool MessageHeaders::ReadIndexedHeader(HeaderIterator & iter, IndexedHeader &, T & header, std::false_type)
+    {
+        header = iter->Deserialize<T>();
+        return iter->IsValid;
+    }
+
+    template <class T> bool MessageHeaders::ReadIndexedHeader(HeaderIterator & iter, IndexedHeader & indexed, T & header, std::true_type)
+    {
+        if (!indexed.Decoded)
+        {
+            auto decoded = std::make_shared<T>(iter->Deserialize<T>());
+            if (!iter->IsValid)
+            {
+                return false;
+            }
+
+            indexed.Decoded = std::move(decoded);
+        }
+
+        header = *std::static_pointer_cast<T const>(indexed.Decoded);
+        return true;
+    }
+
     template <class THeader>
     void MessageHeaders::Replace(THeader const & header)
     {
@@ -23,13 +23,13 @@ namespace Transport
                 Common::PerformanceCounterType::RawData32,
                 "# of Active Callback",
                 "Counter for active threadpool callback")
-            COUNTER_DEFINITION(
+            SHARDED_COUNTER_DEFINITION(
                 2,
                 Common::PerformanceCounterType::AverageBase,
                 "Avg. TCP send size Base",
                 "Base Counter for measuring the average TCP send size in bytes",
                 noDisplay)
-            COUNTER_DEFINITION_WITH_BASE(
+            SHARDED_COUNTER_DEFINITION_WITH_BASE(
                 3,
                 2,
                 Common::PerformanceCounterType::AverageCount64,
@@ -38,17 +38,17 @@ namespace Transport
         END_COUNTER_SET_DEFINITION()
 
         DECLARE_COUNTER_INSTANCE(NumberOfActiveCallbacks)
-        DECLARE_COUNTER_INSTANCE(AverageTcpSendSizeBase)
-        DECLARE_COUNTER_INSTANCE(AverageTcpSendSize)
+        DECLARE_SHARDED_COUNTER_INSTANCE(AverageTcpSendSizeBase)
+        DECLARE_SHARDED_COUNTER_INSTANCE(AverageTcpSendSize)
 
         BEGIN_COUNTER_SET_INSTANCE(PerfCounters)
             DEFINE_COUNTER_INSTANCE(
                 NumberOfActiveCallbacks,
                 1)
-                DEFINE_COUNTER_INSTANCE(
+                DEFINE_SHARDED_COUNTER_INSTANCE(
                 AverageTcpSendSizeBase,
                 2)
-                DEFINE_COUNTER_INSTANCE(
+                DEFINE_SHARDED_COUNTER_INSTANCE(
                 AverageTcpSendSize,
                 3)
         END_COUNTER_SET_INSTANCE()
@@ -33,6 +33,14 @@ public:
     static void RunRecvBufferSizeTests(SecurityProvider::Enum secProvider);
     static void SetShouldQueueReceivedMessage(bool value);
 
+#ifdef PLATFORM_UNIX
+    static bool ShouldRunLocalIpcComparison() { return localIpc_; }
+    static void RunLocalIpcComparison();
+#endif
+
+    static bool ShouldRunMixedWorkload() { return mixedWorkload_; }
+    static void RunMixedWorkload();
+
 private:
     void StartListener();
     void StartClient();
@@ -40,6 +48,12 @@ private:
     void WaitForResult(FileWriter & sw);
     static void PrintUsageAndExit();
 
+#ifdef PLATFORM_UNIX
+    static void MeasureLocalIpc(string const & name, string const & listenAddress, uint messageSize, FileWriter & fw);
+#endif
+
+    static void MeasureMixedWorkload(uint bulkLaneCount, FileWriter & fw);
+
     IDatagramTransportSPtr listener_;
     SecurityProvider::Enum securityProvider_;
     atomic_uint64 recvCount_{0};
@@ -60,6 +74,8 @@ private:
     static uint messageSizeMin_;
     static uint messageSizeMax_;
     static bool shouldQueueReceivedMessage_;
+    static bool localIpc_;
+    static bool mixedWorkload_;
 
     static uint runCount_;
 };
@@ -95,6 +111,16 @@ static const uint messageCountMin = 30000;
 static const bool qrDefault = true;
 bool PerfTest::shouldQueueReceivedMessage_ = qrDefault;
 
+static const bool localIpcDefault = false;
+bool PerfTest::localIpc_ = localIpcDefault;
+static const uint localIpcRoundTripCount = 2000;
+
+static const bool mixedWorkloadDefault = false;
+bool PerfTest::mixedWorkload_ = mixedWorkloadDefault;
+static const uint mixedBulkMessageSize = 2 * 1024 * 1024;
+static const uint mixedControlMessageSize = 256;
+static const uint mixedBulkLaneCount = 2;
+
 uint PerfTest::runCount_ = 0;
 
 static const string clientExeName("Transport.PerfTest.Client.exe");
@@ -142,6 +168,24 @@ void main(int argc, char* argv[])
 
     PerfTest::ParseCmdline(argc, argv);
 
+#ifdef PLATFORM_UNIX
+    if (PerfTest::ShouldRunLocalIpcComparison())
+    {
+        PerfTest::RunLocalIpcComparison();
+        return 0;
+    }
+#endif
+
+    if (PerfTest::ShouldRunMixedWorkload())
+    {
+        PerfTest::RunMixedWorkload();
+#ifdef PLATFORM_UNIX
+        return 0;
+#else
+        return;
+#endif
+    }
+
     bool certs = !securityProviderSet || (securityProvider == SecurityProvider::Ssl);
     if (certs)
     {
@@ -405,6 +449,305 @@ void PerfTest::RunRecvBufferSizeTests(SecurityProvider::Enum secProvider)
     }
 }
 
+#ifdef PLATFORM_UNIX
+
+void PerfTest::RunLocalIpcComparison()
+{
+    vector<pair<string, string>> transports;
+    transports.emplace_back("tcp", "127.0.0.1:0");
+    transports.emplace_back("unix", formatString.L("unix:/tmp/TransportPerfTest-{0}.sock", ::GetCurrentProcessId()));
+
+    string outputFile("PerfTest-LocalIpc.csv");
+    console.WriteLine("=========================================================");
+    console.WriteLine("same host IPC: TCP loopback vs unix domain socket");
+    console.WriteLine("output = {0}", outputFile);
+    console.WriteLine("=========================================================");
+
+    FileWriter csvFile;
+    auto error = csvFile.TryOpen(outputFile);
+    Invariant(error.IsSuccess());
+    KFinally([&] { csvFile.Close(); });
+
+    csvFile.WriteLine("transport,message size,average round trip us,p99 round trip us,throughput mbps");
+    for (uint messageSize = messageSizeMin_; messageSize <= messageSizeMax_; messageSize *= 4)
+    {
+        for (auto const & transport : transports)
+        {
+            MeasureLocalIpc(transport.first, transport.second, messageSize, csvFile);
+        }
+
+        csvFile.Flush();
+    }
+}
+
+void PerfTest::MeasureLocalIpc(string const & name, string const & listenAddress, uint messageSize, FileWriter & fw)
+{
+    TransportConfig::GetConfig().TcpReceiveBufferSize = tcpBufferSizeMax_;
+
+    uint const messageCount = max(testDataSize_ / messageSize, messageCountMin);
+    string const echoAction("LocalIpcEcho");
+    TimeSpan const timeout = TimeSpan::FromMinutes(10);
+
+    atomic_uint64 receiveCount(0);
+    AutoResetEvent echoReceived;
+    ManualResetEvent allReceived;
+
+    auto listener = TcpDatagramTransport::Create(listenAddress);
+    auto listenerPtr = listener.get();
+    listener->SetMessageHandler([&, listenerPtr](MessageUPtr & msg, ISendTarget::SPtr const & st)
+    {
+        if (msg->Action == echoAction)
+        {
+            auto reply = make_unique<Message>();
+            reply->Headers.Add(ActionHeader(echoAction));
+            listenerPtr->SendOneWay(st, move(reply));
+            return;
+        }
+
+        if (++receiveCount == messageCount)
+        {
+            allReceived.Set();
+        }
+    });
+
+    Invariant(listener->Start().IsSuccess());
+
+    auto client = TcpDatagramTransport::CreateClient();
+    client->SetMessageHandler([&](MessageUPtr &, ISendTarget::SPtr const &) { echoReceived.Set(); });
+    Invariant(client->Start().IsSuccess());
+
+    auto target = client->ResolveTarget(listener->ListenAddress());
+
+    vector<char> buffer(messageSize);
+    vector<const_buffer> buffers;
+    buffers.push_back(const_buffer(buffer.data(), buffer.size()));
+
+    // latency: a single request in flight, the first round trip is excluded as it includes connection setup
+    vector<int64> roundTrips;
+    for (uint i = 0; i <= localIpcRoundTripCount; ++i)
+    {
+        auto msg = make_unique<Message>(buffers, [](vector<const_buffer> const &, void*) {}, nullptr);
+        msg->Headers.Add(ActionHeader(echoAction));
+
+        Stopwatch stopwatch;
+        stopwatch.Start();
+        Invariant(client->SendOneWay(target, move(msg)).IsSuccess());
+        Invariant(echoReceived.WaitOne(timeout));
+        stopwatch.Stop();
+
+        if (i > 0)
+        {
+            roundTrips.push_back(stopwatch.ElapsedMicroseconds);
+        }
+    }
+
+    sort(roundTrips.begin(), roundTrips.end());
+    double roundTripTotal = 0;
+    for (auto roundTrip : roundTrips)
+    {
+        roundTripTotal += roundTrip;
+    }
+
+    auto roundTripAverage = roundTripTotal / roundTrips.size();
+    auto roundTripP99 = roundTrips[roundTrips.size() * 99 / 100];
+
+    // throughput: one way messages as fast as the connection takes them
+    const uint64 sendThrottle = 64 * 1024 * 1024;
+    string const dataAction = TTestUtil::GetGuidAction();
+    Stopwatch stopwatch;
+    stopwatch.Start();
+    for (uint i = 0; i < messageCount; ++i)
+    {
+        auto msg = make_unique<Message>(buffers, [](vector<const_buffer> const &, void*) {}, nullptr);
+        msg->Headers.Add(ActionHeader(dataAction));
+        Invariant(client->SendOneWay(target, move(msg)).IsSuccess());
+
+        while (target->BytesPendingForSend() > sendThrottle)
+        {
+            this_thread::yield();
+        }
+    }
+
+    Invariant(allReceived.WaitOne(timeout));
+    stopwatch.Stop();
+
+    // bits per microsecond is mbps
+    auto throughput = (8.0 * messageSize * messageCount) / max<int64>(stopwatch.ElapsedMicroseconds, 1);
+
+    console.WriteLine(
+        ">>> {0}: message size = {1}, round trip average = {2} us, p99 = {3} us, throughput = {4} mbps",
+        name,
+        messageSize,
+        roundTripAverage,
+        roundTripP99,
+        throughput);
+
+    fw.WriteLine("{0},{1},{2},{3},{4}", name, messageSize, roundTripAverage, roundTripP99, throughput);
+
+    client->Stop();
+    listener->Stop();
+}
+
+#endif
+
+void PerfTest::RunMixedWorkload()
+{
+    string outputFile("PerfTest-MixedWorkload.csv");
+    console.WriteLine("=========================================================");
+    console.WriteLine("mixed workload: control round trips while bulk messages are in flight");
+    console.WriteLine("output = {0}", outputFile);
+    console.WriteLine("=========================================================");
+
+    FileWriter csvFile;
+    auto error = csvFile.TryOpen(outputFile);
+    Invariant(error.IsSuccess());
+    KFinally([&] { csvFile.Close(); });
+
+    csvFile.WriteLine("bulk lane count,control p50 ms,control p99 ms,control max ms,bulk throughput mbps");
+    for (uint bulkLaneCount : { 0u, mixedBulkLaneCount })
+    {
+        MeasureMixedWorkload(bulkLaneCount, csvFile);
+        csvFile.Flush();
+    }
+}
+
+void PerfTest::MeasureMixedWorkload(uint bulkLaneCount, FileWriter & fw)
+{
+    // send targets read lane settings on creation
+    auto savedBulkLaneCount = TransportConfig::GetConfig().BulkLaneConnectionCount;
+    TransportConfig::GetConfig().BulkLaneConnectionCount = bulkLaneCount;
+    KFinally([=] { TransportConfig::GetConfig().BulkLaneConnectionCount = savedBulkLaneCount; });
+
+    TransportConfig::GetConfig().TcpReceiveBufferSize = tcpBufferSizeMax_;
+
+    uint const bulkMessageCount = max<uint>(testDataSize_ / mixedBulkMessageSize, 16);
+    string const echoAction("MixedWorkloadEcho");
+    TimeSpan const timeout = TimeSpan::FromMinutes(10);
+
+    atomic_uint64 bulkReceiveCount(0);
+    AutoResetEvent echoReceived;
+    ManualResetEvent allReceived;
+
+    auto listener = TcpDatagramTransport::Create("127.0.0.1:0");
+    auto listenerPtr = listener.get();
+    listener->SetMessageHandler([&, listenerPtr](MessageUPtr & msg, ISendTarget::SPtr const & st)
+    {
+        if (msg->Action == echoAction)
+        {
+            auto reply = make_unique<Message>();
+            reply->Headers.Add(ActionHeader(echoAction));
+            listenerPtr->SendOneWay(st, move(reply));
+            return;
+        }
+
+        if (++bulkReceiveCount == bulkMessageCount)
+        {
+            allReceived.Set();
+        }
+    });
+
+    Invariant(listener->Start().IsSuccess());
+
+    auto client = TcpDatagramTransport::Create("127.0.0.1:0");
+    client->SetMessageHandler([&](MessageUPtr &, ISendTarget::SPtr const &) { echoReceived.Set(); });
+    Invariant(client->Start().IsSuccess());
+
+    auto target = client->ResolveTarget(listener->ListenAddress());
+    auto tcpTarget = dynamic_pointer_cast<TcpSendTarget>(target);
+    Invariant(tcpTarget);
+
+    vector<char> bulkBuffer(mixedBulkMessageSize);
+    vector<const_buffer> bulkBuffers;
+    bulkBuffers.push_back(const_buffer(bulkBuffer.data(), bulkBuffer.size()));
+
+    vector<char> controlBuffer(mixedControlMessageSize);
+    vector<const_buffer> controlBuffers;
+    controlBuffers.push_back(const_buffer(controlBuffer.data(), controlBuffer.size()));
+
+    auto sendControl = [&]
+    {
+        auto msg = make_unique<Message>(controlBuffers, [](vector<const_buffer> const &, void*) {}, nullptr);
+        msg->Headers.Add(ActionHeader(echoAction));
+        Invariant(client->SendOneWay(target, move(msg)).IsSuccess());
+        Invariant(echoReceived.WaitOne(timeout));
+    };
+
+    // connection setup is excluded
+    sendControl();
+
+    const uint64 sendThrottle = 64 * 1024 * 1024;
+    string const bulkAction = TTestUtil::GetGuidAction();
+    Common::atomic_bool bulkSendDone(false);
+    Stopwatch stopwatch;
+    stopwatch.Start();
+    Threadpool::Post([&]
+    {
+        for (uint i = 0; i < bulkMessageCount; ++i)
+        {
+            auto msg = make_unique<Message>(bulkBuffers, [](vector<const_buffer> const &, void*) {}, nullptr);
+            msg->Headers.Add(ActionHeader(bulkAction));
+            Invariant(client->SendOneWay(target, move(msg)).IsSuccess());
+
+            while (target->BytesPendingForSend() > sendThrottle)
+            {
+                this_thread::yield();
+            }
+        }
+
+        bulkSendDone.store(true);
+    });
+
+    // one control message in flight at a time for as long as bulk messages are being queued
+    LatencyHistogram controlRoundTrips;
+    vector<size_t> maxBytesPending(tcpTarget->LaneCount());
+    while (!bulkSendDone.load())
+    {
+        Stopwatch roundTrip;
+        roundTrip.Start();
+        sendControl();
+        roundTrip.Stop();
+        controlRoundTrips.Add(roundTrip.Elapsed);
+
+        for (uint lane = 0; lane < tcpTarget->LaneCount(); ++lane)
+        {
+            maxBytesPending[lane] = max(maxBytesPending[lane], tcpTarget->GetLaneStatistics(lane).BytesPendingForSend);
+        }
+    }
+
+    Invariant(allReceived.WaitOne(timeout));
+    stopwatch.Stop();
+
+    // bits per microsecond is mbps
+    auto throughput = (8.0 * mixedBulkMessageSize * bulkMessageCount) / max<int64>(stopwatch.ElapsedMicroseconds, 1);
+
+    console.WriteLine(
+        ">>> bulk lane count = {0}: control round trip: {1}; bulk throughput = {2} mbps",
+        bulkLaneCount,
+        controlRoundTrips,
+        throughput);
+
+    for (uint lane = 0; lane < tcpTarget->LaneCount(); ++lane)
+    {
+        console.WriteLine(
+            "    lane {0}: connections = {1}, max bytes pending = {2}, send latency: {3}",
+            lane,
+            tcpTarget->GetLaneStatistics(lane).ConnectionCount,
+            maxBytesPending[lane],
+            tcpTarget->LaneSendLatency(lane));
+    }
+
+    fw.WriteLine(
+        "{0},{1},{2},{3},{4}",
+        bulkLaneCount,
+        controlRoundTrips.Percentile(50).TotalMillisecondsAsDouble(),
+        controlRoundTrips.Percentile(99).TotalMillisecondsAsDouble(),
+        controlRoundTrips.Max().TotalMillisecondsAsDouble(),
+        throughput);
+
+    client->Stop();
+    listener->Stop();
+}
+
 TimeSpan PerfTest::GetTestDuration() const
 {
     return stopwatch_.Elapsed;
@@ -425,6 +768,8 @@ static const string mminArg = "-mmin";
 static const string mmaxArg = "-mmax";
 static const string qrArg = "-qr";
 static const string securityArg = "-security";
+static const string localIpcArg = "-localIpc";
+static const string mixedArg = "-mixed";
 
 void PerfTest::ParseCmdline(int argc, char* argv[])
 {
@@ -561,6 +906,26 @@ void PerfTest::ParseCmdline(int argc, char* argv[])
             continue;
         }
 
+        if (StringUtility::AreEqualCaseInsensitive(tokens.front(), localIpcArg))
+        {
+            if (!StringUtility::TryFromWString(tokens[1], localIpc_))
+            {
+                console.WriteLine("Failed to parse '{0}' as boolean", tokens[1]); 
+                PrintUsageAndExit();
+            }
+            continue;
+        }
+
+        if (StringUtility::AreEqualCaseInsensitive(tokens.front(), mixedArg))
+        {
+            if (!StringUtility::TryFromWString(tokens[1], mixedWorkload_))
+            {
+                console.WriteLine("Failed to parse '{0}' as boolean", tokens[1]); 
+                PrintUsageAndExit();
+            }
+            continue;
+        }
+
         if (StringUtility::AreEqualCaseInsensitive(tokens.front(), securityArg))
         {
             if (!SecurityProvider::FromCredentialType(tokens[1], securityProvider).IsSuccess())
@@ -619,6 +984,8 @@ void PerfTest::PrintUsageAndExit()
     console.WriteLine("{0}:maximal message size, default to {1}", mmaxArg, msizeMaxDefault);
     console.WriteLine("{0}:whether to queue received messages, default to {1}", qrArg, qrDefault);
     console.WriteLine("{0}:security provider, by default, all providers will be used", securityArg);
+    console.WriteLine("{0}:compare TCP loopback with unix domain socket in process (Linux only), default to {1}", localIpcArg, localIpcDefault);
+    console.WriteLine("{0}:measure control round trips under bulk load with and without bulk lanes, default to {1}", mixedArg, mixedWorkloadDefault);
 
     ::ExitProcess(1);
 }
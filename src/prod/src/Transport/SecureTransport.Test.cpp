@@ -32,6 +32,9 @@ namespace Transport
             std::string const & senderAddress,
             std::string const & receiverAddress);
 
+        // returns MB/s of message bodies sent over a secured loopback connection
+        double X509Throughput_SelfSigned(size_t messageBodySize, int messageCount);
+
         void BasicTestWin(
             SecurityProvider::Enum provider,
             std::string const & senderAddress,
@@ -1028,6 +1031,35 @@ namespace Transport
         LEAVE;
     }
 
+    BOOST_AUTO_TEST_CASE(KernelTlsOffloadTest)
+    {
+        ENTER;
+
+        auto saved = TransportConfig::GetConfig().KernelTlsOffloadEnabled;
+        KFinally([=] { TransportConfig::GetConfig().KernelTlsOffloadEnabled = saved; });
+
+        // message contents must be intact whether or not kernel TLS is available
+        TransportConfig::GetConfig().KernelTlsOffloadEnabled = true;
+        X509ManyMessage_SelfSigned("127.0.0.1:0", "127.0.0.1:0");
+
+        const size_t messageBodySize = 256 * 1024;
+        const int messageCount = 192;
+
+        TransportConfig::GetConfig().KernelTlsOffloadEnabled = false;
+        auto openSslThroughput = X509Throughput_SelfSigned(messageBodySize, messageCount);
+
+        TransportConfig::GetConfig().KernelTlsOffloadEnabled = true;
+        auto kernelTlsThroughput = X509Throughput_SelfSigned(messageBodySize, messageCount);
+
+        Trace.WriteInfo(
+            TraceType,
+            "encrypted throughput: OpenSSL records: {0} MB/s, kernel TLS records: {1} MB/s",
+            openSslThroughput,
+            kernelTlsThroughput);
+
+        LEAVE;
+    }
+
 #else
 
     BOOST_AUTO_TEST_CASE(ClaimsAuthTestsWithClientRoles)
@@ -3536,6 +3568,94 @@ namespace Transport
         ManyMessageTest(senderAddress, senderSecSettings, receiverAddress, receiverSecSettings);
     }
 
+    double SecureTransportTests::X509Throughput_SelfSigned(size_t messageBodySize, int messageCount)
+    {
+        const string senderCn = "sender.test.com";
+        const string receiverCn = "receiver.test.com";
+        InstallTestCertInScope senderCert("CN=" + senderCn);
+        InstallTestCertInScope receiverCert("CN=" + receiverCn);
+
+        SecuritySettings senderSecSettings = TTestUtil::CreateX509SettingsTp(
+            senderCert.Thumbprint()->PrimaryToString(),
+            "",
+            receiverCert.Thumbprint()->PrimaryToString(),
+            "");
+
+        SecuritySettings receiverSecSettings = TTestUtil::CreateX509SettingsTp(
+            receiverCert.Thumbprint()->PrimaryToString(),
+            "",
+            senderCert.Thumbprint()->PrimaryToString(),
+            "");
+
+        auto sender = DatagramTransportFactory::CreateTcp("127.0.0.1:0");
+        auto receiver = DatagramTransportFactory::CreateTcp("127.0.0.1:0");
+
+        VERIFY_IS_TRUE(sender->SetSecurity(senderSecSettings).IsSuccess());
+        VERIFY_IS_TRUE(receiver->SetSecurity(receiverSecSettings).IsSuccess());
+
+        auto action = TTestUtil::GetGuidAction();
+        auto body = make_shared<ByteBuffer>(messageBodySize);
+
+        // the first message completes connection setup and negotiation, it is excluded from timing
+        atomic_uint64 receiveCount(0);
+        Stopwatch stopwatch;
+        ManualResetEvent firstReceived(false);
+        ManualResetEvent allReceived(false);
+        TTestUtil::SetMessageHandler(
+            receiver,
+            action,
+            [&](MessageUPtr & message, ISendTarget::SPtr const &) -> void
+            {
+                VERIFY_ARE_EQUAL2(static_cast<size_t>(message->SerializedBodySize()), messageBodySize);
+
+                auto seq = ++receiveCount;
+                if (seq == 1)
+                {
+                    stopwatch.Start();
+                    firstReceived.Set();
+                }
+                else if (seq == static_cast<uint64>(messageCount) + 1)
+                {
+                    stopwatch.Stop();
+                    allReceived.Set();
+                }
+            });
+
+        VERIFY_IS_TRUE(sender->Start().IsSuccess());
+        VERIFY_IS_TRUE(receiver->Start().IsSuccess());
+
+        ISendTarget::SPtr target = sender->ResolveTarget(receiver->ListenAddress());
+        VERIFY_IS_TRUE(target);
+
+        auto send = [&]
+        {
+            vector<const_buffer> bufferList(1, const_buffer(body->data(), body->size()));
+            auto message = make_unique<Message>(bufferList, [body](vector<const_buffer> const &, void*) {}, nullptr);
+            message->Headers.Add(ActionHeader(action));
+            message->Headers.Add(MessageIdHeader());
+            sender->SendOneWay(target, move(message));
+        };
+
+        auto waitTime = TimeSpan::FromSeconds(60);
+        send();
+        VERIFY_IS_TRUE(firstReceived.WaitOne(waitTime));
+
+        for (int i = 0; i < messageCount; ++i)
+        {
+            send();
+        }
+
+        VERIFY_IS_TRUE(allReceived.WaitOne(waitTime));
+
+        sender->Stop();
+        receiver->Stop();
+
+        double megaBytes = static_cast<double>(messageBodySize) * messageCount / (1024 * 1024);
+        double throughput = megaBytes * 1000000 / max<int64>(stopwatch.ElapsedMicroseconds, 1);
+        Trace.WriteInfo(TraceType, "X509Throughput_SelfSigned: {0} MB in {1}, {2} MB/s", megaBytes, stopwatch.Elapsed, throughput);
+        return throughput;
+    }
+
     void SecureTransportTests::X509ManySmallMessage_SelfSigned(
         std::string const & senderAddress,
         std::string const & receiverAddress)
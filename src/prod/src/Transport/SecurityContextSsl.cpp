@@ -393,7 +393,47 @@ ErrorCode SecurityContextSsl::Encrypt(void const* buffer, size_t len)
 
 ByteBuffer2 SecurityContextSsl::EncryptFinal()
 {
-    return BioMemToByteBuffer2(outBio_);
+    auto encrypted = BioMemToByteBuffer2(outBio_);
+    sendRecords_.Add(encrypted.data(), encrypted.size());
+    return encrypted;
+}
+
+bool SecurityContextSsl::TryEnableKernelTlsSend(SOCKET socket)
+{
+    if (!kernelTlsSendPending_)
+    {
+        return kernelTlsSendEnabled_;
+    }
+
+    kernelTlsSendPending_ = false;
+
+    // TLS 1.2 Finished message is the first record under the negotiated keys,
+    // it is sent during negotiation and thus not counted in sendRecords_
+    Invariant(sendRecords_.AtRecordBoundary());
+    auto error = KernelTls::Enable(id_, socket, ssl_.get(), true, sendRecords_.RecordCount() + 1);
+    kernelTlsSendEnabled_ = error.IsSuccess();
+    return kernelTlsSendEnabled_;
+}
+
+bool SecurityContextSsl::TryEnableKernelTlsReceive(SOCKET socket)
+{
+    if (!kernelTlsReceivePending_)
+    {
+        return kernelTlsReceiveEnabled_;
+    }
+
+    // The kernel takes over from the next unread byte of the socket, which has
+    // to be the start of a record, and nothing must be left behind in OpenSSL
+    if (!receiveRecords_.AtRecordBoundary() || (BIO_ctrl_pending(inBio_) > 0) || (SSL_pending(ssl_.get()) > 0))
+    {
+        return false;
+    }
+
+    kernelTlsReceivePending_ = false;
+
+    auto error = KernelTls::Enable(id_, socket, ssl_.get(), false, receiveRecords_.RecordCount() + 1);
+    kernelTlsReceiveEnabled_ = error.IsSuccess();
+    return kernelTlsReceiveEnabled_;
 }
 
 SECURITY_STATUS SecurityContextSsl::DecodeMessage(MessageUPtr & message)
@@ -404,6 +444,14 @@ SECURITY_STATUS SecurityContextSsl::DecodeMessage(MessageUPtr & message)
 
 SECURITY_STATUS SecurityContextSsl::DecodeMessage(bique<byte> & receiveQueue, bique<byte> & decrypted)
 {
+    if (kernelTlsReceiveEnabled_)
+    {
+        // records are decrypted by the kernel, receiveQueue_ has plaintext only
+        decrypted.append(receiveQueue.begin(), receiveQueue.end());
+        receiveQueue.truncate_before(receiveQueue.end());
+        return SEC_E_OK;
+    }
+
     // prepare data for decryption
     size_t totalBufferUsed = receiveQueue.end() - receiveQueue.begin();
     auto iter = receiveQueue.begin();
@@ -471,6 +519,7 @@ SECURITY_STATUS SecurityContextSsl::DecodeMessage(bique<byte> & receiveQueue, bi
 void SecurityContextSsl::AddDataToDecrypt(void const* buffer, size_t len)
 {
     //LINUXTODO do we need to clean up inBio_ or SSL_read will clean up?
+    receiveRecords_.Add(buffer, len);
     auto written = BIO_write(inBio_, buffer, len);
     ASSERT_IFNOT(
         written == len,
@@ -547,6 +596,8 @@ void SecurityContextSsl::OnInitialize()
 
     SSL_set_bio(ssl_.get(), inBio_, outBio_);
 
+    kernelTlsSendPending_ = kernelTlsReceivePending_ = TransportConfig::GetConfig().KernelTlsOffloadEnabled;
+
     if (inbound_)
     {
         SSL_set_accept_state(ssl_.get());
@@ -57,6 +57,16 @@ namespace Transport
 #ifdef PLATFORM_UNIX
         Common::ErrorCode Encrypt(void const* buffer, size_t len);
         Common::ByteBuffer2 EncryptFinal();
+
+        // Hands record encryption/decryption of the given direction over to kernel TLS, returns
+        // whether records of that direction are now processed by the kernel. After a failed
+        // attempt, or when disabled by TransportConfig::KernelTlsOffloadEnabled, OpenSSL keeps
+        // processing the records and no further attempts are made.
+        bool TryEnableKernelTlsSend(SOCKET socket);
+        bool TryEnableKernelTlsReceive(SOCKET socket);
+
+        bool KernelTlsSendEnabled() const { return kernelTlsSendEnabled_; }
+        bool KernelTlsReceiveEnabled() const { return kernelTlsReceiveEnabled_; }
 #endif
 
         SECURITY_STATUS ProcessClaimsMessage(MessageUPtr & message) override;
@@ -152,6 +162,15 @@ namespace Transport
         BIO* outBio_ = nullptr;
         SslUPtr ssl_;
         Common::LinuxCryptUtil::CertChainErrors certChainErrors_;
+
+        // TLS records passed through OpenSSL after negotiation, to derive the
+        // record sequence numbers to continue with in kernel TLS
+        TlsRecordCounter sendRecords_;
+        TlsRecordCounter receiveRecords_;
+        bool kernelTlsSendPending_ = false;
+        bool kernelTlsSendEnabled_ = false;
+        bool kernelTlsReceivePending_ = false;
+        bool kernelTlsReceiveEnabled_ = false;
 #else
         ///
         /// Verifies whether the chain's trust status contains only allowed/non-fatal errors.
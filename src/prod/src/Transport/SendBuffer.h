@@ -25,6 +25,15 @@ namespace Transport
         virtual Common::ErrorCode Prepare() = 0;
         virtual void Consume(size_t length) = 0;
 
+        // Encode stage: queued messages that need encryption are encrypted outside TcpConnection::lock_,
+        // by one thread at a time, in queue order, and Prepare() only gathers the frames encrypted so far.
+        // All calls except EncodeTakenFrames() are made while holding TcpConnection::lock_.
+        virtual bool StartEncode() { return false; } // returns true if the caller should run the encode stage
+        virtual bool TakeFramesToEncode() { return false; }
+        virtual Common::ErrorCode EncodeTakenFrames() { return Common::ErrorCode(); }
+        virtual bool CompleteEncode(Common::ErrorCode const & error) { error; return false; } // returns false if encoding failed or the buffer was aborted meanwhile
+        virtual bool ContinueEncode() { return false; } // returns true if the encode stage should run again
+
         auto SentByteTotal() const { return sentByteTotal_; }
 
         void SetPerfCounters(PerfCountersSPtr const & perfCounters);
@@ -37,6 +46,8 @@ namespace Transport
 #endif
         void SetLimit(ULONG limitInBytes);
         ULONG BytesPendingForSend() const;
+        uint64 LimitInBytes() const { return limitInBytes_; }
+        uint64 BytesDelayedBySecurityNegotiation() const { return totalDelayedBytes_; }
         
         virtual bool PurgeExpiredMessages(Common::StopwatchTime now) = 0;
 
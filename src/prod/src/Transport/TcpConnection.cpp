@@ -61,6 +61,7 @@ _Use_decl_annotations_ ErrorCode TcpConnection::Create(
     TransportSecuritySPtr const & transportSecurity,
     string const & sspiTarget,
     TransportPriority::Enum priority,
+    uint lane,
     TransportFlags const & flags,
     Common::TimeSpan openTimeout,
     TcpConnectionSPtr & tcpConnection)
@@ -72,7 +73,7 @@ _Use_decl_annotations_ ErrorCode TcpConnection::Create(
     }
 
     Invariant(*msgHandlerSPtr);
-    tcpConnection = make_shared<TcpConnection>(owner, *msgHandlerSPtr, priority, flags, openTimeout, acceptedSocket);
+    tcpConnection = make_shared<TcpConnection>(owner, *msgHandlerSPtr, priority, lane, flags, openTimeout, acceptedSocket);
     if (!tcpConnection->Initialize(transport, tcpConnection, transportSecurity, sspiTarget))
     {
         tcpConnection->AbortWithRetryableError();
@@ -108,6 +109,7 @@ _Use_decl_annotations_ TcpConnection::TcpConnection(
     TcpSendTargetSPtr const & target, 
     IDatagramTransport::MessageHandler const & msgHandler,
     TransportPriority::Enum priority,
+    uint lane,
     TransportFlags const & flags,
     TimeSpan openTimeout,
     Socket* acceptedSocket)
@@ -116,6 +118,7 @@ _Use_decl_annotations_ TcpConnection::TcpConnection(
     , externalMessageHandler_(msgHandler)
     , transportWPtr_(target->OwnerWPtr())
     , priority_(priority)
+    , lane_(lane)
     , flags_(flags)
     , openTimeout_(openTimeout)
     , traceId_(formatString.L("{0:x}", TextTracePtrAs(this, IConnection)))
@@ -139,6 +142,8 @@ _Use_decl_annotations_ TcpConnection::TcpConnection(
     , testAssertEnabled_(target->Security()->SecurityProvider == SecurityProvider::None)
     , maxIncomingFrameSizeInBytes_(ToInternalFrameSizeLimit(target->Security()->MaxIncomingFrameSize()))
     , lastReceiveCompleteTime_(Message::NullReceiveTime())
+    , lockFreeSendQueueEnabled_(TransportConfig::GetConfig().LockFreeSendQueueEnabled)
+    , messageFragmentSize_(TransportConfig::GetConfig().MessageFragmentSize)
 {
     TrySetOutgoingFrameSizeLimit(ToInternalFrameSizeLimit(target->Security()->MaxOutgoingFrameSize()), true);
 
@@ -171,6 +176,16 @@ _Use_decl_annotations_ TcpConnection::TcpConnection(
 
 TcpConnection::~TcpConnection()
 {
+    // every sender either drains or leaves the queue to the current drainer, and close drains it as
+    // well, so nothing should be left; if anything is, it still gets a failure status
+    for (auto queued = queuedSends_; queued; )
+    {
+        unique_ptr<QueuedSend> current(queued);
+        queued = current->Next;
+
+        current->Message->OnSendStatus(ErrorCodeValue::OperationCanceled, move(current->Message));
+    }
+
    if (inbound_)
     {
         auto incomingRemained = AcceptThrottle::GetThrottle()->OnConnectionDestructed(this, groupId_);
@@ -262,7 +277,7 @@ bool TcpConnection::FinishSocketInit()
         "FinishSocketInit: local message size limits:(incoming={0}/0x{0:x}, outgoing={1}/0x{1:x}), TcpNoDelayEnabled = {2}",
         maxIncomingFrameSizeInBytes_, maxOutgoingFrameSizeInBytes_, tcpNoDelayEnabled);
 
-    if (tcpNoDelayEnabled)
+    if (tcpNoDelayEnabled && !remoteEndpoint_.IsUnixDomain())
     {
         auto error = socket_.SetSocketOption(IPPROTO_TCP, TCP_NODELAY, 1);
         if (!error.IsSuccess())
@@ -562,9 +577,179 @@ ErrorCode TcpConnection::SendOneWay(MessageUPtr && message, TimeSpan expiration)
         return ErrorCode::FromNtStatus(status);
     }
 
+    if (lockFreeSendQueueEnabled_)
+    {
+        return QueueSend(move(message), expiration, securityContext_ != nullptr);
+    }
+
     return Send(move(message), expiration, securityContext_ != nullptr);
 }
 
+ErrorCode TcpConnection::QueueSend(MessageUPtr && message, TimeSpan expiration, bool shouldEncrypt)
+{
+    if (!CanSend())
+    {
+        // take the locked path to report the failure synchronously
+        return Send(move(message), expiration, shouldEncrypt);
+    }
+
+    // the message stays pending until it is moved into sendBuffer_, so that close draining waits for it
+    ++pendingSend_;
+
+    auto sequence = ++queuedSendSequence_;
+    auto queued = new QueuedSend{ move(message), expiration, shouldEncrypt, sequence, nullptr };
+    auto head = queuedSends_;
+    for (;;)
+    {
+        queued->Next = head;
+        auto previous = (QueuedSend*)InterlockedCompareExchangePointer((PVOID volatile*)&queuedSends_, queued, head);
+        if (previous == head)
+        {
+            break;
+        }
+
+        head = previous;
+    }
+
+    return DrainQueuedSends(sequence);
+}
+
+ErrorCode TcpConnection::DrainQueuedSends(uint64 ownSequence)
+{
+    // Only one sender at a time takes lock_ to move the queued messages into sendBuffer_ and start
+    // sending, the others return right after queuing. The queue is checked again after giving up
+    // the drain role, in case a message was queued after the last take but before the role was
+    // given up, when the sender of that message found the role still taken.
+    //
+    // A sender that drains its own message gets the result of sending it, the same as from Send,
+    // a sender whose message is drained by another sender gets the result through OnSendStatus.
+    ErrorCode error;
+    while (queuedSends_ != nullptr)
+    {
+        if (sendDraining_.exchange(true))
+        {
+            return error;
+        }
+
+        auto taken = (QueuedSend*)InterlockedExchangePointer((PVOID volatile*)&queuedSends_, nullptr);
+
+        // reverse into the order messages were queued
+        QueuedSend* queued = nullptr;
+        while (taken)
+        {
+            auto next = taken->Next;
+            taken->Next = queued;
+            queued = taken;
+            taken = next;
+        }
+
+        if (queued)
+        {
+            auto sendError = Send(nullptr, TimeSpan::MaxValue, false, TcpConnectionState::None, queued, ownSequence);
+            if (error.IsSuccess())
+            {
+                error = sendError;
+            }
+        }
+
+        sendDraining_.store(false);
+    }
+
+    return error;
+}
+
+ErrorCode TcpConnection::EnqueueMessageChl(MessageUPtr && message, TimeSpan expiration, bool shouldEncrypt)
+{
+    // messages over the frame size limit are left to the send buffer to fail as before
+    if (!OutgoingMessageFragments::ShouldFragment(*message, messageFragmentSize_) ||
+        !IsOutgoingFrameSizeWithinLimit(message->SerializedSize()))
+    {
+        return sendBuffer_->EnqueueMessage(move(message), expiration, shouldEncrypt);
+    }
+
+    // fragments not yet moved into sendBuffer_ count toward the send queue limit
+    uint64 bytesPending = sendBuffer_->BytesPendingForSend() + fragmentBytesPending_;
+    if (((bytesPending + message->SerializedSize()) > sendBuffer_->LimitInBytes()) &&
+        (!OutgoingFrameSizeLimitDisabled() || (bytesPending > 0)))
+    {
+        trace.SendQueueFull(
+            traceId_,
+            localAddress_,
+            targetAddress_,
+            sendBuffer_->MessageCount() + outgoingFragments_.size(),
+            bytesPending,
+            sendBuffer_->LimitInBytes(),
+            message->TraceId(),
+            message->SerializedSize(),
+            message->Actor,
+            message->Action);
+
+        message->OnSendStatus(ErrorCodeValue::TransportSendQueueFull, move(message));
+        return ErrorCodeValue::TransportSendQueueFull;
+    }
+
+    WriteNoise(
+        TraceType, traceId_,
+        "sending message {0} as fragments, body size = {1}",
+        message->TraceId(), message->SerializedBodySize());
+
+    auto fragments = make_unique<OutgoingMessageFragments>(
+        move(message),
+        ++fragmentedMessageCount_,
+        messageFragmentSize_,
+        expiration,
+        shouldEncrypt);
+
+    fragmentBytesPending_ += fragments->BytesRemaining();
+    outgoingFragments_.push(move(fragments));
+    return ErrorCode();
+}
+
+void TcpConnection::EnqueueFragmentsChl()
+{
+    // fragments are moved into sendBuffer_ only when it runs low, so that messages enqueued later
+    // are sent between fragments and only about one fragment per connection is held in sendBuffer_
+    auto now = Stopwatch::Now();
+    while (!outgoingFragments_.empty() &&
+        ((sendBuffer_->BytesPendingForSend() + sendBuffer_->BytesDelayedBySecurityNegotiation()) < messageFragmentSize_))
+    {
+        auto & fragments = *outgoingFragments_.front();
+        auto bytesBefore = fragments.BytesRemaining();
+
+        if (fragments.HasExpired(now))
+        {
+            fragments.Abandon(ErrorCodeValue::MessageExpired);
+        }
+        else
+        {
+            auto shouldEncrypt = fragments.ShouldEncrypt();
+            auto error = sendBuffer_->EnqueueMessage(fragments.TakeNext(), fragments.RemainingTime(now), shouldEncrypt);
+            if (!error.IsSuccess())
+            {
+                // the failed fragment has already reported the error, the rest are useless to the receiver
+                fragments.Abandon(error);
+            }
+        }
+
+        fragmentBytesPending_ -= (bytesBefore - fragments.BytesRemaining());
+        if (fragments.IsEmpty())
+        {
+            outgoingFragments_.pop();
+        }
+    }
+}
+
+void TcpConnection::AbandonFragmentsChl(ErrorCode const & error)
+{
+    while (!outgoingFragments_.empty())
+    {
+        outgoingFragments_.front()->Abandon(error);
+        outgoingFragments_.pop();
+    }
+
+    fragmentBytesPending_ = 0;
+}
+
 bool TcpConnection::Open()
 {
     MessageUPtr negoMessageToSend = nullptr;
@@ -685,7 +870,7 @@ bool TcpConnection::CompletedAllSending_CallerHoldingLock() const
         "send status: sendBuffer_->Empty() = {0}, pending send= {1}",
         sendBuffer_->Empty(), pendingSend_.load());
 
-    return sendBuffer_->Empty() && (pendingSend_.load() == 0);
+    return sendBuffer_->Empty() && outgoingFragments_.empty() && (pendingSend_.load() == 0);
 }
 
 void TcpConnection::AbortWithRetryableError()
@@ -713,7 +898,7 @@ void TcpConnection::Close_CallerHoldingLock(bool abort, ErrorCode const & fault)
         return;
     }
 
-    if ((state_ == TcpConnectionState::CloseDraining) && !(sendBuffer_->Empty() && receiveDrained_))
+    if ((state_ == TcpConnectionState::CloseDraining) && !(sendBuffer_->Empty() && outgoingFragments_.empty() && receiveDrained_))
     {
         return;
     }
@@ -901,18 +1086,27 @@ void TcpConnection::UpdateInstance(ListenInstance const & remoteListenInstance)
     trace.ConnectionInstanceConfirmed(traceId_, currentInstance, remoteListenInstance);
 }
 
+void TcpConnection::RecordSendLatencyChl(TimeSpan latency)
+{
+    if (tcpTarget_)
+    {
+        tcpTarget_->RecordLaneSendLatency(lane_, latency);
+    }
+}
+
 string TcpConnection::ToStringChl() const
 {
     string result;
     StringWriter(result).Write(
-        "{0}: ({1}-{2}, Passive={3}, Instance={4}, Confirmed={5}, Nonce={6})",
+        "{0}: ({1}-{2}, Passive={3}, Instance={4}, Confirmed={5}, Nonce={6}, Lane={7})",
         traceId_, 
         localAddress_,
         targetAddress_,
         inbound_,
         instance_,
         instanceConfirmed_,
-        listenSideNonce_);
+        listenSideNonce_,
+        lane_);
 
     return result;
 }
@@ -981,8 +1175,17 @@ bool TcpConnection::Validate(uint64 instanceLowerBound, Common::StopwatchTime no
 
 void TcpConnection::CloseInternal(bool abort, ErrorCode const & fault)
 {
-    AcquireWriteLock grab(lock_);
-    Close_CallerHoldingLock(abort, fault);
+    {
+        AcquireWriteLock grab(lock_);
+        Close_CallerHoldingLock(abort, fault);
+    }
+
+    if (lockFreeSendQueueEnabled_)
+    {
+        // messages queued while closing are failed through Send now, instead of waiting for the
+        // next sender to drain them
+        DrainQueuedSends(0).ReadValue();
+    }
 }
 
 string const & TcpConnection::TraceId() const
@@ -1040,6 +1243,7 @@ void TcpConnection::ScheduleCleanup_CallerHoldingLock()
 
                 // This must be called under lock as outgoing message purging timer may be active
                 tcpConnectionSPtr->sendBuffer_->Abort();
+                tcpConnectionSPtr->AbandonFragmentsChl(fault.IsSuccess() ? ErrorCodeValue::OperationCanceled : fault);
 
                 tcpSendTarget = move(tcpConnectionSPtr->tcpTarget_);
                 tcpConnectionSPtr->target_ = nullptr;
@@ -1622,11 +1826,26 @@ void TcpConnection::ConnectComplete(ErrorCode const & error)
     SubmitConnect();
 }
 
-ErrorCode TcpConnection::Send(MessageUPtr && message, TimeSpan expiration, bool shouldEncrypt, TcpConnectionState::Enum newState)
+ErrorCode TcpConnection::Send(MessageUPtr && message, TimeSpan expiration, bool shouldEncrypt, TcpConnectionState::Enum newState, QueuedSend* queued, uint64 ownSequence)
 {
     ErrorCode errorCode;
+    ErrorCode ownError;
+    bool const drainingQueue = (queued != nullptr);
     bool shouldConnect = false;
     bool shouldSend = false;
+    bool shouldEncode = false;
+
+    Invariant(!message || !queued);
+
+    // encryption runs after lock_ is released, including on the early returns below
+    KFinally([&]
+    {
+        if (shouldEncode)
+        {
+            EncodeQueuedMessages();
+        }
+    });
+
     {
         AcquireWriteLock grab(lock_);
 
@@ -1645,6 +1864,30 @@ ErrorCode TcpConnection::Send(MessageUPtr && message, TimeSpan expiration, bool
                 errorCode = fault_;
             }
 
+            while (queued)
+            {
+                unique_ptr<QueuedSend> current(queued);
+                queued = current->Next;
+
+                trace.Msg_InvalidStateForSend(
+                    traceId_,
+                    localAddress_,
+                    targetAddress_,
+                    state_,
+                    fault_,
+                    current->Message->TraceId(),
+                    current->Message->Actor,
+                    current->Message->Action);
+
+                if (current->Sequence == ownSequence)
+                {
+                    ownError = errorCode;
+                }
+
+                current->Message->OnSendStatus(errorCode, move(current->Message));
+                --pendingSend_;
+            }
+
             if (message)
             {
                 trace.Msg_InvalidStateForSend(
@@ -1669,7 +1912,8 @@ ErrorCode TcpConnection::Send(MessageUPtr && message, TimeSpan expiration, bool
                     fault_);
             }
 
-            return errorCode;
+            // a drainer only reports the failure of its own message, others learn it from OnSendStatus
+            return drainingQueue ? ownError : errorCode;
         }
 
         if (newState != TcpConnectionState::None)
@@ -1679,13 +1923,39 @@ ErrorCode TcpConnection::Send(MessageUPtr && message, TimeSpan expiration, bool
 
         if (message)
         {
-            errorCode = sendBuffer_->EnqueueMessage(std::move(message), expiration, shouldEncrypt);
+            errorCode = EnqueueMessageChl(std::move(message), expiration, shouldEncrypt);
             if (!errorCode.IsSuccess())
             {
                 return errorCode;
             }
         }
 
+        while (queued)
+        {
+            unique_ptr<QueuedSend> current(queued);
+            queued = current->Next;
+
+            // failures are reported to the message by EnqueueMessage, only the drainer's own message has a caller waiting for the result
+            auto error = EnqueueMessageChl(move(current->Message), current->Expiration, current->ShouldEncrypt);
+            if (current->Sequence == ownSequence)
+            {
+                errorCode = error;
+            }
+            else
+            {
+                error.ReadValue();
+            }
+
+            --pendingSend_;
+        }
+
+        EnqueueFragmentsChl();
+
+        if ((state_ == TcpConnectionState::Connected) || (state_ == TcpConnectionState::CloseDraining))
+        {
+            shouldEncode = sendBuffer_->StartEncode();
+        }
+
         if (sendActive_ || sendBuffer_->Empty())
         {
             return errorCode;
@@ -1733,6 +2003,51 @@ ErrorCode TcpConnection::Send(MessageUPtr && message, TimeSpan expiration, bool
     return errorCode;
 }
 
+void TcpConnection::EncodeQueuedMessages()
+{
+    // Only one thread runs the encode stage of a connection at a time, as records have to be
+    // encrypted in the order of frames in the send queue, while other threads keep enqueuing
+    // and sending what is already encrypted.
+    {
+        AcquireWriteLock grab(lock_);
+        if (!sendBuffer_->TakeFramesToEncode())
+        {
+            return;
+        }
+    }
+
+    auto error = sendBuffer_->EncodeTakenFrames();
+
+    {
+        AcquireWriteLock grab(lock_);
+        if (!sendBuffer_->CompleteEncode(error))
+        {
+            if (!error.IsSuccess())
+            {
+                WriteWarning(TraceType, traceId_, "{0}-{1} failed to encode messages: {2}", localAddress_, targetAddress_, error);
+                Close_CallerHoldingLock(true, error);
+            }
+
+            return;
+        }
+    }
+
+    Send(nullptr, TimeSpan::MaxValue, false);
+
+    bool moreToEncode = false;
+    {
+        AcquireWriteLock grab(lock_);
+        moreToEncode = sendBuffer_->ContinueEncode();
+    }
+
+    if (moreToEncode)
+    {
+        // continue on a threadpool thread instead of keeping the enqueuing thread busy for other senders
+        auto thisSPtr = shared_from_this();
+        Threadpool::Post([thisSPtr] { thisSPtr->EncodeQueuedMessages(); });
+    }
+}
+
 void TcpConnection::SendComplete(ErrorCode const & error, ULONG_PTR bytesTransferred)
 {
     // Upon overlapped IO completion, WSASend either has sent all the bytes successfully, or a failure
@@ -1809,7 +2124,7 @@ bool TcpConnection::IsIncomingFrameSizeWithinLimit(size_t frameSize) const
 
 ULONG TcpConnection::BytesPendingForSend() const
 {
-    return sendBuffer_->BytesPendingForSend();
+    return sendBuffer_->BytesPendingForSend() + static_cast<ULONG>(fragmentBytesPending_);
 }
 
 size_t TcpConnection::MessagesPendingForSend() const
@@ -2114,8 +2429,78 @@ void TcpConnection::OnUnsecuredMessageReceived(MessageUPtr && message)
     DispatchIncomingMessages(move(message));
 }
 
+bool TcpConnection::TryReassembleFragment(MessageUPtr & message)
+{
+    MessageFragmentHeader header;
+    if (!message->Headers.TryReadFirst(header))
+    {
+        return true;
+    }
+
+    if (header.Index == 0)
+    {
+        if (incomingFragments_)
+        {
+            WriteWarning(
+                TraceType, traceId_,
+                "dropping incomplete fragmented message {0}, {1}/{2} fragments received",
+                incomingFragments_->FragmentedMessageId(),
+                incomingFragments_->ExpectedIndex(),
+                incomingFragments_->Count());
+        }
+
+        incomingFragments_.reset();
+
+        if (!IsIncomingFrameSizeWithinLimit(message->SerializedHeaderSize() + header.BodySize))
+        {
+            WriteError(
+                TraceType, traceId_,
+                "{0}-{1} fragmented message {2} exceeds incoming frame size limit {3}: {4}",
+                localAddress_, targetAddress_, message->TraceId(), maxIncomingFrameSizeInBytes_, header);
+
+            Abort(ErrorCodeValue::MessageTooLarge);
+            return false;
+        }
+
+        incomingFragments_ = make_unique<IncomingMessageFragments>(*message, header);
+    }
+
+    if (!incomingFragments_ || !incomingFragments_->Add(*message, header))
+    {
+        WriteWarning(
+            TraceType, traceId_,
+            "dropping unexpected fragment {0}, expected fragment {1} of {2}",
+            header,
+            incomingFragments_ ? incomingFragments_->ExpectedIndex() : 0,
+            incomingFragments_ ? incomingFragments_->FragmentedMessageId() : 0);
+
+        incomingFragments_.reset();
+        return false;
+    }
+
+    if (!incomingFragments_->IsComplete())
+    {
+        return false;
+    }
+
+    message = incomingFragments_->TakeMessage(message->ReceiveTime());
+    incomingFragments_.reset();
+
+    if (securityContext_ && inbound_)
+    {
+        message->SetSecurityContext(securityContext_.get());
+    }
+
+    return true;
+}
+
 void TcpConnection::DispatchIncomingMessages(MessageUPtr && message)
 {
+    if (!TryReassembleFragment(message))
+    {
+        return;
+    }
+
     RecordMessageDispatching(message);
 
     if (shouldTracePerMessage_ && !IDatagramTransport::IsPerMessageTraceDisabled(message->Actor))
@@ -2240,7 +2625,12 @@ bool TcpConnection::PrepareConnect_CallerHoldingLock(Endpoint & sockName, ErrorC
     trace.BeginConnect(traceId_, localAddress_, targetAddress_, connectToAddress_);
 
     Endpoint const * connectFrom = &::IPv4AnyAddress;
-    if (!remoteEndpoint_.IsIPv4())
+    if (remoteEndpoint_.IsUnixDomain())
+    {
+        // only the address family is used, connecting side of unix domain socket stays unnamed
+        connectFrom = &remoteEndpoint_;
+    }
+    else if (!remoteEndpoint_.IsIPv4())
     {
         ASSERT_IFNOT(remoteEndpoint_.IsIPv6(), "unexpected Endpoint type");
         connectFrom = &::IPv6AnyAddress;
@@ -2269,14 +2659,17 @@ bool TcpConnection::PrepareConnect_CallerHoldingLock(Endpoint & sockName, ErrorC
         return false;
     }
 
-    error = socket_.Bind(*connectFrom);
-    if (!error.IsSuccess())
+    if (!remoteEndpoint_.IsUnixDomain())
     {
-        WriteError(
-            TraceType, traceId_,
-            "{0}-{1} failed to bind to local port for connecting: {2}",
-            localAddress_, targetAddress_, error);
-        return false;
+        error = socket_.Bind(*connectFrom);
+        if (!error.IsSuccess())
+        {
+            WriteError(
+                TraceType, traceId_,
+                "{0}-{1} failed to bind to local port for connecting: {2}",
+                localAddress_, targetAddress_, error);
+            return false;
+        }
     }
 
     error = Endpoint::GetSockName(socket_, sockName);
@@ -35,6 +35,7 @@ namespace Transport
             TransportSecuritySPtr const & transportSecurity,
             std::string const & sspiTarget,
             TransportPriority::Enum,
+            uint lane,
             TransportFlags const &,
             Common::TimeSpan openTimeout,
             _Out_ TcpConnectionSPtr & tcpConnection);
@@ -43,6 +44,7 @@ namespace Transport
             TcpSendTargetSPtr const & owner,
             IDatagramTransport::MessageHandler const & msgHandler,
             TransportPriority::Enum,
+            uint lane,
             TransportFlags const &,
             Common::TimeSpan openTimeout,
             _Inout_ Common::Socket* acceptedSocket);
@@ -53,6 +55,7 @@ namespace Transport
         IConnectionWPtr GetWPtr() override;
 
         TransportPriority::Enum GetPriority() const { return priority_; }
+        uint GetLane() const override { return lane_; }
 
         TransportFlags & GetTransportFlags() { return flags_; }
 
@@ -151,19 +154,39 @@ namespace Transport
         bool IsIdleTooLongChl(Common::StopwatchTime now) const;
         bool IsSendStuck(Common::StopwatchTime now) const;
         void CheckReceiveMissing_CallerHoldingLock(Common::StopwatchTime now);
+        void RecordSendLatencyChl(Common::TimeSpan latency);
 
         void CloseInternal(bool abort, Common::ErrorCode const & fault);
         void Close_CallerHoldingLock(bool abort, Common::ErrorCode const & fault);
         Common::ErrorCode Fault_CallerHoldingLock(Common::ErrorCode const & fault);
         void ScheduleCleanup_CallerHoldingLock();
 
+        // a message queued by SendOneWay without taking lock_
+        struct QueuedSend
+        {
+            MessageUPtr Message;
+            Common::TimeSpan Expiration;
+            bool ShouldEncrypt;
+            uint64 Sequence;
+            QueuedSend* Next;
+        };
+
         void SubmitSend();
+        void EncodeQueuedMessages();
         void SendComplete(Common::ErrorCode const & result, ULONG_PTR bytesTransferred);
         Common::ErrorCode Send(
             MessageUPtr && message,
             Common::TimeSpan expiration,
             bool shouldEncrypt,
-            TcpConnectionState::Enum newState = TcpConnectionState::None);
+            TcpConnectionState::Enum newState = TcpConnectionState::None,
+            QueuedSend* queued = nullptr,
+            uint64 ownSequence = 0);
+        Common::ErrorCode QueueSend(MessageUPtr && message, Common::TimeSpan expiration, bool shouldEncrypt);
+        Common::ErrorCode DrainQueuedSends(uint64 ownSequence);
+        Common::ErrorCode EnqueueMessageChl(MessageUPtr && message, Common::TimeSpan expiration, bool shouldEncrypt);
+        void EnqueueFragmentsChl();
+        void AbandonFragmentsChl(Common::ErrorCode const & error);
+        bool TryReassembleFragment(_Inout_ MessageUPtr & message);
 
         bool CanReceive() const;
         void SubmitReceive();
@@ -247,6 +270,7 @@ namespace Transport
         TcpSendTargetSPtr tcpTarget_;
         ISendTarget::SPtr target_; // save this to avoid creating a new instance for every incoming message dispatch
         TransportPriority::Enum priority_;
+        uint const lane_;
         TransportFlags flags_;
 
         std::string const traceId_;
@@ -269,6 +293,22 @@ namespace Transport
 
         Common::atomic_long pendingSend_{0};
 
+        // lock free stack of messages queued by concurrent senders, newest first
+        QueuedSend* volatile queuedSends_ = nullptr;
+        // set while one sender moves queuedSends_ into sendBuffer_
+        Common::atomic_bool sendDraining_{false};
+        // identifies queued messages, so that a drainer finds its own message in a batch
+        Common::atomic_uint64 queuedSendSequence_{0};
+        bool const lockFreeSendQueueEnabled_;
+
+        // messages with bodies larger than messageFragmentSize_ are sent as fragments, see TransportConfig::MessageFragmentSize
+        size_t const messageFragmentSize_;
+        uint64 fragmentedMessageCount_ = 0;
+        std::queue<std::unique_ptr<OutgoingMessageFragments>> outgoingFragments_;
+        size_t fragmentBytesPending_ = 0;
+        // only accessed on the receive path, which is never active on multiple threads at the same time
+        std::unique_ptr<IncomingMessageFragments> incomingFragments_;
+
 #ifdef PLATFORM_UNIX
         void RegisterEvtLoopIn();
         void RegisterEvtLoopOut();
@@ -23,6 +23,8 @@ namespace Transport
         void ClientTcpTest(string const & serverAddress);
         void IdleTimeoutTest(bool idleTimeoutExpected, bool keepExternalSendTargetReference);
         void SendQueueExpirationTest(SecurityProvider::Enum provider);
+        double ManySendersOneTargetTest(bool lockFreeSendQueueEnabled);
+        void LockFreeSendQueueCloseRaceTest(bool abortConnection);
 
         void ConnectionFaultTest_SenderClose(bool abortConnection);
         void ConnectionFaultTest_ReceiverClose(bool abortConnection);
@@ -1360,6 +1362,17 @@ namespace Transport
         LEAVE;
     }
 
+#ifdef PLATFORM_UNIX
+    BOOST_AUTO_TEST_CASE(SimpleUnixDomainSocketTest)
+    {
+        ENTER;
+        SimpleTcpTest(
+            formatString.L("unix:/tmp/TcpTransportTests-{0}-1.sock", ::GetCurrentProcessId()),
+            formatString.L("unix:/tmp/TcpTransportTests-{0}-2.sock", ::GetCurrentProcessId()));
+        LEAVE;
+    }
+#endif
+
     BOOST_AUTO_TEST_CASE(SimpleTcpTestWithLocalhost3)
     {
         ENTER;
@@ -2176,6 +2189,223 @@ namespace Transport
         LEAVE;
     }
 
+    BOOST_AUTO_TEST_CASE(ManySendersOneTargetBenchmark)
+    {
+        ENTER;
+
+        auto lockedRate = ManySendersOneTargetTest(false);
+        auto lockFreeRate = ManySendersOneTargetTest(true);
+
+        Trace.WriteInfo(
+            TraceType,
+            "many senders one target: locked send {0} messages/sec, lock free send queue {1} messages/sec",
+            lockedRate,
+            lockFreeRate);
+
+        LEAVE;
+    }
+
+    BOOST_AUTO_TEST_CASE(BulkLaneTest)
+    {
+        ENTER;
+
+        // send targets read lane settings on creation
+        auto savedCount = TransportConfig::GetConfig().BulkLaneConnectionCount;
+        auto savedThreshold = TransportConfig::GetConfig().BulkLaneMessageSizeThreshold;
+        TransportConfig::GetConfig().BulkLaneConnectionCount = 2;
+        TransportConfig::GetConfig().BulkLaneMessageSizeThreshold = 64 * 1024;
+        KFinally([=]
+        {
+            TransportConfig::GetConfig().BulkLaneConnectionCount = savedCount;
+            TransportConfig::GetConfig().BulkLaneMessageSizeThreshold = savedThreshold;
+        });
+
+        const LONG orderedMessageCount = 2;
+        const LONG largeMessageCount = 4;
+        const LONG smallMessageCount = 20;
+        LONG largeReceived = 0;
+        LONG totalReceived = 0;
+        ManualResetEvent orderedReceived(false);
+        ManualResetEvent allReceived(false);
+
+        auto sender = TcpDatagramTransport::Create(TTestUtil::GetListenAddress());
+        auto receiver = TcpDatagramTransport::Create(TTestUtil::GetListenAddress());
+
+        receiver->SetMessageHandler([&](MessageUPtr & message, ISendTarget::SPtr const &)
+        {
+            TestMessageBody body;
+            VERIFY_IS_TRUE(message->GetBody(body));
+            VERIFY_IS_TRUE(body.Verify());
+
+            if (body.size() >= 64 * 1024)
+            {
+                InterlockedIncrement(&largeReceived);
+            }
+
+            auto received = InterlockedIncrement(&totalReceived);
+            if (received == orderedMessageCount)
+            {
+                orderedReceived.Set();
+            }
+            else if (received == (orderedMessageCount + largeMessageCount + smallMessageCount))
+            {
+                allReceived.Set();
+            }
+        });
+
+        VERIFY_IS_TRUE(receiver->Start().IsSuccess());
+        VERIFY_IS_TRUE(sender->Start().IsSuccess());
+
+        auto target = sender->ResolveTarget(receiver->ListenAddress());
+        VERIFY_IS_TRUE(target);
+        auto tcpTarget = dynamic_pointer_cast<TcpSendTarget>(target);
+        VERIFY_IS_TRUE(tcpTarget);
+        VERIFY_IS_TRUE(tcpTarget->LaneCount() == 3);
+
+        // large messages of protocols relying on per target ordering stay on the control lane,
+        // bulk lane connections are only created when a message is sent on them
+        for (LONG i = 0; i < orderedMessageCount; ++i)
+        {
+            auto message = make_unique<Message>(TestMessageBody(1024 * 1024));
+            message->Headers.Add(ActorHeader(Actor::Federation));
+            VERIFY_IS_TRUE(sender->SendOneWay(target, std::move(message)).IsSuccess());
+        }
+
+        VERIFY_IS_TRUE(orderedReceived.WaitOne(TimeSpan::FromSeconds(60)));
+        VERIFY_IS_TRUE(tcpTarget->GetLaneStatistics(1).ConnectionCount == 0);
+        VERIFY_IS_TRUE(tcpTarget->GetLaneStatistics(2).ConnectionCount == 0);
+
+        for (LONG i = 0; i < largeMessageCount; ++i)
+        {
+            VERIFY_IS_TRUE(sender->SendOneWay(target, make_unique<Message>(TestMessageBody(1024 * 1024))).IsSuccess());
+        }
+
+        for (LONG i = 0; i < smallMessageCount; ++i)
+        {
+            VERIFY_IS_TRUE(sender->SendOneWay(target, make_unique<Message>(TestMessageBody(128))).IsSuccess());
+        }
+
+        VERIFY_IS_TRUE(allReceived.WaitOne(TimeSpan::FromSeconds(60)));
+        VERIFY_IS_TRUE(largeReceived == (orderedMessageCount + largeMessageCount));
+
+        // large messages are sent round-robin on both bulk lanes, small ones on the control lane
+        VERIFY_IS_TRUE(tcpTarget->GetLaneStatistics(0).ConnectionCount >= 1);
+        VERIFY_IS_TRUE(tcpTarget->GetLaneStatistics(1).ConnectionCount == 1);
+        VERIFY_IS_TRUE(tcpTarget->GetLaneStatistics(2).ConnectionCount == 1);
+        VERIFY_IS_TRUE(tcpTarget->LaneSendLatency(0).Count() >= static_cast<uint64>(smallMessageCount));
+        VERIFY_IS_TRUE(tcpTarget->LaneSendLatency(1).Count() >= static_cast<uint64>(largeMessageCount / 2));
+        VERIFY_IS_TRUE(tcpTarget->LaneSendLatency(2).Count() >= static_cast<uint64>(largeMessageCount / 2));
+
+        Trace.WriteInfo(
+            TraceType,
+            "lane send latency: control: {0}; bulk 1: {1}; bulk 2: {2}",
+            tcpTarget->LaneSendLatency(0),
+            tcpTarget->LaneSendLatency(1),
+            tcpTarget->LaneSendLatency(2));
+
+        sender->Stop();
+        receiver->Stop();
+
+        LEAVE;
+    }
+
+    BOOST_AUTO_TEST_CASE(MessageFragmentTest)
+    {
+        ENTER;
+
+        // connections read fragment size on creation
+        auto savedFragmentSize = TransportConfig::GetConfig().MessageFragmentSize;
+        TransportConfig::GetConfig().MessageFragmentSize = 64 * 1024;
+        KFinally([=] { TransportConfig::GetConfig().MessageFragmentSize = savedFragmentSize; });
+
+        const string largeAction = "LargeMessage";
+        const LONG largeMessageCount = 3;
+        const LONG smallMessageCount = 20;
+        LONG largeReceived = 0;
+        LONG totalReceived = 0;
+        LONG sendSucceeded = 0;
+        ManualResetEvent allReceived(false);
+        ManualResetEvent allSent(false);
+
+        auto sender = TcpDatagramTransport::Create(TTestUtil::GetListenAddress());
+        auto receiver = TcpDatagramTransport::Create(TTestUtil::GetListenAddress());
+
+        receiver->SetMessageHandler([&](MessageUPtr & message, ISendTarget::SPtr const &)
+        {
+            VERIFY_IS_FALSE(message->Headers.Contains(MessageHeaderId::MessageFragment));
+
+            TestMessageBody body;
+            VERIFY_IS_TRUE(message->GetBody(body));
+            VERIFY_IS_TRUE(body.Verify());
+
+            if (message->Action == largeAction)
+            {
+                VERIFY_IS_TRUE(body.size() == 1024 * 1024);
+                InterlockedIncrement(&largeReceived);
+            }
+
+            auto received = InterlockedIncrement(&totalReceived);
+            if (received == orderedMessageCount)
+            {
+                orderedReceived.Set();
+            }
+            else if (received == (orderedMessageCount + largeMessageCount + smallMessageCount))
+            {
+                allReceived.Set();
+            }
+        });
+
+        VERIFY_IS_TRUE(receiver->Start().IsSuccess());
+        VERIFY_IS_TRUE(sender->Start().IsSuccess());
+
+        auto target = sender->ResolveTarget(receiver->ListenAddress());
+        VERIFY_IS_TRUE(target);
+
+        for (LONG i = 0; i < largeMessageCount; ++i)
+        {
+            auto message = make_unique<Message>(TestMessageBody(1024 * 1024));
+            message->Headers.Add(ActionHeader(largeAction));
+            message->SetSendStatusCallback([&](ErrorCode const & error, MessageUPtr &&)
+            {
+                VERIFY_IS_TRUE(error.IsSuccess());
+                if (InterlockedIncrement(&sendSucceeded) == largeMessageCount)
+                {
+                    allSent.Set();
+                }
+            });
+
+            VERIFY_IS_TRUE(sender->SendOneWay(target, move(message)).IsSuccess());
+
+            // small messages are sent between fragments instead of waiting behind the whole large message
+            for (LONG j = 0; j < smallMessageCount / largeMessageCount; ++j)
+            {
+                VERIFY_IS_TRUE(sender->SendOneWay(target, make_unique<Message>(TestMessageBody(128))).IsSuccess());
+            }
+        }
+
+        for (LONG i = (smallMessageCount / largeMessageCount) * largeMessageCount; i < smallMessageCount; ++i)
+        {
+            VERIFY_IS_TRUE(sender->SendOneWay(target, make_unique<Message>(TestMessageBody(128))).IsSuccess());
+        }
+
+        VERIFY_IS_TRUE(allReceived.WaitOne(TimeSpan::FromSeconds(60)));
+        VERIFY_IS_TRUE(largeReceived == (orderedMessageCount + largeMessageCount));
+        VERIFY_IS_TRUE(allSent.WaitOne(TimeSpan::FromSeconds(60)));
+
+        sender->Stop();
+        receiver->Stop();
+
+        LEAVE;
+    }
+
+    BOOST_AUTO_TEST_CASE(LockFreeSendQueueCloseRace)
+    {
+        ENTER;
+        LockFreeSendQueueCloseRaceTest(false);
+        LockFreeSendQueueCloseRaceTest(true);
+        LEAVE;
+    }
+
     BOOST_AUTO_TEST_CASE(AbortReceiver)
     {
         ENTER;
@@ -3621,6 +3851,206 @@ namespace Transport
         receiver->Stop();
     }
 
+    double TcpTransportTests::ManySendersOneTargetTest(bool lockFreeSendQueueEnabled)
+    {
+        // connection reads the setting on creation, so it must be set before the target is resolved
+        auto saved = TransportConfig::GetConfig().LockFreeSendQueueEnabled;
+        TransportConfig::GetConfig().LockFreeSendQueueEnabled = lockFreeSendQueueEnabled;
+        KFinally([=] { TransportConfig::GetConfig().LockFreeSendQueueEnabled = saved; });
+
+        const LONG senderCount = Environment::GetNumberOfProcessors() * 2;
+        const LONG messagesPerSender = 5000;
+        const LONG totalMessageCount = senderCount * messagesPerSender;
+
+        auto sender = TcpDatagramTransport::Create(TTestUtil::GetListenAddress());
+        auto receiver = TcpDatagramTransport::Create(TTestUtil::GetListenAddress());
+
+        // one extra message is sent up front to get the connection established before timing
+        LONG messageCount = 0;
+        ManualResetEvent firstMessageReceived(false);
+        ManualResetEvent messagesReceived(false);
+        receiver->SetMessageHandler([&messageCount, &firstMessageReceived, &messagesReceived, totalMessageCount](MessageUPtr &, ISendTarget::SPtr const &)
+        {
+            auto count = InterlockedIncrement(&messageCount);
+            if (count == 1)
+            {
+                firstMessageReceived.Set();
+            }
+            else if (count == (totalMessageCount + 1))
+            {
+                messagesReceived.Set();
+            }
+        });
+
+        VERIFY_IS_TRUE(receiver->Start().IsSuccess());
+        VERIFY_IS_TRUE(sender->Start().IsSuccess());
+
+        ISendTarget::SPtr target = sender->ResolveTarget(receiver->ListenAddress());
+        VERIFY_IS_TRUE(target);
+
+        sender->SendOneWay(target, make_unique<Message>(TcpTestMessage("warm up")));
+        VERIFY_IS_TRUE(firstMessageReceived.WaitOne(TimeSpan::FromSeconds(30)));
+
+        LONG sendersRemaining = senderCount;
+        ManualResetEvent sendersDone(false);
+        Stopwatch stopwatch;
+        stopwatch.Start();
+        for (LONG i = 0; i < senderCount; ++i)
+        {
+            Threadpool::Post([&sender, &target, &sendersRemaining, &sendersDone, messagesPerSender]
+            {
+                for (LONG j = 0; j < messagesPerSender; ++j)
+                {
+                    sender->SendOneWay(target, make_unique<Message>(TcpTestMessage("Message message message message oh yeah")));
+                }
+
+                if (InterlockedDecrement(&sendersRemaining) == 0)
+                {
+                    sendersDone.Set();
+                }
+            });
+        }
+
+        VERIFY_IS_TRUE(sendersDone.WaitOne(TimeSpan::FromSeconds(120)));
+        VERIFY_IS_TRUE(messagesReceived.WaitOne(TimeSpan::FromSeconds(120)));
+        stopwatch.Stop();
+
+        VERIFY_IS_TRUE(messageCount == (totalMessageCount + 1));
+
+        sender->Stop();
+        receiver->Stop();
+
+        auto rate = totalMessageCount * 1000.0 / max<int64>(stopwatch.ElapsedMilliseconds, 1);
+        Trace.WriteInfo(
+            TraceType,
+            "ManySendersOneTargetTest: lockFreeSendQueueEnabled = {0}, senderCount = {1}, messageCount = {2}, elapsed = {3}, {4} messages/sec",
+            lockFreeSendQueueEnabled,
+            senderCount,
+            totalMessageCount,
+            stopwatch.Elapsed,
+            rate);
+
+        return rate;
+    }
+
+    void TcpTransportTests::LockFreeSendQueueCloseRaceTest(bool abortConnection)
+    {
+        // connection reads the setting on creation, so it must be set before the target is resolved
+        auto saved = TransportConfig::GetConfig().LockFreeSendQueueEnabled;
+        TransportConfig::GetConfig().LockFreeSendQueueEnabled = true;
+        KFinally([=] { TransportConfig::GetConfig().LockFreeSendQueueEnabled = saved; });
+
+        const LONG senderCount = Environment::GetNumberOfProcessors() * 2;
+        const LONG messagesPerSender = 2000;
+        const LONG totalMessageCount = senderCount * messagesPerSender;
+
+        auto sender = TcpDatagramTransport::Create(TTestUtil::GetListenAddress());
+        auto receiver = TcpDatagramTransport::Create(TTestUtil::GetListenAddress());
+
+        ManualResetEvent firstMessageReceived(false);
+        receiver->SetMessageHandler([&firstMessageReceived](MessageUPtr &, ISendTarget::SPtr const &)
+        {
+            firstMessageReceived.Set();
+        });
+
+        VERIFY_IS_TRUE(receiver->Start().IsSuccess());
+        VERIFY_IS_TRUE(sender->Start().IsSuccess());
+
+        ISendTarget::SPtr target = sender->ResolveTarget(receiver->ListenAddress());
+        VERIFY_IS_TRUE(target);
+
+        sender->SendOneWay(target, make_unique<Message>(TcpTestMessage("warm up")));
+        VERIFY_IS_TRUE(firstMessageReceived.WaitOne(TimeSpan::FromSeconds(30)));
+
+        // every message must get exactly one send status, whether it was sent, failed when queued,
+        // or was still in the queue when the connection closed
+        vector<LONG> statusCount(totalMessageCount, 0);
+        vector<LONG> statusFailed(totalMessageCount, 0);
+        vector<LONG> sendFailed(totalMessageCount, 0);
+        LONG statusRemaining = totalMessageCount;
+        ManualResetEvent allStatusReported(false);
+
+        LONG sendersStarted = 0;
+        ManualResetEvent sendersRunning(false);
+        LONG sendersRemaining = senderCount;
+        ManualResetEvent sendersDone(false);
+        for (LONG i = 0; i < senderCount; ++i)
+        {
+            Threadpool::Post([&, i]
+            {
+                if (InterlockedIncrement(&sendersStarted) == senderCount)
+                {
+                    sendersRunning.Set();
+                }
+
+                for (LONG j = 0; j < messagesPerSender; ++j)
+                {
+                    LONG index = i * messagesPerSender + j;
+                    auto message = make_unique<Message>(TcpTestMessage("Message message message message oh yeah"));
+                    message->SetSendStatusCallback([&, index](ErrorCode const & error, MessageUPtr &&)
+                    {
+                        InterlockedIncrement(&statusCount[index]);
+                        if (!error.IsSuccess())
+                        {
+                            statusFailed[index] = 1;
+                        }
+
+                        if (InterlockedDecrement(&statusRemaining) == 0)
+                        {
+                            allStatusReported.Set();
+                        }
+                    });
+
+                    if (!sender->SendOneWay(target, move(message)).IsSuccess())
+                    {
+                        sendFailed[index] = 1;
+                    }
+                }
+
+                if (InterlockedDecrement(&sendersRemaining) == 0)
+                {
+                    sendersDone.Set();
+                }
+            });
+        }
+
+        // close the connection while senders are queuing to it
+        VERIFY_IS_TRUE(sendersRunning.WaitOne(TimeSpan::FromSeconds(30)));
+        Sleep(10);
+        if (abortConnection)
+        {
+            ((TcpSendTarget&)(*target)).Abort();
+        }
+        else
+        {
+            target->Reset();
+        }
+
+        VERIFY_IS_TRUE(sendersDone.WaitOne(TimeSpan::FromSeconds(120)));
+        VERIFY_IS_TRUE(allStatusReported.WaitOne(TimeSpan::FromSeconds(120)));
+
+        LONG failedCount = 0;
+        for (LONG i = 0; i < totalMessageCount; ++i)
+        {
+            VERIFY_ARE_EQUAL2(statusCount[i], 1);
+
+            // a failure returned by SendOneWay is also reported to the message
+            VERIFY_IS_TRUE(!sendFailed[i] || statusFailed[i]);
+            failedCount += statusFailed[i];
+        }
+
+        Trace.WriteInfo(
+            TraceType,
+            "LockFreeSendQueueCloseRaceTest: abortConnection = {0}, senderCount = {1}, messageCount = {2}, failed = {3}",
+            abortConnection,
+            senderCount,
+            totalMessageCount,
+            failedCount);
+
+        sender->Stop();
+        receiver->Stop();
+    }
+
     void TcpTransportTests::TargetInstanceTestSendRequest(
         IDatagramTransportSPtr const & srcNode,
         ISendTarget::SPtr const & target,
@@ -763,6 +763,12 @@ ErrorCode TcpDatagramTransport::SetDynamicListenPortForHostName(std::vector<ILis
 
 void TcpDatagramTransport::UpdateListenAddress(Endpoint const & endpoint)
 {
+    if (endpoint.IsUnixDomain())
+    {
+        listenAddress_ = endpoint.ToString();
+        return;
+    }
+
     string host, inputPort;
     auto error = TcpTransportUtility::TryParseHostPortString(listenAddress_, host, inputPort);
     Invariant(error.IsSuccess());
@@ -29,19 +29,40 @@ NTSTATUS TcpReceiveBuffer::GetNextMessage(MessageUPtr & message, StopwatchTime r
 
     if (securityContext && securityContext->FramingProtectionEnabled() && securityContext->NegotiationSucceeded())
     {
-        msgBuffers_ = &decrypted_;
+        bool decryptedByKernel = false;
+#ifdef PLATFORM_UNIX
+        auto securityContextSsl = (SecurityContextSsl*)securityContext;
 
-        if (totalBufferUsed > 0)
+        // records are decrypted by the kernel, frames can be parsed from receiveQueue_
+        // directly once nothing decrypted by OpenSSL is left
+        decryptedByKernel = securityContextSsl->KernelTlsReceiveEnabled() && decrypted_.empty();
+#endif
+
+        if (decryptedByKernel)
         {
-            auto status = securityContext->DecodeMessage(receiveQueue_, decrypted_);
-            if (FAILED(status)) return STATUS_UNSUCCESSFUL;
+            msgBuffers_ = &receiveQueue_;
         }
+        else
+        {
+            msgBuffers_ = &decrypted_;
 
-        totalBufferUsed = decrypted_.cend() - decrypted_.cbegin();
-        TcpConnection::WriteNoise(
-            TraceType, connectionPtr_->TraceId(),
-            "GetNextMessage: finished security processing: totalBufferUsed = {0}",
-            totalBufferUsed);
+            if (totalBufferUsed > 0)
+            {
+                auto status = securityContext->DecodeMessage(receiveQueue_, decrypted_);
+                if (FAILED(status)) return STATUS_UNSUCCESSFUL;
+            }
+
+            totalBufferUsed = decrypted_.cend() - decrypted_.cbegin();
+            TcpConnection::WriteNoise(
+                TraceType, connectionPtr_->TraceId(),
+                "GetNextMessage: finished security processing: totalBufferUsed = {0}",
+                totalBufferUsed);
+
+#ifdef PLATFORM_UNIX
+            // no read is outstanding here, so the socket has not been read beyond what OpenSSL has consumed
+            securityContextSsl->TryEnableKernelTlsReceive(connectionPtr_->socket_.GetHandle());
+#endif
+        }
     }
 
     if (!haveFrameHeader_)
@@ -17,6 +17,9 @@ namespace
 
     const static size_t FrameQueueBiqueChunkSize = (1024 * 32) / sizeof(TcpSendBuffer::Frame);
     const static size_t SendBatchBufferCountLimit = 1024; // writev on Linux limit buffer count to 1024
+
+    // frames encrypted per round of the encode stage, so that sending can start before a long queue is all encrypted
+    const static size_t EncodeBatchLimitInBytes = 1024 * 1024;
 }
 
 TcpSendBuffer::Frame::Frame(
@@ -26,8 +29,10 @@ TcpSendBuffer::Frame::Frame(
     bool shouldEncrypt)
 : header_(message, securityProviderMask)
 , message_(std::move(message))
+, enqueueTime_(Stopwatch::Now())
 , shouldEncrypt_(shouldEncrypt)
 , preparedForSending_(false)
+, encoding_(false)
 {
     auto count = ++frameCount;
     TcpConnection::WriteNoise(TraceType, "Frame ctor: count = {0}", count);
@@ -38,9 +43,8 @@ TcpSendBuffer::Frame::Frame(
         return;
     }
 
-    StopwatchTime now = Stopwatch::Now();
-    expiration_ = now + expiration;
-    if (expiration_ < now) // overflow?
+    expiration_ = enqueueTime_ + expiration;
+    if (expiration_ < enqueueTime_) // overflow?
     {
         expiration_ = StopwatchTime::MaxValue;
     }
@@ -77,7 +81,7 @@ MessageUPtr const & TcpSendBuffer::Frame::Message() const
 
 bool TcpSendBuffer::Frame::HasExpired(StopwatchTime now) const
 {
-    return !preparedForSending_ && expiration_ <= now;
+    return !preparedForSending_ && !encoding_ && expiration_ <= now;
 }
 
 bool TcpSendBuffer::Frame::IsInUse() const
@@ -97,7 +101,13 @@ ErrorCode TcpSendBuffer::Frame::EncryptIfNeeded(TcpSendBuffer & sendBuffer)
     auto provider = securityContext->TransportSecurity().SecurityProvider;
     Invariant(provider == SecurityProvider::Ssl || provider == SecurityProvider::Claims);
     auto securityContextSsl = (SecurityContextSsl*)securityContext;
-    
+
+    // with kernel TLS, the plaintext frame is gathered into the socket as is
+    if (securityContextSsl->KernelTlsSendEnabled())
+    {
+        return ErrorCode();
+    }
+
     //LINUXTODO avoid data copying during encryption
     ByteBuffer2 buffer(header_.FrameLength());
     TcpConnection::WriteNoise(
@@ -126,10 +136,6 @@ ErrorCode TcpSendBuffer::Frame::EncryptIfNeeded(TcpSendBuffer & sendBuffer)
         "Encrypt: ciphertext length = {0}",
         encrypted_.size());
 
-    // adjust for size change due to encryption
-    sendBuffer.totalBufferedBytes_ -= buffer.size(); 
-    sendBuffer.totalBufferedBytes_ += encrypted_.size(); 
-
     return error;
 
 #else
@@ -163,27 +169,18 @@ ErrorCode TcpSendBuffer::Frame::EncryptIfNeeded(TcpSendBuffer & sendBuffer)
 
         if (SUCCEEDED(status))
         {
-            // adjust for size change due to encryption
-            sendBuffer.totalBufferedBytes_ -= header_.FrameLength();
-            sendBuffer.totalBufferedBytes_ += encrypted_.size();
             return ErrorCodeValue::Success;
         }
 
         return ErrorCodeValue::OperationFailed;
     }
 
-    auto sizeBeforeEncryption = message_->SerializedSize();
-
     auto status = sendBuffer.connection_->securityContext_->EncodeMessage(message_);
     if (FAILED(status))
     {
         return ErrorCode::FromHResult(status);
     }
 
-    // adjust for size change due to encryption
-    sendBuffer.totalBufferedBytes_ -= sizeBeforeEncryption;
-    sendBuffer.totalBufferedBytes_ += message_->SerializedSize();
-
     header_ = TcpFrameHeader(message_, sendBuffer.securityProviderMask_);
     return ErrorCode();
 
@@ -193,14 +190,10 @@ ErrorCode TcpSendBuffer::Frame::EncryptIfNeeded(TcpSendBuffer & sendBuffer)
 ErrorCode TcpSendBuffer::Frame::PrepareForSending(TcpSendBuffer & sendBuffer)
 {
     Invariant(!preparedForSending_);
+    Invariant(!encoding_);
     preparedForSending_ = true;
 
-    ErrorCode error = EncryptIfNeeded(sendBuffer);
-    if (!error.IsSuccess())
-    {
-        return error;
-    }
-
+    ErrorCode error;
     if (!encrypted_.empty())
     {
         Invariant(shouldEncrypt_);
@@ -313,7 +306,10 @@ ErrorCode TcpSendBuffer::Prepare()
 
     StopwatchTime now = Stopwatch::Now();
     ErrorCode error;
-    for (auto cur = messageQueue_.begin(); cur != messageQueue_.end(); ++cur)
+
+    // frames after encodedFrameCount_ are still waiting for the encode stage
+    auto encodedEnd = messageQueue_.begin() + encodedFrameCount_;
+    for (auto cur = messageQueue_.begin(); cur != encodedEnd; ++cur)
     {
         // cap large sends
         if ((sendingLength_ >= sendBatchLimitInBytes_) || (preparedBuffers_.size() >= SendBatchBufferCountLimit))
@@ -341,6 +337,12 @@ ErrorCode TcpSendBuffer::Prepare()
         }
     }
 
+    if (preparedBuffers_.empty())
+    {
+        // all messages expired, or all are waiting for the encode stage, which starts sending when done
+        return error;
+    }
+
     perfCounters_->AverageTcpSendSizeBase.Increment();
     perfCounters_->AverageTcpSendSize.IncrementBy(sendingLength_);
     return error;
@@ -359,8 +361,10 @@ void TcpSendBuffer::Consume(size_t length)
     auto messageCountBefore = MessageCount();
     auto totalBufferedBytesBefore = totalBufferedBytes_;
 
+    StopwatchTime now = Stopwatch::Now();
     FrameQueue::iterator frame = messageQueue_.begin();
     size_t consumedBytes = 0;
+    size_t consumedFrames = 0;
     while ((consumedBytes < length) && (frame != messageQueue_.end()))
     {
         if (frame->Message())
@@ -368,6 +372,7 @@ void TcpSendBuffer::Consume(size_t length)
             KAssert(frame->IsInUse());
             consumedBytes += frame->FrameLength();
             ++messageSentCount_;
+            connection_->RecordSendLatencyChl(now - frame->EnqueueTime());
 
             this->UntrackMessageIdIfNeeded(frame->Message()->MessageId);
 
@@ -390,9 +395,12 @@ void TcpSendBuffer::Consume(size_t length)
         }
 
         ++frame;
+        ++consumedFrames;
     }
 
     Invariant(consumedBytes == length);
+    Invariant(consumedFrames <= encodedFrameCount_);
+    encodedFrameCount_ -= consumedFrames;
     messageQueue_.truncate_before(frame);
     sendingLength_ = 0;
     totalBufferedBytes_ -= (ULONG)length;
@@ -437,46 +445,56 @@ void TcpSendBuffer::Abort()
         }
     }
 
-    auto frame = messageQueue_.begin();
-    while (frame != messageQueue_.end())
+    for (auto frame = messageQueue_.begin(); frame != messageQueue_.end(); ++frame)
     {
-        if (frame->Message())
+        // frames being encoded are disposed by CompleteEncode()
+        if (frame->Message() && !frame->IsEncoding())
         {
-            if (dropCount++ < dropTraceLimit)
-            {
-                trace.DropMessageOnAbort(
-                    frame->Message()->TraceId(),
-                    frame->Message()->Actor,
-                    frame->Message()->Action,
-                    sendError);
-            }
-
-            if (frame->Message()->HasSendStatusCallback())
-            {
-                auto msg = frame->Dispose();
-                msg->OnSendStatus(sendError, move(msg));
-            }
-            else
-            {
-                //no send status callback, so message is not used to keep things alive
-                frame->Dispose(); // This is required as bique will not call ~Frame()
-            }
+            DisposeOnAbort(*frame, sendError, dropCount);
         }
-
-        ++frame;
     }
 
     TcpConnection::WriteInfo(
         TraceType, connection_->TraceId(),
-        "abort send buffer with {0}, dropping {1} messages",
+        "abort send buffer with {0}, dropping {1} messages, {2} messages being encoded",
         sendError,
-        dropCount);
+        dropCount,
+        encodingFrames_.size());
+
+    if (encodingFrames_.empty())
+    {
+        messageQueue_.truncate_before(messageQueue_.cend());
+        encodedFrameCount_ = 0;
+    }
 
-    messageQueue_.truncate_before(messageQueue_.cend());
     totalBufferedBytes_ = 0;
     sendingLength_ = 0;
 }
 
+void TcpSendBuffer::DisposeOnAbort(Frame & frame, ErrorCode const & sendError, uint & dropCount)
+{
+    const uint dropTraceLimit = 9;
+    if (dropCount++ < dropTraceLimit)
+    {
+        trace.DropMessageOnAbort(
+            frame.Message()->TraceId(),
+            frame.Message()->Actor,
+            frame.Message()->Action,
+            sendError);
+    }
+
+    if (frame.Message()->HasSendStatusCallback())
+    {
+        auto msg = frame.Dispose();
+        msg->OnSendStatus(sendError, move(msg));
+    }
+    else
+    {
+        //no send status callback, so message is not used to keep things alive
+        frame.Dispose(); // This is required as bique will not call ~Frame()
+    }
+}
+
 bool TcpSendBuffer::Empty() const
 {
     return messageQueue_.empty();
@@ -498,6 +516,133 @@ void TcpSendBuffer::EnqueueImpl(MessageUPtr && message, TimeSpan expiration, boo
 
     messageQueue_.emplace_back(move(message), securityProviderMask_, expiration, shouldEncrypt);
     totalBufferedBytes_ += messageQueue_.back().FrameLength();
+
+    // frames without encryption skip the encode stage, unless they have to wait for frames ahead of them
+    if (!shouldEncrypt && (encodedFrameCount_ + 1 == messageQueue_.size()))
+    {
+        ++encodedFrameCount_;
+    }
+}
+
+bool TcpSendBuffer::StartEncode()
+{
+    if (encodeActive_ || (encodedFrameCount_ == messageQueue_.size()))
+    {
+        return false;
+    }
+
+    encodeActive_ = true;
+    return true;
+}
+
+bool TcpSendBuffer::TakeFramesToEncode()
+{
+    Invariant(encodeActive_);
+    Invariant(encodingFrames_.empty());
+
+    encodingPositionCount_ = 0;
+    encodingLengthDelta_ = 0;
+
+    size_t takenBytes = 0;
+    auto cur = messageQueue_.begin() + encodedFrameCount_;
+    for (; (cur != messageQueue_.end()) && (takenBytes < EncodeBatchLimitInBytes); ++cur)
+    {
+        ++encodingPositionCount_;
+        if (!cur->Message())
+        {
+            continue; // message had been dropped due to expiration
+        }
+
+        cur->SetEncoding(true);
+        encodingFrames_.push_back(&(*cur));
+        takenBytes += cur->FrameLength();
+    }
+
+    if (encodingPositionCount_ == 0)
+    {
+        encodeActive_ = false;
+        return false;
+    }
+
+#ifdef PLATFORM_UNIX
+    // Kernel TLS has to continue the record sequence right after the last record written
+    // to the socket, which is only known when nothing encrypted by OpenSSL is still queued
+    if ((encodedFrameCount_ == 0) &&
+        !encodingFrames_.empty() &&
+        encodingFrames_.front()->ShouldEncrypt())
+    {
+        auto securityContext = connection_->securityContext_.get();
+        auto provider = securityContext->TransportSecurity().SecurityProvider;
+        if (provider == SecurityProvider::Ssl || provider == SecurityProvider::Claims)
+        {
+            ((SecurityContextSsl*)securityContext)->TryEnableKernelTlsSend(connection_->socket_.GetHandle());
+        }
+    }
+#endif
+
+    return true;
+}
+
+ErrorCode TcpSendBuffer::EncodeTakenFrames()
+{
+    for (auto frame : encodingFrames_)
+    {
+        auto lengthBefore = frame->FrameLength();
+        auto error = frame->EncryptIfNeeded(*this);
+        if (!error.IsSuccess())
+        {
+            return error;
+        }
+
+        // adjust for size change due to encryption
+        encodingLengthDelta_ += (int64)frame->FrameLength() - (int64)lengthBefore;
+    }
+
+    return ErrorCode();
+}
+
+bool TcpSendBuffer::CompleteEncode(ErrorCode const & error)
+{
+    for (auto frame : encodingFrames_)
+    {
+        frame->SetEncoding(false);
+    }
+
+    if (!error.IsSuccess() && (abortCount_.load() == 0))
+    {
+        // connection is closed by caller, encodeActive_ is left set to stop further encoding
+        encodingFrames_.clear();
+        return false;
+    }
+
+    if (abortCount_.load() > 0)
+    {
+        ErrorCode sendError = connection_->fault_.IsSuccess() ? ErrorCodeValue::OperationCanceled : connection_->fault_;
+        uint dropCount = 0;
+        for (auto frame : encodingFrames_)
+        {
+            DisposeOnAbort(*frame, sendError, dropCount);
+        }
+
+        encodingFrames_.clear();
+        messageQueue_.truncate_before(messageQueue_.cend());
+        encodedFrameCount_ = 0;
+        encodeActive_ = false;
+        return false;
+    }
+
+    encodingFrames_.clear();
+    encodedFrameCount_ += encodingPositionCount_;
+    totalBufferedBytes_ += encodingLengthDelta_;
+    KAssert(encodedFrameCount_ <= messageQueue_.size());
+    return true;
+}
+
+bool TcpSendBuffer::ContinueEncode()
+{
+    Invariant(encodeActive_);
+    encodeActive_ = (encodedFrameCount_ < messageQueue_.size());
+    return encodeActive_;
 }
 
 bool TcpSendBuffer::PurgeExpiredMessages(StopwatchTime now)
@@ -33,14 +33,22 @@ namespace Transport
             bool HasExpired(Common::StopwatchTime now) const; // HasExpired => ! IsInUse
             bool IsInUse() const;
 
-        private:
+            Common::StopwatchTime EnqueueTime() const { return enqueueTime_; }
+            bool ShouldEncrypt() const { return shouldEncrypt_; }
+            bool IsEncoding() const { return encoding_; }
+            void SetEncoding(bool encoding) { encoding_ = encoding; }
+
+            // called without holding TcpConnection::lock_, the frame is not touched by others while IsEncoding()
             Common::ErrorCode EncryptIfNeeded(TcpSendBuffer & sendBuffer);
 
+        private:
             TcpFrameHeader header_;
             MessageUPtr message_;
+            Common::StopwatchTime enqueueTime_;
             Common::StopwatchTime expiration_;
             bool shouldEncrypt_;
             bool preparedForSending_;
+            bool encoding_;
 
             Common::ByteBuffer2 encrypted_;
         };
@@ -53,6 +61,12 @@ namespace Transport
         Common::ErrorCode Prepare() override;
         void Consume(size_t length) override;
 
+        bool StartEncode() override;
+        bool TakeFramesToEncode() override;
+        Common::ErrorCode EncodeTakenFrames() override;
+        bool CompleteEncode(Common::ErrorCode const & error) override;
+        bool ContinueEncode() override;
+
         bool PurgeExpiredMessages(Common::StopwatchTime now) override;
 
         void Abort() override;
@@ -63,7 +77,18 @@ namespace Transport
     private:
         void DropExpiredMessage(Frame & frame);
 
+        void DisposeOnAbort(Frame & frame, Common::ErrorCode const & sendError, uint & dropCount);
+
         using FrameQueue = Common::bique<Frame>;
         FrameQueue messageQueue_;
+
+        // messageQueue_ = [frames ready to send, i.e. encrypted if needed][frames waiting for the encode stage]
+        size_t encodedFrameCount_ = 0;
+        bool encodeActive_ = false;
+
+        // owned by the thread running the encode stage
+        std::vector<Frame*> encodingFrames_;
+        size_t encodingPositionCount_ = 0; // including expired frames skipped
+        int64 encodingLengthDelta_ = 0;
     };
 }
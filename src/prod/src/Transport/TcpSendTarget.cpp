@@ -53,6 +53,9 @@ TcpSendTarget::TcpSendTarget(
     , connectionIdleTimeout_(owner.ConnectionIdleTimeout())
     , security_(security)
     , flags_()
+    , bulkLaneCount_(TransportConfig::GetConfig().BulkLaneConnectionCount)
+    , bulkLaneMessageSizeThreshold_(TransportConfig::GetConfig().BulkLaneMessageSizeThreshold)
+    , laneSendLatency_(new LatencyHistogram[bulkLaneCount_ + 1])
 {
     ++objCount_;
 
@@ -108,8 +111,10 @@ Common::ErrorCode TcpSendTarget::SendOneWay(MessageUPtr && message, TimeSpan exp
     Invariant(message);
     MessageUPtr messageLocal(move(message)); // Move message to local for isolation
 
+    auto lane = ChooseLane(*messageLocal, priority);
+
     IConnectionSPtr connection;
-    ErrorCode error =  GetConnectionForSend(connection, priority);
+    ErrorCode error =  GetConnectionForSend(connection, priority, lane);
     if (!error.IsSuccess())
     {
         trace.CannotSend(traceId_, localAddress_, address_, error, messageLocal->TraceId(), messageLocal->Actor, messageLocal->Action);
@@ -276,6 +281,7 @@ void TcpSendTarget::StartConnectionRefresh(IConnection* expiringConnection)
             security_,
             sspiTarget_,
             expiringConnection->GetPriority(),
+            expiringConnection->GetLane(),
             flags_,
             SecurityConfig::GetConfig().SessionRefreshTimeout,
             newConnection);
@@ -384,7 +390,7 @@ TcpConnectionSPtr TcpSendTarget::AddAcceptedConnection(Socket & socket)
             return connection;
         }
 
-        ErrorCode error = AddConnection_CallerHoldingLock(&socket, TransportPriority::Normal, connection);
+        ErrorCode error = AddConnection_CallerHoldingLock(&socket, TransportPriority::Normal, 0, connection);
         if (!error.IsSuccess())
         {
             return connection;
@@ -713,13 +719,50 @@ void TcpSendTarget::OnMessageReceived(
     owner->OnMessageReceived(std::move(message), connection, target);
 }
 
-IConnectionSPtr TcpSendTarget::ChooseExistingConnectionForSendChl(TransportPriority::Enum priority)
+uint TcpSendTarget::ChooseLane(Message & message, TransportPriority::Enum priority)
+{
+    // anonymous targets cannot connect, so they only have the connections accepted on lane 0
+    if ((bulkLaneCount_ == 0) || anonymous_ || (priority != TransportPriority::Normal))
+    {
+        return 0;
+    }
+
+    if ((message.SerializedSize() < bulkLaneMessageSizeThreshold_) || !CanReorder(message))
+    {
+        return 0;
+    }
+
+    return 1 + static_cast<uint>(bulkLaneNext_++ % bulkLaneCount_);
+}
+
+bool TcpSendTarget::CanReorder(Message & message)
+{
+    // Messages on different lanes may be received in a different order than they were sent, federation
+    // and failover protocols expect messages between two nodes to be received in the order they were sent
+    switch (message.Actor)
+    {
+    case Actor::Federation:
+    case Actor::Routing:
+    case Actor::FMM:
+    case Actor::FM:
+    case Actor::RA:
+    case Actor::RS:
+        return false;
+    default:
+        break;
+    }
+
+    // messages routed through federation
+    return !message.Headers.Contains(MessageHeaderId::Routing);
+}
+
+IConnectionSPtr TcpSendTarget::ChooseExistingConnectionForSendChl(TransportPriority::Enum priority, uint lane)
 {
     auto now = Stopwatch::Now();
     for (auto const & connection : connections_)
     {
         bool canSend = connection->CanSend();
-        bool priorityMatch = (connection->GetPriority() == priority);
+        bool priorityMatch = (connection->GetPriority() == priority) && (connection->GetLane() == lane);
 
         if (canSend)
         {
@@ -731,9 +774,26 @@ IConnectionSPtr TcpSendTarget::ChooseExistingConnectionForSendChl(TransportPrior
 }
 
 _Use_decl_annotations_
-ErrorCode TcpSendTarget::GetConnectionForSend(IConnectionSPtr & connection, TransportPriority::Enum priority)
+ErrorCode TcpSendTarget::GetConnectionForSend(IConnectionSPtr & connection, TransportPriority::Enum priority, uint lane)
 {
     connection = nullptr;
+
+    // Fast path for the common case of an existing connection: concurrent senders
+    // only share lock_ in read mode and do not serialize on each other
+    {
+        AcquireReadLock grab(lock_);
+
+        if (!destructing_)
+        {
+            connection = ChooseExistingConnectionForSendChl(priority, lane);
+            if (connection)
+            {
+                connection->AddPendingSend();
+                return ErrorCodeValue::Success;
+            }
+        }
+    }
+
     bool shouldStartConnection = false;
     {
         AcquireWriteLock grab(lock_);
@@ -750,7 +810,7 @@ ErrorCode TcpSendTarget::GetConnectionForSend(IConnectionSPtr & connection, Tran
             return ErrorCodeValue::ObjectClosed;
         }
 
-        connection = ChooseExistingConnectionForSendChl(priority);
+        connection = ChooseExistingConnectionForSendChl(priority, lane);
         if (!connection)
         {
             if (anonymous_)
@@ -759,12 +819,24 @@ ErrorCode TcpSendTarget::GetConnectionForSend(IConnectionSPtr & connection, Tran
             }
 
             TcpConnectionSPtr tcpConnection;
-            auto error = AddConnection_CallerHoldingLock(nullptr, priority, tcpConnection);
+            auto error = AddConnection_CallerHoldingLock(nullptr, priority, lane, tcpConnection);
             if (!error.IsSuccess())
             {
                 return error;
             }
 
+            if (lane > 0)
+            {
+                TcpDatagramTransport::WriteInfo(
+                    TraceType,
+                    traceId_,
+                    "{0}-{1}: created connection {2} for bulk lane {3}",
+                    localAddress_,
+                    address_,
+                    tcpConnection->TraceId(),
+                    lane);
+            }
+
             connection = move(tcpConnection);
             shouldStartConnection = true;
         }
@@ -795,6 +867,7 @@ ErrorCode TcpSendTarget::GetConnectionForSend(IConnectionSPtr & connection, Tran
 _Use_decl_annotations_ ErrorCode TcpSendTarget::AddConnection_CallerHoldingLock(
     Socket * acceptedSocket,
     TransportPriority::Enum priority,
+    uint lane,
     TcpConnectionSPtr & connection)
 {
     auto transport = ownerWPtr_.lock();
@@ -808,6 +881,7 @@ _Use_decl_annotations_ ErrorCode TcpSendTarget::AddConnection_CallerHoldingLock(
         security_,
         sspiTarget_,
         priority,
+        lane,
         flags_,
         transport->ConnectionOpenTimeout(),
         connection);
@@ -1311,3 +1385,35 @@ IConnection const* TcpSendTarget::Test_ActiveConnection() const
     AcquireReadLock grab(lock_);
     return connections_.front().get();
 }
+
+TcpSendTarget::LaneStatistics TcpSendTarget::GetLaneStatistics(uint lane) const
+{
+    LaneStatistics statistics;
+
+    AcquireReadLock grab(lock_);
+    for (auto const & connection : connections_)
+    {
+        if (connection->GetLane() == lane)
+        {
+            ++statistics.ConnectionCount;
+            statistics.MessagesPendingForSend += connection->MessagesPendingForSend();
+            statistics.BytesPendingForSend += connection->BytesPendingForSend();
+        }
+    }
+
+    return statistics;
+}
+
+LatencyHistogram const & TcpSendTarget::LaneSendLatency(uint lane) const
+{
+    Invariant(lane < LaneCount());
+    return laneSendLatency_[lane];
+}
+
+void TcpSendTarget::RecordLaneSendLatency(uint lane, TimeSpan latency)
+{
+    if (lane < LaneCount())
+    {
+        laneSendLatency_[lane].Add(latency);
+    }
+}
@@ -13,6 +13,14 @@ namespace Transport
         friend class TcpConnection;
 
     public:
+        // queue depth of the connections on one lane, see TransportConfig::BulkLaneConnectionCount
+        struct LaneStatistics
+        {
+            size_t ConnectionCount = 0;
+            size_t MessagesPendingForSend = 0;
+            size_t BytesPendingForSend = 0;
+        };
+
         TcpSendTarget(
             TcpDatagramTransport & owner,
             IDatagramTransport::MessageHandlerSPtr const& msgHandler,
@@ -91,6 +99,13 @@ namespace Transport
         void Test_ResumeReceive();
         IConnection const* Test_ActiveConnection() const;
 
+        // lane 0 is the control lane, lanes [1, LaneCount()) are bulk lanes
+        uint LaneCount() const { return bulkLaneCount_ + 1; }
+        LaneStatistics GetLaneStatistics(uint lane) const;
+        // time from enqueueing to sending completion of messages sent on the lane
+        Common::LatencyHistogram const & LaneSendLatency(uint lane) const;
+        void RecordLaneSendLatency(uint lane, Common::TimeSpan latency);
+
     private:
         void SetMessageHandler(IDatagramTransport::MessageHandlerSPtr const & msgHandler);
 
@@ -103,6 +118,7 @@ namespace Transport
         Common::ErrorCode AddConnection_CallerHoldingLock(
             _In_ Common::Socket * acceptedSocket, 
             TransportPriority::Enum,
+            uint lane,
             _Out_ TcpConnectionSPtr & connection);
         void AcquireConnection(
             TcpSendTarget & src,
@@ -110,8 +126,10 @@ namespace Transport
             ListenInstance const & remoteListenInstance);
 
         IConnectionSPtr CreateConnectionChl(Common::Socket * socket = nullptr);
-        Common::ErrorCode GetConnectionForSend(_Out_ IConnectionSPtr & connection, TransportPriority::Enum);
-        IConnectionSPtr ChooseExistingConnectionForSendChl(TransportPriority::Enum);
+        uint ChooseLane(Message & message, TransportPriority::Enum priority);
+        static bool CanReorder(Message & message);
+        Common::ErrorCode GetConnectionForSend(_Out_ IConnectionSPtr & connection, TransportPriority::Enum, uint lane);
+        IConnectionSPtr ChooseExistingConnectionForSendChl(TransportPriority::Enum, uint lane);
 
         void Start();
 
@@ -177,5 +195,10 @@ namespace Transport
         IConnection const* expiringConnection_ = nullptr;
 
         TransportFlags flags_;
+
+        uint const bulkLaneCount_;
+        uint const bulkLaneMessageSizeThreshold_;
+        Common::atomic_uint64 bulkLaneNext_{0};
+        std::unique_ptr<Common::LatencyHistogram[]> laneSendLatency_;
     };
 }
@@ -436,6 +436,13 @@ USHORT TcpTransportUtility::ParsePortString(string const & address)
 
 ErrorCode TcpTransportUtility::TryParseEndpointString(std::string const & address, Common::Endpoint & endpoint)
 {
+#ifdef PLATFORM_UNIX
+    if (Endpoint::IsUnixDomainAddress(address))
+    {
+        return Endpoint::TryParseUnixDomain(address, endpoint);
+    }
+#endif
+
     string host;
     string port;
 
@@ -50,6 +50,18 @@ namespace Transport
 
         // TCP send batch size limit in bytes
         INTERNAL_CONFIG_ENTRY(uint, "Transport", SendBatchSizeLimit, 16 * 1024 * 1024, Common::ConfigEntryUpgradePolicy::Static, Common::UIntNoLessThan(64 * 1024));
+        // Number of bulk lane connections per send target in addition to the control lane connection. Normal priority
+        // messages at or above BulkLaneMessageSizeThreshold are sent round-robin on bulk lanes, so that small messages
+        // on the control lane are not queued behind them. Messages sent on different lanes are not received in order,
+        // so messages of federation and failover actors and messages routed through federation always use the control
+        // lane. Set to 0 to send everything on one connection per priority.
+        INTERNAL_CONFIG_ENTRY(uint, "Transport", BulkLaneConnectionCount, 0, Common::ConfigEntryUpgradePolicy::Static, Common::InRange<uint>(0, 16));
+        // Serialized message size in bytes from which messages are sent on bulk lanes, see BulkLaneConnectionCount
+        INTERNAL_CONFIG_ENTRY(uint, "Transport", BulkLaneMessageSizeThreshold, 256 * 1024, Common::ConfigEntryUpgradePolicy::Static, Common::UIntGreaterThan(0));
+        // Message bodies larger than this are sent as fragments of at most this many bytes, so that other messages on the
+        // same connection can be sent between fragments. Receivers reassemble fragments before dispatching. Set to 0 to
+        // disable. Must only be enabled after all nodes are upgraded to a version that reassembles fragments.
+        INTERNAL_CONFIG_ENTRY(uint, "Transport", MessageFragmentSize, 0, Common::ConfigEntryUpgradePolicy::Static);
         // Send timeout for detecting stuck connection. TCP failure reports are not reliable in some environment.
         // This may need to be adjusted according to available network bandwidth and size of outbound data (*MaxMessageSize/*SendQueueSizeLimit).
         PUBLIC_CONFIG_ENTRY(Common::TimeSpan, "Transport", SendTimeout, Common::TimeSpan::FromSeconds(300), Common::ConfigEntryUpgradePolicy::Dynamic);
@@ -64,6 +76,11 @@ namespace Transport
         // SecPkgContext_StreamSizes{cbHeader + cbMaximumMessage + cbTrailer}
         INTERNAL_CONFIG_ENTRY(uint, "Transport", SslReceiveChunkSize, 64*1024, Common::ConfigEntryUpgradePolicy::Static, Common::InRange<uint>(32*1024, 8*1024*1024));
 
+        // Linux only: once SSL negotiation completes, hand TLS record encryption and decryption over to the kernel (kTLS),
+        // so that outgoing frames are written as plaintext gather lists. Connections keep using OpenSSL for records when
+        // the negotiated protocol or cipher, or the kernel, does not support it.
+        INTERNAL_CONFIG_ENTRY(bool, "Transport", KernelTlsOffloadEnabled, false, Common::ConfigEntryUpgradePolicy::Static);
+
         // Indicate how long an outgoing message can be queued until being sent or dropped, set to 0 to disable
         INTERNAL_CONFIG_ENTRY(Common::TimeSpan, "Transport", DefaultOutgoingMessageExpiration, Common::TimeSpan::FromSeconds(180), Common::ConfigEntryUpgradePolicy::Static, Common::TimeSpanNoLessThan(Common::TimeSpan::Zero));
         // Indicate how often periodic outgoing message expiration check is done, set to 0 to disable
@@ -110,6 +127,10 @@ namespace Transport
         INTERNAL_CONFIG_ENTRY(Common::TimeSpan, "Transport", IpcReconnectDelay, Common::TimeSpan::FromSeconds(3), Common::ConfigEntryUpgradePolicy::Static, Common::TimeSpanNoLessThan(Common::TimeSpan::Zero));
         // IpcClient exits process when disconnect count reaches the following limit, set to 0 to disable such process exit.
         INTERNAL_CONFIG_ENTRY(uint, "Transport", IpcClientDisconnectLimit, 100, Common::ConfigEntryUpgradePolicy::Dynamic);
+        // Linux only: IpcServer listens on a unix domain socket created in IpcUnixDomainSocketDirectory instead of TCP loopback.
+        // IpcClient must be able to access the directory, which is not the case for containers by default.
+        INTERNAL_CONFIG_ENTRY(bool, "Transport", IpcUnixDomainSocketEnabled, false, Common::ConfigEntryUpgradePolicy::Static);
+        INTERNAL_CONFIG_ENTRY(std::string, "Transport", IpcUnixDomainSocketDirectory, "/tmp", Common::ConfigEntryUpgradePolicy::Static);
 
         // Default close delay for scheduled close
         DEPRECATED_CONFIG_ENTRY(Common::TimeSpan, "Transport", DefaultCloseDelay, Common::TimeSpan::FromSeconds(60), Common::ConfigEntryUpgradePolicy::Dynamic, Common::TimeSpanNoLessThan(Common::TimeSpan::Zero));
@@ -123,6 +144,12 @@ namespace Transport
         // Whether to enable TCP fast loopback
         INTERNAL_CONFIG_ENTRY(bool, "Transport", TcpFastLoopbackEnabled, true, Common::ConfigEntryUpgradePolicy::Dynamic);
 
+        // Whether concurrent senders queue messages to a connection without taking the connection lock, only the sender that
+        // wins the drain role takes the lock and moves all queued messages into the send buffer at once. Send failures found
+        // while draining are reported through Message::OnSendStatus, and through the return value of SendOneWay only to the
+        // sender that drained its own message.
+        INTERNAL_CONFIG_ENTRY(bool, "Transport", LockFreeSendQueueEnabled, false, Common::ConfigEntryUpgradePolicy::Static);
+
         // Whether to enable TCP_NODELAY
         INTERNAL_CONFIG_ENTRY(bool, "Transport", TcpNoDelayEnabled, true, Common::ConfigEntryUpgradePolicy::Static);
 
@@ -22,6 +22,7 @@
 #include <openssl/ssl.h>
 #include "Common/CryptoUtility.Linux.h"
 #include "Transport/TransportSecurity.Linux.h"
+#include "Transport/KernelTls.Linux.h"
 #else
 #include <schannel.h>
 #include <Ws2tcpip.h>
@@ -36,6 +37,7 @@
 #include "Transport/TcpFrameHeader.h"
 #include "Transport/ListenInstance.h"
 #include "Transport/SecurityNegotiationHeader.h"
+#include "Transport/MessageFragmentHeader.h"
 #include "Transport/IConnection.h"
 #include "Transport/IoBuffer.h"
 #include "Transport/ReceiveBuffer.h"
@@ -48,6 +50,7 @@
 #include "Transport/LTSendBuffer.h"
 #include "Transport/LTReceiveBuffer.h"
 #include "Transport/LTBufferFactory.h"
+#include "Transport/MessageFragments.h"
 #include "Transport/TcpConnection.h"
 #include "Transport/TcpSendTarget.h"
 #include "Transport/IListenSocket.h"
@@ -489,6 +489,236 @@ class OverlayLog;
 class OverlayManager;
 class LogStreamOpenGateContext;
 
+//
+// KIoBufferElementPool hands out page aligned KIoBufferElements from
+// size classes of 4K up to 1MB. Buffers are carved out of 1MB slabs
+// that are touched when allocated so that steady state writes do not
+// page fault. A slab serves one size class at a time and a buffer goes
+// back to its slab when the KIoBufferElement that uses it is destroyed.
+// Once all of the buffers of a slab are back the slab is idle and can
+// be handed to any size class; a few idle slabs are kept and the rest
+// are freed, so the memory the pool holds follows what is in use. The
+// pool stops carving new slabs once its capacity is reached;
+// allocations that do not fit in a size class or in the capacity are
+// served by KIoBufferElement::CreateNew. Buffers are zeroed when
+// handed out so that no data is carried over from an earlier user.
+//
+// On Linux slabs are carved out of huge pages mapped with MAP_HUGETLB
+// and locked with mlock, so that buffers are not paged out and use
+// fewer TLB entries. A huge page is unmapped once all of the slabs
+// carved from it are freed. Only the slabs carved count against the
+// capacity, so the pool may hold up to one huge page more. If no huge
+// page can be mapped the pool stops trying and, as on Windows and in
+// kernel mode, slabs come from the page aligned allocator.
+//
+class KIoBufferElementPool : public KObject<KIoBufferElementPool>, public KShared<KIoBufferElementPool>
+{
+    K_FORCE_SHARED(KIoBufferElementPool);
+
+    public:
+        KIoBufferElementPool(
+            __in LONGLONG Capacity
+            );
+
+        static NTSTATUS
+        Create(
+            __in LONGLONG Capacity,
+            __in KAllocator& Allocator,
+            __in ULONG AllocationTag,
+            __out KIoBufferElementPool::SPtr& Context
+            );
+
+        //
+        // Size must be a multiple of 4K
+        //
+        NTSTATUS
+        AllocateElement(
+            __in ULONG Size,
+            __out KIoBufferElement::SPtr& IoBufferElement,
+            __out PVOID& Buffer
+            );
+
+        VOID SetCapacity(
+            __in LONGLONG Capacity
+            );
+
+        inline LONGLONG GetCapacity()
+        {
+            return(_Capacity);
+        }
+
+        inline LONGLONG GetSlabBytes()
+        {
+            return(_SlabBytes);
+        }
+
+        inline ULONG GetIdleSlabCount()
+        {
+            return(_IdleSlabs.Count());
+        }
+
+        inline LONGLONG GetPooledAllocations()
+        {
+            return(_PooledAllocations);
+        }
+
+        inline LONGLONG GetUnpooledAllocations()
+        {
+            return(_UnpooledAllocations);
+        }
+
+        static const ULONG _MinimumClassSize = 0x1000;       // 4K
+        static const ULONG _MaximumClassSize = 0x100000;     // 1MB
+        static const ULONG _NumberClasses = 9;
+        static const ULONG _SlabSize = _MaximumClassSize;
+        static const ULONG _MaximumIdleSlabs = 4;
+
+    private:
+        class Slab;
+#if defined(PLATFORM_UNIX)
+        class HugePageMapping;
+#endif
+
+        class PooledElement : public KIoBufferElement
+        {
+            K_FORCE_SHARED(PooledElement);
+
+            public:
+                static NTSTATUS
+                Create(
+                    __in KIoBufferElementPool& Pool,
+                    __in Slab& BufferSlab,
+                    __in PVOID Buffer,
+                    __in ULONG Size,
+                    __out KIoBufferElement::SPtr& Context
+                    );
+
+            private:
+                PooledElement(
+                    __in KIoBufferElementPool& Pool,
+                    __in Slab& BufferSlab,
+                    __in PVOID Buffer,
+                    __in ULONG Size
+                    );
+
+            private:
+                KIoBufferElementPool::SPtr _Pool;
+                Slab* _Slab;
+        };
+
+        //
+        // Free buffers are linked through their first bytes
+        //
+        struct FreeBuffer
+        {
+            FreeBuffer* _Next;
+        };
+
+        //
+        // A slab is on the list of its size class while it has free
+        // buffers, on the idle list while none of its buffers are in
+        // use and on no list while all of them are
+        //
+        class Slab
+        {
+            public:
+                KListEntry _ListEntry;
+                PVOID _Buffer;
+                ULONG _ClassIndex;
+                ULONG _BuffersInUse;
+                FreeBuffer* _FreeBuffers;
+#if defined(PLATFORM_UNIX)
+                HugePageMapping* _Mapping;      // nullptr if _Buffer is from the page aligned allocator
+#endif
+        };
+
+#if defined(PLATFORM_UNIX)
+        //
+        // A huge page that slabs are carved from in order. It is
+        // unmapped when no slab carved from it is in use and no more
+        // slabs are to be carved from it
+        //
+        class HugePageMapping
+        {
+            public:
+                PVOID _Address;
+                SIZE_T _Size;
+                ULONG _SlabsCarved;
+                ULONG _SlabsInUse;
+        };
+#endif
+
+        class SizeClass
+        {
+            public:
+                SizeClass() :
+                    _Slabs(FIELD_OFFSET(Slab, _ListEntry))
+                {
+                }
+
+                KNodeList<Slab> _Slabs;
+        };
+
+        static ULONG GetClassIndex(
+            __in ULONG Size
+            );
+
+        static inline ULONG GetClassSize(
+            __in ULONG ClassIndex
+            )
+        {
+            return(_MinimumClassSize << ClassIndex);
+        }
+
+        PVOID AllocateBuffer(
+            __in ULONG ClassIndex,
+            __out Slab*& BufferSlab
+            );
+
+        VOID ReturnBuffer(
+            __in Slab& BufferSlab,
+            __in PVOID Buffer
+            );
+
+        Slab* CarveSlab();
+
+        VOID FreeSlab(
+            __in Slab* FreedSlab
+            );
+
+#if defined(PLATFORM_UNIX)
+        PVOID CarveHugePageSlab(
+            __out HugePageMapping*& Mapping
+            );
+
+        VOID FreeHugePageSlab(
+            __in HugePageMapping& Mapping
+            );
+#endif
+
+        VOID AssignSlab(
+            __in Slab& AssignedSlab,
+            __in ULONG ClassIndex
+            );
+
+        PVOID TakeBuffer(
+            __in Slab& BufferSlab
+            );
+
+    private:
+        KSpinLock _Lock;
+        LONGLONG _Capacity;
+        LONGLONG _SlabBytes;
+        LONGLONG _PooledAllocations;
+        LONGLONG _UnpooledAllocations;
+        SizeClass _Classes[_NumberClasses];
+        KNodeList<Slab> _IdleSlabs;
+#if defined(PLATFORM_UNIX)
+        SIZE_T _HugePageSize;                   // 0 once huge pages are not used
+        HugePageMapping* _CarvingMapping;       // Huge page with slabs left to carve
+#endif
+};
+
 class ThrottledKIoBufferAllocator : public KObject<ThrottledKIoBufferAllocator>, public KShared<ThrottledKIoBufferAllocator>
 {
     K_FORCE_SHARED(ThrottledKIoBufferAllocator);
@@ -679,6 +909,53 @@ class ThrottledKIoBufferAllocator : public KObject<ThrottledKIoBufferAllocator>,
     {
         _AllocationTimeoutInMs = AllocationTimeoutInMs;
     }
+
+    //
+    // Records held by the overlay stream read caches are charged
+    // against a budget that is a fraction of the write buffer memory
+    // pool. Nothing new is charged while writes are waiting for
+    // memory.
+    //
+    static const LONG _ReadCacheLimitDivisor = 4;
+    static const LONGLONG _ReadCacheNoLimitSize = 64 * 1024 * 1024;
+
+    LONGLONG GetReadCacheLimit();
+
+    BOOLEAN TryChargeReadCache(
+        __in LONG Size
+    );
+
+    VOID UnchargeReadCache(
+        __in LONG Size
+    );
+
+    inline LONGLONG GetReadCacheUsage()
+    {
+        return(_ReadCacheAllocations);
+    }
+
+    //
+    // Buffers handed out by the allocator come from a pool of page
+    // aligned buffers that is sized from the allocation limit but
+    // never keeps more than _BufferPoolMaximumCapacity. Memory taken
+    // from the pool is not charged against the limit; callers that
+    // need throttling use AsyncAllocateKIoBufferContext. On Linux the
+    // pool is backed by locked huge pages when the system has them
+    // reserved and by the page aligned allocator otherwise, which is
+    // what Windows and kernel mode builds always use.
+    //
+    static const LONGLONG _BufferPoolMaximumCapacity = 64 * 1024 * 1024;
+
+    NTSTATUS AllocateKIoBufferElement(
+        __in ULONG Size,
+        __out KIoBufferElement::SPtr& IoBufferElement,
+        __out PVOID& Buffer
+    );
+
+    inline KIoBufferElementPool& GetBufferPool()
+    {
+        return(*_BufferPool);
+    }
     
     VOID Shutdown();        
 
@@ -710,6 +987,8 @@ class ThrottledKIoBufferAllocator : public KObject<ThrottledKIoBufferAllocator>,
 
         BOOLEAN RestartTimerIfNeeded();
 
+        VOID UpdateBufferPoolCapacity();
+
         ULONG GetAllocationTimeoutInMs()
         {
             return(_AllocationTimeoutInMs);
@@ -728,6 +1007,185 @@ class ThrottledKIoBufferAllocator : public KObject<ThrottledKIoBufferAllocator>,
         BOOLEAN _ShuttingDown;
         KNodeList<AsyncAllocateKIoBufferContext> _WaitingAllocsList;
         LONGLONG _CurrentAllocations;
+        LONGLONG _ReadCacheAllocations;
+        KIoBufferElementPool::SPtr _BufferPool;
+};
+
+//
+// OverlayReadCache keeps copies of records recently written to or read
+// from an overlay stream so that reading them again does not go to the
+// shared or dedicated log. Records are looked up by ASN and only
+// returned for the version the logs report for that ASN, so records
+// rewritten with a higher version are never returned stale. Memory is
+// charged to the read cache budget of the ThrottledKIoBufferAllocator
+// and the least recently used records are evicted to make room.
+//
+class OverlayReadCache : public KObject<OverlayReadCache>, public KShared<OverlayReadCache>
+{
+    K_FORCE_SHARED(OverlayReadCache);
+
+    public:
+        OverlayReadCache(
+            __in ThrottledKIoBufferAllocator& ThrottledAllocator
+            );
+
+        static NTSTATUS
+        Create(
+            __in ThrottledKIoBufferAllocator& ThrottledAllocator,
+            __in KAllocator& Allocator,
+            __in ULONG AllocationTag,
+            __out OverlayReadCache::SPtr& Context
+            );
+
+        //
+        // Returns a copy of the record if it is cached with the
+        // version passed
+        //
+        BOOLEAN
+        Lookup(
+            __in RvdLogAsn RecordAsn,
+            __in ULONGLONG Version,
+            __out KBuffer::SPtr& MetaDataBuffer,
+            __out KIoBuffer::SPtr& IoBuffer
+            );
+
+        BOOLEAN
+        IsCached(
+            __in RvdLogAsn RecordAsn,
+            __in ULONGLONG Version
+            );
+
+        //
+        // Caches a copy of the record unless a higher version is
+        // already cached, the record is at or below the truncation
+        // point or there is no room in the budget for it
+        //
+        VOID
+        Add(
+            __in RvdLogAsn RecordAsn,
+            __in ULONGLONG Version,
+            __in KBuffer& MetaDataBuffer,
+            __in KIoBuffer& IoBuffer
+            );
+
+        //
+        // Drops records at or below the truncation point
+        //
+        VOID
+        Truncate(
+            __in RvdLogAsn TruncationAsn
+            );
+
+        VOID
+        Clear(
+            );
+
+        inline ULONGLONG GetHits()
+        {
+            return(_Hits);
+        }
+
+        inline ULONGLONG GetMisses()
+        {
+            return(_Misses);
+        }
+
+        inline ULONGLONG GetEvictions()
+        {
+            return(_Evictions);
+        }
+
+        inline LONGLONG GetBytesCached()
+        {
+            return(_BytesCached);
+        }
+
+        //
+        // Larger records are not worth the copy
+        //
+        static const ULONG _MaximumRecordSize = 1024 * 1024;
+
+    private:
+        class Entry : public KObject<Entry>
+        {
+            friend OverlayReadCache;
+
+            public:
+                Entry();
+                ~Entry();
+
+                static LONG
+                Comparator(Entry& Left, Entry& Right)
+                {
+                    // -1 if Left < Right
+                    // +1 if Left > Right
+                    //  0 if Left == Right
+                    if (Left._RecordAsn < Right._RecordAsn)
+                    {
+                        return(-1);
+                    } else if (Left._RecordAsn > Right._RecordAsn) {
+                        return(+1);
+                    }
+
+                    return(0);
+                };
+
+                static ULONG
+                GetTableLinksOffset() { return FIELD_OFFSET(Entry, _TableEntry); };
+
+                static ULONG
+                GetListLinksOffset() { return FIELD_OFFSET(Entry, _ListEntry); };
+
+            private:
+                KTableEntry _TableEntry;
+                KListEntry _ListEntry;
+                RvdLogAsn _RecordAsn;
+                ULONGLONG _Version;
+                LONG _Size;
+                KBuffer::SPtr _MetaDataBuffer;
+                KIoBuffer::SPtr _IoBuffer;
+        };
+
+        NTSTATUS
+        CopyRecord(
+            __in KBuffer& MetaDataBuffer,
+            __in KIoBuffer& IoBuffer,
+            __out KBuffer::SPtr& MetaDataBufferCopy,
+            __out KIoBuffer::SPtr& IoBufferCopy
+            );
+
+        //
+        // Must be called with _Lock held, the entry is freed
+        // afterwards outside of the lock
+        //
+        VOID
+        RemoveEntryNoLock(
+            __in Entry& CacheEntry
+            );
+
+        VOID
+        FreeEntries(
+            __in KNodeList<Entry>& Entries
+            );
+
+    private:
+        ThrottledKIoBufferAllocator::SPtr _ThrottledAllocator;
+
+        //
+        // _Lock protects _Table, _LruList and _TruncationAsn. Entries
+        // are in the table by ASN and in the list with the most
+        // recently used at the head
+        //
+        KSpinLock _Lock;
+        KNodeTable<Entry> _Table;
+        KNodeList<Entry> _LruList;
+        Entry _LookupKey;
+        RvdLogAsn _TruncationAsn;
+
+        LONGLONG _BytesCached;
+        ULONGLONG _Hits;
+        ULONGLONG _Misses;
+        ULONGLONG _Evictions;
 };
 
 class OverlayStreamBase : public WrappedServiceBase
@@ -919,6 +1377,24 @@ class OverlayStream : public OverlayStreamBase
             return(_DedicatedContainerId);
         }
 
+        inline OverlayReadCache::SPtr GetReadCache()
+        {
+            return(_ReadCache);
+        }
+
+        //
+        // Called as each record is read so that a reader moving
+        // forward through the stream is detected and the records it
+        // will read next are read ahead into the read cache
+        //
+        VOID NoteRecordRead(
+            __in RvdLogAsn RecordAsn
+            );
+
+        static const ULONG _ReadAheadTriggerCount = 4;
+        static const ULONG _ReadAheadMaxRecords = 32;
+        static const ULONG _ReadAheadMaxOutstanding = 8;
+
 #if DBG
         inline ULONG GetSharedTimerDelay()
         {
@@ -3116,6 +3592,15 @@ class OverlayStream : public OverlayStreamBase
                     __in_opt KAsyncContextBase* const ParentAsyncContext,
                     __in_opt KAsyncContextBase::CompletionCallback CallbackPtr);
 
+                //
+                // Reads the record only to place it in the read cache
+                //
+                VOID
+                StartReadAhead(
+                    __in RvdLogAsn RecordAsn,
+                    __in_opt KAsyncContextBase* const ParentAsyncContext,
+                    __in_opt KAsyncContextBase::CompletionCallback CallbackPtr);
+
             protected:
                 VOID
                 OnStart(
@@ -3138,7 +3623,8 @@ class OverlayStream : public OverlayStreamBase
                 DetermineRecordLocation(
                     __out BOOLEAN& ReadFromDedicated,
                     __out RvdLogAsn& AsnToRead,
-                    __out RvdLogStream::AsyncReadContext::ReadType& ReadType
+                    __out RvdLogStream::AsyncReadContext::ReadType& ReadType,
+                    __out ULONGLONG& VersionToRead
                     );
 
                 NTSTATUS TrimLogicalLogRecord(
@@ -3182,6 +3668,9 @@ class OverlayStream : public OverlayStreamBase
                 KBuffer::SPtr* _MetaDataBuffer;
                 KIoBuffer::SPtr* _IoBuffer;
                 BOOLEAN* _ReadFromDedicated;
+                BOOLEAN _IsReadAhead;
+                KBuffer::SPtr _ReadAheadMetaDataBuffer;
+                KIoBuffer::SPtr _ReadAheadIoBuffer;
 
                 //
                 // Members needed for functionality (reused)
@@ -3451,6 +3940,34 @@ class OverlayStream : public OverlayStreamBase
 
         ThrottledKIoBufferAllocator::SPtr _ThrottledAllocator;
 
+        //
+        // Copies of records recently written or read. Streams for the
+        // logical log read through the coalesce buffers instead.
+        //
+        OverlayReadCache::SPtr _ReadCache;
+
+        //
+        // Read ahead state, protected by _ReadAheadLock. Only the
+        // thread that sets _ReadAheadRunning runs StartReadAhead.
+        // _ReadAheadNextAsn is the last record read ahead and
+        // _ReadAheadRecords the number read ahead and not yet read.
+        //
+        VOID StartReadAhead();
+
+        VOID ReadAheadCompletion(
+            __in_opt KAsyncContextBase* const ParentAsync,
+            __in KAsyncContextBase& Async
+            );
+
+        KSpinLock _ReadAheadLock;
+        RvdLogAsn _ReadAheadLastAsn;
+        RvdLogAsn _ReadAheadNextAsn;
+        ULONG _ReadAheadSequentialReads;
+        ULONG _ReadAheadRecords;
+        ULONG _ReadAheadOutstanding;
+        BOOLEAN _ReadAheadRunning;
+        ULONGLONG _ReadAheadCount;
+
         //
         // This is a list of KtlLogStreamKernel objects exposed for
         // this stream
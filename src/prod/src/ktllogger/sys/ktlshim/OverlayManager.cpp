@@ -9,6 +9,11 @@
 
 #include "KtlLogShimKernel.h"
 
+#if defined(PLATFORM_UNIX)
+#include <errno.h>
+#include <sys/mman.h>
+#endif
+
 #define VERBOSE 1
 
 //
@@ -2556,6 +2561,639 @@ OverlayManager::CreateAsyncCloseLogContext(
 }
 
 
+//
+// KIoBufferElementPool
+//
+KIoBufferElementPool::PooledElement::PooledElement()
+{
+    // Not used
+    KInvariant(FALSE);
+}
+
+KIoBufferElementPool::PooledElement::~PooledElement()
+{
+#if defined(PLATFORM_UNIX)
+    //
+    // The buffer is reused so the page protection must be put back
+    // before it is returned to the pool
+    //
+    if (_PageAccessChanged)
+    {
+        DWORD oldPageProtection;
+
+        VirtualProtect(_Buffer,
+                       KIoBufferElementPool::GetClassSize(_Slab->_ClassIndex),
+                       PAGE_READWRITE,
+                       &oldPageProtection);
+        _PageAccessChanged = FALSE;
+    }
+#endif
+
+    _Pool->ReturnBuffer(*_Slab, _Buffer);
+    _Pool = nullptr;
+    _Slab = nullptr;
+
+    _Buffer = nullptr;
+    _Size = 0;
+}
+
+KIoBufferElementPool::PooledElement::PooledElement(
+    __in KIoBufferElementPool& Pool,
+    __in Slab& BufferSlab,
+    __in PVOID Buffer,
+    __in ULONG Size
+    )
+{
+    _Pool = &Pool;
+    _Slab = &BufferSlab;
+
+    //
+    // KIoBufferElement fields. The buffer belongs to the pool and so
+    // is not freed by the KIoBufferElement destructor.
+    //
+    _FreeBuffer = FALSE;
+    _IsReference = FALSE;
+    _Buffer = Buffer;
+    _Size = Size;
+#if defined(PLATFORM_UNIX)
+    _PageAccessChanged = FALSE;
+#endif
+}
+
+NTSTATUS
+KIoBufferElementPool::PooledElement::Create(
+    __in KIoBufferElementPool& Pool,
+    __in Slab& BufferSlab,
+    __in PVOID Buffer,
+    __in ULONG Size,
+    __out KIoBufferElement::SPtr& Context
+    )
+{
+    PooledElement::SPtr context;
+
+    context = _new(Pool.GetThisAllocationTag(), Pool.GetThisAllocator()) PooledElement(Pool, BufferSlab, Buffer, Size);
+    if (! context)
+    {
+        KTraceOutOfMemory(0, STATUS_INSUFFICIENT_RESOURCES, nullptr, Size, 0);
+        return(STATUS_INSUFFICIENT_RESOURCES);
+    }
+
+    Context = context.RawPtr();
+    return(STATUS_SUCCESS);
+}
+
+#if defined(PLATFORM_UNIX)
+//
+// Returns the default huge page size if slabs can be carved from it,
+// 0 otherwise
+//
+static SIZE_T
+GetHugePageSizeForSlabs(
+    __in ULONG SlabSize
+    )
+{
+    FILE* fp;
+    CHAR line[128];
+    ULONGLONG hugePageSizeKb = 0;
+
+    fp = fopen("/proc/meminfo", "r");
+    if (fp == nullptr)
+    {
+        return(0);
+    }
+
+    while (fgets(line, sizeof(line), fp) != nullptr)
+    {
+        if (sscanf(line, "Hugepagesize: %llu kB", &hugePageSizeKb) == 1)
+        {
+            break;
+        }
+    }
+    fclose(fp);
+
+    SIZE_T hugePageSize = (SIZE_T)(hugePageSizeKb * 1024);
+    if ((hugePageSize < SlabSize) || ((hugePageSize % SlabSize) != 0))
+    {
+        return(0);
+    }
+
+    return(hugePageSize);
+}
+#endif
+
+KIoBufferElementPool::KIoBufferElementPool(
+    __in LONGLONG Capacity
+    ) :
+    _Capacity(Capacity),
+    _SlabBytes(0),
+    _PooledAllocations(0),
+    _UnpooledAllocations(0),
+    _IdleSlabs(FIELD_OFFSET(Slab, _ListEntry))
+#if defined(PLATFORM_UNIX)
+    ,
+    _HugePageSize(GetHugePageSizeForSlabs(_SlabSize)),
+    _CarvingMapping(nullptr)
+#endif
+{
+}
+
+KIoBufferElementPool::~KIoBufferElementPool()
+{
+    Slab* slab;
+
+    //
+    // Every pooled element holds a reference on the pool so all of the
+    // slabs are idle by now
+    //
+    for (ULONG i = 0; i < _NumberClasses; i++)
+    {
+        KInvariant(_Classes[i]._Slabs.IsEmpty());
+    }
+
+    while ((slab = _IdleSlabs.RemoveHead()) != nullptr)
+    {
+        FreeSlab(slab);
+    }
+
+#if defined(PLATFORM_UNIX)
+    if (_CarvingMapping != nullptr)
+    {
+        KInvariant(_CarvingMapping->_SlabsInUse == 0);
+        munmap(_CarvingMapping->_Address, _CarvingMapping->_Size);
+        _delete(_CarvingMapping);
+        _CarvingMapping = nullptr;
+    }
+#endif
+}
+
+NTSTATUS
+KIoBufferElementPool::Create(
+    __in LONGLONG Capacity,
+    __in KAllocator& Allocator,
+    __in ULONG AllocationTag,
+    __out KIoBufferElementPool::SPtr& Context
+    )
+{
+    NTSTATUS status;
+    KIoBufferElementPool::SPtr context;
+
+    context = _new(AllocationTag, Allocator) KIoBufferElementPool(Capacity);
+    if (context == nullptr)
+    {
+        status = STATUS_INSUFFICIENT_RESOURCES;
+        KTraceOutOfMemory(0, status, NULL, AllocationTag, 0);
+        return(status);
+    }
+
+    status = context->Status();
+    if (! NT_SUCCESS(status))
+    {
+        return(status);
+    }
+
+    Context = Ktl::Move(context);
+
+    return(STATUS_SUCCESS);
+}
+
+VOID
+KIoBufferElementPool::SetCapacity(
+    __in LONGLONG Capacity
+    )
+{
+    KNodeList<Slab> freedSlabs(FIELD_OFFSET(Slab, _ListEntry));
+    Slab* slab;
+
+    //
+    // Idle slabs above the new capacity are freed now; slabs in use
+    // are freed as they become idle
+    //
+    K_LOCK_BLOCK(_Lock)
+    {
+        _Capacity = Capacity;
+
+        while ((_SlabBytes > _Capacity) && ((slab = _IdleSlabs.RemoveHead()) != nullptr))
+        {
+            _SlabBytes -= _SlabSize;
+            freedSlabs.AppendTail(slab);
+        }
+    }
+
+    while ((slab = freedSlabs.RemoveHead()) != nullptr)
+    {
+        FreeSlab(slab);
+    }
+}
+
+ULONG
+KIoBufferElementPool::GetClassIndex(
+    __in ULONG Size
+    )
+{
+    ULONG classIndex = 0;
+
+    while ((classIndex < _NumberClasses) && (GetClassSize(classIndex) < Size))
+    {
+        classIndex++;
+    }
+
+    return(classIndex);
+}
+
+NTSTATUS
+KIoBufferElementPool::AllocateElement(
+    __in ULONG Size,
+    __out KIoBufferElement::SPtr& IoBufferElement,
+    __out PVOID& Buffer
+    )
+{
+    NTSTATUS status;
+    ULONG classIndex;
+    PVOID buffer = nullptr;
+    Slab* slab = nullptr;
+
+    classIndex = GetClassIndex(Size);
+    if (classIndex < _NumberClasses)
+    {
+        buffer = AllocateBuffer(classIndex, slab);
+    }
+
+    if (buffer == nullptr)
+    {
+        //
+        // Too large for the pool or the pool is at capacity
+        //
+        InterlockedAdd64(&_UnpooledAllocations, 1);
+        return(KIoBufferElement::CreateNew(Size, IoBufferElement, Buffer, GetThisAllocator(), GetThisAllocationTag()));
+    }
+
+    status = PooledElement::Create(*this, *slab, buffer, Size, IoBufferElement);
+    if (! NT_SUCCESS(status))
+    {
+        ReturnBuffer(*slab, buffer);
+        return(status);
+    }
+
+    //
+    // The buffer may hold data of an earlier user
+    //
+    RtlZeroMemory(buffer, Size);
+
+    InterlockedAdd64(&_PooledAllocations, 1);
+    Buffer = buffer;
+
+    return(STATUS_SUCCESS);
+}
+
+VOID
+KIoBufferElementPool::AssignSlab(
+    __in Slab& AssignedSlab,
+    __in ULONG ClassIndex
+    )
+{
+    ULONG classSize = GetClassSize(ClassIndex);
+    PUCHAR buffer = (PUCHAR)AssignedSlab._Buffer;
+
+    //
+    // Called with the lock held on a slab that is on no list
+    //
+    AssignedSlab._ClassIndex = ClassIndex;
+    AssignedSlab._BuffersInUse = 0;
+    AssignedSlab._FreeBuffers = nullptr;
+
+    for (ULONG offset = _SlabSize; offset > 0; offset -= classSize)
+    {
+        FreeBuffer* freeBuffer = (FreeBuffer*)(buffer + offset - classSize);
+
+        freeBuffer->_Next = AssignedSlab._FreeBuffers;
+        AssignedSlab._FreeBuffers = freeBuffer;
+    }
+
+    _Classes[ClassIndex]._Slabs.AppendTail(&AssignedSlab);
+}
+
+PVOID
+KIoBufferElementPool::TakeBuffer(
+    __in Slab& BufferSlab
+    )
+{
+    FreeBuffer* freeBuffer = BufferSlab._FreeBuffers;
+
+    //
+    // Called with the lock held on a slab on the list of its class
+    //
+    BufferSlab._FreeBuffers = freeBuffer->_Next;
+    BufferSlab._BuffersInUse++;
+
+    if (BufferSlab._FreeBuffers == nullptr)
+    {
+        _Classes[BufferSlab._ClassIndex]._Slabs.Remove(&BufferSlab);
+    }
+
+    return((PVOID)freeBuffer);
+}
+
+PVOID
+KIoBufferElementPool::AllocateBuffer(
+    __in ULONG ClassIndex,
+    __out Slab*& BufferSlab
+    )
+{
+    BOOLEAN reserved = FALSE;
+    PVOID buffer = nullptr;
+    Slab* slab = nullptr;
+
+    K_LOCK_BLOCK(_Lock)
+    {
+        slab = _Classes[ClassIndex]._Slabs.PeekHead();
+        if (slab == nullptr)
+        {
+            //
+            // Any size class can take an idle slab
+            //
+            slab = _IdleSlabs.RemoveHead();
+            if (slab != nullptr)
+            {
+                AssignSlab(*slab, ClassIndex);
+            }
+        }
+
+        if (slab != nullptr)
+        {
+            buffer = TakeBuffer(*slab);
+        }
+        else if ((_SlabBytes + _SlabSize) <= _Capacity)
+        {
+            _SlabBytes += _SlabSize;
+            reserved = TRUE;
+        }
+    }
+
+    if (reserved)
+    {
+        slab = CarveSlab();
+
+        K_LOCK_BLOCK(_Lock)
+        {
+            if (slab == nullptr)
+            {
+                _SlabBytes -= _SlabSize;
+            }
+            else
+            {
+                AssignSlab(*slab, ClassIndex);
+                buffer = TakeBuffer(*slab);
+            }
+        }
+    }
+
+    BufferSlab = slab;
+    return(buffer);
+}
+
+VOID
+KIoBufferElementPool::ReturnBuffer(
+    __in Slab& BufferSlab,
+    __in PVOID Buffer
+    )
+{
+    FreeBuffer* freeBuffer = (FreeBuffer*)Buffer;
+    Slab* freedSlab = nullptr;
+
+    K_LOCK_BLOCK(_Lock)
+    {
+        KIoBufferElementPool::SizeClass& sizeClass = _Classes[BufferSlab._ClassIndex];
+
+        if (BufferSlab._FreeBuffers == nullptr)
+        {
+            sizeClass._Slabs.AppendTail(&BufferSlab);
+        }
+
+        freeBuffer->_Next = BufferSlab._FreeBuffers;
+        BufferSlab._FreeBuffers = freeBuffer;
+        BufferSlab._BuffersInUse--;
+
+        if (BufferSlab._BuffersInUse == 0)
+        {
+            //
+            // Keep a few idle slabs for any size class to take and
+            // free the rest so that memory is not held by a size class
+            // that is no longer used
+            //
+            sizeClass._Slabs.Remove(&BufferSlab);
+
+            if ((_SlabBytes <= _Capacity) && (_IdleSlabs.Count() < _MaximumIdleSlabs))
+            {
+                _IdleSlabs.AppendTail(&BufferSlab);
+            }
+            else
+            {
+                _SlabBytes -= _SlabSize;
+                freedSlab = &BufferSlab;
+            }
+        }
+    }
+
+    if (freedSlab != nullptr)
+    {
+        FreeSlab(freedSlab);
+    }
+}
+
+KIoBufferElementPool::Slab*
+KIoBufferElementPool::CarveSlab(
+    )
+{
+    Slab* slab;
+    PUCHAR buffer = nullptr;
+
+    slab = _new(GetThisAllocationTag(), GetThisAllocator()) Slab();
+    if (slab == nullptr)
+    {
+        KTraceOutOfMemory(0, STATUS_INSUFFICIENT_RESOURCES, this, sizeof(Slab), 0);
+        return(nullptr);
+    }
+
+#if defined(PLATFORM_UNIX)
+    //
+    // Huge pages are populated and zeroed when they are mapped
+    //
+    slab->_Mapping = nullptr;
+    buffer = (PUCHAR)CarveHugePageSlab(slab->_Mapping);
+    if (buffer != nullptr)
+    {
+        slab->_Buffer = buffer;
+        return(slab);
+    }
+#endif
+
+    buffer = (PUCHAR)GetThisKtlSystem().PageAlignedRawAllocator().AllocWithTag(_SlabSize, GetThisAllocationTag());
+    if (buffer == nullptr)
+    {
+        KTraceOutOfMemory(0, STATUS_INSUFFICIENT_RESOURCES, this, _SlabSize, 0);
+        _delete(slab);
+        return(nullptr);
+    }
+
+    //
+    // Touch the whole slab now so that writes into the buffers carved
+    // from it do not page fault
+    //
+    RtlZeroMemory(buffer, _SlabSize);
+    slab->_Buffer = buffer;
+
+    return(slab);
+}
+
+VOID
+KIoBufferElementPool::FreeSlab(
+    __in Slab* FreedSlab
+    )
+{
+#if defined(PLATFORM_UNIX)
+    if (FreedSlab->_Mapping != nullptr)
+    {
+        FreeHugePageSlab(*FreedSlab->_Mapping);
+        _delete(FreedSlab);
+        return;
+    }
+#endif
+
+    GetThisKtlSystem().PageAlignedRawAllocator().Free(FreedSlab->_Buffer);
+    _delete(FreedSlab);
+}
+
+#if defined(PLATFORM_UNIX)
+PVOID
+KIoBufferElementPool::CarveHugePageSlab(
+    __out HugePageMapping*& Mapping
+    )
+{
+    HugePageMapping* mapping = nullptr;
+    PVOID buffer = nullptr;
+    SIZE_T hugePageSize = 0;
+
+    Mapping = nullptr;
+
+    K_LOCK_BLOCK(_Lock)
+    {
+        hugePageSize = _HugePageSize;
+        mapping = _CarvingMapping;
+        if (mapping != nullptr)
+        {
+            buffer = (PUCHAR)mapping->_Address + (mapping->_SlabsCarved * (SIZE_T)_SlabSize);
+            mapping->_SlabsCarved++;
+            mapping->_SlabsInUse++;
+
+            if ((mapping->_SlabsCarved * (SIZE_T)_SlabSize) == mapping->_Size)
+            {
+                _CarvingMapping = nullptr;
+            }
+        }
+    }
+
+    if (buffer != nullptr)
+    {
+        Mapping = mapping;
+        return(buffer);
+    }
+
+    if (hugePageSize == 0)
+    {
+        return(nullptr);
+    }
+
+    mapping = _new(GetThisAllocationTag(), GetThisAllocator()) HugePageMapping();
+    if (mapping == nullptr)
+    {
+        KTraceOutOfMemory(0, STATUS_INSUFFICIENT_RESOURCES, this, sizeof(HugePageMapping), 0);
+        return(nullptr);
+    }
+
+    buffer = mmap(nullptr,
+                  hugePageSize,
+                  PROT_READ | PROT_WRITE,
+                  MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB | MAP_POPULATE,
+                  -1,
+                  0);
+    if (buffer == MAP_FAILED)
+    {
+        //
+        // No huge pages are reserved or they are all in use; do not
+        // keep trying for every slab
+        //
+        KDbgCheckpointWData(0, "KIoBufferElementPool huge page mmap failed", STATUS_INSUFFICIENT_RESOURCES,
+                            (ULONGLONG)this, (ULONGLONG)errno, (ULONGLONG)hugePageSize, 0);
+        K_LOCK_BLOCK(_Lock)
+        {
+            _HugePageSize = 0;
+        }
+
+        _delete(mapping);
+        return(nullptr);
+    }
+
+    //
+    // Huge pages are not swapped, mlock also keeps them from being
+    // migrated. A failure, such as RLIMIT_MEMLOCK being reached, leaves
+    // the mapping usable.
+    //
+    if (mlock(buffer, hugePageSize) != 0)
+    {
+        KDbgCheckpointWData(0, "KIoBufferElementPool huge page mlock failed", STATUS_SUCCESS,
+                            (ULONGLONG)this, (ULONGLONG)errno, (ULONGLONG)hugePageSize, 0);
+    }
+
+    mapping->_Address = buffer;
+    mapping->_Size = hugePageSize;
+    mapping->_SlabsCarved = 1;
+    mapping->_SlabsInUse = 1;
+
+    if (hugePageSize > _SlabSize)
+    {
+        K_LOCK_BLOCK(_Lock)
+        {
+            if (_CarvingMapping == nullptr)
+            {
+                _CarvingMapping = mapping;
+            }
+            else
+            {
+                //
+                // Another huge page was mapped at the same time; the
+                // rest of this one is left uncarved
+                //
+                mapping->_SlabsCarved = (ULONG)(hugePageSize / _SlabSize);
+            }
+        }
+    }
+
+    Mapping = mapping;
+    return(buffer);
+}
+
+VOID
+KIoBufferElementPool::FreeHugePageSlab(
+    __in HugePageMapping& Mapping
+    )
+{
+    BOOLEAN unmap;
+
+    K_LOCK_BLOCK(_Lock)
+    {
+        Mapping._SlabsInUse--;
+        unmap = (Mapping._SlabsInUse == 0) && (&Mapping != _CarvingMapping);
+    }
+
+    if (unmap)
+    {
+        munmap(Mapping._Address, Mapping._Size);
+        _delete(&Mapping);
+    }
+}
+#endif
+
+
 //
 // AllocateKIoBuffer
 //
@@ -2580,6 +3218,7 @@ ThrottledKIoBufferAllocator::ThrottledKIoBufferAllocator(
     _TotalAllocationLimit = MemoryThrottleLimits.WriteBufferMemoryPoolMin;
     
     _CurrentAllocations = 0;
+    _ReadCacheAllocations = 0;
     _ShuttingDown = FALSE;
     _TimerRunning = FALSE;
 
@@ -2587,12 +3226,23 @@ ThrottledKIoBufferAllocator::ThrottledKIoBufferAllocator(
     if (! NT_SUCCESS(status))
     {
         SetConstructorStatus(status);
+        return;
     }
+
+    status = KIoBufferElementPool::Create(0, GetThisAllocator(), GetThisAllocationTag(), _BufferPool);
+    if (! NT_SUCCESS(status))
+    {
+        SetConstructorStatus(status);
+        return;
+    }
+
+    UpdateBufferPoolCapacity();
 }
 
 ThrottledKIoBufferAllocator::~ThrottledKIoBufferAllocator()
 {
     KInvariant(_CurrentAllocations == 0);
+    KInvariant(_ReadCacheAllocations == 0);
 }
 
 NTSTATUS
@@ -2659,7 +3309,8 @@ VOID ThrottledKIoBufferAllocator::SetLimit(
     }
     _MaxAllocationLimit = Max;
     _PerStreamAllocation = PerStream;
-    
+
+    UpdateBufferPoolCapacity();
 }
 
 LONG ThrottledKIoBufferAllocator::AddToLimit(
@@ -2689,6 +3340,8 @@ LONG ThrottledKIoBufferAllocator::AddToLimit(
         } while (actual != expected);
     }
 
+    UpdateBufferPoolCapacity();
+
     //
     // Since the limit has grown, we may be able to provide memory to
     // requests that are waiting
@@ -2714,7 +3367,73 @@ VOID ThrottledKIoBufferAllocator::RemoveFromLimit(
         // providing allocations until the allocator is back under the
         // limit
         //
+        UpdateBufferPoolCapacity();
+    }
+}
+
+VOID ThrottledKIoBufferAllocator::UpdateBufferPoolCapacity()
+{
+    LONGLONG capacity = _TotalAllocationLimit;
+
+    if ((capacity == KtlLogManager::MemoryThrottleLimits::_NoLimit) ||
+        (capacity > _BufferPoolMaximumCapacity))
+    {
+        capacity = _BufferPoolMaximumCapacity;
     }
+
+    _BufferPool->SetCapacity(capacity);
+}
+
+NTSTATUS ThrottledKIoBufferAllocator::AllocateKIoBufferElement(
+    __in ULONG Size,
+    __out KIoBufferElement::SPtr& IoBufferElement,
+    __out PVOID& Buffer
+)
+{
+    return(_BufferPool->AllocateElement(Size, IoBufferElement, Buffer));
+}
+
+LONGLONG ThrottledKIoBufferAllocator::GetReadCacheLimit(
+)
+{
+    LONGLONG totalAllocationLimit = _TotalAllocationLimit;
+    
+    if (totalAllocationLimit == KtlLogManager::MemoryThrottleLimits::_NoLimit)
+    {
+        return(_ReadCacheNoLimitSize);
+    }
+
+    return(totalAllocationLimit / _ReadCacheLimitDivisor);
+}
+
+BOOLEAN ThrottledKIoBufferAllocator::TryChargeReadCache(
+    __in LONG Size
+)
+{
+    //
+    // Writes waiting for memory take priority over caching records
+    //
+    if (IsUnderMemoryPressure())
+    {
+        return(FALSE);
+    }
+
+    LONGLONG newAllocations = InterlockedAdd64(&_ReadCacheAllocations, Size);
+    if (newAllocations > GetReadCacheLimit())
+    {
+        InterlockedAdd64(&_ReadCacheAllocations, -1*Size);
+        return(FALSE);
+    }
+
+    return(TRUE);
+}
+
+VOID ThrottledKIoBufferAllocator::UnchargeReadCache(
+    __in LONG Size
+)
+{
+    KInvariant(_ReadCacheAllocations >= Size);
+    InterlockedAdd64(&_ReadCacheAllocations, -1*Size);
 }
 
 VOID ThrottledKIoBufferAllocator::ProcessFreedMemory()
@@ -2979,7 +3698,7 @@ ThrottledKIoBufferAllocator::AllocateIfPossible(
 
     for (ULONG i = 0; i < elementCount; i++)
     {
-        status = KIoBufferElement::CreateNew(alloc->GetAllocationExtentSize(), ioBufferElement, p, GetThisAllocator(), GetThisAllocationTag());
+        status = _BufferPool->AllocateElement(alloc->GetAllocationExtentSize(), ioBufferElement, p);
         if (!NT_SUCCESS(status))
         {
             break;
@@ -2992,7 +3711,7 @@ ThrottledKIoBufferAllocator::AllocateIfPossible(
     {
         if (lastElementSize != 0)
         {
-            status = KIoBufferElement::CreateNew(lastElementSize, ioBufferElement, p, GetThisAllocator(), GetThisAllocationTag());
+            status = _BufferPool->AllocateElement(lastElementSize, ioBufferElement, p);
             if (NT_SUCCESS(status))
             {
                 ioBuffer->AddIoBufferElement(*ioBufferElement);
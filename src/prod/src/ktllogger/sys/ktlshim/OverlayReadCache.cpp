@@ -0,0 +1,371 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#ifdef UNIFY
+#define UPASSTHROUGH 1
+#endif
+
+#include "KtlLogShimKernel.h"
+
+//
+// OverlayReadCache
+//
+OverlayReadCache::Entry::Entry()
+{
+}
+
+OverlayReadCache::Entry::~Entry()
+{
+}
+
+OverlayReadCache::OverlayReadCache(
+    __in ThrottledKIoBufferAllocator& ThrottledAllocator
+    ) :
+    _ThrottledAllocator(&ThrottledAllocator),
+    _Table(Entry::GetTableLinksOffset(),
+           KNodeTable<Entry>::CompareFunction(&Entry::Comparator)),
+    _LruList(Entry::GetListLinksOffset()),
+    _TruncationAsn(RvdLogAsn::Null()),
+    _BytesCached(0),
+    _Hits(0),
+    _Misses(0),
+    _Evictions(0)
+{
+}
+
+OverlayReadCache::~OverlayReadCache()
+{
+    Clear();
+}
+
+NTSTATUS
+OverlayReadCache::Create(
+    __in ThrottledKIoBufferAllocator& ThrottledAllocator,
+    __in KAllocator& Allocator,
+    __in ULONG AllocationTag,
+    __out OverlayReadCache::SPtr& Context
+    )
+{
+    NTSTATUS status;
+    OverlayReadCache::SPtr context;
+
+    Context = nullptr;
+
+    context = _new(AllocationTag, Allocator) OverlayReadCache(ThrottledAllocator);
+    if (context == nullptr)
+    {
+        status = STATUS_INSUFFICIENT_RESOURCES;
+        KTraceOutOfMemory(0, status, NULL, AllocationTag, 0);
+        return(status);
+    }
+
+    status = context->Status();
+    if (! NT_SUCCESS(status))
+    {
+        return(status);
+    }
+
+    Context = Ktl::Move(context);
+
+    return(STATUS_SUCCESS);
+}
+
+NTSTATUS
+OverlayReadCache::CopyRecord(
+    __in KBuffer& MetaDataBuffer,
+    __in KIoBuffer& IoBuffer,
+    __out KBuffer::SPtr& MetaDataBufferCopy,
+    __out KIoBuffer::SPtr& IoBufferCopy
+    )
+{
+    NTSTATUS status;
+    KBuffer::SPtr metaDataBuffer;
+    KIoBuffer::SPtr ioBuffer;
+
+    status = KBuffer::CreateOrCopy(metaDataBuffer, &MetaDataBuffer, GetThisAllocator(), GetThisAllocationTag());
+    if (! NT_SUCCESS(status))
+    {
+        KTraceOutOfMemory(0, status, this, MetaDataBuffer.QuerySize(), 0);
+        return(status);
+    }
+
+    if (IoBuffer.QuerySize() == 0)
+    {
+        status = KIoBuffer::CreateEmpty(ioBuffer, GetThisAllocator(), GetThisAllocationTag());
+        if (! NT_SUCCESS(status))
+        {
+            KTraceOutOfMemory(0, status, this, 0, 0);
+            return(status);
+        }
+    } else {
+        PVOID ioBufferPtr;
+        BOOLEAN b;
+
+        status = KIoBuffer::CreateSimple(IoBuffer.QuerySize(), ioBuffer, ioBufferPtr, GetThisAllocator(), GetThisAllocationTag());
+        if (! NT_SUCCESS(status))
+        {
+            KTraceOutOfMemory(0, status, this, IoBuffer.QuerySize(), 0);
+            return(status);
+        }
+
+        b = KIoBufferStream::CopyFrom(IoBuffer, 0, IoBuffer.QuerySize(), ioBufferPtr);
+        KInvariant(b);
+    }
+
+    MetaDataBufferCopy = Ktl::Move(metaDataBuffer);
+    IoBufferCopy = Ktl::Move(ioBuffer);
+
+    return(STATUS_SUCCESS);
+}
+
+BOOLEAN
+OverlayReadCache::Lookup(
+    __in RvdLogAsn RecordAsn,
+    __in ULONGLONG Version,
+    __out KBuffer::SPtr& MetaDataBuffer,
+    __out KIoBuffer::SPtr& IoBuffer
+    )
+{
+    NTSTATUS status;
+    KBuffer::SPtr metaDataBuffer;
+    KIoBuffer::SPtr ioBuffer;
+
+    K_LOCK_BLOCK(_Lock)
+    {
+        _LookupKey._RecordAsn = RecordAsn;
+        Entry* entry = _Table.Lookup(_LookupKey);
+
+        if ((entry == nullptr) || (entry->_Version != Version))
+        {
+            _Misses++;
+            return(FALSE);
+        }
+
+        _LruList.Remove(entry);
+        _LruList.InsertHead(entry);
+        _Hits++;
+
+        metaDataBuffer = entry->_MetaDataBuffer;
+        ioBuffer = entry->_IoBuffer;
+    }
+
+    //
+    // The cached buffers are never handed out since the caller owns
+    // and may change the buffers it reads into
+    //
+    status = CopyRecord(*metaDataBuffer, *ioBuffer, MetaDataBuffer, IoBuffer);
+    if (! NT_SUCCESS(status))
+    {
+        return(FALSE);
+    }
+
+    return(TRUE);
+}
+
+BOOLEAN
+OverlayReadCache::IsCached(
+    __in RvdLogAsn RecordAsn,
+    __in ULONGLONG Version
+    )
+{
+    K_LOCK_BLOCK(_Lock)
+    {
+        _LookupKey._RecordAsn = RecordAsn;
+        Entry* entry = _Table.Lookup(_LookupKey);
+
+        return((entry != nullptr) && (entry->_Version >= Version));
+    }
+
+    return(FALSE);
+}
+
+VOID
+OverlayReadCache::Add(
+    __in RvdLogAsn RecordAsn,
+    __in ULONGLONG Version,
+    __in KBuffer& MetaDataBuffer,
+    __in KIoBuffer& IoBuffer
+    )
+{
+    NTSTATUS status;
+    ULONG size = MetaDataBuffer.QuerySize() + IoBuffer.QuerySize();
+    Entry* entry;
+    Entry* existingEntry;
+    KNodeList<Entry> entriesToFree(Entry::GetListLinksOffset());
+
+    if (size > _MaximumRecordSize)
+    {
+        return;
+    }
+
+    //
+    // Avoid copying the record when it would not be kept
+    //
+    K_LOCK_BLOCK(_Lock)
+    {
+        if (RecordAsn <= _TruncationAsn)
+        {
+            return;
+        }
+
+        _LookupKey._RecordAsn = RecordAsn;
+        existingEntry = _Table.Lookup(_LookupKey);
+        if ((existingEntry != nullptr) && (existingEntry->_Version >= Version))
+        {
+            return;
+        }
+    }
+
+    entry = _new(GetThisAllocationTag(), GetThisAllocator()) Entry();
+    if (entry == nullptr)
+    {
+        KTraceOutOfMemory(0, STATUS_INSUFFICIENT_RESOURCES, this, size, 0);
+        return;
+    }
+
+    status = CopyRecord(MetaDataBuffer, IoBuffer, entry->_MetaDataBuffer, entry->_IoBuffer);
+    if (! NT_SUCCESS(status))
+    {
+        _delete(entry);
+        return;
+    }
+
+    entry->_RecordAsn = RecordAsn;
+    entry->_Version = Version;
+    entry->_Size = (LONG)size;
+
+    K_LOCK_BLOCK(_Lock)
+    {
+        //
+        // A truncation or a newer version may have raced with the copy
+        //
+        if (RecordAsn <= _TruncationAsn)
+        {
+            break;
+        }
+
+        existingEntry = _Table.Lookup(*entry);
+        if (existingEntry != nullptr)
+        {
+            if (existingEntry->_Version >= Version)
+            {
+                break;
+            }
+
+            RemoveEntryNoLock(*existingEntry);
+            entriesToFree.AppendTail(existingEntry);
+        }
+
+        //
+        // Make room by evicting the least recently used records. While
+        // writes are waiting for memory nothing can be charged and so
+        // the cache empties itself.
+        //
+        BOOLEAN charged;
+        while (! (charged = _ThrottledAllocator->TryChargeReadCache(entry->_Size)))
+        {
+            Entry* victim = _LruList.PeekTail();
+            if (victim == nullptr)
+            {
+                break;
+            }
+
+            RemoveEntryNoLock(*victim);
+            entriesToFree.AppendTail(victim);
+            _Evictions++;
+        }
+
+        if (charged)
+        {
+            BOOLEAN b = _Table.Insert(*entry);
+            KInvariant(b);
+            _LruList.InsertHead(entry);
+            _BytesCached += entry->_Size;
+            entry = nullptr;
+        }
+    }
+
+    if (entry != nullptr)
+    {
+        _delete(entry);
+    }
+
+    FreeEntries(entriesToFree);
+}
+
+VOID
+OverlayReadCache::Truncate(
+    __in RvdLogAsn TruncationAsn
+    )
+{
+    Entry* entry;
+    KNodeList<Entry> entriesToFree(Entry::GetListLinksOffset());
+
+    K_LOCK_BLOCK(_Lock)
+    {
+        _TruncationAsn.SetIfLarger(TruncationAsn);
+
+        entry = _Table.First();
+        while ((entry != nullptr) && (entry->_RecordAsn <= _TruncationAsn))
+        {
+            RemoveEntryNoLock(*entry);
+            entriesToFree.AppendTail(entry);
+            entry = _Table.First();
+        }
+    }
+
+    FreeEntries(entriesToFree);
+}
+
+VOID
+OverlayReadCache::Clear(
+    )
+{
+    Entry* entry;
+    KNodeList<Entry> entriesToFree(Entry::GetListLinksOffset());
+
+    K_LOCK_BLOCK(_Lock)
+    {
+        entry = _LruList.PeekHead();
+        while (entry != nullptr)
+        {
+            RemoveEntryNoLock(*entry);
+            entriesToFree.AppendTail(entry);
+            entry = _LruList.PeekHead();
+        }
+
+        _TruncationAsn = RvdLogAsn::Null();
+    }
+
+    FreeEntries(entriesToFree);
+}
+
+VOID
+OverlayReadCache::RemoveEntryNoLock(
+    __in Entry& CacheEntry
+    )
+{
+    _Table.Remove(CacheEntry);
+    _LruList.Remove(&CacheEntry);
+
+    _ThrottledAllocator->UnchargeReadCache(CacheEntry._Size);
+    _BytesCached -= CacheEntry._Size;
+}
+
+VOID
+OverlayReadCache::FreeEntries(
+    __in KNodeList<Entry>& Entries
+    )
+{
+    Entry* entry;
+
+    //
+    // Record buffers are released outside of the lock
+    //
+    while ((entry = Entries.RemoveHead()) != nullptr)
+    {
+        _delete(entry);
+    }
+}
@@ -1531,8 +1531,21 @@ OverlayLog::QueryCacheSize(__out_opt LONGLONG* const ReadCacheSizeLimit, __out_o
         return;
     }
 	
-    _BaseLogContainer->QueryCacheSize(ReadCacheSizeLimit,
-                                     ReadCacheUsage);
+    KFinally([&] { ReleaseRequestRef(); });
+
+    //
+    // Records are cached by the overlay streams rather than by the
+    // base container
+    //
+    if (ReadCacheSizeLimit != nullptr)
+    {
+        *ReadCacheSizeLimit = _ThrottledAllocator->GetReadCacheLimit();
+    }
+
+    if (ReadCacheUsage != nullptr)
+    {
+        *ReadCacheUsage = _ThrottledAllocator->GetReadCacheUsage();
+    }
 }
 
 VOID
@@ -13,6 +13,13 @@
 
 #include <bldver.h>
 
+//
+// Records read ahead by all overlay streams, and a switch that turns
+// read ahead off, so that tests can compare scans with and without it
+//
+LONGLONG g_OverlayStreamNumReadAheadRecords = 0;
+BOOLEAN g_OverlayStreamDisableReadAhead = FALSE;
+
 OverlayGlobalContext::OverlayGlobalContext(
     __in KActivityId ActivityId
     ) :
@@ -107,6 +114,13 @@ OverlayStream::OverlayStream(
        _PeriodicTimerTestDelayInSec(0),
 #endif
        _StreamAllocation(0),
+       _ReadAheadLastAsn(RvdLogAsn::Null()),
+       _ReadAheadNextAsn(RvdLogAsn::Null()),
+       _ReadAheadSequentialReads(0),
+       _ReadAheadRecords(0),
+       _ReadAheadOutstanding(0),
+       _ReadAheadRunning(FALSE),
+       _ReadAheadCount(0),
        _OpenServiceFSMCallout(nullptr)
 #if DBG
        ,_SharedTimerDelay(0),
@@ -132,6 +146,13 @@ OverlayStream::OverlayStream(
     globalContext = up_cast<KAsyncGlobalContext, OverlayGlobalContext>(_GlobalContext);
     SetGlobalContext(globalContext);
 
+    status = OverlayReadCache::Create(ThrottledAllocator, GetThisAllocator(), GetThisAllocationTag(), _ReadCache);
+    if (! NT_SUCCESS(status))
+    {
+        SetConstructorStatus(status);
+        return;
+    }
+
     //
     // Allocate a waiter for the base container close event
     //
@@ -373,6 +394,7 @@ OverlayStream::DoCompleteOpen(
         _PerfCounterSetInstance = nullptr;
 #endif
         _CoalesceRecords = nullptr;
+        _ReadCache->Clear();
     } else {
         _ObjectState = Opened;
     }
@@ -1274,6 +1296,18 @@ OverlayStream::CloseServiceFSM(
                 _CoalesceRecords = nullptr;
             }
 
+            KDbgCheckpointWDataInformational(GetActivityId(), "ReadCache", STATUS_SUCCESS,
+                                             (ULONGLONG)this,
+                                             _ReadCache->GetHits(),
+                                             _ReadCache->GetMisses(),
+                                             _ReadCache->GetEvictions());
+            KDbgCheckpointWDataInformational(GetActivityId(), "ReadAhead", STATUS_SUCCESS,
+                                             (ULONGLONG)this,
+                                             _ReadAheadCount,
+                                             0,
+                                             0);
+            _ReadCache->Clear();
+
             KInvariant(_DedicatedLogContainer);
 
             _DedicatedLogContainer = nullptr;
@@ -1886,6 +1920,16 @@ OverlayStream::AsyncWriteContextOverlay::FSMContinue(
 
         case WriteToDestaging:
         {
+            //
+            // Records written are often read back soon, for example
+            // by replication catching up a secondary
+            //
+            if ((! _OverlayStream->IsStreamForLogicalLog()) &&
+                (_MetaDataBuffer) && (_IoBuffer))
+            {
+                _OverlayStream->GetReadCache()->Add(_RecordAsn, _Version, *_MetaDataBuffer, *_IoBuffer);
+            }
+            
             Complete(STATUS_SUCCESS);
             break;
         }
@@ -3646,6 +3690,212 @@ OverlayStream::SetTruncationPending(
     return(0);
 }
 
+//
+// Read ahead
+//
+VOID
+OverlayStream::NoteRecordRead(
+    __in RvdLogAsn RecordAsn
+    )
+{
+    BOOLEAN startReadAhead = FALSE;
+
+    if (g_OverlayStreamDisableReadAhead)
+    {
+        return;
+    }
+
+    K_LOCK_BLOCK(_ReadAheadLock)
+    {
+        if (RecordAsn > _ReadAheadLastAsn)
+        {
+            if (_ReadAheadSequentialReads < _ReadAheadTriggerCount)
+            {
+                _ReadAheadSequentialReads++;
+            }
+
+            if ((_ReadAheadRecords > 0) && (RecordAsn <= _ReadAheadNextAsn))
+            {
+                //
+                // The reader consumed one of the records read ahead
+                //
+                _ReadAheadRecords--;
+            } else {
+                //
+                // The reader is past anything read ahead
+                //
+                _ReadAheadRecords = 0;
+                _ReadAheadNextAsn = RecordAsn;
+            }
+        } else {
+            _ReadAheadSequentialReads = 0;
+            _ReadAheadRecords = 0;
+            _ReadAheadNextAsn = RecordAsn;
+        }
+
+        _ReadAheadLastAsn = RecordAsn;
+
+        if ((_ReadAheadSequentialReads >= _ReadAheadTriggerCount) && (! _ReadAheadRunning))
+        {
+            _ReadAheadRunning = TRUE;
+            startReadAhead = TRUE;
+        }
+    }
+
+    if (startReadAhead)
+    {
+        StartReadAhead();
+    }
+}
+
+VOID
+OverlayStream::StartReadAhead(
+    )
+{
+    NTSTATUS status;
+    BOOLEAN running = TRUE;
+    KAsyncContextBase::CompletionCallback completion(this, &OverlayStream::ReadAheadCompletion);
+
+    status = TryAcquireRequestRef();
+    if (! NT_SUCCESS(status))
+    {
+        K_LOCK_BLOCK(_ReadAheadLock)
+        {
+            _ReadAheadRunning = FALSE;
+        }
+        return;
+    }
+    KFinally([&] { ReleaseRequestRef(); });
+
+    while (running)
+    {
+        RvdLogAsn fromAsn;
+        RvdLogAsn recordAsn;
+        ULONGLONG version = 0;
+        RvdLogStream::RecordDisposition disposition = RvdLogStream::RecordDisposition::eDispositionNone;
+        ULONG ioBufferSize = 0;
+        BOOLEAN readRecord = FALSE;
+
+        K_LOCK_BLOCK(_ReadAheadLock)
+        {
+            if ((_ReadAheadSequentialReads < _ReadAheadTriggerCount) ||
+                (_ReadAheadRecords >= _ReadAheadMaxRecords) ||
+                (_ReadAheadOutstanding >= _ReadAheadMaxOutstanding))
+            {
+                _ReadAheadRunning = FALSE;
+                running = FALSE;
+            }
+
+            fromAsn = _ReadAheadNextAsn;
+        }
+
+        if (! running)
+        {
+            break;
+        }
+
+        //
+        // Only records already destaged to the dedicated log are read
+        // ahead. This is a lookup in the in memory index and does not
+        // go to disk.
+        //
+        recordAsn = fromAsn;
+        status = _DedicatedLogStream->QueryRecord(recordAsn,
+                                                  RvdLogStream::AsyncReadContext::ReadNextRecord,
+                                                  &version,
+                                                  &disposition,
+                                                  &ioBufferSize,
+                                                  NULL);
+
+        BOOLEAN isCached = NT_SUCCESS(status) && _ReadCache->IsCached(recordAsn, version);
+
+        K_LOCK_BLOCK(_ReadAheadLock)
+        {
+            if (_ReadAheadNextAsn != fromAsn)
+            {
+                //
+                // The reader moved while the index was queried so
+                // start again from where it is now
+                //
+                break;
+            }
+
+            if ((! NT_SUCCESS(status)) ||
+                (disposition != RvdLogStream::RecordDisposition::eDispositionPersisted) ||
+                (ioBufferSize > OverlayReadCache::_MaximumRecordSize))
+            {
+                _ReadAheadRunning = FALSE;
+                running = FALSE;
+                break;
+            }
+
+            _ReadAheadNextAsn = recordAsn;
+            _ReadAheadRecords++;
+
+            if (! isCached)
+            {
+                _ReadAheadOutstanding++;
+                _ReadAheadCount++;
+                InterlockedIncrement64(&g_OverlayStreamNumReadAheadRecords);
+                readRecord = TRUE;
+            }
+        }
+
+        if (readRecord)
+        {
+            AsyncReadContext::SPtr context;
+            AsyncReadContextOverlay::SPtr readAhead;
+
+            status = CreateAsyncReadContext(context);
+            if (! NT_SUCCESS(status))
+            {
+                KTraceFailedAsyncRequest(status, this, recordAsn.Get(), 0);
+                K_LOCK_BLOCK(_ReadAheadLock)
+                {
+                    _ReadAheadOutstanding--;
+                    _ReadAheadRunning = FALSE;
+                }
+                break;
+            }
+
+            readAhead = down_cast<AsyncReadContextOverlay, AsyncReadContext>(context);
+            readAhead->StartReadAhead(recordAsn, NULL, completion);
+        }
+    }
+}
+
+VOID
+OverlayStream::ReadAheadCompletion(
+    __in_opt KAsyncContextBase* const ParentAsync,
+    __in KAsyncContextBase& Async
+    )
+{
+    UNREFERENCED_PARAMETER(ParentAsync);
+    UNREFERENCED_PARAMETER(Async);
+
+    BOOLEAN startReadAhead = FALSE;
+
+    //
+    // A failed read ahead is not an error as the reader will read the
+    // record itself
+    //
+    K_LOCK_BLOCK(_ReadAheadLock)
+    {
+        _ReadAheadOutstanding--;
+
+        if ((_ReadAheadSequentialReads >= _ReadAheadTriggerCount) && (! _ReadAheadRunning))
+        {
+            _ReadAheadRunning = TRUE;
+            startReadAhead = TRUE;
+        }
+    }
+
+    if (startReadAhead)
+    {
+        StartReadAhead();
+    }
+}
+
 //
 // ReadContext
 //
@@ -3662,6 +3912,17 @@ OverlayStream::AsyncReadContextOverlay::OnCompleted(
     {
         *_VersionPtr = _VersionLocal;
     }
+
+    if (_IsReadAhead)
+    {
+        //
+        // The record was cached as it was verified
+        //
+        _ReadAheadMetaDataBuffer = nullptr;
+        _ReadAheadIoBuffer = nullptr;
+    } else if (NT_SUCCESS(Status()) && (! _OverlayStream->IsStreamForLogicalLog())) {
+        _OverlayStream->NoteRecordRead(_ActualRecordAsnLocal);
+    }
     
     if (_RequestRefAcquired)
     {
@@ -3674,12 +3935,14 @@ NTSTATUS
 OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
     __out BOOLEAN& ReadFromDedicated,
     __out RvdLogAsn& AsnToRead,
-    __out RvdLogStream::AsyncReadContext::ReadType& ReadType
+    __out RvdLogStream::AsyncReadContext::ReadType& ReadType,
+    __out ULONGLONG& VersionToRead
 )
 {
     NTSTATUS status;
     ReadFromDedicated = FALSE;
     AsnToRead = 0;
+    VersionToRead = 0;
     ReadType = RvdLogStream::AsyncReadContext::ReadContainingRecord;
     
     //
@@ -3857,6 +4120,7 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
             //
             ReadFromDedicated = TRUE;
             AsnToRead = dedicatedAsn;
+            VersionToRead = dedicatedVersion;
             ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
 #ifdef VERBOSE
             KDbgCheckpointWData(_OverlayStream->GetActivityId(), "ReadFromDedicated",
@@ -3871,6 +4135,7 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
         //
         ReadFromDedicated = FALSE;
         AsnToRead = sharedAsn;
+        VersionToRead = sharedVersion;
         ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
 #ifdef VERBOSE
         KDbgCheckpointWData(_OverlayStream->GetActivityId(), "ReadFromShared", STATUS_SUCCESS,
@@ -3908,6 +4173,7 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
                     // record so that is the one
                     //
                     AsnToRead = dedicatedAsn;
+                    VersionToRead = dedicatedVersion;
                     ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
                     ReadFromDedicated = TRUE;
                 } else {
@@ -3916,6 +4182,7 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
                     // record so that is the one
                     //
                     AsnToRead = sharedAsn;
+                    VersionToRead = sharedVersion;
                     ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
                     ReadFromDedicated = FALSE;
                 }
@@ -3939,6 +4206,7 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
                     // record so that is the one
                     //
                     AsnToRead = dedicatedAsn;
+                    VersionToRead = dedicatedVersion;
                     ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
                     ReadFromDedicated = TRUE;
                 } else {
@@ -3947,6 +4215,7 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
                     // record so that is the one
                     //
                     AsnToRead = sharedAsn;
+                    VersionToRead = sharedVersion;
                     ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
                     ReadFromDedicated = FALSE;
                 }
@@ -3973,6 +4242,7 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
                         // record so that is the one
                         //
                         AsnToRead = dedicatedAsn;
+                        VersionToRead = dedicatedVersion;
                         ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
                         ReadFromDedicated = TRUE;
                     } else {
@@ -3981,6 +4251,7 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
                         // record so that is the one
                         //
                         AsnToRead = sharedAsn;
+                        VersionToRead = sharedVersion;
                         ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
                         ReadFromDedicated = FALSE;
                     }
@@ -3994,10 +4265,12 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
                     if (sharedVersion > dedicatedVersion)
                     {
                         AsnToRead = sharedAsn;
+                        VersionToRead = sharedVersion;
                         ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
                         ReadFromDedicated = FALSE;
                     } else {
                         AsnToRead = dedicatedAsn;
+                        VersionToRead = dedicatedVersion;
                         ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
                         ReadFromDedicated = TRUE;
                     }
@@ -4024,10 +4297,12 @@ OverlayStream::AsyncReadContextOverlay::DetermineRecordLocation(
     if (sharedVersion > dedicatedVersion)
     {
         AsnToRead = sharedAsn;
+        VersionToRead = sharedVersion;
         ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
         ReadFromDedicated = FALSE;
     } else {
         AsnToRead = dedicatedAsn;
+        VersionToRead = dedicatedVersion;
         ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
         ReadFromDedicated = TRUE;
     }
@@ -4208,10 +4483,12 @@ OverlayStream::AsyncReadContextOverlay::FSMContinue(
             //
             RvdLogAsn asnToRead = _AsnToRead;
             RvdLogStream::AsyncReadContext::ReadType readType = _ReadType;
+            ULONGLONG versionToRead;
 
             Status = DetermineRecordLocation(readFromDedicated,
                                              asnToRead,
-                                             readType
+                                             readType,
+                                             versionToRead
                                             );
             if (! NT_SUCCESS(Status))
             {
@@ -4228,6 +4505,21 @@ OverlayStream::AsyncReadContextOverlay::FSMContinue(
                 *_ReadFromDedicated = readFromDedicated;
             }
 
+            //
+            // Once the exact record is known it may be returned from
+            // the read cache without going to either log
+            //
+            if ((! _OverlayStream->IsStreamForLogicalLog()) &&
+                (! _IsReadAhead) &&
+                (readType == RvdLogStream::AsyncReadContext::ReadExactRecord) &&
+                (_OverlayStream->GetReadCache()->Lookup(asnToRead, versionToRead, *_MetaDataBuffer, *_IoBuffer)))
+            {
+                _ActualRecordAsnLocal = asnToRead;
+                _VersionLocal = versionToRead;
+                Complete(STATUS_SUCCESS);
+                return;
+            }
+
             if (! readFromDedicated)
             {
                 //
@@ -4281,10 +4573,12 @@ OverlayStream::AsyncReadContextOverlay::FSMContinue(
                 RvdLogAsn asnToRead = _AsnToRead;
                 RvdLogStream::AsyncReadContext::ReadType readType = _ReadType;
                 BOOLEAN readFromDedicated;
+                ULONGLONG versionToRead;
 
                 Status = DetermineRecordLocation(readFromDedicated,
                                                  asnToRead,
-                                                 readType
+                                                 readType,
+                                                 versionToRead
                                                 );
                 if (! NT_SUCCESS(Status))
                 {
@@ -4359,6 +4653,11 @@ VerifyRecord:
                 Complete(Status);
                 break;
             }
+
+            if (! _OverlayStream->IsStreamForLogicalLog())
+            {
+                _OverlayStream->GetReadCache()->Add(_ActualRecordAsnLocal, _VersionLocal, *(*_MetaDataBuffer), *(*_IoBuffer));
+            }
             
             Complete(Status);
             break;
@@ -4642,6 +4941,7 @@ OverlayStream::AsyncReadContextOverlay::StartRead(
     _MetaDataBuffer = &MetaDataBuffer;
     _IoBuffer = &IoBuffer;
     _ReadFromDedicated = NULL;
+    _IsReadAhead = FALSE;
     
     Start(ParentAsyncContext, CallbackPtr);
 }
@@ -4679,6 +4979,7 @@ OverlayStream::AsyncReadContextOverlay::StartRead(
     _MetaDataBuffer = &MetaDataBuffer;
     _IoBuffer = &IoBuffer;  
     _ReadFromDedicated = NULL;
+    _IsReadAhead = FALSE;
     
     Start(ParentAsyncContext, CallbackPtr);
 }
@@ -4722,10 +5023,34 @@ OverlayStream::AsyncReadContextOverlay::StartRead(
     _MetaDataBuffer = &MetaDataBuffer;
     _IoBuffer = &IoBuffer;  
     _ReadFromDedicated = ReadFromDedicated;
+    _IsReadAhead = FALSE;
     
     Start(ParentAsyncContext, CallbackPtr);
 }
 
+VOID
+OverlayStream::AsyncReadContextOverlay::StartReadAhead(
+    __in RvdLogAsn RecordAsn,
+    __in_opt KAsyncContextBase* const ParentAsyncContext,
+    __in_opt KAsyncContextBase::CompletionCallback CallbackPtr)
+{
+    _State = Initial;
+
+    _ReadAheadMetaDataBuffer = nullptr;
+    _ReadAheadIoBuffer = nullptr;
+
+    _ReadType = RvdLogStream::AsyncReadContext::ReadExactRecord;
+    _RecordAsn = RecordAsn;
+    _ActualRecordAsnPtr = NULL;
+    _VersionPtr = NULL;
+    _MetaDataBuffer = &_ReadAheadMetaDataBuffer;
+    _IoBuffer = &_ReadAheadIoBuffer;
+    _ReadFromDedicated = NULL;
+    _IsReadAhead = TRUE;
+
+    Start(ParentAsyncContext, CallbackPtr);
+}
+
 OverlayStreamBase::AsyncReadContext::~AsyncReadContext()
 {
 }
@@ -4766,6 +5091,7 @@ OverlayStream::AsyncReadContextOverlay::AsyncReadContextOverlay(
     _SharedLogStream = &SharedLogStream;
     _DedicatedLogContainer = &DedicatedLogContainer;
     _DedicatedLogStream = &DedicatedLogStream;
+    _IsReadAhead = FALSE;
     coalesceRecords = _OverlayStream->GetCoalesceRecords();
 
     status = _DedicatedLogStream->CreateAsyncReadContext(_DedicatedRead);
@@ -6117,6 +6443,7 @@ OverlayStream::Truncate(__in RvdLogAsn TruncationPoint, __in RvdLogAsn Preferred
     }
 
     _SharedTruncationAsn.SetIfLarger(TruncationPoint);
+    _ReadCache->Truncate(TruncationPoint);
 
 #ifdef UDRIVER
     KDbgCheckpointWData(GetActivityId(),
@@ -2480,7 +2480,7 @@ NTSTATUS OverlayStream::CoalesceRecords::FindDataInFlushingRecords(
                 KIoBuffer::SPtr oldIoBuffer;
                 oldIoBuffer = _LLDestination.GetIoBuffer();
 
-                status = KIoBufferElement::CreateNew(lastBlockSize, lastBufferElement, lastBufferElementPtr, GetThisAllocator(), GetThisAllocationTag());
+                status = _ThrottledAllocator->AllocateKIoBufferElement(lastBlockSize, lastBufferElement, lastBufferElementPtr);
                 if (! NT_SUCCESS(status))
                 {
                     KTraceOutOfMemory(_OverlayStream->GetActivityId(), status, this, lastBlockSize, RecordAsn.Get());
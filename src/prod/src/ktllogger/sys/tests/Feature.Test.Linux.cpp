@@ -174,6 +174,11 @@ namespace KtlPhysicalLogTest
         ::DLogReservationTest(_diskId, _logManagers[0]);
     }
 
+    BOOST_AUTO_TEST_CASE(SequentialReadScanTest)
+    {
+        ::SequentialReadScanTest(_diskId, _logManagers[0]);
+    }
+
     BOOST_AUTO_TEST_SUITE_END()
 
             
@@ -415,6 +420,16 @@ namespace KtlPhysicalLogTest
     {
         ::ThrottledAllocatorTest(_diskId);
     }
+
+    BOOST_AUTO_TEST_CASE(OverlayReadCacheTest)
+    {
+        ::OverlayReadCacheTest(_diskId);
+    }
+
+    BOOST_AUTO_TEST_CASE(KIoBufferElementPoolTest)
+    {
+        ::KIoBufferElementPoolTest(_diskId);
+    }
    
     BOOST_AUTO_TEST_CASE(VerifyCopyFromSharedToBackupTest)
     {
@@ -70,6 +70,11 @@ extern volatile LONGLONG gs_AllocsRemaining;
  #define wprintf(...)    KDbgPrintf(__VA_ARGS__)
 #endif
 
+#if defined(UDRIVER) || defined(UPASSTHROUGH)
+extern LONGLONG g_OverlayStreamNumReadAheadRecords;
+extern BOOLEAN g_OverlayStreamDisableReadAhead;
+#endif
+
 #define ALLOCATION_TAG 'LLKT'
 
 KAllocator* g_Allocator = nullptr;
@@ -20363,6 +20368,213 @@ DLogReservationTest(
     }
 }
 
+VOID
+SequentialReadScanTest(
+    KGuid diskId,
+    KtlLogManager::SPtr logManager
+    )
+{
+    NTSTATUS status;
+    KGuid logContainerGuid;
+    KtlLogContainerId logContainerId;
+    StreamCloseSynchronizer closeStreamSync;
+    ContainerCloseSynchronizer closeContainerSync;
+    KtlLogContainer::SPtr logContainer;
+    KSynchronizer sync;
+    KGuid logStreamGuid;
+    KtlLogStreamId logStreamId;
+    ULONG metadataLength = 0x10000;
+    const ULONG recordCount = 2048;
+    const ULONG recordBlocks = 4;
+    const ULONG recordBlockSize = 0x1000;
+
+    //
+    // This test measures the throughput of a reader scanning the whole
+    // stream from beginning to end after the stream is reopened, which
+    // is where read ahead from the dedicated log helps, and checks that
+    // records are read ahead only when read ahead is enabled
+    //
+
+    logContainerGuid.CreateNew();
+    logContainerId = static_cast<KtlLogContainerId>(logContainerGuid);
+
+    logStreamGuid.CreateNew();
+    logStreamId = static_cast<KtlLogStreamId>(logStreamGuid);
+
+    {
+        KtlLogManager::AsyncCreateLogContainer::SPtr createContainerAsync;
+        LONGLONG logSize = DefaultTestLogFileSize;
+
+        status = logManager->CreateAsyncCreateLogContainerContext(createContainerAsync);
+        VERIFY_IS_TRUE(NT_SUCCESS(status));
+        createContainerAsync->StartCreateLogContainer(diskId,
+                                             logContainerId,
+                                             logSize,
+                                             0,            // Max Number Streams
+                                             0,            // Max Record Size
+                                             logContainer,
+                                             NULL,         // ParentAsync
+                                             sync);
+        status = sync.WaitForCompletion();
+        VERIFY_IS_TRUE(NT_SUCCESS(status));
+
+        //
+        // Create the stream and fill it
+        //
+        {
+            KtlLogContainer::AsyncCreateLogStreamContext::SPtr createStreamAsync;
+            KtlLogStream::SPtr logStream;
+
+            status = logContainer->CreateAsyncCreateLogStreamContext(createStreamAsync);
+            VERIFY_IS_TRUE(NT_SUCCESS(status));
+            KBuffer::SPtr securityDescriptor = nullptr;
+            createStreamAsync->StartCreateLogStream(logStreamId,
+                                                        nullptr,           // Alias
+                                                        nullptr,
+                                                        securityDescriptor,
+                                                        metadataLength,
+                                                        DEFAULT_STREAM_SIZE,
+                                                        DEFAULT_MAX_RECORD_SIZE,
+                                                        logStream,
+                                                        NULL,    // ParentAsync
+                                                    sync);
+
+            status = sync.WaitForCompletion();
+            VERIFY_IS_TRUE(NT_SUCCESS(status));
+
+            for (ULONG i = 1; i <= recordCount; i++)
+            {
+                status = WriteRecord(logStream,
+                                     1,              // version
+                                     i,              // asn
+                                     recordBlocks,
+                                     recordBlockSize);
+                VERIFY_IS_TRUE(NT_SUCCESS(status));
+            }
+
+            //
+            // Closing the stream drops the records cached as they
+            // were written
+            //
+            logStream->StartClose(NULL,
+                             closeStreamSync.CloseCompletionCallback());
+
+            status = closeStreamSync.WaitForCompletion();
+            VERIFY_IS_TRUE(NT_SUCCESS(status));
+            logStream = nullptr;
+        }
+
+        //
+        // Reopen the stream and scan it, first without read ahead as a
+        // baseline and then with read ahead
+        //
+        for (ULONG scan = 0; scan < 2; scan++)
+        {
+            KtlLogContainer::AsyncOpenLogStreamContext::SPtr openStreamAsync;
+            KtlLogStream::SPtr logStream;
+            ULONG openMetadataLength;
+            ULONGLONG version;
+            ULONG metadataSize;
+            KIoBuffer::SPtr dataIoBuffer;
+            KIoBuffer::SPtr metadataIoBuffer;
+            ULONGLONG bytesRead = 0;
+            BOOLEAN readAhead = (scan == 1);
+
+#if defined(UDRIVER) || defined(UPASSTHROUGH)
+            g_OverlayStreamDisableReadAhead = ! readAhead;
+            LONGLONG readAheadRecords = InterlockedAdd64(&g_OverlayStreamNumReadAheadRecords, 0);
+#endif
+
+            status = logContainer->CreateAsyncOpenLogStreamContext(openStreamAsync);
+            VERIFY_IS_TRUE(NT_SUCCESS(status));
+            openStreamAsync->StartOpenLogStream(logStreamId,
+                                                    &openMetadataLength,
+                                                    logStream,
+                                                    NULL,    // ParentAsync
+                                                    sync);
+
+            status = sync.WaitForCompletion();
+            VERIFY_IS_TRUE(NT_SUCCESS(status));
+
+            ULONGLONG startTime = GetTickCount64();
+            for (ULONG i = 1; i <= recordCount; i++)
+            {
+                status = ReadExactRecord(logStream,
+                                         i,
+                                         version,
+                                         metadataSize,
+                                         dataIoBuffer,
+                                         metadataIoBuffer);
+                VERIFY_IS_TRUE(NT_SUCCESS(status));
+                VERIFY_IS_TRUE(version == 1);
+                VERIFY_IS_TRUE(dataIoBuffer->QuerySize() == (recordBlocks * recordBlockSize));
+
+                bytesRead += dataIoBuffer->QuerySize() + metadataSize;
+            }
+            ULONGLONG endTime = GetTickCount64();
+
+            //
+            // There is nothing past the last record
+            //
+            status = ReadNextRecord(logStream,
+                                    recordCount,
+                                    version,
+                                    metadataSize,
+                                    dataIoBuffer,
+                                    metadataIoBuffer);
+            VERIFY_IS_TRUE(! NT_SUCCESS(status));
+
+            ULONGLONG elapsed = (endTime - startTime) == 0 ? 1 : (endTime - startTime);
+            ULONGLONG throughput = ((bytesRead * 1000) / elapsed) / 0x400;
+
+            KDbgPrintf("Sequential scan of %d records %s read ahead: %llu KB/sec\n",
+                       recordCount,
+                       readAhead ? "with" : "without",
+                       throughput);
+
+#if defined(UDRIVER) || defined(UPASSTHROUGH)
+            readAheadRecords = InterlockedAdd64(&g_OverlayStreamNumReadAheadRecords, 0) - readAheadRecords;
+            if (readAhead)
+            {
+                VERIFY_IS_TRUE(readAheadRecords > 0);
+            } else {
+                VERIFY_IS_TRUE(readAheadRecords == 0);
+            }
+            g_OverlayStreamDisableReadAhead = FALSE;
+#endif
+
+            logStream->StartClose(NULL,
+                             closeStreamSync.CloseCompletionCallback());
+
+            status = closeStreamSync.WaitForCompletion();
+            VERIFY_IS_TRUE(NT_SUCCESS(status));
+            logStream = nullptr;
+        }
+
+        logContainer->StartClose(NULL,
+                         closeContainerSync.CloseCompletionCallback());
+
+        status = closeContainerSync.WaitForCompletion();
+        VERIFY_IS_TRUE(NT_SUCCESS(status));
+    }
+
+    //
+    // Delete the log container
+    //
+    {
+        KtlLogManager::AsyncDeleteLogContainer::SPtr deleteAsync;
+
+        status = logManager->CreateAsyncDeleteLogContainerContext(deleteAsync);
+        VERIFY_IS_TRUE(NT_SUCCESS(status));
+        deleteAsync->StartDeleteLogContainer(diskId,
+                                             logContainerId,
+                                             NULL,         // ParentAsync
+                                             sync);
+        status = sync.WaitForCompletion();
+        VERIFY_IS_TRUE(NT_SUCCESS(status));
+    }
+}
+
 WorkerAsync::WorkerAsync()
 {
 }
@@ -22259,6 +22471,349 @@ VOID ThrottledAllocatorTest(
     }
 
 }
+
+static VOID
+CreateReadCacheRecord(
+    __in UCHAR Fill,
+    __in ULONG IoBufferSize,
+    __out KBuffer::SPtr& MetaDataBuffer,
+    __out KIoBuffer::SPtr& IoBuffer
+    )
+{
+    NTSTATUS status;
+    PVOID ioBufferPtr;
+
+    status = KBuffer::Create(0x100, MetaDataBuffer, *g_Allocator, KTL_TAG_TEST);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    memset(MetaDataBuffer->GetBuffer(), Fill, MetaDataBuffer->QuerySize());
+
+    status = KIoBuffer::CreateSimple(IoBufferSize, IoBuffer, ioBufferPtr, *g_Allocator, KTL_TAG_TEST);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    memset(ioBufferPtr, Fill, IoBufferSize);
+}
+
+static BOOLEAN
+IsReadCacheRecord(
+    __in UCHAR Fill,
+    __in KBuffer& MetaDataBuffer,
+    __in KIoBuffer& IoBuffer
+    )
+{
+    PUCHAR metaDataPtr = (PUCHAR)MetaDataBuffer.GetBuffer();
+    PUCHAR ioBufferPtr = (PUCHAR)IoBuffer.First()->GetBuffer();
+
+    return((metaDataPtr[0] == Fill) && (metaDataPtr[MetaDataBuffer.QuerySize() - 1] == Fill) &&
+           (ioBufferPtr[0] == Fill) && (ioBufferPtr[IoBuffer.QuerySize() - 1] == Fill));
+}
+
+VOID OverlayReadCacheTest(
+    KGuid&
+    )
+{
+    NTSTATUS status;
+    ULONG ioBufferSize = 0x4000;
+    ULONG recordSize = 0x100 + ioBufferSize;
+    ThrottledKIoBufferAllocator::SPtr throttledAllocator;
+    OverlayReadCache::SPtr readCache;
+    KBuffer::SPtr metaDataBuffer;
+    KIoBuffer::SPtr ioBuffer;
+    KBuffer::SPtr metaDataBufferRead;
+    KIoBuffer::SPtr ioBufferRead;
+
+    //
+    // Budget for the read cache is room for 8 records
+    //
+    KtlLogManager::MemoryThrottleLimits memoryThrottleLimits;
+    memoryThrottleLimits.WriteBufferMemoryPoolMax = 8 * recordSize * ThrottledKIoBufferAllocator::_ReadCacheLimitDivisor;
+    memoryThrottleLimits.WriteBufferMemoryPoolMin = 8 * recordSize * ThrottledKIoBufferAllocator::_ReadCacheLimitDivisor;
+    memoryThrottleLimits.AllocationTimeoutInMs = KtlLogManager::MemoryThrottleLimits::_UseDefaultAllocationTimeoutInMs;
+
+    status = ThrottledKIoBufferAllocator::CreateThrottledKIoBufferAllocator(
+        memoryThrottleLimits,
+        *g_Allocator,
+        KTL_TAG_TEST,
+        throttledAllocator);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(throttledAllocator->GetReadCacheLimit() == 8 * recordSize);
+
+    status = OverlayReadCache::Create(*throttledAllocator, *g_Allocator, KTL_TAG_TEST, readCache);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+
+    //
+    // Test 1: Records are returned only for the version cached and
+    //         are copies of what was added
+    //
+    CreateReadCacheRecord(1, ioBufferSize, metaDataBuffer, ioBuffer);
+    readCache->Add(RvdLogAsn(1), 10, *metaDataBuffer, *ioBuffer);
+    memset(metaDataBuffer->GetBuffer(), 0xff, metaDataBuffer->QuerySize());
+
+    VERIFY_IS_TRUE(readCache->Lookup(RvdLogAsn(1), 10, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(IsReadCacheRecord(1, *metaDataBufferRead, *ioBufferRead));
+    VERIFY_IS_TRUE(! readCache->Lookup(RvdLogAsn(1), 11, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(! readCache->Lookup(RvdLogAsn(2), 10, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(readCache->GetHits() == 1);
+    VERIFY_IS_TRUE(readCache->GetMisses() == 2);
+    VERIFY_IS_TRUE(throttledAllocator->GetReadCacheUsage() == recordSize);
+
+    //
+    // Test 2: A lower version does not replace a higher one and a
+    //         higher version does
+    //
+    CreateReadCacheRecord(2, ioBufferSize, metaDataBuffer, ioBuffer);
+    readCache->Add(RvdLogAsn(1), 9, *metaDataBuffer, *ioBuffer);
+    VERIFY_IS_TRUE(! readCache->Lookup(RvdLogAsn(1), 9, metaDataBufferRead, ioBufferRead));
+
+    readCache->Add(RvdLogAsn(1), 12, *metaDataBuffer, *ioBuffer);
+    VERIFY_IS_TRUE(! readCache->Lookup(RvdLogAsn(1), 10, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(readCache->Lookup(RvdLogAsn(1), 12, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(IsReadCacheRecord(2, *metaDataBufferRead, *ioBufferRead));
+    VERIFY_IS_TRUE(throttledAllocator->GetReadCacheUsage() == recordSize);
+
+    //
+    // Test 3: Least recently used records are evicted to stay within
+    //         the budget
+    //
+    for (ULONG i = 2; i <= 9; i++)
+    {
+        CreateReadCacheRecord((UCHAR)i, ioBufferSize, metaDataBuffer, ioBuffer);
+        readCache->Add(RvdLogAsn(i), i, *metaDataBuffer, *ioBuffer);
+
+        if (i == 5)
+        {
+            VERIFY_IS_TRUE(readCache->Lookup(RvdLogAsn(2), 2, metaDataBufferRead, ioBufferRead));
+        }
+    }
+
+    VERIFY_IS_TRUE(readCache->GetEvictions() == 1);
+    VERIFY_IS_TRUE(throttledAllocator->GetReadCacheUsage() == 8 * recordSize);
+    VERIFY_IS_TRUE(! readCache->Lookup(RvdLogAsn(1), 12, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(readCache->Lookup(RvdLogAsn(2), 2, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(readCache->Lookup(RvdLogAsn(9), 9, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(IsReadCacheRecord(9, *metaDataBufferRead, *ioBufferRead));
+
+    //
+    // Test 4: Truncation drops records at and below the truncation
+    //         point and they are not added back afterwards
+    //
+    readCache->Truncate(RvdLogAsn(5));
+    VERIFY_IS_TRUE(! readCache->Lookup(RvdLogAsn(5), 5, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(readCache->Lookup(RvdLogAsn(6), 6, metaDataBufferRead, ioBufferRead));
+    VERIFY_IS_TRUE(throttledAllocator->GetReadCacheUsage() == 4 * recordSize);
+
+    CreateReadCacheRecord(3, ioBufferSize, metaDataBuffer, ioBuffer);
+    readCache->Add(RvdLogAsn(3), 20, *metaDataBuffer, *ioBuffer);
+    VERIFY_IS_TRUE(! readCache->Lookup(RvdLogAsn(3), 20, metaDataBufferRead, ioBufferRead));
+
+    //
+    // Test 5: Records larger than the maximum are not cached
+    //
+    CreateReadCacheRecord(10, OverlayReadCache::_MaximumRecordSize, metaDataBuffer, ioBuffer);
+    readCache->Add(RvdLogAsn(10), 10, *metaDataBuffer, *ioBuffer);
+    VERIFY_IS_TRUE(! readCache->Lookup(RvdLogAsn(10), 10, metaDataBufferRead, ioBufferRead));
+
+    readCache->Clear();
+    VERIFY_IS_TRUE(readCache->GetBytesCached() == 0);
+    VERIFY_IS_TRUE(throttledAllocator->GetReadCacheUsage() == 0);
+
+    readCache = nullptr;
+    throttledAllocator->Shutdown();
+    throttledAllocator.Reset();
+}
+
+VOID KIoBufferElementPoolTest(
+    KGuid&
+    )
+{
+    NTSTATUS status;
+    KIoBufferElementPool::SPtr pool;
+    KIoBufferElement::SPtr element;
+    KIoBufferElement::SPtr smallElement;
+    KIoBufferElement::SPtr elements[16];
+    PVOID buffer;
+    PVOID firstBuffer;
+    ULONG extentSize = ThrottledKIoBufferAllocator::AsyncAllocateKIoBufferContext::_AllocationExtentSize;
+    ULONG extentsPerSlab = KIoBufferElementPool::_SlabSize / extentSize;
+
+    //
+    // Room for two slabs
+    //
+    status = KIoBufferElementPool::Create(2 * KIoBufferElementPool::_SlabSize, *g_Allocator, KTL_TAG_TEST, pool);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+
+    //
+    // Test 1: Buffers are page aligned, carved from a slab and reused
+    //         zeroed once the element is released
+    //
+    status = pool->AllocateElement(extentSize, element, buffer);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(element->QuerySize() == extentSize);
+    VERIFY_IS_TRUE(((ULONG_PTR)buffer & (KIoBufferElementPool::_MinimumClassSize - 1)) == 0);
+    VERIFY_IS_TRUE(pool->GetSlabBytes() == KIoBufferElementPool::_SlabSize);
+    memset(buffer, 0xcc, extentSize);
+
+    firstBuffer = buffer;
+    element = nullptr;
+    VERIFY_IS_TRUE(pool->GetIdleSlabCount() == 1);
+
+    status = pool->AllocateElement(extentSize, element, buffer);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(buffer == firstBuffer);
+    VERIFY_IS_TRUE(pool->GetSlabBytes() == KIoBufferElementPool::_SlabSize);
+    VERIFY_IS_TRUE(pool->GetPooledAllocations() == 2);
+    for (ULONG i = 0; i < extentSize; i++)
+    {
+        VERIFY_IS_TRUE(((PUCHAR)buffer)[i] == 0);
+    }
+    element = nullptr;
+
+    //
+    // Test 2: Sizes are rounded up to a size class but the element
+    //         reports the size asked for. An idle slab is taken by
+    //         whichever size class needs one.
+    //
+    status = pool->AllocateElement(0x3000, element, buffer);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(element->QuerySize() == 0x3000);
+    VERIFY_IS_TRUE(buffer == firstBuffer);
+    VERIFY_IS_TRUE(pool->GetSlabBytes() == KIoBufferElementPool::_SlabSize);
+    VERIFY_IS_TRUE(pool->GetIdleSlabCount() == 0);
+    element = nullptr;
+
+    //
+    // Test 3: Once at capacity and for sizes larger than the largest
+    //         class the allocations are not pooled
+    //
+    for (ULONG i = 0; i < extentsPerSlab; i++)
+    {
+        status = pool->AllocateElement(extentSize, elements[i], buffer);
+        VERIFY_IS_TRUE(NT_SUCCESS(status));
+    }
+
+    status = pool->AllocateElement(KIoBufferElementPool::_MinimumClassSize, smallElement, buffer);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(pool->GetSlabBytes() == 2 * KIoBufferElementPool::_SlabSize);
+    VERIFY_IS_TRUE(pool->GetUnpooledAllocations() == 0);
+
+    status = pool->AllocateElement(extentSize, element, buffer);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(pool->GetUnpooledAllocations() == 1);
+    element = nullptr;
+
+    status = pool->AllocateElement(2 * KIoBufferElementPool::_MaximumClassSize, element, buffer);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(element->QuerySize() == 2 * KIoBufferElementPool::_MaximumClassSize);
+    VERIFY_IS_TRUE(pool->GetUnpooledAllocations() == 2);
+    element = nullptr;
+
+    //
+    // Test 4: A larger capacity allows another slab to be carved
+    //
+    pool->SetCapacity(3 * KIoBufferElementPool::_SlabSize);
+    status = pool->AllocateElement(extentSize, element, buffer);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(pool->GetUnpooledAllocations() == 2);
+    VERIFY_IS_TRUE(pool->GetSlabBytes() == 3 * KIoBufferElementPool::_SlabSize);
+    element = nullptr;
+    smallElement = nullptr;
+    VERIFY_IS_TRUE(pool->GetIdleSlabCount() == 2);
+
+    //
+    // Test 5: Elements in a KIoBuffer go back to the pool when the
+    //         KIoBuffer is destroyed
+    //
+    KIoBuffer::SPtr ioBuffer;
+    status = KIoBuffer::CreateEmpty(ioBuffer, *g_Allocator, KTL_TAG_TEST);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    for (ULONG i = 0; i < extentsPerSlab; i++)
+    {
+        ioBuffer->AddIoBufferElement(*elements[i]);
+        elements[i] = nullptr;
+    }
+    VERIFY_IS_TRUE(ioBuffer->QuerySize() == KIoBufferElementPool::_SlabSize);
+    VERIFY_IS_TRUE(pool->GetIdleSlabCount() == 2);
+    ioBuffer = nullptr;
+    VERIFY_IS_TRUE(pool->GetIdleSlabCount() == 3);
+
+    //
+    // Test 6: Slabs released by one size class are used by the next
+    //         one and slabs beyond what is in use and the few kept idle
+    //         are freed, so the memory held stays bounded as the sizes
+    //         allocated change
+    //
+    const ULONG slabsPerClass = KIoBufferElementPool::_MaximumIdleSlabs + 2;
+    pool->SetCapacity(16 * KIoBufferElementPool::_SlabSize);
+
+    for (ULONG round = 0; round < 2; round++)
+    {
+        for (ULONG classIndex = 0; classIndex < KIoBufferElementPool::_NumberClasses; classIndex++)
+        {
+            ULONG classSize = KIoBufferElementPool::_MinimumClassSize << classIndex;
+            ULONG count = slabsPerClass * (KIoBufferElementPool::_SlabSize / classSize);
+
+            status = KIoBuffer::CreateEmpty(ioBuffer, *g_Allocator, KTL_TAG_TEST);
+            VERIFY_IS_TRUE(NT_SUCCESS(status));
+
+            for (ULONG i = 0; i < count; i++)
+            {
+                status = pool->AllocateElement(classSize, element, buffer);
+                VERIFY_IS_TRUE(NT_SUCCESS(status));
+                ioBuffer->AddIoBufferElement(*element);
+                element = nullptr;
+            }
+
+            VERIFY_IS_TRUE(pool->GetSlabBytes() == slabsPerClass * KIoBufferElementPool::_SlabSize);
+            VERIFY_IS_TRUE(pool->GetIdleSlabCount() == 0);
+
+            ioBuffer = nullptr;
+
+            VERIFY_IS_TRUE(pool->GetIdleSlabCount() == KIoBufferElementPool::_MaximumIdleSlabs);
+            VERIFY_IS_TRUE(pool->GetSlabBytes() == KIoBufferElementPool::_MaximumIdleSlabs * KIoBufferElementPool::_SlabSize);
+        }
+    }
+    VERIFY_IS_TRUE(pool->GetUnpooledAllocations() == 2);
+
+    //
+    // Shrinking the capacity frees the idle slabs above it
+    //
+    pool->SetCapacity(KIoBufferElementPool::_SlabSize);
+    VERIFY_IS_TRUE(pool->GetIdleSlabCount() == 1);
+    VERIFY_IS_TRUE(pool->GetSlabBytes() == KIoBufferElementPool::_SlabSize);
+
+    pool->SetCapacity(0);
+    VERIFY_IS_TRUE(pool->GetIdleSlabCount() == 0);
+    VERIFY_IS_TRUE(pool->GetSlabBytes() == 0);
+
+    status = pool->AllocateElement(extentSize, element, buffer);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(pool->GetUnpooledAllocations() == 3);
+    element = nullptr;
+
+    //
+    // Test 7: The throttled allocator sizes its pool from the limit
+    //
+    ThrottledKIoBufferAllocator::SPtr throttledAllocator;
+    KtlLogManager::MemoryThrottleLimits memoryThrottleLimits;
+    memoryThrottleLimits.WriteBufferMemoryPoolMax = 4 * KIoBufferElementPool::_SlabSize;
+    memoryThrottleLimits.WriteBufferMemoryPoolMin = 4 * KIoBufferElementPool::_SlabSize;
+    memoryThrottleLimits.AllocationTimeoutInMs = KtlLogManager::MemoryThrottleLimits::_UseDefaultAllocationTimeoutInMs;
+
+    status = ThrottledKIoBufferAllocator::CreateThrottledKIoBufferAllocator(
+        memoryThrottleLimits,
+        *g_Allocator,
+        KTL_TAG_TEST,
+        throttledAllocator);
+    VERIFY_IS_TRUE(NT_SUCCESS(status));
+    VERIFY_IS_TRUE(throttledAllocator->GetBufferPool().GetCapacity() == 4 * KIoBufferElementPool::_SlabSize);
+
+    throttledAllocator->SetLimit(KtlLogManager::MemoryThrottleLimits::_NoLimit,
+                                 KtlLogManager::MemoryThrottleLimits::_NoLimit,
+                                 0);
+    VERIFY_IS_TRUE(throttledAllocator->GetBufferPool().GetCapacity() == ThrottledKIoBufferAllocator::_BufferPoolMaximumCapacity);
+
+    throttledAllocator->Shutdown();
+    throttledAllocator.Reset();
+    pool = nullptr;
+}
 #endif
 
 //
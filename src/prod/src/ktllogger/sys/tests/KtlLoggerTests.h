@@ -374,6 +374,12 @@ DLogReservationTest(
     KtlLogManager::SPtr logManager
     );
 
+VOID
+SequentialReadScanTest(
+    KGuid diskId,
+    KtlLogManager::SPtr logManager
+    );
+
 VOID
 DeletedDedicatedLogTest(
     KGuid diskId,
@@ -490,6 +496,14 @@ VOID ThrottledAllocatorTest(
     KGuid& DiskId
     );
 
+VOID OverlayReadCacheTest(
+    KGuid& DiskId
+    );
+
+VOID KIoBufferElementPoolTest(
+    KGuid& DiskId
+    );
+
 VOID OfflineDestageContainerTest(
     KGuid& DiskId
     );
@@ -0,0 +1,1706 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+//
+// LogBench drives the logger through KtlLogManager and KtlLogStream
+// with a configurable workload and reports throughput and latency
+// percentiles per operation type as JSON on stdout so that runs can be
+// compared from build to build.
+//
+
+#pragma once
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <ktl.h>
+#include <ktrace.h>
+
+#include "../../inc/ktllogger.h"
+#include "InternalKtlLogger.h"
+#include "KtlLogShimKernel.h"
+
+#include <windows.h>
+
+#define CONVERT_TO_ARGS(argc, cargs) \
+    std::vector<CHAR*> args_vec(argc);\
+    CHAR** args = (CHAR**)args_vec.data();\
+    std::vector<std::string> wargs(argc);\
+    for (int iter = 0; iter < argc; iter++)\
+    {\
+        wargs[iter] = Utf8To16(cargs[iter]);\
+        args[iter] = (CHAR*)(wargs[iter].data());\
+    }\
+
+static inline ULONG RoundUpTo4K(__in ULONG size)
+{
+    return(((size) + 0xFFF) &(~0xFFF));
+}
+
+static const ULONG oneMB = 1024 * 1024;
+static const ULONGLONG oneMBL = static_cast<ULONGLONG>(oneMB);
+
+KAllocator* g_Allocator;
+
+//
+// Samples are only taken while this is set, which is after the warmup
+// and until the runners are told to stop
+//
+volatile BOOLEAN g_Measuring = FALSE;
+
+typedef struct
+{
+    PCHAR Path;
+    ULONG RecordSize;
+    ULONG StreamCount;
+    ULONG WritePercent;
+    BOOLEAN Coalescing;
+    BOOLEAN UseSharedLog;
+    ULONG FlushInterval;
+    ULONG DurationInSeconds;
+    ULONG WarmupInSeconds;
+    ULONG LogSizeInMB;
+} BenchInformation;
+
+BenchInformation BenchInfo =
+    {
+#if !defined(PLATFORM_UNIX)
+      "\\??\\c:\\temp",
+#else
+      "/tmp",
+#endif
+      4096,           // RecordSize
+      1,              // StreamCount
+      100,            // WritePercent
+      TRUE,           // Coalescing
+      TRUE,           // UseSharedLog
+      1,              // FlushInterval
+      30,             // DurationInSeconds
+      5,              // WarmupInSeconds
+      1024            // LogSizeInMB
+    };
+
+typedef enum
+{
+    OperationWrite = 0,
+    OperationFlush = 1,
+    OperationRead = 2,
+    OperationContainerRecovery = 3,
+    OperationStreamRecovery = 4,
+    OperationCount = 5
+} OperationType;
+
+static const CHAR* const OperationNames[OperationCount] =
+    { "write", "flush", "read", "container_recovery", "stream_recovery" };
+
+//
+// Latencies are kept in log linear buckets so that percentiles are
+// within about 3% of the actual value without keeping every sample.
+// Values below _LinearBuckets have a bucket of their own and each
+// power of two above is split into 2^_SubBucketBits buckets.
+//
+class LatencyHistogram
+{
+    public:
+        LatencyHistogram()
+        {
+            Reset();
+        }
+
+        VOID Reset()
+        {
+            RtlZeroMemory(_Buckets, sizeof(_Buckets));
+            _Count = 0;
+            _Sum = 0;
+            _Min = MAXULONGLONG;
+            _Max = 0;
+        }
+
+        VOID Add(
+            __in ULONGLONG Value
+            )
+        {
+            _Buckets[GetBucket(Value)]++;
+            _Count++;
+            _Sum += Value;
+            if (Value < _Min)
+            {
+                _Min = Value;
+            }
+            if (Value > _Max)
+            {
+                _Max = Value;
+            }
+        }
+
+        VOID Merge(
+            __in LatencyHistogram& Other
+            )
+        {
+            for (ULONG i = 0; i < _NumberBuckets; i++)
+            {
+                _Buckets[i] += Other._Buckets[i];
+            }
+            _Count += Other._Count;
+            _Sum += Other._Sum;
+            if (Other._Min < _Min)
+            {
+                _Min = Other._Min;
+            }
+            if (Other._Max > _Max)
+            {
+                _Max = Other._Max;
+            }
+        }
+
+        ULONGLONG Percentile(
+            __in ULONG PerThousand
+            )
+        {
+            ULONGLONG rank;
+            ULONGLONG seen = 0;
+
+            if (_Count == 0)
+            {
+                return(0);
+            }
+
+            rank = ((_Count * PerThousand) + 999) / 1000;
+            if (rank == 0)
+            {
+                rank = 1;
+            }
+
+            for (ULONG i = 0; i < _NumberBuckets; i++)
+            {
+                seen += _Buckets[i];
+                if (seen >= rank)
+                {
+                    ULONGLONG value = GetBucketValue(i);
+                    return((value > _Max) ? _Max : ((value < _Min) ? _Min : value));
+                }
+            }
+
+            return(_Max);
+        }
+
+        ULONGLONG GetCount() { return(_Count); }
+        ULONGLONG GetMin() { return(_Count == 0 ? 0 : _Min); }
+        ULONGLONG GetMax() { return(_Max); }
+        ULONGLONG GetMean() { return(_Count == 0 ? 0 : _Sum / _Count); }
+        ULONGLONG GetSum() { return(_Sum); }
+
+    private:
+        static const ULONG _LinearBuckets = 64;
+        static const ULONG _LinearBits = 6;
+        static const ULONG _SubBucketBits = 5;
+        static const ULONG _NumberBuckets = _LinearBuckets + ((64 - _LinearBits) << _SubBucketBits);
+
+        static ULONG GetBucket(
+            __in ULONGLONG Value
+            )
+        {
+            ULONG msb = 0;
+
+            if (Value < _LinearBuckets)
+            {
+                return((ULONG)Value);
+            }
+
+            while ((Value >> (msb + 1)) != 0)
+            {
+                msb++;
+            }
+
+            return(_LinearBuckets +
+                   ((msb - _LinearBits) << _SubBucketBits) +
+                   (ULONG)((Value >> (msb - _SubBucketBits)) & ((1 << _SubBucketBits) - 1)));
+        }
+
+        static ULONGLONG GetBucketValue(
+            __in ULONG Bucket
+            )
+        {
+            ULONG msb;
+            ULONGLONG subBucket;
+
+            if (Bucket < _LinearBuckets)
+            {
+                return(Bucket);
+            }
+
+            msb = _LinearBits + ((Bucket - _LinearBuckets) >> _SubBucketBits);
+            subBucket = (Bucket - _LinearBuckets) & ((1 << _SubBucketBits) - 1);
+
+            return(((1ULL << _SubBucketBits) + subBucket) << (msb - _SubBucketBits));
+        }
+
+        ULONGLONG _Buckets[_NumberBuckets];
+        ULONGLONG _Count;
+        ULONGLONG _Sum;
+        ULONGLONG _Min;
+        ULONGLONG _Max;
+};
+
+typedef struct
+{
+    LatencyHistogram Latency;
+    ULONGLONG Bytes;
+} OperationStatistics;
+
+static ULONGLONG ElapsedInUs(
+    __in LONGLONG StartTime
+    )
+{
+    //
+    // Performance time is in 100ns units
+    //
+    return((ULONGLONG)(KNt::GetPerformanceTime() - StartTime) / 10);
+}
+
+//
+// Common code
+//
+class WorkerAsync : public KAsyncContextBase
+{
+    K_FORCE_SHARED_WITH_INHERITANCE(WorkerAsync);
+
+
+    public:
+        virtual VOID StartIt(
+            __in PVOID Parameters,
+            __in_opt KAsyncContextBase* const ParentAsyncContext,
+            __in_opt KAsyncContextBase::CompletionCallback CallbackPtr) = 0;
+
+    protected:
+        virtual VOID FSMContinue(
+            __in NTSTATUS Status,
+            __in KAsyncContextBase& Async
+            )
+        {
+            UNREFERENCED_PARAMETER(Status);
+            UNREFERENCED_PARAMETER(Async);
+
+            Complete(STATUS_SUCCESS);
+        }
+
+        virtual VOID OnReuse() = 0;
+
+        virtual VOID OnCompleted()
+        {
+        }
+
+    private:
+        VOID OnStart()
+        {
+            _Completion.Bind(this, &WorkerAsync::OperationCompletion);
+            FSMContinue(STATUS_SUCCESS, *this);
+        }
+
+        VOID OnCancel()
+        {
+            FSMContinue(STATUS_CANCELLED, *this);
+        }
+
+        VOID OperationCompletion(
+            __in_opt KAsyncContextBase* const ParentAsync,
+            __in KAsyncContextBase& Async
+        )
+        {
+            UNREFERENCED_PARAMETER(ParentAsync);
+            FSMContinue(Async.Status(), Async);
+        }
+
+    protected:
+        KAsyncContextBase::CompletionCallback _Completion;
+
+};
+
+WorkerAsync::WorkerAsync()
+{
+}
+
+WorkerAsync::~WorkerAsync()
+{
+}
+
+
+class StreamCloseSynchronizer : public KObject<StreamCloseSynchronizer>
+{
+    K_DENY_COPY(StreamCloseSynchronizer);
+
+public:
+
+    FAILABLE
+        StreamCloseSynchronizer(__in BOOLEAN IsManualReset = FALSE)
+        : _Event(IsManualReset, FALSE),
+        _CompletionStatus(STATUS_SUCCESS)
+    {
+            _Callback.Bind(this, &StreamCloseSynchronizer::AsyncCompletion);
+            SetConstructorStatus(_Event.Status());
+        }
+
+    ~StreamCloseSynchronizer()
+    {
+    }
+
+    KtlLogStream::CloseCompletionCallback CloseCompletionCallback()
+    {
+        return(_Callback);
+    }
+
+    NTSTATUS
+        WaitForCompletion(
+        __in_opt ULONG TimeoutInMilliseconds = KEvent::Infinite,
+        __out_opt PBOOLEAN IsCompleted = nullptr)
+    {
+            KInvariant(!KtlSystem::GetDefaultKtlSystem().DefaultThreadPool().IsCurrentThreadOwned());
+
+            BOOLEAN b = _Event.WaitUntilSet(TimeoutInMilliseconds);
+            if (!b)
+            {
+                if (IsCompleted)
+                {
+                    *IsCompleted = FALSE;
+                }
+
+                return STATUS_IO_TIMEOUT;
+            }
+            else
+            {
+                if (IsCompleted)
+                {
+                    *IsCompleted = TRUE;
+                }
+
+                return _CompletionStatus;
+            }
+        }
+
+
+    VOID
+        Reset()
+    {
+            _Event.ResetEvent();
+            _CompletionStatus = STATUS_SUCCESS;
+        }
+
+
+protected:
+    VOID
+        AsyncCompletion(
+        __in_opt KAsyncContextBase* const Parent,
+        __in KtlLogStream& LogStream,
+        __in NTSTATUS Status)
+    {
+            UNREFERENCED_PARAMETER(Parent);
+            UNREFERENCED_PARAMETER(LogStream);
+
+            _CompletionStatus = Status;
+
+            _Event.SetEvent();
+        }
+
+private:
+    KEvent                                      _Event;
+    NTSTATUS                                    _CompletionStatus;
+    KtlLogStream::CloseCompletionCallback       _Callback;
+};
+
+
+class ContainerCloseSynchronizer : public KObject<ContainerCloseSynchronizer>
+{
+    K_DENY_COPY(ContainerCloseSynchronizer);
+
+public:
+
+    FAILABLE
+        ContainerCloseSynchronizer(__in BOOLEAN IsManualReset = FALSE)
+        : _Event(IsManualReset, FALSE),
+        _CompletionStatus(STATUS_SUCCESS)
+    {
+            _Callback.Bind(this, &ContainerCloseSynchronizer::AsyncCompletion);
+            SetConstructorStatus(_Event.Status());
+        }
+
+    ~ContainerCloseSynchronizer()
+    {
+    }
+
+    KtlLogContainer::CloseCompletionCallback CloseCompletionCallback()
+    {
+        return(_Callback);
+    }
+
+    NTSTATUS
+        WaitForCompletion(
+        __in_opt ULONG TimeoutInMilliseconds = KEvent::Infinite,
+        __out_opt PBOOLEAN IsCompleted = nullptr)
+    {
+            KInvariant(!KtlSystem::GetDefaultKtlSystem().DefaultThreadPool().IsCurrentThreadOwned());
+
+            BOOLEAN b = _Event.WaitUntilSet(TimeoutInMilliseconds);
+            if (!b)
+            {
+                if (IsCompleted)
+                {
+                    *IsCompleted = FALSE;
+                }
+
+                return STATUS_IO_TIMEOUT;
+            }
+            else
+            {
+                if (IsCompleted)
+                {
+                    *IsCompleted = TRUE;
+                }
+
+                return _CompletionStatus;
+            }
+        }
+
+
+    VOID
+        Reset()
+    {
+            _Event.ResetEvent();
+            _CompletionStatus = STATUS_SUCCESS;
+        }
+
+
+protected:
+    VOID
+        AsyncCompletion(
+        __in_opt KAsyncContextBase* const Parent,
+        __in KtlLogContainer& LogContainer,
+        __in NTSTATUS Status)
+    {
+            UNREFERENCED_PARAMETER(Parent);
+            UNREFERENCED_PARAMETER(LogContainer);
+
+            _CompletionStatus = Status;
+
+            _Event.SetEvent();
+        }
+
+private:
+    KEvent                                      _Event;
+    NTSTATUS                                    _CompletionStatus;
+    KtlLogContainer::CloseCompletionCallback       _Callback;
+};
+
+//
+// Builds a logical log record with the data placed right after the
+// stream block header. Data that does not fit in the metadata block
+// goes into the IoBuffer.
+//
+NTSTATUS PrepareRecord(
+    __in KtlLogStream& LogStream,
+    __in ULONGLONG Version,
+    __in ULONGLONG Asn,
+    __in PUCHAR Data,
+    __in ULONG DataSize,
+    __in BOOLEAN IsBarrierRecord,
+    __out KIoBuffer::SPtr& MetadataIoBuffer,
+    __out KIoBuffer::SPtr& DataIoBuffer
+    )
+{
+    NTSTATUS status;
+    KtlLogStreamId logStreamId;
+    PVOID metadataBuffer;
+    PVOID dataBuffer = NULL;
+    KLogicalLogInformation::MetadataBlockHeader* metadataBlockHeader;
+    KLogicalLogInformation::StreamBlockHeader* streamBlockHeader;
+    ULONG offsetToStreamBlockHeader = LogStream.QueryReservedMetadataSize() + sizeof(KLogicalLogInformation::MetadataBlockHeader);
+    ULONG offsetToDataLocation = offsetToStreamBlockHeader + sizeof(KLogicalLogInformation::StreamBlockHeader);
+    ULONG firstBlockSize;
+    ULONG secondBlockSize;
+
+    status = KIoBuffer::CreateSimple(KLogicalLogInformation::FixedMetadataSize, MetadataIoBuffer, metadataBuffer, *g_Allocator);
+    if (! NT_SUCCESS(status))
+    {
+        return(status);
+    }
+
+    firstBlockSize = KLogicalLogInformation::FixedMetadataSize - offsetToDataLocation;
+    if (firstBlockSize > DataSize)
+    {
+        firstBlockSize = DataSize;
+    }
+    secondBlockSize = DataSize - firstBlockSize;
+
+    if (secondBlockSize > 0)
+    {
+        status = KIoBuffer::CreateSimple(RoundUpTo4K(secondBlockSize), DataIoBuffer, dataBuffer, *g_Allocator);
+    } else {
+        status = KIoBuffer::CreateEmpty(DataIoBuffer, *g_Allocator);
+    }
+    if (! NT_SUCCESS(status))
+    {
+        return(status);
+    }
+
+    LogStream.QueryLogStreamId(logStreamId);
+
+    RtlZeroMemory(metadataBuffer, KLogicalLogInformation::FixedMetadataSize);
+    metadataBlockHeader = (KLogicalLogInformation::MetadataBlockHeader*)((PUCHAR)metadataBuffer +
+                                                                         LogStream.QueryReservedMetadataSize());
+    metadataBlockHeader->OffsetToStreamHeader = offsetToStreamBlockHeader;
+    metadataBlockHeader->Flags = IsBarrierRecord ? KLogicalLogInformation::MetadataBlockHeader::IsEndOfLogicalRecord : 0;
+
+    streamBlockHeader = (KLogicalLogInformation::StreamBlockHeader*)((PUCHAR)metadataBuffer + offsetToStreamBlockHeader);
+    streamBlockHeader->Signature = KLogicalLogInformation::StreamBlockHeader::Sig;
+    streamBlockHeader->StreamId = logStreamId;
+    streamBlockHeader->StreamOffset = Asn;
+    streamBlockHeader->HighestOperationId = Version;
+    streamBlockHeader->DataSize = DataSize;
+
+    KMemCpySafe((PUCHAR)metadataBuffer + offsetToDataLocation,
+                KLogicalLogInformation::FixedMetadataSize - offsetToDataLocation,
+                Data,
+                firstBlockSize);
+    if (secondBlockSize > 0)
+    {
+        KMemCpySafe(dataBuffer, DataIoBuffer->QuerySize(), Data + firstBlockSize, secondBlockSize);
+    }
+
+    streamBlockHeader->DataCRC64 = KLogicalLogInformation::ComputeDataBlockCRC(streamBlockHeader,
+                                                                               *DataIoBuffer,
+                                                                               offsetToDataLocation);
+    streamBlockHeader->HeaderCRC64 = KLogicalLogInformation::ComputeStreamBlockHeaderCRC(streamBlockHeader);
+
+    return(STATUS_SUCCESS);
+}
+
+//
+// Runs a closed loop of writes and reads against one stream. Each
+// operation is started when the previous one completes and its latency
+// is the time from starting it until its completion.
+//
+class LogBenchRunner : public WorkerAsync
+{
+    K_FORCE_SHARED(LogBenchRunner);
+
+    public:
+        static NTSTATUS
+        Create(
+            __in KAllocator& Allocator,
+            __in ULONG AllocationTag,
+            __out LogBenchRunner::SPtr& Context
+        )
+        {
+            NTSTATUS status;
+            LogBenchRunner::SPtr context;
+
+            context = _new(AllocationTag, Allocator) LogBenchRunner();
+            if (context == nullptr)
+            {
+                status = STATUS_INSUFFICIENT_RESOURCES;
+                return(status);
+            }
+
+            status = context->Status();
+            if (! NT_SUCCESS(status))
+            {
+                return(status);
+            }
+
+            context->_LogStream = nullptr;
+            context->_IsCancelled = FALSE;
+
+            Context = context.RawPtr();
+
+            return(STATUS_SUCCESS);
+        }
+
+        VOID StartIt(
+            __in PVOID Parameters,
+            __in_opt KAsyncContextBase* const ParentAsyncContext,
+            __in_opt KAsyncContextBase::CompletionCallback CallbackPtr) override
+        {
+            UNREFERENCED_PARAMETER(Parameters);
+
+            _State = Initial;
+
+            Start(ParentAsyncContext, CallbackPtr);
+        }
+
+        void SetStartParameters(
+            __in KtlLogStream& LogStream,
+            __in ULONG StreamIndex,
+            __in BenchInformation* BenchInformation1
+        )
+        {
+            _LogStream = &LogStream;
+            _BenchInformation = BenchInformation1;
+
+            //
+            // Every stream gets its own sequence so that runs are
+            // repeatable
+            //
+            _Random = 0x9e3779b97f4a7c15ULL * (StreamIndex + 1);
+
+            _LogSpaceAllowed = 128 * oneMBL;
+        }
+
+        OperationStatistics& GetStatistics(
+            __in OperationType Operation
+            )
+        {
+            return(_Statistics[Operation]);
+        }
+
+    private:
+        enum  FSMState { Initial = 0, StartOperation = 1, WriteCompleted = 2, ReadCompleted = 3, Completed = 4 };
+        FSMState _State;
+
+        ULONGLONG NextRandom()
+        {
+            _Random ^= _Random << 13;
+            _Random ^= _Random >> 7;
+            _Random ^= _Random << 17;
+            return(_Random);
+        }
+
+        VOID RecordSample(
+            __in OperationType Operation,
+            __in ULONGLONG Bytes
+            )
+        {
+            ULONGLONG latency = ElapsedInUs(_OperationStartTime);
+
+            if (g_Measuring)
+            {
+                _Statistics[Operation].Latency.Add(latency);
+                _Statistics[Operation].Bytes += Bytes;
+            }
+        }
+
+        VOID FSMContinue(
+            __in NTSTATUS Status,
+            __in KAsyncContextBase& Async
+            ) override
+        {
+            UNREFERENCED_PARAMETER(Async);
+
+            if (_IsCancelled)
+            {
+                Complete(STATUS_CANCELLED);
+                return;
+            }
+
+            if (! NT_SUCCESS(Status))
+            {
+                KTraceFailedAsyncRequest(Status, this, _State, _Asn);
+                Complete(Status);
+                return;
+            }
+
+            switch (_State)
+            {
+                case Initial:
+                {
+                    _Asn = KtlLogAsn::Min().Get();
+                    _Version = 0;
+                    _TruncationAsn = KtlLogAsn::Min().Get();
+                    _WritesStarted = 0;
+
+                    for (ULONG i = 0; i < OperationCount; i++)
+                    {
+                        _Statistics[i].Latency.Reset();
+                        _Statistics[i].Bytes = 0;
+                    }
+
+                    Status = _LogStream->CreateAsyncWriteContext(_WriteContext);
+                    if (! NT_SUCCESS(Status))
+                    {
+                        KTraceFailedAsyncRequest(Status, this, _State, 0);
+                        Complete(Status);
+                        return;
+                    }
+
+                    Status = _LogStream->CreateAsyncReadContext(_ReadContext);
+                    if (! NT_SUCCESS(Status))
+                    {
+                        KTraceFailedAsyncRequest(Status, this, _State, 0);
+                        Complete(Status);
+                        return;
+                    }
+
+                    Status = KBuffer::Create(_BenchInformation->RecordSize, _Data, *g_Allocator);
+                    if (! NT_SUCCESS(Status))
+                    {
+                        KTraceFailedAsyncRequest(Status, this, _State, 0);
+                        Complete(Status);
+                        return;
+                    }
+
+                    PUCHAR data = (PUCHAR)_Data->GetBuffer();
+                    for (ULONG i = 0; i < _BenchInformation->RecordSize; i++)
+                    {
+                        data[i] = (UCHAR)NextRandom();
+                    }
+
+                    _State = StartOperation;
+                    // Fall through
+                }
+
+                case StartOperation:
+                {
+StartNextOperation:
+                    //
+                    // Reads need something to read so the first
+                    // record is always a write
+                    //
+                    if ((_Asn > (_TruncationAsn + 1)) &&
+                        ((NextRandom() % 100) >= _BenchInformation->WritePercent))
+                    {
+                        ULONGLONG readAsn = _TruncationAsn + 1 + (NextRandom() % (_Asn - _TruncationAsn - 1));
+
+                        _ReadMetadata = nullptr;
+                        _ReadIoBuffer = nullptr;
+                        _ReadContext->Reuse();
+
+                        _State = ReadCompleted;
+                        _OperationStartTime = KNt::GetPerformanceTime();
+                        _ReadContext->StartReadContaining(readAsn,
+                                                          &_ReadAsn,
+                                                          &_ReadVersion,
+                                                          _ReadMetadataLength,
+                                                          _ReadMetadata,
+                                                          _ReadIoBuffer,
+                                                          this,
+                                                          _Completion);
+                        break;
+                    }
+
+                    if ((_Asn - _TruncationAsn) >= _LogSpaceAllowed)
+                    {
+                        KtlLogStream::AsyncTruncateContext::SPtr truncateContext;
+
+                        Status = _LogStream->CreateAsyncTruncateContext(truncateContext);
+                        if (! NT_SUCCESS(Status))
+                        {
+                            KTraceFailedAsyncRequest(Status, this, _State, 0);
+                            Complete(Status);
+                            return;
+                        }
+
+                        _TruncationAsn = _Asn - (_LogSpaceAllowed / 2);
+                        truncateContext->Truncate(_TruncationAsn, _TruncationAsn);
+                    }
+
+                    _WritesStarted++;
+                    _IsBarrierWrite = ((_WritesStarted % _BenchInformation->FlushInterval) == 0);
+                    _Version++;
+
+                    //
+                    // Records are built outside of the measured time
+                    //
+                    Status = PrepareRecord(*_LogStream,
+                                           _Version,
+                                           _Asn,
+                                           (PUCHAR)_Data->GetBuffer(),
+                                           _BenchInformation->RecordSize,
+                                           _IsBarrierWrite,
+                                           _Metadata,
+                                           _IoBuffer);
+                    if (! NT_SUCCESS(Status))
+                    {
+                        KTraceFailedAsyncRequest(Status, this, _State, 0);
+                        Complete(Status);
+                        return;
+                    }
+
+                    _WriteContext->Reuse();
+
+                    _State = WriteCompleted;
+                    _OperationStartTime = KNt::GetPerformanceTime();
+                    _WriteContext->StartWrite(_Asn,
+                                              _Version,
+                                              KLogicalLogInformation::FixedMetadataSize,
+                                              _Metadata,
+                                              _IoBuffer,
+                                              0,       // Reservation
+                                              this,    // ParentAsync
+                                              _Completion);
+
+                    _Asn = _Asn + _BenchInformation->RecordSize;
+                    break;
+                }
+
+                case WriteCompleted:
+                {
+                    RecordSample(_IsBarrierWrite ? OperationFlush : OperationWrite, _BenchInformation->RecordSize);
+
+                    _Metadata = nullptr;
+                    _IoBuffer = nullptr;
+
+                    _State = StartOperation;
+                    goto StartNextOperation;
+                }
+
+                case ReadCompleted:
+                {
+                    RecordSample(OperationRead, _ReadMetadataLength + _ReadIoBuffer->QuerySize());
+
+                    _ReadMetadata = nullptr;
+                    _ReadIoBuffer = nullptr;
+
+                    _State = StartOperation;
+                    goto StartNextOperation;
+                }
+
+                default:
+                {
+                    KInvariant(FALSE);
+                }
+            }
+
+            return;
+        }
+
+
+        VOID OnCancel() override
+        {
+            _IsCancelled = TRUE;
+        }
+
+        VOID OnReuse() override
+        {
+            _IsCancelled = FALSE;
+        }
+
+        VOID OnCompleted() override
+        {
+            _LogStream = nullptr;
+            _BenchInformation = nullptr;
+
+            _WriteContext = nullptr;
+            _ReadContext = nullptr;
+
+            _Data = nullptr;
+            _Metadata = nullptr;
+            _IoBuffer = nullptr;
+            _ReadMetadata = nullptr;
+            _ReadIoBuffer = nullptr;
+        }
+
+    private:
+        //
+        // Parameters
+        //
+        KtlLogStream::SPtr _LogStream;
+        BenchInformation* _BenchInformation;
+
+        //
+        // Internal
+        //
+        KtlLogStream::AsyncWriteContext::SPtr _WriteContext;
+        KtlLogStream::AsyncReadContext::SPtr _ReadContext;
+        KBuffer::SPtr _Data;
+        KIoBuffer::SPtr _Metadata;
+        KIoBuffer::SPtr _IoBuffer;
+        KIoBuffer::SPtr _ReadMetadata;
+        KIoBuffer::SPtr _ReadIoBuffer;
+        ULONG _ReadMetadataLength;
+        KtlLogAsn _ReadAsn;
+        ULONGLONG _ReadVersion;
+        ULONGLONG _Asn;
+        ULONGLONG _Version;
+        ULONGLONG _TruncationAsn;
+        ULONGLONG _LogSpaceAllowed;
+        ULONGLONG _WritesStarted;
+        BOOLEAN _IsBarrierWrite;
+        ULONGLONG _Random;
+        LONGLONG _OperationStartTime;
+        OperationStatistics _Statistics[OperationCount];
+
+        BOOLEAN _IsCancelled;
+};
+
+LogBenchRunner::LogBenchRunner()
+{
+}
+
+LogBenchRunner::~LogBenchRunner()
+{
+}
+
+NTSTATUS StreamIoctl(
+    __in KtlLogStream& LogStream,
+    __in ULONG ControlCode
+    )
+{
+    NTSTATUS status;
+    KSynchronizer sync;
+    KtlLogStream::AsyncIoctlContext::SPtr ioctl;
+    KBuffer::SPtr inBuffer, outBuffer;
+    ULONG result;
+
+    status = LogStream.CreateAsyncIoctlContext(ioctl);
+    if (! NT_SUCCESS(status))
+    {
+        return(status);
+    }
+
+    ioctl->StartIoctl(ControlCode, inBuffer.RawPtr(), result, outBuffer, NULL, sync);
+    status = sync.WaitForCompletion();
+
+    return(status);
+}
+
+NTSTATUS ConfigureLogManager(
+    __in KtlLogManager& LogManager
+    )
+{
+    NTSTATUS status;
+    KSynchronizer sync;
+    KtlLogManager::MemoryThrottleLimits* memoryThrottleLimits;
+    KtlLogManager::AsyncConfigureContext::SPtr configureContext;
+    KBuffer::SPtr inBuffer;
+    KBuffer::SPtr outBuffer;
+    ULONG result;
+
+    status = LogManager.CreateAsyncConfigureContext(configureContext);
+    if (! NT_SUCCESS(status))
+    {
+        return(status);
+    }
+
+    status = KBuffer::Create(sizeof(KtlLogManager::MemoryThrottleLimits),
+                             inBuffer,
+                             *g_Allocator);
+    if (! NT_SUCCESS(status))
+    {
+        return(status);
+    }
+
+    //
+    // Defaults without throttling limits
+    //
+    memoryThrottleLimits = (KtlLogManager::MemoryThrottleLimits*)inBuffer->GetBuffer();
+    memoryThrottleLimits->WriteBufferMemoryPoolMax = KtlLogManager::MemoryThrottleLimits::_NoLimit;
+    memoryThrottleLimits->WriteBufferMemoryPoolMin = KtlLogManager::MemoryThrottleLimits::_NoLimit;
+    memoryThrottleLimits->WriteBufferMemoryPoolPerStream = KtlLogManager::MemoryThrottleLimits::_DefaultWriteBufferMemoryPoolPerStream;
+    memoryThrottleLimits->PinnedMemoryLimit = KtlLogManager::MemoryThrottleLimits::_NoLimit;
+    memoryThrottleLimits->PeriodicFlushTimeInSec = KtlLogManager::MemoryThrottleLimits::_DefaultPeriodicFlushTimeInSec;
+    memoryThrottleLimits->PeriodicTimerIntervalInSec = KtlLogManager::MemoryThrottleLimits::_DefaultPeriodicTimerIntervalInSec;
+    memoryThrottleLimits->AllocationTimeoutInMs = KtlLogManager::MemoryThrottleLimits::_DefaultAllocationTimeoutInMs;
+    memoryThrottleLimits->MaximumDestagingWriteOutstanding = KtlLogManager::MemoryThrottleLimits::_NoLimit;
+
+    configureContext->StartConfigure(KtlLogManager::ConfigureMemoryThrottleLimits2,
+                                     inBuffer.RawPtr(),
+                                     result,
+                                     outBuffer,
+                                     NULL,
+                                     sync);
+    status = sync.WaitForCompletion();
+
+    return(status);
+}
+
+NTSTATUS BuildPathName(
+    __out KString::SPtr& PathName,
+    __in PCHAR Directory,
+    __in KGuid& Guid,
+    __in PCHAR Extension
+    )
+{
+    NTSTATUS status;
+    KWString path(*g_Allocator);
+
+    path = Directory;
+    path += KVolumeNamespace::PathSeparator;
+    path += Guid;
+    path += Extension;
+    status = path.Status();
+    if (! NT_SUCCESS(status))
+    {
+        return(status);
+    }
+
+    status = KString::Create(PathName, *g_Allocator, (PCHAR)path, TRUE);
+    return(status);
+}
+
+NTSTATUS CloseStreamsAndContainer(
+    __in KArray<KtlLogStream::SPtr>& Streams,
+    __in KtlLogContainer::SPtr& LogContainer
+    )
+{
+    NTSTATUS status;
+    NTSTATUS finalStatus = STATUS_SUCCESS;
+    ContainerCloseSynchronizer closeContainerSync;
+
+    for (ULONG i = 0; i < Streams.Count(); i++)
+    {
+        StreamCloseSynchronizer closeStreamSync;
+
+        if (! Streams[i])
+        {
+            continue;
+        }
+
+        Streams[i]->StartClose(NULL,
+                               closeStreamSync.CloseCompletionCallback());
+
+        status = closeStreamSync.WaitForCompletion();
+        if (! NT_SUCCESS(status))
+        {
+            KTraceFailedAsyncRequest(status, nullptr, i, 0);
+            finalStatus = status;
+        }
+        Streams[i] = nullptr;
+    }
+
+    if (LogContainer)
+    {
+        LogContainer->StartClose(NULL,
+                                 closeContainerSync.CloseCompletionCallback());
+
+        status = closeContainerSync.WaitForCompletion();
+        if (! NT_SUCCESS(status))
+        {
+            KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+            finalStatus = status;
+        }
+        LogContainer = nullptr;
+    }
+
+    return(finalStatus);
+}
+
+VOID PrintResults(
+    __in BenchInformation* BenchInfo1,
+    __in ULONGLONG MeasuredInUs,
+    __in OperationStatistics* Statistics
+    )
+{
+    double measuredSeconds = (double)MeasuredInUs / 1000000.0;
+
+    printf("{\n");
+    printf("  \"tool\": \"LogBench\",\n");
+    printf("  \"configuration\": {\n");
+    printf("    \"path\": \"");
+    for (PCHAR p = BenchInfo1->Path; *p != 0; p++)
+    {
+        if ((*p == '\\') || (*p == '"'))
+        {
+            printf("\\");
+        }
+        printf("%c", *p);
+    }
+    printf("\",\n");
+    printf("    \"recordSize\": %u,\n", BenchInfo1->RecordSize);
+    printf("    \"streams\": %u,\n", BenchInfo1->StreamCount);
+    printf("    \"writePercent\": %u,\n", BenchInfo1->WritePercent);
+    printf("    \"coalescing\": %s,\n", BenchInfo1->Coalescing ? "true" : "false");
+    printf("    \"log\": \"%s\",\n", BenchInfo1->UseSharedLog ? "shared" : "dedicated");
+    printf("    \"flushInterval\": %u,\n", BenchInfo1->FlushInterval);
+    printf("    \"durationInSeconds\": %u,\n", BenchInfo1->DurationInSeconds);
+    printf("    \"warmupInSeconds\": %u,\n", BenchInfo1->WarmupInSeconds);
+    printf("    \"logSizeInMB\": %u\n", BenchInfo1->LogSizeInMB);
+    printf("  },\n");
+    printf("  \"measuredSeconds\": %.3f,\n", measuredSeconds);
+    printf("  \"operations\": [");
+
+    for (ULONG i = 0; i < OperationCount; i++)
+    {
+        LatencyHistogram& latency = Statistics[i].Latency;
+        double seconds = measuredSeconds;
+
+        //
+        // Recovery is not part of the timed run so its rate is over
+        // the time the opens took
+        //
+        if ((i == OperationContainerRecovery) || (i == OperationStreamRecovery))
+        {
+            seconds = (double)latency.GetSum() / 1000000.0;
+        }
+
+        printf("%s\n    {\n", (i == 0) ? "" : ",");
+        printf("      \"operation\": \"%s\",\n", OperationNames[i]);
+        printf("      \"count\": %llu,\n", latency.GetCount());
+        printf("      \"bytes\": %llu,\n", Statistics[i].Bytes);
+        printf("      \"opsPerSecond\": %.1f,\n", (seconds > 0.0) ? (double)latency.GetCount() / seconds : 0.0);
+        printf("      \"megabytesPerSecond\": %.3f,\n", (seconds > 0.0) ? ((double)Statistics[i].Bytes / (double)oneMB) / seconds : 0.0);
+        printf("      \"latencyUs\": { \"min\": %llu, \"mean\": %llu, \"p50\": %llu, \"p99\": %llu, \"p999\": %llu, \"max\": %llu }\n",
+               latency.GetMin(),
+               latency.GetMean(),
+               latency.Percentile(500),
+               latency.Percentile(990),
+               latency.Percentile(999),
+               latency.GetMax());
+        printf("    }");
+    }
+
+    printf("\n  ]\n");
+    printf("}\n");
+}
+
+NTSTATUS RunBenchmark(
+    __in BenchInformation* BenchInfo1
+    )
+{
+    NTSTATUS status;
+    NTSTATUS finalStatus = STATUS_SUCCESS;
+    KSynchronizer sync;
+    ULONG streamCount = BenchInfo1->StreamCount;
+    KtlLogManager::SPtr logManager;
+    KArray<KGuid> streamGuids(*g_Allocator, streamCount, streamCount, 100);
+    KArray<KtlLogStream::SPtr> streams(*g_Allocator, streamCount, streamCount, 100);
+    KArray<LogBenchRunner::SPtr> runners(*g_Allocator, streamCount, streamCount, 100);
+    KArray<KSynchronizer> runnerSyncs(*g_Allocator, streamCount, streamCount, 100);
+    KServiceSynchronizer serviceSync;
+    KBuffer::SPtr securityDescriptor = nullptr;
+    KGuid logContainerGuid;
+    KtlLogContainerId logContainerId;
+    KString::SPtr containerPath;
+    KtlLogContainer::SPtr logContainer;
+    KtlLogManager::AsyncCreateLogContainer::SPtr createContainerAsync;
+    KtlLogManager::AsyncOpenLogContainer::SPtr openContainerAsync;
+    KtlLogManager::AsyncDeleteLogContainer::SPtr deleteContainerAsync;
+    KtlLogContainer::AsyncCreateLogStreamContext::SPtr createStreamAsync;
+    KtlLogContainer::AsyncOpenLogStreamContext::SPtr openStreamAsync;
+    KtlLogContainer::AsyncDeleteLogStreamContext::SPtr deleteStreamAsync;
+    OperationStatistics statistics[OperationCount];
+    LONGLONG measureStartTime;
+    ULONGLONG measuredInUs;
+
+    if ((! NT_SUCCESS(streamGuids.Status())) || (! NT_SUCCESS(streams.Status())) ||
+        (! NT_SUCCESS(runners.Status())) || (! NT_SUCCESS(runnerSyncs.Status())))
+    {
+        return(STATUS_INSUFFICIENT_RESOURCES);
+    }
+
+    for (ULONG i = 0; i < OperationCount; i++)
+    {
+        statistics[i].Bytes = 0;
+    }
+
+    status = KtlLogManager::CreateInproc(KTL_TAG_TEST, *g_Allocator, logManager);
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        return(status);
+    }
+
+    status = logManager->StartOpenLogManager(NULL, // ParentAsync
+                                             serviceSync.OpenCompletionCallback());
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        return(status);
+    }
+    status = serviceSync.WaitForCompletion();
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        return(status);
+    }
+
+    status = ConfigureLogManager(*logManager);
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        finalStatus = status;
+        goto CloseManager;
+    }
+
+    //
+    // Create the container and the streams
+    //
+    logContainerGuid.CreateNew();
+    logContainerId = static_cast<KtlLogContainerId>(logContainerGuid);
+
+    status = BuildPathName(containerPath, BenchInfo1->Path, logContainerGuid, ".log");
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        finalStatus = status;
+        goto CloseManager;
+    }
+
+    status = logManager->CreateAsyncCreateLogContainerContext(createContainerAsync);
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        finalStatus = status;
+        goto CloseManager;
+    }
+
+    createContainerAsync->StartCreateLogContainer(*containerPath,
+                                                  logContainerId,
+                                                  BenchInfo1->LogSizeInMB * oneMBL,
+                                                  0,            // Max Number Streams
+                                                  0,            // Max Record Size
+                                                  KtlLogManager::FlagSparseFile,
+                                                  logContainer,
+                                                  NULL,         // ParentAsync
+                                                  sync);
+    status = sync.WaitForCompletion();
+    if (! NT_SUCCESS(status))
+    {
+        fprintf(stderr, "Failed to create log container in %s: 0x%x\n", BenchInfo1->Path, status);
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        finalStatus = status;
+        goto CloseManager;
+    }
+
+    status = logContainer->CreateAsyncCreateLogStreamContext(createStreamAsync);
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        finalStatus = status;
+        goto DeleteContainer;
+    }
+
+    for (ULONG i = 0; i < streamCount; i++)
+    {
+        KString::SPtr streamPath;
+        ULONG metadataLength = 0x10000;
+        const LONGLONG StreamSize = 512 * oneMBL;
+
+        streamGuids[i].CreateNew();
+
+        status = BuildPathName(streamPath, BenchInfo1->Path, streamGuids[i], ".stream");
+        if (! NT_SUCCESS(status))
+        {
+            KTraceFailedAsyncRequest(status, nullptr, i, 0);
+            finalStatus = status;
+            goto DeleteContainer;
+        }
+
+        createStreamAsync->Reuse();
+        createStreamAsync->StartCreateLogStream(static_cast<KtlLogStreamId>(streamGuids[i]),
+                                                KLogicalLogInformation::GetLogicalLogStreamType(),
+                                                nullptr,           // Alias
+                                                KString::CSPtr(streamPath.RawPtr()),
+                                                securityDescriptor,
+                                                metadataLength,
+                                                StreamSize,
+                                                oneMB,
+                                                KtlLogManager::FlagSparseFile,
+                                                streams[i],
+                                                NULL,    // ParentAsync
+                                                sync);
+        status = sync.WaitForCompletion();
+        if (! NT_SUCCESS(status))
+        {
+            KTraceFailedAsyncRequest(status, nullptr, i, 0);
+            finalStatus = status;
+            goto DeleteContainer;
+        }
+
+        status = StreamIoctl(*streams[i], BenchInfo1->Coalescing ? KLogicalLogInformation::EnableCoalescingWrites :
+                                                                   KLogicalLogInformation::DisableCoalescingWrites);
+        if (NT_SUCCESS(status) && (! BenchInfo1->UseSharedLog))
+        {
+            status = StreamIoctl(*streams[i], KLogicalLogInformation::WriteOnlyToDedicatedLog);
+        }
+        if (! NT_SUCCESS(status))
+        {
+            KTraceFailedAsyncRequest(status, nullptr, i, 0);
+            finalStatus = status;
+            goto DeleteContainer;
+        }
+    }
+
+    //
+    // Run the workload, sampling only after the warmup
+    //
+    for (ULONG i = 0; i < streamCount; i++)
+    {
+        status = LogBenchRunner::Create(*g_Allocator, KTL_TAG_TEST, runners[i]);
+        if (! NT_SUCCESS(status))
+        {
+            KTraceFailedAsyncRequest(status, nullptr, i, 0);
+            finalStatus = status;
+            goto DeleteContainer;
+        }
+
+        runners[i]->SetStartParameters(*streams[i], i, BenchInfo1);
+    }
+
+    for (ULONG i = 0; i < streamCount; i++)
+    {
+        runners[i]->StartIt(nullptr, nullptr, runnerSyncs[i]);
+    }
+
+    KNt::Sleep(BenchInfo1->WarmupInSeconds * 1000);
+
+    measureStartTime = KNt::GetPerformanceTime();
+    g_Measuring = TRUE;
+
+    KNt::Sleep(BenchInfo1->DurationInSeconds * 1000);
+
+    g_Measuring = FALSE;
+    measuredInUs = ElapsedInUs(measureStartTime);
+
+    for (ULONG i = 0; i < streamCount; i++)
+    {
+        runners[i]->Cancel();
+    }
+
+    for (ULONG i = 0; i < streamCount; i++)
+    {
+        status = runnerSyncs[i].WaitForCompletion();
+        if ((status != STATUS_CANCELLED) && (! NT_SUCCESS(status)))
+        {
+            fprintf(stderr, "Stream %u failed: 0x%x\n", i, status);
+            finalStatus = status;
+        }
+
+        for (ULONG j = 0; j < OperationCount; j++)
+        {
+            statistics[j].Latency.Merge(runners[i]->GetStatistics((OperationType)j).Latency);
+            statistics[j].Bytes += runners[i]->GetStatistics((OperationType)j).Bytes;
+        }
+
+        runners[i] = nullptr;
+    }
+
+    //
+    // Close everything and time opening it again, which recovers the
+    // shared log and then each stream
+    //
+    createStreamAsync = nullptr;
+    status = CloseStreamsAndContainer(streams, logContainer);
+    if (! NT_SUCCESS(status))
+    {
+        finalStatus = status;
+        goto DeleteContainer;
+    }
+
+    status = logManager->CreateAsyncOpenLogContainerContext(openContainerAsync);
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        finalStatus = status;
+        goto DeleteContainer;
+    }
+
+    LONGLONG startTime;
+
+    startTime = KNt::GetPerformanceTime();
+    openContainerAsync->StartOpenLogContainer(*containerPath,
+                                              logContainerId,
+                                              logContainer,
+                                              NULL,         // ParentAsync
+                                              sync);
+    status = sync.WaitForCompletion();
+    statistics[OperationContainerRecovery].Latency.Add(ElapsedInUs(startTime));
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        finalStatus = status;
+        goto DeleteContainer;
+    }
+
+    status = logContainer->CreateAsyncOpenLogStreamContext(openStreamAsync);
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        finalStatus = status;
+        goto DeleteContainer;
+    }
+
+    for (ULONG i = 0; i < streamCount; i++)
+    {
+        ULONG openedMetadataLength;
+
+        openStreamAsync->Reuse();
+        startTime = KNt::GetPerformanceTime();
+        openStreamAsync->StartOpenLogStream(streamGuids[i],
+                                            &openedMetadataLength,
+                                            streams[i],
+                                            NULL,    // ParentAsync
+                                            sync);
+        status = sync.WaitForCompletion();
+        statistics[OperationStreamRecovery].Latency.Add(ElapsedInUs(startTime));
+        if (! NT_SUCCESS(status))
+        {
+            KTraceFailedAsyncRequest(status, nullptr, i, 0);
+            finalStatus = status;
+            goto DeleteContainer;
+        }
+    }
+    openStreamAsync = nullptr;
+
+    if (NT_SUCCESS(finalStatus))
+    {
+        PrintResults(BenchInfo1, measuredInUs, statistics);
+    }
+
+DeleteContainer:
+    //
+    // Remove the logs so that repeated runs start from the same state
+    //
+    createStreamAsync = nullptr;
+    openStreamAsync = nullptr;
+    CloseStreamsAndContainer(streams, logContainer);
+
+    status = logManager->CreateAsyncOpenLogContainerContext(openContainerAsync);
+    if (NT_SUCCESS(status))
+    {
+        openContainerAsync->StartOpenLogContainer(*containerPath,
+                                                  logContainerId,
+                                                  logContainer,
+                                                  NULL,         // ParentAsync
+                                                  sync);
+        status = sync.WaitForCompletion();
+    }
+
+    if (NT_SUCCESS(status))
+    {
+        status = logContainer->CreateAsyncDeleteLogStreamContext(deleteStreamAsync);
+        for (ULONG i = 0; (i < streamCount) && NT_SUCCESS(status); i++)
+        {
+            deleteStreamAsync->Reuse();
+            deleteStreamAsync->StartDeleteLogStream(static_cast<KtlLogStreamId>(streamGuids[i]), NULL, sync);
+            status = sync.WaitForCompletion();
+            if (status == STATUS_NOT_FOUND)
+            {
+                // Stream was never created
+                status = STATUS_SUCCESS;
+            }
+        }
+        deleteStreamAsync = nullptr;
+
+        CloseStreamsAndContainer(streams, logContainer);
+    }
+
+    if (NT_SUCCESS(status))
+    {
+        status = logManager->CreateAsyncDeleteLogContainerContext(deleteContainerAsync);
+        if (NT_SUCCESS(status))
+        {
+            deleteContainerAsync->StartDeleteLogContainer(*containerPath, logContainerId, NULL, sync);
+            status = sync.WaitForCompletion();
+        }
+    }
+
+    if (! NT_SUCCESS(status))
+    {
+        fprintf(stderr, "Failed to delete log container %s: 0x%x\n", (PCHAR)*containerPath, status);
+    }
+
+    createContainerAsync = nullptr;
+    openContainerAsync = nullptr;
+    deleteContainerAsync = nullptr;
+
+CloseManager:
+    status = logManager->StartCloseLogManager(NULL, // ParentAsync
+                                              serviceSync.CloseCompletionCallback());
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        return(status);
+    }
+
+    logManager = nullptr;
+    status = serviceSync.WaitForCompletion();
+    if (! NT_SUCCESS(status))
+    {
+        KTraceFailedAsyncRequest(status, nullptr, 0, 0);
+        return(status);
+    }
+
+    return(finalStatus);
+}
+
+void Usage()
+{
+    fprintf(stderr, "LogBench - measure ktllogger throughput and latency\n");
+    fprintf(stderr, "\n");
+    fprintf(stderr, "       -p:<directory for the log files, use tmpfs to take the disk out, default %s>\n", BenchInfo.Path);
+    fprintf(stderr, "       -r:<record size in bytes, default %u>\n", BenchInfo.RecordSize);
+    fprintf(stderr, "       -s:<number of streams, default %u>\n", BenchInfo.StreamCount);
+    fprintf(stderr, "       -w:<percent of operations that are writes, the rest are reads, default %u>\n", BenchInfo.WritePercent);
+    fprintf(stderr, "       -c:<1 to coalesce writes, 0 not to, default %u>\n", BenchInfo.Coalescing ? 1 : 0);
+    fprintf(stderr, "       -l:<s to write to the shared and dedicated log, d to write only to the dedicated log, default s>\n");
+    fprintf(stderr, "       -f:<every Nth write is a barrier that flushes, reported as flush, default %u>\n", BenchInfo.FlushInterval);
+    fprintf(stderr, "       -d:<seconds measured, default %u>\n", BenchInfo.DurationInSeconds);
+    fprintf(stderr, "       -u:<seconds of warmup before measuring, default %u>\n", BenchInfo.WarmupInSeconds);
+    fprintf(stderr, "       -m:<log container size in MB, default %u>\n", BenchInfo.LogSizeInMB);
+    fprintf(stderr, "\n");
+    fprintf(stderr, "Results are written to stdout as JSON with throughput and latency\n");
+    fprintf(stderr, "percentiles in microseconds per operation type.\n");
+    fprintf(stderr, "\n");
+}
+
+ULONG ParseCommandLine(__in int argc, __in char** args, __out BenchInformation* Options)
+{
+    CHAR flag;
+    size_t len;
+    PCHAR arg;
+
+    for (int i = 1; i < argc; i++)
+    {
+        arg = args[i];
+
+        len = strlen(arg);
+        if (len < 4)
+        {
+            Usage();
+            return(ERROR_INVALID_PARAMETER);
+        }
+
+        if ((arg[0] != '-') || (arg[2] != ':'))
+        {
+            Usage();
+            return(ERROR_INVALID_PARAMETER);
+        }
+
+        flag = (CHAR)tolower(arg[1]);
+
+        switch (flag)
+        {
+            case 'p':
+            {
+                Options->Path = arg + 3;
+                break;
+            }
+
+            case 'r':
+            {
+                Options->RecordSize = (ULONG)atol(arg + 3);
+                break;
+            }
+
+            case 's':
+            {
+                Options->StreamCount = (ULONG)atol(arg + 3);
+                break;
+            }
+
+            case 'w':
+            {
+                Options->WritePercent = (ULONG)atol(arg + 3);
+                break;
+            }
+
+            case 'c':
+            {
+                Options->Coalescing = (atol(arg + 3) != 0);
+                break;
+            }
+
+            case 'l':
+            {
+                CHAR log = (CHAR)tolower(arg[3]);
+
+                if (log == 's')
+                {
+                    Options->UseSharedLog = TRUE;
+                } else if (log == 'd') {
+                    Options->UseSharedLog = FALSE;
+                } else {
+                    Usage();
+                    return(ERROR_INVALID_PARAMETER);
+                }
+                break;
+            }
+
+            case 'f':
+            {
+                Options->FlushInterval = (ULONG)atol(arg + 3);
+                break;
+            }
+
+            case 'd':
+            {
+                Options->DurationInSeconds = (ULONG)atol(arg + 3);
+                break;
+            }
+
+            case 'u':
+            {
+                Options->WarmupInSeconds = (ULONG)atol(arg + 3);
+                break;
+            }
+
+            case 'm':
+            {
+                Options->LogSizeInMB = (ULONG)atol(arg + 3);
+                break;
+            }
+
+            default:
+            {
+                Usage();
+                return(ERROR_INVALID_PARAMETER);
+            }
+        }
+    }
+
+    //
+    // Records are limited by the 1MB maximum record size of the streams
+    //
+    if ((Options->RecordSize == 0) ||
+        (Options->RecordSize > (oneMB - KLogicalLogInformation::FixedMetadataSize)) ||
+        (Options->StreamCount == 0) ||
+        (Options->WritePercent > 100) ||
+        (Options->FlushInterval == 0) ||
+        (Options->DurationInSeconds == 0))
+    {
+        fprintf(stderr, "Record size, stream count, write percent, flush interval or duration is out of range\n\n");
+        Usage();
+        return(ERROR_INVALID_PARAMETER);
+    }
+
+    return(ERROR_SUCCESS);
+}
+
+NTSTATUS
+TheMain(
+    int argc, CHAR* args[]
+    )
+{
+    ULONG error;
+
+    error = ParseCommandLine(argc, args, &BenchInfo);
+    if (error != ERROR_SUCCESS)
+    {
+        return(error);
+    }
+
+    EventRegisterMicrosoft_Windows_KTL();
+
+    KtlSystem* system = nullptr;
+    NTSTATUS Result = KtlSystem::Initialize(FALSE, &system);
+    KInvariant(NT_SUCCESS(Result));
+
+    g_Allocator = &KtlSystem::GlobalNonPagedAllocator();
+
+    Result = RunBenchmark(&BenchInfo);
+
+    //
+    // Sleep to give time for asyncs to be cleaned up
+    //
+    KNt::Sleep(500);
+
+    EventUnregisterMicrosoft_Windows_KTL();
+
+    KtlSystem::Shutdown();
+
+    return Result;
+}
+
+#if !defined(PLATFORM_UNIX)
+int
+wmain(int argc, CHAR* args[])
+{
+    return TheMain(argc, args);
+}
+#else
+#include <vector>
+int main(int argc, char* cargs[])
+{
+    CONVERT_TO_ARGS(argc, cargs);
+    return TheMain(argc, args);
+}
+#endif
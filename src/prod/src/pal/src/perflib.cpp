@@ -4,6 +4,195 @@
 // ------------------------------------------------------------
 
 #include "perflib.h"
+#include "perflib_shm.h"
+
+#include <dirent.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+namespace
+{
+    //
+    // Counter set templates registered on a provider via PerfSetCounterSetInfo
+    //
+    struct PerfCounterSetTemplate
+    {
+        GUID CounterSetGuid;
+        ULONG InstanceType;
+        vector<PERF_SHM_COUNTER> Counters;
+    };
+
+    struct PerfProvider
+    {
+        GUID ProviderGuid;
+        mutex Lock;
+        vector<PerfCounterSetTemplate> CounterSets;
+    };
+
+    //
+    // Process wide bookkeeping of the regions backing live instances, used to
+    // unmap and unlink them on PerfDeleteInstance
+    //
+    struct PerfInstanceRegion
+    {
+        string ShmName;     // empty if the region is private (shm unavailable)
+        size_t Size;
+    };
+
+    mutex instanceLock;
+    map<PPERF_COUNTERSET_INSTANCE, PerfInstanceRegion> instanceRegions;
+    atomic<ULONG> nextInstanceSequence(0);
+    once_flag staleRegionCleanup;
+
+    inline ULONG AlignUp(ULONG value, ULONG alignment)
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // one cell per CPU, rounded up to a power of two so that callers can mask
+    ULONG GetShardCount()
+    {
+        static ULONG shardCount = 0;
+        if (shardCount == 0)
+        {
+            long processors = sysconf(_SC_NPROCESSORS_CONF);
+            ULONG count = 1;
+            while (count < (ULONG)processors && count < PERF_SHM_MAX_SHARDS)
+            {
+                count <<= 1;
+            }
+
+            shardCount = count;
+        }
+
+        return shardCount;
+    }
+
+    inline bool GuidEquals(GUID const & left, GUID const & right)
+    {
+        return memcmp(&left, &right, sizeof(GUID)) == 0;
+    }
+
+    inline PPERF_SHM_COUNTERSET_HEADER ToHeader(PPERF_COUNTERSET_INSTANCE pInstance)
+    {
+        auto header = reinterpret_cast<PPERF_SHM_COUNTERSET_HEADER>(pInstance);
+        return (header != NULL && header->Magic == PERF_SHM_MAGIC) ? header : NULL;
+    }
+
+    inline PPERF_SHM_COUNTER GetCounters(PPERF_SHM_COUNTERSET_HEADER header)
+    {
+        return reinterpret_cast<PPERF_SHM_COUNTER>(reinterpret_cast<BYTE*>(header) + header->CounterInfoOffset);
+    }
+
+    inline LONGLONG * GetValues(PPERF_SHM_COUNTERSET_HEADER header)
+    {
+        return reinterpret_cast<LONGLONG*>(reinterpret_cast<BYTE*>(header) + header->ValuesOffset);
+    }
+
+    LPVOID AllocateRegion(size_t size, __out string & shmName)
+    {
+        char name[64];
+        snprintf(name, sizeof(name), "/" PERF_SHM_NAME_PREFIX "%d.%u", getpid(), nextInstanceSequence++);
+
+        int fd = shm_open(name, O_CREAT | O_EXCL | O_RDWR, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH);
+        if (fd >= 0)
+        {
+            void * addr = MAP_FAILED;
+            if (ftruncate(fd, size) == 0)
+            {
+                addr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+            }
+
+            close(fd);
+
+            if (addr != MAP_FAILED)
+            {
+                shmName = name;
+                return addr;
+            }
+
+            shm_unlink(name);
+        }
+
+        // Export is best effort: fall back to private memory so that counters
+        // keep working in process when /dev/shm is not available
+        shmName.clear();
+        return calloc(1, size);
+    }
+
+    void FreeRegion(LPVOID addr, PerfInstanceRegion const & region)
+    {
+        if (region.ShmName.empty())
+        {
+            free(addr);
+            return;
+        }
+
+        shm_unlink(region.ShmName.c_str());
+        munmap(addr, region.Size);
+    }
+
+    //
+    // Regions are unlinked by PerfDeleteInstance, so the regions of a process
+    // that crashed stay in /dev/shm until someone removes them. The first
+    // provider started in a process removes the regions of processes that no
+    // longer exist.
+    //
+    void RemoveStaleRegions()
+    {
+        DIR * dir = opendir(PERF_SHM_DIRECTORY);
+        if (dir == NULL)
+        {
+            return;
+        }
+
+        size_t prefixLength = strlen(PERF_SHM_NAME_PREFIX);
+        pid_t self = getpid();
+
+        struct dirent * entry;
+        while ((entry = readdir(dir)) != NULL)
+        {
+            if (strncmp(entry->d_name, PERF_SHM_NAME_PREFIX, prefixLength) != 0)
+            {
+                continue;
+            }
+
+            char * end = NULL;
+            long pid = strtol(entry->d_name + prefixLength, &end, 10);
+            if (end == entry->d_name + prefixLength || *end != '.' || pid <= 0 || pid == self)
+            {
+                continue;
+            }
+
+            // EPERM means the process exists but belongs to someone else
+            if (kill(static_cast<pid_t>(pid), 0) == 0 || errno != ESRCH)
+            {
+                continue;
+            }
+
+            string name = "/";
+            name += entry->d_name;
+            shm_unlink(name.c_str());
+        }
+
+        closedir(dir);
+    }
+}
 
 ULONG __stdcall
 PerfStartProvider(
@@ -12,10 +201,18 @@ PerfStartProvider(
     __out    HANDLE        * phProvider
 )
 {
-    static int fakedHandle = 0;
-    fakedHandle++;
-    *phProvider = (HANDLE) fakedHandle; // Return a faked handle
-    return 0;
+    if (ProviderGuid == NULL || phProvider == NULL)
+    {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    call_once(staleRegionCleanup, RemoveStaleRegions);
+
+    auto provider = new PerfProvider();
+    provider->ProviderGuid = *ProviderGuid;
+
+    *phProvider = (HANDLE) provider;
+    return ERROR_SUCCESS;
 }
 
 ULONG __stdcall
@@ -23,7 +220,8 @@ PerfStopProvider(
     __in HANDLE hProvider
 )
 {
-    return 0;
+    delete (PerfProvider*) hProvider;
+    return ERROR_SUCCESS;
 }
 
 __success(return == ERROR_SUCCESS)
@@ -34,7 +232,47 @@ PerfSetCounterSetInfo(
     __in     ULONG                 dwTemplateSize
 )
 {
-    return 0;
+    auto provider = (PerfProvider*) hProvider;
+    if (provider == NULL ||
+        pTemplate == NULL ||
+        dwTemplateSize < sizeof(PERF_COUNTERSET_INFO) + pTemplate->NumCounters * sizeof(PERF_COUNTER_INFO))
+    {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    PerfCounterSetTemplate counterSet;
+    counterSet.CounterSetGuid = pTemplate->CounterSetGuid;
+    counterSet.InstanceType = pTemplate->InstanceType;
+
+    auto counterInfo = reinterpret_cast<PPERF_COUNTER_INFO>(pTemplate + 1);
+    for (ULONG i = 0; i < pTemplate->NumCounters; ++i, ++counterInfo)
+    {
+        PERF_SHM_COUNTER counter = { 0 };
+        counter.CounterId = counterInfo->CounterId;
+        counter.Type = counterInfo->Type;
+        if ((counterInfo->Attrib & PERF_ATTRIB_SHARDED) != 0)
+        {
+            counter.Flags |= PERF_SHM_COUNTER_FLAG_SHARDED;
+            counter.ShardCount = GetShardCount();
+        }
+
+        counterSet.Counters.push_back(counter);
+    }
+
+    lock_guard<mutex> grab(provider->Lock);
+
+    for (auto & existing : provider->CounterSets)
+    {
+        if (GuidEquals(existing.CounterSetGuid, counterSet.CounterSetGuid))
+        {
+            // re-registration replaces the template for subsequent instances
+            existing = move(counterSet);
+            return ERROR_SUCCESS;
+        }
+    }
+
+    provider->CounterSets.push_back(move(counterSet));
+    return ERROR_SUCCESS;
 }
 
 PPERF_COUNTERSET_INSTANCE __stdcall
@@ -45,8 +283,96 @@ PerfCreateInstance(
     __in ULONG   dwInstance
 )
 {
-    static PERF_COUNTERSET_INSTANCE dummy_instance{0};
-    return &dummy_instance;
+    auto provider = (PerfProvider*) hProvider;
+    if (provider == NULL || CounterSetGuid == NULL || szInstanceName == NULL)
+    {
+        SetLastError(ERROR_INVALID_PARAMETER);
+        return NULL;
+    }
+
+    vector<PERF_SHM_COUNTER> counters;
+    ULONG instanceType = 0;
+    {
+        lock_guard<mutex> grab(provider->Lock);
+
+        bool found = false;
+        for (auto const & counterSet : provider->CounterSets)
+        {
+            if (GuidEquals(counterSet.CounterSetGuid, *CounterSetGuid))
+            {
+                counters = counterSet.Counters;
+                instanceType = counterSet.InstanceType;
+                found = true;
+                break;
+            }
+        }
+
+        if (!found)
+        {
+            SetLastError(ERROR_NOT_FOUND);
+            return NULL;
+        }
+    }
+
+    ULONG numCounters = static_cast<ULONG>(counters.size());
+    ULONG counterInfoOffset = AlignUp(sizeof(PERF_SHM_COUNTERSET_HEADER), sizeof(LONGLONG));
+    ULONG valuesOffset = AlignUp(counterInfoOffset + numCounters * sizeof(PERF_SHM_COUNTER), PERF_SHM_VALUE_ALIGNMENT);
+    ULONG totalSize = AlignUp(valuesOffset + numCounters * sizeof(LONGLONG), PERF_SHM_VALUE_ALIGNMENT);
+
+    for (auto & counter : counters)
+    {
+        if (counter.ShardCount > 0)
+        {
+            counter.ShardOffset = totalSize;
+            totalSize += counter.ShardCount * PERF_SHM_VALUE_ALIGNMENT;
+        }
+    }
+
+    PerfInstanceRegion region;
+    region.Size = totalSize;
+
+    auto header = reinterpret_cast<PPERF_SHM_COUNTERSET_HEADER>(AllocateRegion(totalSize, region.ShmName));
+    if (header == NULL)
+    {
+        SetLastError(ERROR_NOT_ENOUGH_MEMORY);
+        return NULL;
+    }
+
+    size_t nameLength = strnlen(szInstanceName, PERF_SHM_MAX_INSTANCE_NAME - 1);
+
+    header->Instance.CounterSetGuid = *CounterSetGuid;
+    header->Instance.dwSize = totalSize;
+    header->Instance.InstanceId = dwInstance;
+    header->Instance.InstanceNameOffset = offsetof(PERF_SHM_COUNTERSET_HEADER, InstanceName);
+    header->Instance.InstanceNameSize = static_cast<ULONG>(nameLength + 1);
+
+    header->Magic = PERF_SHM_MAGIC;
+    header->Version = PERF_SHM_VERSION;
+    header->HeaderSize = sizeof(PERF_SHM_COUNTERSET_HEADER);
+    header->TotalSize = totalSize;
+    header->ProcessId = getpid();
+    header->ProviderGuid = provider->ProviderGuid;
+    header->InstanceType = instanceType;
+    header->NumCounters = numCounters;
+    header->CounterInfoOffset = counterInfoOffset;
+    header->ValuesOffset = valuesOffset;
+    memcpy(header->InstanceName, szInstanceName, nameLength);
+    header->InstanceName[nameLength] = '\0';
+
+    if (numCounters > 0)
+    {
+        memcpy(GetCounters(header), counters.data(), numCounters * sizeof(PERF_SHM_COUNTER));
+    }
+
+    // Publish the layout before readers are allowed to look at it
+    __atomic_store_n(&header->State, PERF_SHM_STATE_ACTIVE, __ATOMIC_RELEASE);
+
+    {
+        lock_guard<mutex> grab(instanceLock);
+        instanceRegions[&header->Instance] = move(region);
+    }
+
+    return &header->Instance;
 }
 
 ULONG __stdcall
@@ -55,7 +381,25 @@ PerfDeleteInstance(
     __in PPERF_COUNTERSET_INSTANCE InstanceBlock
 )
 {
-    return 0;
+    PerfInstanceRegion region;
+    {
+        lock_guard<mutex> grab(instanceLock);
+
+        auto it = instanceRegions.find(InstanceBlock);
+        if (it == instanceRegions.end())
+        {
+            return ERROR_NOT_FOUND;
+        }
+
+        region = move(it->second);
+        instanceRegions.erase(it);
+    }
+
+    auto header = ToHeader(InstanceBlock);
+    __atomic_store_n(&header->State, PERF_SHM_STATE_DELETED, __ATOMIC_RELEASE);
+
+    FreeRegion(header, region);
+    return ERROR_SUCCESS;
 }
 
 ULONG __stdcall
@@ -66,5 +410,89 @@ PerfSetCounterRefValue(
     __in LPVOID                    lpAddr
 )
 {
-    return 0;
+    auto header = ToHeader(pInstance);
+    if (header == NULL)
+    {
+        return ERROR_INVALID_PARAMETER;
+    }
+
+    auto counters = GetCounters(header);
+    auto values = GetValues(header);
+    for (ULONG i = 0; i < header->NumCounters; ++i)
+    {
+        if (counters[i].CounterId == CounterId)
+        {
+            // Only the exported slot can be sampled out of process. Any other
+            // address is accepted for compatibility but marks the slot stale.
+            if (lpAddr == &values[i])
+            {
+                counters[i].Flags &= ~PERF_SHM_COUNTER_FLAG_EXTERNAL;
+            }
+            else
+            {
+                counters[i].Flags |= PERF_SHM_COUNTER_FLAG_EXTERNAL;
+            }
+
+            return ERROR_SUCCESS;
+        }
+    }
+
+    return ERROR_NOT_FOUND;
+}
+
+LPVOID __stdcall
+PerfGetCounterStorage(
+    __in PPERF_COUNTERSET_INSTANCE pInstance,
+    __in ULONG                     CounterId
+)
+{
+    auto header = ToHeader(pInstance);
+    if (header == NULL)
+    {
+        return NULL;
+    }
+
+    auto counters = GetCounters(header);
+    for (ULONG i = 0; i < header->NumCounters; ++i)
+    {
+        if (counters[i].CounterId == CounterId)
+        {
+            return &GetValues(header)[i];
+        }
+    }
+
+    return NULL;
+}
+
+LPVOID __stdcall
+PerfGetCounterShardStorage(
+    __in  PPERF_COUNTERSET_INSTANCE pInstance,
+    __in  ULONG                     CounterId,
+    __out ULONG                   * pShardCount
+)
+{
+    *pShardCount = 0;
+
+    auto header = ToHeader(pInstance);
+    if (header == NULL)
+    {
+        return NULL;
+    }
+
+    auto counters = GetCounters(header);
+    for (ULONG i = 0; i < header->NumCounters; ++i)
+    {
+        if (counters[i].CounterId == CounterId)
+        {
+            if ((counters[i].Flags & PERF_SHM_COUNTER_FLAG_SHARDED) == 0)
+            {
+                return NULL;
+            }
+
+            *pShardCount = counters[i].ShardCount;
+            return reinterpret_cast<BYTE*>(header) + counters[i].ShardOffset;
+        }
+    }
+
+    return NULL;
 }
@@ -0,0 +1,117 @@
+// ------------------------------------------------------------
+// Copyright (c) Microsoft Corporation.  All rights reserved.
+// Licensed under the MIT License (MIT). See License.txt in the repo root for license information.
+// ------------------------------------------------------------
+
+#pragma once
+
+#include "perflib.h"
+
+//
+// Shared memory layout of an exported counter set instance.
+//
+// Every PerfCreateInstance call maps one region named
+//
+//     /dev/shm/sfperf.<pid>.<sequence>
+//
+// which holds a PERF_SHM_COUNTERSET_HEADER, NumCounters PERF_SHM_COUNTER
+// descriptors and NumCounters 64-bit counter values. The values are the live
+// backing store of PerformanceCounterData, so an out-of-process reader samples
+// them with plain aligned 64-bit loads and never calls into the process.
+//
+// Counters registered with PERF_ATTRIB_SHARDED additionally own ShardCount
+// cache line sized cells starting at ShardOffset. Updates go to the cell of the
+// current CPU and the counter value is the slot plus the sum of the first 64-bit
+// word of its cells. The rest of a cell is private to the writer.
+//
+// Readers must check Magic, Version and State before trusting the rest of the
+// header, and should ignore regions whose ProcessId no longer exists (the
+// writer crashed before it could unlink the region). Such regions are removed
+// by the next process that starts a counter provider.
+//
+
+#define PERF_SHM_DIRECTORY          "/dev/shm"
+#define PERF_SHM_NAME_PREFIX        "sfperf."
+
+#define PERF_SHM_MAGIC              0x43504653  // 'SFPC'
+#define PERF_SHM_VERSION            2  // 2: PERF_SHM_COUNTER gained ShardCount and ShardOffset
+
+#define PERF_SHM_STATE_INITIALIZING 0
+#define PERF_SHM_STATE_ACTIVE       1
+#define PERF_SHM_STATE_DELETED      2
+
+#define PERF_SHM_VALUE_ALIGNMENT    64
+
+#define PERF_SHM_MAX_SHARDS         64
+
+// PAL extension to PERF_COUNTER_INFO::Attrib: allocate per-CPU shard cells
+#define PERF_ATTRIB_SHARDED         0x0000000100000000
+
+// The value slot is not the backing store of the counter; the owning process
+// redirected it with PerfSetCounterRefValue and the slot is not updated.
+#define PERF_SHM_COUNTER_FLAG_EXTERNAL 0x00000001
+
+// The value is the slot plus the sum of the counter's shard cells.
+#define PERF_SHM_COUNTER_FLAG_SHARDED  0x00000002
+
+#define PERF_SHM_MAX_INSTANCE_NAME  256
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct _PERF_SHM_COUNTER {
+    ULONG  CounterId;
+    ULONG  Type;
+    ULONG  Flags;
+    ULONG  ShardCount;          // 0 unless PERF_SHM_COUNTER_FLAG_SHARDED
+    ULONG  ShardOffset;         // first of ShardCount PERF_SHM_VALUE_ALIGNMENT sized cells
+    ULONG  Reserved;
+} PERF_SHM_COUNTER, * PPERF_SHM_COUNTER;
+
+typedef struct _PERF_SHM_COUNTERSET_HEADER {
+    // Must be first: the address of the header is the PPERF_COUNTERSET_INSTANCE
+    // handed back to PerfCreateInstance callers.
+    PERF_COUNTERSET_INSTANCE Instance;
+
+    ULONG  Magic;
+    ULONG  Version;
+    ULONG  HeaderSize;
+    ULONG  TotalSize;
+    volatile LONG State;
+    LONG   ProcessId;
+    GUID   ProviderGuid;
+    ULONG  InstanceType;
+    ULONG  NumCounters;
+    ULONG  CounterInfoOffset;   // PERF_SHM_COUNTER[NumCounters]
+    ULONG  ValuesOffset;        // LONGLONG[NumCounters], PERF_SHM_VALUE_ALIGNMENT aligned
+    CHAR   InstanceName[PERF_SHM_MAX_INSTANCE_NAME];
+} PERF_SHM_COUNTERSET_HEADER, * PPERF_SHM_COUNTERSET_HEADER;
+
+//
+// Returns the address of the exported value slot for CounterId, or NULL if the
+// counter is not part of the instance. Counter set instances that allocate
+// their own counter memory use this as the backing store so that updates are
+// visible to readers without any copying.
+//
+LPVOID __stdcall
+PerfGetCounterStorage(
+    __in PPERF_COUNTERSET_INSTANCE pInstance,
+    __in ULONG                     CounterId
+);
+
+//
+// Returns the first of the shard cells of a counter registered with
+// PERF_ATTRIB_SHARDED and their count, or NULL if the counter is not sharded.
+// Cells are PERF_SHM_VALUE_ALIGNMENT bytes apart.
+//
+LPVOID __stdcall
+PerfGetCounterShardStorage(
+    __in  PPERF_COUNTERSET_INSTANCE pInstance,
+    __in  ULONG                     CounterId,
+    __out ULONG                   * pShardCount
+);
+
+#ifdef __cplusplus
+}
+#endif